@@ -1,6 +1,6 @@
 // Example for usage of libriff
 //
-// We open a potential RIFF file, recursively traverse through all chunks and print the chunk header info with indentation.
+// We open a potential RIFF file, traverse through all chunks and print the chunk header info with indentation.
 //
 
 
@@ -19,66 +19,51 @@ int nchunk = 0; //number of chunks
 
 
 
-void test_traverse_rec(riff_handle *rh){
-	int err;
-	char indent[512*8] = "";  //indentation
-	
-	//identation for pretty output
-	for(int i = 0; i < rh->ls_level; i++)
-		snprintf(indent, sizeof(indent), "%s ", indent);
+//print indentation for pretty output
+void print_indent(int level){
+	for(int i = 0; i < level; i++)
+		putchar(' ');
+}
+
+
+//walker callback, called for every chunk
+int print_chunk(riff_handle *rh, void *user){
+	(void)user;
+	print_indent(rh->ls_level + 1);
+	printf("%s: %zu [%zu..%zu]\n", rh->c_id, rh->c_size, rh->c_pos_start,  rh->c_pos_start + 8 + rh->c_size + rh->pad - 1);
+	nchunk++;
+	//getchar(); //uncomment to press ENTER to continue after a printed chunk
+	return RIFF_WALK_CONTINUE;
+}
+
+
+//walker callback, called after stepping into a sub list
+int print_list_type(riff_handle *rh, void *user){
+	(void)user;
+	//output type of parent list chunk
+	struct riff_levelStackE *ls = rh->ls + rh->ls_level - 1;
+	//type ID of sub list is only read, after stepping into it
+	print_indent(rh->ls_level + 1);
+	printf("Type: %s\n", ls->c_type);
+	nlist++;
+	return RIFF_WALK_CONTINUE;
+}
+
+
+void test_traverse(riff_handle *rh){
+	printf("CHUNK_ID: TOTAL_CHUNK_SIZE [CHUNK_DATA_FROM_TO_POS]\n");
+	//output RIFF file header
+	printf("%s: %zu [%zu..%zu]\n", rh->h_id, rh->h_size, rh->pos_start, rh->pos_start + rh->size);
+	printf(" Type: %s\n", rh->h_type);
 	
-	if(rh->ls_level == 0) {
-		printf("CHUNK_ID: TOTAL_CHUNK_SIZE [CHUNK_DATA_FROM_TO_POS]\n");
-		//output RIFF file header
-		printf("%s%s: %zu [%zu..%zu]\n", indent, rh->h_id, rh->h_size, rh->pos_start, rh->pos_start + rh->size);
-		printf(" %sType: %s\n", indent, rh->h_type);
-	}
-	else {
-		//output type of parent list chunk
-		struct riff_levelStackE *ls = rh->ls + rh->ls_level - 1;
-		//type ID of sub list is only read, after stepping into it
-		printf(" %sType: %s\n", indent, ls->c_type);
-	}
+	//no recursion needed, the walker uses the level stack of the handle
+	struct riff_walker w = {0};
+	w.fp_chunk = &print_chunk;
+	w.fp_enter = &print_list_type;
 	
-	strncat(indent, " ", sizeof(indent) - strlen(indent) - 1);
-	
-	int k = 0;
-	
-	while(1){
-		printf("%s%s: %zu [%zu..%zu]\n", indent, rh->c_id, rh->c_size, rh->c_pos_start,  rh->c_pos_start + 8 + rh->c_size + rh->pad - 1);
-		
-		//if current chunk not a chunk list
-		if(memcmp(rh->c_id, "LIST", 4) != 0  &&  memcmp(rh->c_id, "RIFF", 4) != 0){
-		}
-		else {
-			//getchar(); //uncomment to press ENTER to continue after a printed chunk
-			{
-				err = riff_seekLevelSub(rh);
-				if (err){
-				}
-				else
-					nlist++;
-				test_traverse_rec(rh); //recursive call
-			}
-		}
-		k++;
-		
-		err = riff_seekNextChunk(rh);
-		if(err >= RIFF_ERROR_CRITICAL) {
-			printf("%s", riff_errorToString(err));
-			break;
-		}
-		else if (err < RIFF_ERROR_CRITICAL  &&  err != RIFF_ERROR_NONE) {
-			//printf("last chunk in level %d %d .. %d %s\n", rh->ls_level, rh->c_pos_start, rh->c_pos_start + 8 + rh->c_size + rh->pad, rh->c_id);
-			
-			//go back from sub level
-			riff_levelParent(rh);
-			//file pos has not changed by going a level back, we are now within that parent's data
-			break;
-		}
-		else
-			nchunk++;
-	}
+	int err = riff_walk(rh, &w);
+	if(err != RIFF_ERROR_NONE)
+		printf("%s\n", riff_errorToString(err));
 }
 
 
@@ -104,7 +89,7 @@ void test(FILE *f){
 	}
 	nchunk++; //header can be seen as chunk
 	
-	test_traverse_rec(rh);
+	test_traverse(rh);
 	printf("\nlist chunks: %d\nchunks: %d\n", nlist, nchunk);
 	
 	int r;
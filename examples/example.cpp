@@ -1,6 +1,6 @@
 // Example for usage of libriff
 //
-// We open a potential RIFF file, recursively traverse through all chunks and print the chunk header info with indentation.
+// We open a potential RIFF file, traverse through all chunks and print the chunk header info with indentation.
 //
 
 
@@ -22,66 +22,41 @@ int nchunk = 0; //number of chunks
 
 
 
-void test_traverse_rec(RIFF::RIFFFile & rh){
-	int err;
-	std::string indent = "";  //indentation
-	
-	//identation for pretty output
-	for(int i = 0; i < rh().ls_level; i++)
-		indent += " ";
+//walker callback, called for every chunk
+int print_chunk(riff_handle *rh, void *user){
+	(void)user;
+	std::cout << std::string(rh->ls_level + 1, ' ') << rh->c_id << ": " <<  rh->c_size << " [" << rh->c_pos_start << ".." << rh->c_pos_start + 8 + rh->c_size + rh->pad - 1 << "]" << std::endl;
+	nchunk++;
+	//getchar(); //uncomment to press ENTER to continue after a printed chunk
+	return RIFF_WALK_CONTINUE;
+}
+
+
+//walker callback, called after stepping into a sub list
+int print_list_type(riff_handle *rh, void *user){
+	(void)user;
+	//output type of parent list chunk
+	struct riff_levelStackE *ls = rh->ls + rh->ls_level - 1;
+	//type ID of sub list is only read, after stepping into it
+	std::cout << std::string(rh->ls_level + 1, ' ') << "Type: " << ls->c_type << std::endl;
+	nlist++;
+	return RIFF_WALK_CONTINUE;
+}
+
+
+void test_traverse(RIFF::RIFFFile & rh){
+	std::cout << "CHUNK_ID: TOTAL_CHUNK_SIZE [CHUNK_DATA_FROM_TO_POS]" << std::endl;
+	//output RIFF file header
+	std::cout << rh().h_id << ": " << rh().h_size << " [" << rh().pos_start << ".." << rh().pos_start + rh().size << "]" << std::endl;
+	std::cout << " Type: " << rh().h_type << std::endl;
 	
-	if(rh().ls_level == 0) {
-		std::cout << "CHUNK_ID: TOTAL_CHUNK_SIZE [CHUNK_DATA_FROM_TO_POS]" << std::endl;
-		//output RIFF file header
-		std::cout << indent << rh().h_id << ": " << rh().h_size << " [" << rh().pos_start << ".." << rh().pos_start + rh().size << "]" << std::endl;
-		std::cout << indent << "Type: " << rh().h_type << std::endl;
-	}
-	else {
-		//output type of parent list chunk
-		struct riff_levelStackE *ls = rh().ls + rh().ls_level - 1;
-		//type ID of sub list is only read, after stepping into it
-		std::cout << indent << "Type: " << ls->c_type << std::endl;
-	}
+	//no recursion needed, the walker uses the level stack of the handle
+	riff_walker w = {};
+	w.fp_chunk = &print_chunk;
+	w.fp_enter = &print_list_type;
 	
-	indent += " ";
-	
-	int k = 0;
-	
-	while(1){
-		std::cout << indent << rh().c_id << ": " <<  rh().c_size << " [" << rh().c_pos_start << ".." << rh().c_pos_start + 8 + rh().c_size + rh().pad - 1 << "]" << std::endl;
-		
-		//if current chunk not a chunk list
-		if(memcmp(rh().c_id, "LIST", 4) != 0  &&  memcmp(rh().c_id, "RIFF", 4) != 0){
-		}
-		else {
-			//getchar(); //uncomment to press ENTER to continue after a printed chunk
-			{
-				err = rh.seekLevelSub();
-				if (err){
-				}
-				else
-					nlist++;
-				test_traverse_rec(rh); //recursive call
-			}
-		}
-		k++;
-		
-		err = rh.seekNextChunk();
-		if(err >= RIFF_ERROR_CRITICAL) {
-			std::cout << riff_errorToString(err) << std::endl;
-			break;
-		}
-		else if (err < RIFF_ERROR_CRITICAL  &&  err != RIFF_ERROR_NONE) {
-			//printf("last chunk in level %d %d .. %d %s\n", rh().ls_level, rh().c_pos_start, rh().c_pos_start + 8 + rh().c_size + rh().pad, rh().c_id);
-			
-			//go back from sub level
-			rh.levelParent();
-			//file pos has not changed by going a level back, we are now within that parent's data
-			break;
-		}
-		else
-			nchunk++;
-	}
+	if(rh.walk(w) != RIFF_ERROR_NONE)
+		std::cout << rh.latestErrorToString() << std::endl;
 }
 
 
@@ -107,7 +82,7 @@ void test(std::fstream & f){
 	}
 	nchunk++; //header can be seen as chunk
 	
-	test_traverse_rec(rh);
+	test_traverse(rh);
 	std::cout << std::endl << "list chunks: " << nlist << ", chunks:" << nchunk << std::endl << std::endl ;
 	
 	int r;
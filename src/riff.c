@@ -8,8 +8,10 @@
 #include <string.h>
 
 #include <stdarg.h> //function with variable number of arguments
+#include <time.h>
 
 #include "riff.h"
+#include "riff_internal.h"
 
 
 #define RIFF_LEVEL_ALLOC 16  //number of stack elements allocated per step lock more when needing to enlarge (step)
@@ -37,9 +39,11 @@ static const char *riff_es[] = {
 	"File access failed",
 	//8
 	"Invalid riff_handle",
+	//9
+	"Memory allocation failed",
 	
 	
-	//9
+	//10
 	//all other
 	"Unknown RIFF error"  
 };
@@ -60,6 +64,41 @@ int riff_printf(const char *format, ... ){
 }
 
 
+//** allocator **
+
+
+/*****************************************************************************/
+static void *heapMalloc(void *user, size_t size){
+	(void)user;
+	return malloc(size);
+}
+
+/*****************************************************************************/
+static void *heapRealloc(void *user, void *ptr, size_t size){
+	(void)user;
+	return realloc(ptr, size);
+}
+
+/*****************************************************************************/
+static void heapFree(void *user, void *ptr){
+	(void)user;
+	free(ptr);
+}
+
+//C heap by default
+riff_allocator alloc_global = {heapMalloc, heapRealloc, heapFree, NULL};
+
+/*****************************************************************************/
+void *mem_calloc(const riff_allocator *a, size_t n, size_t size){
+	if(size != 0  &&  n > (size_t)-1 / size)
+		return NULL;
+	void *p = mem_alloc(a, n * size);
+	if(p != NULL)
+		memset(p, 0, n * size);
+	return p;
+}
+
+
 //** FILE **
 
 
@@ -74,6 +113,11 @@ size_t seek_file(riff_handle *rh, size_t pos){
 	return pos;
 }
 
+/*****************************************************************************/
+size_t overwrite_file(riff_handle *rh, const void *ptr, size_t size){
+	return fwrite(ptr, 1, size, (FILE*)(rh->fh));
+}
+
 /*****************************************************************************/
 //description: see header file
 int riff_open_file(riff_handle *rh, FILE *f, size_t size){
@@ -84,6 +128,7 @@ int riff_open_file(riff_handle *rh, FILE *f, size_t size){
 	
 	rh->fp_read = &read_file;
 	rh->fp_seek = &seek_file;
+	rh->fp_write = &overwrite_file;
 	
 	return riff_readHeader(rh);
 }
@@ -111,7 +156,7 @@ int riff_open_mem(riff_handle *rh, const void *ptr, size_t size){
 	
 	rh->fh = (void *)ptr;
 	rh->size = size;
-	//rh->pos_start = 0 //redundant -> passed memory pointer is always expected to point to start of riff file
+	rh->pos_start = 0; //passed memory pointer is always expected to point to start of riff file, handle may be reused
 	
 	rh->fp_read = &read_mem;
 	rh->fp_seek = &seek_mem;
@@ -129,7 +174,7 @@ int riff_open_mem(riff_handle *rh, const void *ptr, size_t size){
 //pass pointer to 32 bit LE value and convert, return in native byte order
 uint32_t convUInt32LE(const void *p){
 	const uint8_t *c = (const uint8_t*)p;
-	return c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+	return c[0] | (c[1] << 8) | (c[2] << 16) | ((uint32_t)c[3] << 24);
 }
 
 
@@ -145,26 +190,149 @@ uint32_t readUInt32LE(riff_handle *rh){
 
 
 /*****************************************************************************/
-//read chunk header
-//return error code
-int riff_readChunkHeader(riff_handle *rh){
-	checkValidRiffHandle(rh);
+//read at absolute position, not beyond the file size if known
+size_t riff_readAt(riff_handle *rh, size_t pos, void *ptr, size_t size){
+	if(rh->size > 0){
+		if(pos >= rh->size)
+			return 0;
+		if(size > rh->size - pos)
+			size = rh->size - pos;
+	}
+	rh->pos = pos;
+	rh->fp_seek(rh, pos);
+	size_t n = rh->fp_read(rh, ptr, size);
+	rh->pos += n;
+	return n;
+}
 
-	char buf[8];
+
+/*****************************************************************************/
+//hash bucket of chunk ID in ds64 hash
+static size_t ds64Bucket(const riff_handle *rh, const char *id){
+	uint32_t v;
+	memcpy(&v, id, 4);
+	return (size_t)((v * 2654435761u) >> 7) & (rh->ds64_hash_size - 1);
+}
+
+/*****************************************************************************/
+//64 bit size of chunk with size field 0xFFFFFFFF, constant time
+//returns 0xFFFFFFFF if not listed
+uint64_t ds64Size(const riff_handle *rh, const char *id){
+	if(memcmp(id, "data", 4) == 0)
+		return rh->ds64_data;
+	if(rh->ds64_hash_size == 0)
+		return 0xFFFFFFFF;
+	
+	size_t b = ds64Bucket(rh, id);
+	while(rh->ds64_hash[b] != 0){
+		const struct riff_ds64E *e = rh->ds64_table + (rh->ds64_hash[b] - 1);
+		if(memcmp(e->c_id, id, 4) == 0)
+			return e->c_size;
+		b = (b + 1) & (rh->ds64_hash_size - 1);
+	}
+	return 0xFFFFFFFF;
+}
+
+/*****************************************************************************/
+//free ds64 table and hash
+void ds64Free(riff_handle *rh){
+	mem_free(&rh->alloc, rh->ds64_table);
+	mem_free(&rh->alloc, rh->ds64_hash);
+	rh->ds64_table = NULL;
+	rh->ds64_hash = NULL;
+	rh->ds64_table_len = 0;
+	rh->ds64_hash_size = 0;
+	rh->ds64 = 0;
+}
+
+/*****************************************************************************/
+//parse data of current chunk as ds64 chunk: RIFF size, data size, sample count, table
+//see https://www.itu.int/dms_pubrec/itu-r/rec/bs/R-REC-BS.2088-1-201910-I!!PDF-E.pdf
+int ds64Read(riff_handle *rh){
+	uint8_t buf[28];
+	size_t n = riff_readInChunk(rh, buf, sizeof(buf));
+	if(n < 8){
+		if (rh->fp_printf)
+			rh->fp_printf("ds64 chunk too small to contain any meaningful information.\n");
+		return RIFF_ERROR_ICSIZE;
+	}
+	rh->h_size = (size_t)convUInt64LE(buf);
+	rh->ds64 = 1;
+	rh->ds64_data = 0xFFFFFFFF; //unknown
+	//older writers may omit the rest
+	if(n < 24)
+		return RIFF_ERROR_NONE;
+	rh->ds64_data = convUInt64LE(buf + 8);
+	rh->ds64_samples = convUInt64LE(buf + 16);
+	if(n < 28)
+		return RIFF_ERROR_NONE;
+	
+	//table, limited by chunk size
+	size_t len = convUInt32LE(buf + 24);
+	if(len > (rh->c_size - 28) / 12)
+		len = (rh->c_size - 28) / 12;
+	if(len == 0)
+		return RIFF_ERROR_NONE;
+	
+	size_t hash_size = 4;
+	while(hash_size < len * 2)
+		hash_size *= 2;
+	rh->ds64_table = mem_alloc(&rh->alloc, len * sizeof(struct riff_ds64E));
+	rh->ds64_hash = mem_calloc(&rh->alloc, hash_size, sizeof(uint32_t));
+	if(rh->ds64_table == NULL  ||  rh->ds64_hash == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate ds64 table\n");
+		ds64Free(rh);
+		return RIFF_ERROR_MEMORY;
+	}
+	rh->ds64_hash_size = hash_size;
 	
+	size_t i;
+	for(i = 0; i < len; i++){
+		uint8_t e[12];
+		if(riff_readInChunk(rh, e, 12) != 12)
+			break;
+		struct riff_ds64E *te = rh->ds64_table + rh->ds64_table_len;
+		memcpy(te->c_id, e, 4);
+		te->c_id[4] = '\0';
+		te->c_size = convUInt64LE(e + 4);
+		
+		//first entry of an ID wins
+		size_t b = ds64Bucket(rh, te->c_id);
+		while(rh->ds64_hash[b] != 0  &&  memcmp(rh->ds64_table[rh->ds64_hash[b] - 1].c_id, te->c_id, 4) != 0)
+			b = (b + 1) & (hash_size - 1);
+		if(rh->ds64_hash[b] == 0)
+			rh->ds64_hash[b] = (uint32_t)++rh->ds64_table_len;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//read the 8 byte chunk header, ID is set, size is left to the caller
+//return 0 on error
+static int readChunkHeaderRaw(riff_handle *rh, char *buf){
 	int n = rh->fp_read(rh, buf, 8);
 	
 	if(n != 8){
 		if(rh->fp_printf)
 			rh->fp_printf("Failed to read header, %d of %d bytes read!\n", n, 8);
-		return RIFF_ERROR_EOF; //return error code
+		return 0;
 	}
 	
 	rh->c_pos_start = rh->pos;
 	rh->pos += n;
 	
 	memcpy(rh->c_id, buf, 4);
-	rh->c_size = convUInt32LE(buf + 4);
+	rh->c_fourcc = convUInt32LE(buf);
+	return 1;
+}
+
+
+/*****************************************************************************/
+//verify chunk header after the size is set
+//return error code
+static int checkChunkHeader(riff_handle *rh){
 	rh->pad = rh->c_size & 0x1; //pad byte present if size is odd
 	rh->c_pos = 0;
 	
@@ -209,6 +377,33 @@ int riff_readChunkHeader(riff_handle *rh){
 }
 
 
+/*****************************************************************************/
+//read chunk header of little endian files ("RIFF", "RF64", "BW64")
+//return error code
+int readChunkHeaderLE(riff_handle *rh){
+	char buf[8];
+	if(!readChunkHeaderRaw(rh, buf))
+		return RIFF_ERROR_EOF;
+	rh->c_size = convUInt32LE(buf + 4);
+	//real size of 64 bit files is in the ds64 chunk
+	if(rh->c_size == 0xFFFFFFFF  &&  rh->ds64)
+		rh->c_size = ds64Size(rh, rh->c_id);
+	return checkChunkHeader(rh);
+}
+
+
+/*****************************************************************************/
+//read chunk header of big endian files ("RIFX")
+//return error code
+static int readChunkHeaderBE(riff_handle *rh){
+	char buf[8];
+	if(!readChunkHeaderRaw(rh, buf))
+		return RIFF_ERROR_EOF;
+	rh->c_size = convUInt32BE(buf + 4);
+	return checkChunkHeader(rh);
+}
+
+
 /*****************************************************************************/
 //pop from level stack
 //when returning we are positioned inside the parent chunk ()
@@ -221,6 +416,7 @@ void stack_pop(riff_handle *rh){
 	
 	rh->c_pos_start = ls->c_pos_start;
 	memcpy(rh->c_id, ls->c_id, 4);
+	rh->c_fourcc = ls->c_fourcc;
 	rh->c_size = ls->c_size;
 	rh->pad = rh->c_size & 0x1; //pad if chunk sizesize is odd
 	
@@ -230,34 +426,53 @@ void stack_pop(riff_handle *rh){
 
 /*****************************************************************************/
 //push to level stack
-void stack_push(riff_handle *rh, const char *type){
+int stack_push(riff_handle *rh, const char *type){
 	//need to enlarge stack?
 	if(rh->ls_size < rh->ls_level + 1){
 		size_t ls_size_new = rh->ls_size * 2; //double size
-		if(ls_size_new == 0)
+		if(ls_size_new < RIFF_LEVEL_ALLOC)
 			ls_size_new = RIFF_LEVEL_ALLOC; //default stack allocation
 		
-		struct riff_levelStackE *lsnew = calloc(ls_size_new, sizeof(struct riff_levelStackE));
+		//a stack on the heap is resized, the allocator may extend it in place
+		struct riff_levelStackE *lsnew = NULL;
+		if(ls_size_new <= (size_t)-1 / sizeof(struct riff_levelStackE))
+			lsnew = mem_realloc(&rh->alloc, rh->ls_heap ? rh->ls : NULL, ls_size_new * sizeof(struct riff_levelStackE));
+		if(lsnew == NULL){
+			if(rh->fp_printf)
+				rh->fp_printf("Failed to allocate level stack\n");
+			return RIFF_ERROR_MEMORY;
+		}
 		rh->ls_size = ls_size_new;
 		
-		//need to copy?
-		if(rh->ls_level > 0){
+		//inline or caller provided stack is copied once when moving to the heap
+		if(!rh->ls_heap  &&  rh->ls_level > 0){
 			memcpy(lsnew, rh->ls, rh->ls_level * sizeof(struct riff_levelStackE));
 		}
-		
-		//free old
-		if(rh->ls != NULL)
-			free(rh->ls);
 		rh->ls = lsnew;
+		rh->ls_heap = 1;
 	}
 	
 	struct riff_levelStackE *ls = rh->ls + rh->ls_level;
 	ls->c_pos_start = rh->c_pos_start;
 	memcpy(ls->c_id, rh->c_id, 4);
+	ls->c_fourcc = rh->c_fourcc;
 	ls->c_size = rh->c_size;
 	//printf("list size %d\n", (rh->ls[rh->ls_level].size));
 	memcpy(ls->c_type, type, 4);
+	ls->c_type_fourcc = convUInt32LE(type);
 	rh->ls_level++;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//initialize zeroed handle
+static void handleSetup(riff_handle *rh, const riff_allocator *alloc){
+	rh->fp_printf = riff_printf;
+	rh->fp_readChunkHeader = &readChunkHeaderLE;
+	rh->alloc = *alloc;
+	rh->ls = rh->ls_inline;
+	rh->ls_size = RIFF_LEVEL_INLINE;
 }
 
 
@@ -267,9 +482,34 @@ void stack_push(riff_handle *rh, const char *type){
 /*****************************************************************************/
 //description: see header file
 riff_handle *riff_handleAllocate(){
-	riff_handle *rh = calloc(1, sizeof(riff_handle));
-	if(rh != NULL){
-		rh->fp_printf = riff_printf;
+	return riff_handleAllocateWith(&alloc_global);
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_handle *riff_handleAllocateWith(const riff_allocator *alloc){
+	if(alloc == NULL)
+		return NULL;
+	riff_handle *rh = mem_calloc(alloc, 1, sizeof(riff_handle));
+	if(rh != NULL)
+		handleSetup(rh, alloc);
+	return rh;
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_handle *riff_handleInit(void *buf, size_t len){
+	if(buf == NULL  ||  len < sizeof(riff_handle)  ||  (uintptr_t)buf % sizeof(uint64_t) != 0)
+		return NULL;
+	riff_handle *rh = (riff_handle *)buf;
+	memset(rh, 0, sizeof(riff_handle));
+	handleSetup(rh, &alloc_global);
+	rh->storage = 1;
+	//rest of the storage as level stack if larger than the inline one
+	size_t ls_size = (len - sizeof(riff_handle)) / sizeof(struct riff_levelStackE);
+	if(ls_size > RIFF_LEVEL_INLINE){
+		rh->ls = (struct riff_levelStackE *)(rh + 1);
+		rh->ls_size = ls_size;
 	}
 	return rh;
 }
@@ -281,10 +521,161 @@ void riff_handleFree(riff_handle *rh){
 	if(rh == NULL)
 		return;
 	//free stack
-	if(rh->ls != NULL)
-		free(rh->ls);
-	//free struct
-	free(rh);
+	if(rh->ls_heap)
+		mem_free(&rh->alloc, rh->ls);
+	ds64Free(rh);
+	//free struct, with a copy of the allocator as it is part of it
+	if(!rh->storage){
+		riff_allocator alloc = rh->alloc;
+		mem_free(&alloc, rh);
+	}
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_handle *riff_handleDuplicate(const riff_handle *rh){
+	if(rh == NULL)
+		return NULL;
+	riff_handle *dup = mem_alloc(&rh->alloc, sizeof(riff_handle));
+	if(dup == NULL)
+		return NULL;
+	memcpy(dup, rh, sizeof(riff_handle));
+	//nothing owned yet, safe to free on failure
+	dup->storage = 0;
+	dup->ls_heap = 0;
+	dup->ls = dup->ls_inline;
+	dup->ls_size = RIFF_LEVEL_INLINE;
+	dup->ds64_table = NULL;
+	dup->ds64_hash = NULL;
+	dup->ds64_table_len = 0;
+	dup->ds64_hash_size = 0;
+	
+	//level stack, inline if it fits
+	if(rh->ls_level > RIFF_LEVEL_INLINE){
+		dup->ls = mem_alloc(&dup->alloc, rh->ls_size * sizeof(struct riff_levelStackE));
+		if(dup->ls == NULL){
+			riff_handleFree(dup);
+			return NULL;
+		}
+		dup->ls_size = rh->ls_size;
+		dup->ls_heap = 1;
+	}
+	if(rh->ls_level > 0)
+		memcpy(dup->ls, rh->ls, rh->ls_level * sizeof(struct riff_levelStackE));
+	
+	//ds64 table
+	if(rh->ds64_hash_size > 0){
+		dup->ds64_table = mem_alloc(&dup->alloc, (rh->ds64_table_len + 1) * sizeof(struct riff_ds64E));
+		dup->ds64_hash = mem_alloc(&dup->alloc, rh->ds64_hash_size * sizeof(uint32_t));
+		if(dup->ds64_table == NULL  ||  dup->ds64_hash == NULL){
+			riff_handleFree(dup);
+			return NULL;
+		}
+		memcpy(dup->ds64_table, rh->ds64_table, rh->ds64_table_len * sizeof(struct riff_ds64E));
+		memcpy(dup->ds64_hash, rh->ds64_hash, rh->ds64_hash_size * sizeof(uint32_t));
+		dup->ds64_table_len = rh->ds64_table_len;
+		dup->ds64_hash_size = rh->ds64_hash_size;
+	}
+	return dup;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_handleReset(riff_handle *rh){
+	if(rh == NULL)
+		return;
+	ds64Free(rh);
+	//keep stack, print function and allocator
+	struct riff_levelStackE *ls = (rh->ls == rh->ls_inline) ? NULL : rh->ls;
+	size_t ls_size = rh->ls_size;
+	uint8_t ls_heap = rh->ls_heap;
+	uint8_t storage = rh->storage;
+	int (*fp_printf)(const char * format, ... ) = rh->fp_printf;
+	riff_allocator alloc = rh->alloc;
+	
+	memset(rh, 0, sizeof(riff_handle));
+	handleSetup(rh, &alloc);
+	rh->fp_printf = fp_printf;
+	if(ls != NULL){
+		rh->ls = ls;
+		rh->ls_size = ls_size;
+	}
+	rh->ls_heap = ls_heap;
+	rh->storage = storage;
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_handlePool *riff_handlePoolAllocate(size_t max){
+	riff_handlePool *pool = mem_calloc(&alloc_global, 1, sizeof(riff_handlePool));
+	if(pool == NULL)
+		return NULL;
+	pool->alloc = alloc_global;
+	pool->max = max;
+	if(max > 0){
+		pool->handles = mem_calloc(&pool->alloc, max, sizeof(riff_handle *));
+		if(pool->handles == NULL){
+			mem_free(&pool->alloc, pool);
+			return NULL;
+		}
+	}
+	return pool;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_handlePoolFree(riff_handlePool *pool){
+	if(pool == NULL)
+		return;
+	size_t i;
+	for(i = 0; i < pool->handles_len; i++)
+		riff_handleFree(pool->handles[i]);
+	riff_allocator alloc = pool->alloc;
+	mem_free(&alloc, pool->handles);
+	mem_free(&alloc, pool);
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_handle *riff_handlePoolGet(riff_handlePool *pool){
+	if(pool == NULL)
+		return NULL;
+	if(pool->handles_len > 0)
+		return pool->handles[--pool->handles_len];
+	return riff_handleAllocateWith(&pool->alloc);
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_handlePoolPut(riff_handlePool *pool, riff_handle *rh){
+	if(rh == NULL)
+		return;
+	//handles of caller storage stay with the caller
+	if(pool == NULL  ||  pool->handles_len >= pool->max  ||  rh->storage){
+		riff_handleFree(rh);
+		return;
+	}
+	riff_handleReset(rh);
+	pool->handles[pool->handles_len++] = rh;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_setAllocator(const riff_allocator *alloc){
+	if(alloc == NULL){
+		alloc_global.fp_malloc = heapMalloc;
+		alloc_global.fp_realloc = heapRealloc;
+		alloc_global.fp_free = heapFree;
+		alloc_global.user = NULL;
+	}
+	else
+		alloc_global = *alloc;
+}
+
+/*****************************************************************************/
+//description: see header file
+const riff_allocator *riff_getAllocator(){
+	return &alloc_global;
 }
 
 /*****************************************************************************/
@@ -301,6 +692,12 @@ int riff_readHeader(riff_handle *rh){
 		return RIFF_ERROR_INVALID_HANDLE;
 	}
 	
+	ds64Free(rh); //handle may be reused
+	rh->ds64_data = 0;
+	rh->ds64_samples = 0;
+	rh->ls_level = 0;
+	rh->pos = rh->pos_start; //the header is read at the current position of the source
+	
 	size_t n = rh->fp_read(rh, buf, RIFF_HEADER_SIZE);
 	rh->pos += n;
 	
@@ -311,11 +708,20 @@ int riff_readHeader(riff_handle *rh){
 		return RIFF_ERROR_EOF; //return error code
 	}
 	memcpy(rh->h_id, buf, 4);
-	rh->h_size = convUInt32LE(buf + 4);
 	memcpy(rh->h_type, buf + 8, 4);
+	rh->h_fourcc = convUInt32LE(buf);
+	rh->h_type_fourcc = convUInt32LE(buf + 8);
 
-
-	if(memcmp(rh->h_id, "RIFF", 4) != 0 && memcmp(rh->h_id, "BW64", 4) != 0) {
+	//byte order is picked once, chunk headers are read by the matching function
+	if(rh->h_fourcc == RIFF_FOURCC_RIFF  ||  rh->h_fourcc == RIFF_FOURCC_RF64  ||  rh->h_fourcc == RIFF_FOURCC_BW64){
+		rh->h_size = convUInt32LE(buf + 4);
+		rh->fp_readChunkHeader = &readChunkHeaderLE;
+	}
+	else if(rh->h_fourcc == RIFF_FOURCC_RIFX){
+		rh->h_size = convUInt32BE(buf + 4);
+		rh->fp_readChunkHeader = &readChunkHeaderBE;
+	}
+	else {
 		if(rh->fp_printf)
 			rh->fp_printf("Invalid RIFF header\n");
 		return RIFF_ERROR_ILLID;
@@ -325,20 +731,12 @@ int riff_readHeader(riff_handle *rh){
 	if(r != RIFF_ERROR_NONE)
 		return r;
 
-	if (rh->h_size == 0xFFFFFFFF && !memcmp(rh->c_id, "ds64", 4)) {
+	if (rh->h_size == 0xFFFFFFFF && rh->c_fourcc == RIFF_FOURCC('d','s','6','4')) {
 		// It's a 64-bit sized file
-		// Specification can be found at
-		// https://www.itu.int/dms_pubrec/itu-r/rec/bs/R-REC-BS.2088-1-201910-I!!PDF-E.pdf
-		
-		// Buffer already used, so it can be reused
-		size_t r_ = riff_readInChunk(rh, buf, 8);
-		if (r_ != 8) {
-			if (rh->fp_printf) {
-				rh->fp_printf("ds64 chunk too small to contain any meaningful information.\n");
-			}
-			return RIFF_ERROR_ICSIZE;
-		}
-		rh->h_size = ((size_t)convUInt32LE(buf+4) << 32) | convUInt32LE(buf);
+		if((r = ds64Read(rh)) != RIFF_ERROR_NONE)
+			return r;
+		//back to start of ds64 chunk data like for any other first chunk
+		riff_seekInChunk(rh, 0);
 	}
 	
 	//compare with given file size
@@ -461,8 +859,12 @@ int riff_seekLevelStart(struct riff_handle *rh){
 	checkValidRiffHandle(rh);
 
 	//if in sub list level
-	if(rh->ls_level > 0)
+	if(rh->ls_level > 0){
+		//empty list, see riff_seekLevelSub()
+		if(rh->ls[rh->ls_level - 1].c_size == 4)
+			return RIFF_ERROR_EOCL;
 		rh->pos = rh->ls[rh->ls_level - 1].c_pos_start;
+	}
 	else
 		rh->pos = rh->pos_start;
 		
@@ -483,8 +885,7 @@ int riff_seekLevelStart(struct riff_handle *rh){
 int riff_seekLevelSub(riff_handle *rh){
 	checkValidRiffHandle(rh);
 
-	//according to "https://en.wikipedia.org/wiki/Resource_Interchange_File_Format" only RIFF and LIST chunk IDs can contain subchunks
-	if(memcmp(rh->c_id, "LIST", 4) != 0  && memcmp(rh->c_id, "RIFF", 4) != 0 && memcmp(rh->c_id, "BW64", 4) != 0){
+	if(!riff_chunkIsList(rh)){
 		if(rh->fp_printf)
 			rh->fp_printf("%s() failed for chunk ID \"%s\", only RIFF or LIST chunk can contain subchunks", __func__, rh->c_id);
 		return RIFF_ERROR_ILLID;
@@ -519,8 +920,13 @@ int riff_seekLevelSub(riff_handle *rh){
 	
 	//add parent chunk data to stack
 	//push
-	stack_push(rh, type);
+	int r = stack_push(rh, type);
+	if(r != RIFF_ERROR_NONE)
+		return r;
 	
+	//empty list, there is no chunk header to read
+	if(rh->c_size == 4)
+		return RIFF_ERROR_EOCL;
 	return riff_readChunkHeader(rh);
 }
 
@@ -579,37 +985,268 @@ int riff_levelValidate(struct riff_handle *rh){
 
 /*****************************************************************************/
 
-// Internal function, do not use
-int riff_recursiveLevelValidate(struct riff_handle *rh){
-	int r;
-	while (1) {
-		r = riff_seekNextChunk(rh);
-		if (r != RIFF_ERROR_NONE) {
-			if (r == RIFF_ERROR_EOCL) {
-				// End of chunk list, time to come back
-				return riff_levelParent(rh);
-			} else return r; // Otherwise, some shit occured
+//walk from the current chunk (header read, not visited yet) until the end of level "base"
+//depth first, the level stack of the handle is the only traversal stack -> no recursion
+static int walkFrom(struct riff_handle *rh, const struct riff_walker *w, int base){
+	int r, act;
+	
+	while(1){
+		act = RIFF_WALK_CONTINUE;
+		if(w != NULL  &&  w->fp_chunk != NULL)
+			act = w->fp_chunk(rh, w->user);
+		if(act == RIFF_WALK_STOP)
+			return RIFF_ERROR_NONE;
+		
+		//descend into chunk list, its first chunk is visited next
+		if(act != RIFF_WALK_SKIP  &&  riff_chunkIsList(rh)){
+			//an empty list is entered without a current chunk, left again below
+			int empty = (r = riff_seekLevelSub(rh)) == RIFF_ERROR_EOCL;
+			if(r != RIFF_ERROR_NONE  &&  !empty)
+				return r;
+			if(w != NULL  &&  w->fp_enter != NULL  &&  w->fp_enter(rh, w->user) == RIFF_WALK_STOP)
+				return RIFF_ERROR_NONE;
+			if(!empty)
+				continue;
 		}
-		if (!(memcmp(rh->c_id, "LIST", 4) != 0 && memcmp(rh->c_id, "RIFF", 4) != 0 && memcmp(rh->c_id, "BW64", 4) != 0)) { // If the chunk can contain subchunks
-			r = riff_seekLevelSub(rh);
-			if (r != RIFF_ERROR_NONE) return r;
-			r = riff_recursiveLevelValidate(rh);
-			if (r != RIFF_ERROR_NONE) return r;
+		
+		//go to next chunk, step back to parent levels as long as they are finished
+		while((r = riff_seekNextChunk(rh)) != RIFF_ERROR_NONE){
+			if(r != RIFF_ERROR_EOCL)
+				return r; //error occured, was probably printed already
+			if(rh->ls_level <= base)
+				return RIFF_ERROR_NONE; //end of the level we started in
+			if(w != NULL  &&  w->fp_leave != NULL  &&  w->fp_leave(rh, w->user) == RIFF_WALK_STOP)
+				return RIFF_ERROR_NONE;
+			riff_levelParent(rh);
 		}
 	}
-	return RIFF_ERROR_NONE;
 }
 
-int riff_fileValidate(struct riff_handle *rh){
+/*****************************************************************************/
+//description: see header file
+int riff_walk(struct riff_handle *rh, const struct riff_walker *w){
 	checkValidRiffHandle(rh);
 
 	int r;
-	//seek to start of file
-	if((r = riff_rewind(rh)) != RIFF_ERROR_NONE)
+	if((r = riff_seekLevelStart(rh)) != RIFF_ERROR_NONE)
 		return r;
+	
+	//walk ends when returning to this level
+	return walkFrom(rh, w, rh->ls_level);
+}
+
+/*****************************************************************************/
+int riff_fileValidate(struct riff_handle *rh){
+	checkValidRiffHandle(rh);
 
-	//seek all chunks
-	return riff_recursiveLevelValidate(rh);
+	//step back to level 0, the walk seeks to its start
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+
+	//seek all chunks, no callbacks needed
+	return riff_walk(rh, NULL);
+}
+
+/*****************************************************************************/
+//milliseconds from an arbitrary starting point, only differences are used
+static uint64_t msNow(){
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#else
+	return (uint64_t)clock() * 1000 / CLOCKS_PER_SEC;
+#endif
+}
+
+//budget of a single riff_validatorStep() call, passed to the walker callbacks
+struct validatorBudget {
+	struct riff_validator *v;
+	size_t io_end;    //stop before io_bytes exceeds this, 0 for unlimited
+	uint64_t ms_end;  //stop at this time, 0 for unlimited
+	int stopped;
+};
+
+//walker callback: account the chunk header, stop before visiting the chunk if the budget is used up
+//the chunk stays unvisited, so the next step continues exactly here
+static int validatorChunk(struct riff_handle *rh, void *user){
+	struct validatorBudget *b = (struct validatorBudget *)user;
+	b->v->covered = rh->c_pos_start - rh->pos_start; //everything before this chunk is validated
+	if((b->io_end > 0  &&  b->v->io_bytes >= b->io_end)  ||  (b->ms_end > 0  &&  msNow() >= b->ms_end)){
+		b->stopped = 1;
+		return RIFF_WALK_STOP;
+	}
+	b->v->io_bytes += RIFF_CHUNK_DATA_OFFSET;
+	return RIFF_WALK_CONTINUE;
+}
+
+//walker callback: account the list type ID read when entering a sub level
+static int validatorEnter(struct riff_handle *rh, void *user){
+	(void)rh;
+	((struct validatorBudget *)user)->v->io_bytes += 4;
+	return RIFF_WALK_CONTINUE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_validatorInit(struct riff_handle *rh, struct riff_validator *v){
+	checkValidRiffHandle(rh);
+	
+	memset(v, 0, sizeof(struct riff_validator));
+	v->total = rh->h_size + RIFF_CHUNK_DATA_OFFSET;
+	
+	//step back to level 0, position at first chunk
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	int r = riff_seekLevelStart(rh);
+	if(r != RIFF_ERROR_NONE){
+		v->done = 1;
+		v->result = r;
+	}
+	return r;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_validatorStep(struct riff_handle *rh, struct riff_validator *v, size_t max_io, uint32_t max_ms){
+	checkValidRiffHandle(rh);
+	if(v->done)
+		return v->result;
+	
+	struct validatorBudget b;
+	b.v = v;
+	b.io_end = (max_io > 0) ? v->io_bytes + max_io : 0;
+	b.ms_end = (max_ms > 0) ? msNow() + max_ms : 0;
+	b.stopped = 0;
+	
+	struct riff_walker w = {0};
+	w.fp_chunk = &validatorChunk;
+	w.fp_enter = &validatorEnter;
+	w.user = &b;
+	
+	int r = walkFrom(rh, &w, 0);
+	if(r == RIFF_ERROR_NONE  &&  b.stopped)
+		return RIFF_ERROR_NONE; //budget used up, more to do
+	
+	v->done = 1;
+	v->result = r;
+	if(r == RIFF_ERROR_NONE)
+		v->covered = v->total;
+	return r;
+}
+
+
+//serialized validator layout, all values LE:
+//  "RVS1", h_id, h_type, h_size (8), pos_start (8), io_bytes (8), covered (8), done (4), result (4), ls_level (4), c_pos_start (8)
+//  then per level: c_pos_start (8), c_size (8), c_id (4), c_type (4)
+#define RIFF_VALIDATOR_SER_HEADER (4 + 4 + 4 + 8 + 8 + 8 + 8 + 4 + 4 + 4 + 8)
+#define RIFF_VALIDATOR_SER_LEVEL  (8 + 8 + 4 + 4)
+
+//a chunk with size bytes of data at pos lies within [start, end], without overflowing
+static int validatorInRange(size_t pos, size_t size, size_t start, size_t end){
+	return pos >= start  &&  pos <= end  &&  end - pos >= RIFF_CHUNK_DATA_OFFSET  &&  size <= end - pos - RIFF_CHUNK_DATA_OFFSET;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_validatorSerialize(const struct riff_handle *rh, const struct riff_validator *v, void *buf, size_t size){
+	if(rh == NULL  ||  v == NULL)
+		return 0;
+	size_t need = RIFF_VALIDATOR_SER_HEADER + (size_t)rh->ls_level * RIFF_VALIDATOR_SER_LEVEL;
+	if(buf == NULL  ||  size < need)
+		return need;
+	
+	uint8_t *p = (uint8_t *)buf;
+	memcpy(p, "RVS1", 4);  p += 4;
+	memcpy(p, rh->h_id, 4);  p += 4;
+	memcpy(p, rh->h_type, 4);  p += 4;
+	writeUInt64LE(p, rh->h_size);  p += 8;
+	writeUInt64LE(p, rh->pos_start);  p += 8;
+	writeUInt64LE(p, v->io_bytes);  p += 8;
+	writeUInt64LE(p, v->covered);  p += 8;
+	writeUInt32LE(p, v->done);  p += 4;
+	writeUInt32LE(p, v->result);  p += 4;
+	writeUInt32LE(p, rh->ls_level);  p += 4;
+	writeUInt64LE(p, rh->c_pos_start);  p += 8;
+	int i;
+	for(i = 0; i < rh->ls_level; i++){
+		writeUInt64LE(p, rh->ls[i].c_pos_start);  p += 8;
+		writeUInt64LE(p, rh->ls[i].c_size);  p += 8;
+		memcpy(p, rh->ls[i].c_id, 4);  p += 4;
+		memcpy(p, rh->ls[i].c_type, 4);  p += 4;
+	}
+	return need;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_validatorRestore(struct riff_handle *rh, struct riff_validator *v, const void *buf, size_t size){
+	checkValidRiffHandle(rh);
+	
+	const uint8_t *p = (const uint8_t *)buf;
+	if(buf == NULL  ||  size < RIFF_VALIDATOR_SER_HEADER  ||  memcmp(p, "RVS1", 4) != 0){
+		if(rh->fp_printf)
+			rh->fp_printf("Invalid serialized validator state\n");
+		return RIFF_ERROR_ILLID;
+	}
+	//must be the same file as when serialized
+	if(memcmp(p + 4, rh->h_id, 4) != 0  ||  memcmp(p + 8, rh->h_type, 4) != 0  ||  convUInt64LE(p + 12) != rh->h_size  ||  convUInt64LE(p + 20) != rh->pos_start){
+		if(rh->fp_printf)
+			rh->fp_printf("Serialized validator state belongs to a different RIFF file\n");
+		return RIFF_ERROR_ILLID;
+	}
+	int level = (int)convUInt32LE(p + 52);
+	if(level < 0  ||  (size - RIFF_VALIDATOR_SER_HEADER) / RIFF_VALIDATOR_SER_LEVEL < (size_t)level){
+		if(rh->fp_printf)
+			rh->fp_printf("Serialized validator state is cut off\n");
+		return RIFF_ERROR_EOF;
+	}
+	
+	memset(v, 0, sizeof(struct riff_validator));
+	v->total = rh->h_size + RIFF_CHUNK_DATA_OFFSET;
+	v->io_bytes = convUInt64LE(p + 28);
+	v->covered = convUInt64LE(p + 36);
+	v->done = convUInt32LE(p + 44);
+	v->result = (int)convUInt32LE(p + 48);
+	size_t c_pos_start = convUInt64LE(p + 56);
+	
+	//rebuild level stack, every list must lie within the data of its parent, starting with the RIFF chunk
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	size_t start = rh->pos_start + RIFF_HEADER_SIZE;
+	size_t end = rh->pos_start + RIFF_CHUNK_DATA_OFFSET + rh->h_size;
+	p += RIFF_VALIDATOR_SER_HEADER;
+	int i;
+	for(i = 0; i < level; i++){
+		rh->c_pos_start = convUInt64LE(p);
+		rh->c_size = convUInt64LE(p + 8);
+		if(!validatorInRange(rh->c_pos_start, rh->c_size, start, end)  ||  rh->c_size < 4){
+			if(rh->fp_printf)
+				rh->fp_printf("Serialized validator state has a list outside of its parent\n");
+			return RIFF_ERROR_ICSIZE;
+		}
+		start = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + 4;
+		end = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + rh->c_size;
+		memcpy(rh->c_id, p + 16, 4);
+		rh->c_fourcc = convUInt32LE(p + 16);
+		int r = stack_push(rh, (const char *)p + 20);
+		if(r != RIFF_ERROR_NONE)
+			return r;
+		p += RIFF_VALIDATOR_SER_LEVEL;
+	}
+	if(v->done)
+		return RIFF_ERROR_NONE;
+	if(!validatorInRange(c_pos_start, 0, start, end)){
+		if(rh->fp_printf)
+			rh->fp_printf("Serialized validator state has a chunk outside of its list\n");
+		return RIFF_ERROR_ICSIZE;
+	}
+	
+	//load the chunk to be visited next
+	rh->pos = c_pos_start;
+	rh->c_pos = 0;
+	rh->fp_seek(rh, rh->pos);
+	return riff_readChunkHeader(rh);
 }
 
 /*****************************************************************************/
@@ -641,6 +1278,7 @@ int32_t riff_amountOfChunksInLevelWithID(struct riff_handle *rh, const char * id
 	checkValidRiffHandle(rh);
 
 	int32_t counter = 0;
+	uint32_t fourcc = riff_fourcc(id);
 	int r;
 	//seek to start of current list
 	if((r = riff_seekLevelStart(rh)) != RIFF_ERROR_NONE)
@@ -648,7 +1286,7 @@ int32_t riff_amountOfChunksInLevelWithID(struct riff_handle *rh, const char * id
 	
 	//seek all chunks of current list level
 	while(1){
-		if (!memcmp(rh->c_id, id, 4)) counter++;
+		if (rh->c_fourcc == fourcc) counter++;
 		r = riff_seekNextChunk(rh);
 		if(r != RIFF_ERROR_NONE){
 			if(r == RIFF_ERROR_EOCL) //just end of list
@@ -666,6 +1304,6 @@ const char *riff_errorToString(int e){
 	//map error to error string
 	//Make sure mapping is correct!
 	if (e >= 0 && e <= RIFF_ERROR_MAX) return riff_es[e];
-	else return riff_es[9];
+	else return riff_es[RIFF_ERROR_MAX + 1];
 }
 
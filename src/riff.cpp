@@ -2,24 +2,19 @@
 #define __RIFF_CPP__
 
 #include "riff.hpp"
+#include <utility>
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace RIFF {
 
 #pragma region condes
 
-void * try_calloc(size_t nmemb, size_t size, const char * const objName) {
-    int cnt = 16;
-    void * ptr = nullptr;
-    while (cnt != 0 && ptr == nullptr) {
-        ptr = calloc(nmemb, size);
-    }
-    if (ptr == nullptr) {
-        fprintf(stderr, "Could not allocate %s\n", objName);
-    }
-
-    return ptr;
-}
-
 RIFFFile::RIFFFile() {
     rh = riff_handleAllocate();
     #if !RIFF_CXX_PRINT_ERRORS
@@ -27,46 +22,16 @@ RIFFFile::RIFFFile() {
     #endif
 }
 
-// copy assignment
-RIFFFile & RIFFFile::operator = (const RIFFFile &rhs) {
-    if (&rhs == this)
-		return *this;
-
-    // Copy the riff_handle
-    auto newrh = (riff_handle *)try_calloc(1, sizeof(riff_handle), "riff_handle, aborting copy assignment of RIFFFile");
-    if (newrh == nullptr) return *this;
-    memcpy(rh, rhs.rh, sizeof(riff_handle));
-
-    if (newrh->ls) {
-        newrh->ls = (struct riff_levelStackE *)try_calloc(rh->ls_size, sizeof(struct riff_levelStackE), "riff level stack, aborting copy assignment of RIFFFile");
-        if (newrh->ls == nullptr) return *this;
-        memcpy(newrh->ls, rhs.rh->ls, rh->ls_size * sizeof(struct riff_levelStackE));
-    }
-
-    if (rh) die();
-
-    // Copy the data
-    memcpy(this, &rhs, sizeof(RIFFFile));
-    rh = newrh;
-
-    return *this;
+RIFFFile::RIFFFile(RIFFHandlePool &pool) {
+    this->pool = pool.pool;
+    rh = riff_handlePoolGet(this->pool);
+    #if !RIFF_CXX_PRINT_ERRORS
+        if (rh) rh->fp_printf = NULL;
+    #endif
 }
 
-// copy constructor
-RIFFFile::RIFFFile(const RIFFFile &rhs) {
-    // Copy the data
-    memcpy(this, &rhs, sizeof(RIFFFile));
-
-    // Copy the riff_handle
-    rh = (riff_handle *)try_calloc(1, sizeof(riff_handle), "riff_handle, aborting copy assignment of RIFFFile");
-    if (rh == nullptr) return;
-    memcpy(rh, rhs.rh, sizeof(riff_handle));
-
-    if (rh->ls) {
-        rh->ls = (struct riff_levelStackE *)try_calloc(rh->ls_size, sizeof(struct riff_levelStackE), "riff level stack, aborting copy assignment of RIFFFile");
-        if (rh->ls == nullptr) return;
-        memcpy(rh->ls, rhs.rh->ls, rh->ls_size * sizeof(struct riff_levelStackE));
-    }
+RIFFFile::RIFFFile(riff_handle *handle) {
+    rh = handle;
 }
 
 // move assignment
@@ -74,20 +39,15 @@ RIFFFile & RIFFFile::operator = (RIFFFile &&rhs) noexcept {
     if (&rhs == this)
 		return *this;
 
-    if (rh) die();
-
-    memcpy(this, &rhs, sizeof(RIFFFile));
-
-    rhs.reset();
+    die();
+    take(rhs);
 
     return *this;
 }
 
 // move constructor
 RIFFFile::RIFFFile (RIFFFile &&rhs) noexcept {
-    memcpy(this, &rhs, sizeof(RIFFFile));
-
-    rhs.reset();
+    take(rhs);
 }
 
 
@@ -96,16 +56,34 @@ RIFFFile::~RIFFFile() {
 }
 
 void RIFFFile::die() {
-    riff_handleFree(rh);
     close();
+    if (pool) riff_handlePoolPut(pool, rh);
+    else riff_handleFree(rh);
+    reset();
 }
 
 void RIFFFile::reset() {
-    // Reset the 4 internal variables
+    // Reset the internal variables, releases the shared sources
     file = nullptr;
     rh = nullptr;
     type = CLOSED;
     __latestError = RIFF_ERROR_NONE;
+    pool = nullptr;
+    cfile.reset();
+    stream.reset();
+    streamPath.clear();
+}
+
+void RIFFFile::take(RIFFFile &rhs) {
+    file = rhs.file;
+    rh = rhs.rh;
+    type = rhs.type;
+    __latestError = rhs.__latestError;
+    pool = rhs.pool;
+    cfile = std::move(rhs.cfile);
+    stream = std::move(rhs.stream);
+    streamPath = std::move(rhs.streamPath);
+    rhs.reset();
 }
 
 #pragma endregion
@@ -113,8 +91,12 @@ void RIFFFile::reset() {
 #pragma region openCfile
 
 int RIFFFile::openCFILE (const char* __filename, bool __detectSize) {
-    file = std::fopen(__filename, "rb");
-    FILE * __file = (FILE *)file;
+    close();
+    FILE * __file = std::fopen(__filename, "rb");
+    if (__file == nullptr) return __latestError = RIFF_ERROR_ACCESS;
+    // Owned by this object and its duplicates, closed with the last of them
+    cfile = std::shared_ptr<std::FILE>(__file, [](std::FILE * f) {std::fclose(f);});
+    file = __file;
     // Detect file size
     size_t __size = 0;
     if (__detectSize) {
@@ -127,16 +109,37 @@ int RIFFFile::openCFILE (const char* __filename, bool __detectSize) {
 }
 
 int RIFFFile::openCFILE (std::FILE & __file, size_t __size) {
+    close();
     file = &__file;
     type = C_FILE|MANUAL;
     return riff_open_file(rh, &__file, __size);
 }
 
+// Cursors of duplicate() read at their own position and never move the position of the shared source
+size_t seek_at(riff_handle *rh, size_t pos){
+    (void)rh;
+    return pos;
+}
+
+#if !defined(_WIN32)
+size_t read_file_at(riff_handle *rh, void *ptr, size_t size){
+    int fd = fileno((std::FILE *)rh->fh);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, (char *)ptr + done, size - done, rh->pos + done);
+        if (n <= 0) break;
+        done += n;
+    }
+    return done;
+}
+#endif
+
 #pragma endregion
 
 #pragma region openMem 
 
 int RIFFFile::openMemory (const void * __mem_ptr, size_t __size) {
+    close();
     file = nullptr;
     type = MEM_PTR;
     return riff_open_mem(rh, __mem_ptr, __size);
@@ -154,15 +157,36 @@ size_t read_fstream(riff_handle *rh, void *ptr, size_t size){
     return newg-oldg;
 }
 
+// Restores the stream position, for duplicates of a caller's std::fstream
+size_t read_fstream_at(riff_handle *rh, void *ptr, size_t size){
+    auto stream = ((std::fstream *)rh->fh);
+    auto g = stream->tellg();
+    stream->clear();
+    stream->seekg(rh->pos);
+    stream->read((char *)ptr, size);
+    size_t n = stream->gcount();
+    stream->clear();
+    stream->seekg(g);
+    return n;
+}
+
 size_t seek_fstream(riff_handle *rh, size_t pos){
     auto stream = ((std::ifstream *)rh->fh);
     stream->seekg(pos);
 	return stream->tellg();
 }
 
+size_t overwrite_fstream(riff_handle *rh, const void *ptr, size_t size){
+    auto stream = ((std::fstream *)rh->fh);
+    stream->seekp(stream->tellg());
+    stream->write((const char *)ptr, size);
+    return stream->good() ? size : 0;
+}
+
 int RIFFFile::openFstream(const char * __filename, bool __detectSize) {
     // Set type
     setAutomaticFstream();
+    streamPath = __filename;
     auto & stream = *(std::fstream*)file;
     stream.open(__filename, std::ios_base::in|std::ios_base::binary);
     return openFstreamCommon(detectFstreamSize(__detectSize));
@@ -171,6 +195,7 @@ int RIFFFile::openFstream(const char * __filename, bool __detectSize) {
 int RIFFFile::openFstream(const std::string & __filename, bool __detectSize) {
     // Set type
     setAutomaticFstream();
+    streamPath = __filename;
     auto & stream = *(std::fstream*)file;
     stream.open(__filename, std::ios_base::in|std::ios_base::binary);
     return openFstreamCommon(detectFstreamSize(__detectSize));
@@ -180,6 +205,7 @@ int RIFFFile::openFstream(const std::string & __filename, bool __detectSize) {
 int RIFFFile::openFstream(const std::filesystem::path & __filename, bool __detectSize) {
     // Set type
     setAutomaticFstream();
+    streamPath = __filename;
     auto & stream = *(std::fstream*)file;
     stream.open(__filename, std::ios_base::in|std::ios_base::binary);
     return openFstreamCommon(detectFstreamSize(__detectSize));
@@ -197,11 +223,16 @@ size_t RIFFFile::detectFstreamSize(bool __detectSize) {
 }
 
 void RIFFFile::setAutomaticFstream(){
+    close();
     type = FSTREAM;
-    file = new std::fstream;
+    // Reuse the stream of the previous file
+    if (stream) stream->clear();
+    else stream = std::unique_ptr<std::fstream>(new std::fstream());
+    file = stream.get();
 }
 
 int RIFFFile::openFstream(std::fstream & __file, size_t __size){
+    close();
     type = FSTREAM|MANUAL;
     file = &__file;
     return openFstreamCommon(__size);
@@ -218,6 +249,7 @@ int RIFFFile::openFstreamCommon(size_t __size){
 	
 	rh->fp_read = &read_fstream;
 	rh->fp_seek = &seek_fstream;
+	rh->fp_write = &overwrite_fstream;
 	
 	return riff_readHeader(rh);
 }
@@ -225,18 +257,67 @@ int RIFFFile::openFstreamCommon(size_t __size){
 #pragma endregion
 
 void RIFFFile::close () {
-    if (!(type & MANUAL)) { // Must be automatically allocated to close
-        if (type == C_FILE) {
-            std::fclose((std::FILE *)file);
-            free (file);
-        } else if (type == FSTREAM) {
-            ((std::fstream *)file)->close();
-            free (file);
-        }
+    // Only automatically opened files are owned, see cfile and stream
+    if (type == C_FILE) {
+        cfile.reset();  // closes the file if no duplicate reads from it
+    } else if (type == FSTREAM) {
+        stream->close();    // kept for reuse
     }
     type = CLOSED;
 }
 
+RIFFFile RIFFFile::duplicate () {
+    RIFFFile out(riff_handleDuplicate(rh));
+    if (out.rh == nullptr) {
+        out.__latestError = RIFF_ERROR_MEMORY;
+        return out;
+    }
+    out.file = file;
+    out.type = type;
+
+    // Only the new cursor gets its own reader, this object keeps its I/O functions
+    if ((type & ~MANUAL) == C_FILE) {
+#if defined(_WIN32)
+        // Reopened, a positional ReadFile() would move the shared file pointer
+        HANDLE h = ReOpenFile((HANDLE)_get_osfhandle(_fileno((std::FILE *)file)), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, 0);
+        int fd = (h != INVALID_HANDLE_VALUE) ? _open_osfhandle((intptr_t)h, _O_RDONLY|_O_BINARY) : -1;
+        std::FILE *f = (fd != -1) ? _fdopen(fd, "rb") : nullptr;
+        if (f == nullptr) {
+            if (fd != -1) _close(fd);
+            else if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+            out.__latestError = RIFF_ERROR_ACCESS;
+            return out;
+        }
+        out.cfile = std::shared_ptr<std::FILE>(f, [](std::FILE * f) {std::fclose(f);});
+        out.file = f;
+        out.type = C_FILE;
+        out.rh->fh = f;
+        out.rh->fp_seek(out.rh, out.rh->pos);
+#else
+        // pread() leaves the position of the shared FILE alone
+        out.cfile = cfile;
+        out.rh->fp_read = &read_file_at;
+        out.rh->fp_seek = &seek_at;
+#endif
+    } else if (type == FSTREAM) {
+        // Reopened by name, with its own stream position
+        out.type = CLOSED;
+        out.setAutomaticFstream();
+        out.streamPath = streamPath;
+        out.stream->open(streamPath, std::ios_base::in|std::ios_base::binary);
+        if (!out.stream->is_open()) {
+            out.__latestError = RIFF_ERROR_ACCESS;
+            return out;
+        }
+        out.rh->fh = out.file;
+        out.stream->seekg(out.rh->pos);
+    } else if (type == (FSTREAM|MANUAL)) {
+        out.rh->fp_read = &read_fstream_at;
+        out.rh->fp_seek = &seek_at;
+    }
+    return out;
+}
+
 std::string RIFFFile::latestErrorToString () {
     #define posStrSize 1+2+1+3+1+2+(2*sizeof(size_t))+1
 
@@ -253,24 +334,313 @@ std::string RIFFFile::latestErrorToString () {
 }
 
 std::vector<uint8_t> RIFFFile::readChunkData() {
-    __latestError = seekChunkStart(); 
-    if (__latestError || rh->c_size == 0) {
-        return std::vector<uint8_t>(0);
-    }
-    auto outVec = std::vector<uint8_t>(rh->c_size);
+    std::vector<uint8_t> outVec;
+    readChunkData(outVec);
+    return outVec;
+}
+
+size_t RIFFFile::readChunkData(void * __to, size_t __size) {
+    __latestError = riff_seekChunkStart(rh);
+    if (__latestError) return 0;
+    if (__size > rh->c_size) __size = rh->c_size;
+    // readInChunk may return less than requested, read the remainder
     size_t totalSize = 0, succSize;
     do {
-        succSize = readInChunk(outVec.data()+totalSize, rh->c_size);
+        succSize = riff_readInChunk(rh, (uint8_t *)__to + totalSize, __size - totalSize);
         totalSize += succSize;
-    } while (succSize != 0);
+    } while (succSize != 0 && totalSize < __size);
+    if (totalSize != __size) {
+        __latestError = RIFF_ERROR_EOF;
 #if RIFF_CXX_PRINT_ERRORS
-    if (totalSize != rh->c_size && rh->fp_printf) {
-        rh->fp_printf("Couldn't read the entire chunk for some reason. Successfully read %zu bytes out of %zu\n", totalSize, rh->c_size);
-    } 
+        if (rh->fp_printf)
+            rh->fp_printf("Couldn't read the entire chunk for some reason. Successfully read %zu bytes out of %zu\n", totalSize, __size);
 #endif
+    }
+    return totalSize;
+}
+
+std::vector<uint8_t> RIFFFile::validatorSerialize(const riff_validator & v) {
+    auto outVec = std::vector<uint8_t>(riff_validatorSerialize(rh, &v, nullptr, 0));
+    riff_validatorSerialize(rh, &v, outVec.data(), outVec.size());
     return outVec;
 }
 
+#pragma region writer
+
+RIFFWriter::RIFFWriter() {
+    rw = riff_writerAllocate();
+    #if !RIFF_CXX_PRINT_ERRORS
+        if (rw) rw->fp_printf = NULL;
+    #endif
+}
+
+// move assignment
+RIFFWriter & RIFFWriter::operator = (RIFFWriter &&rhs) noexcept {
+    if (&rhs == this)
+		return *this;
+
+    if (rw) die();
+    take(rhs);
+
+    return *this;
+}
+
+// move constructor
+RIFFWriter::RIFFWriter (RIFFWriter &&rhs) noexcept {
+    take(rhs);
+}
+
+RIFFWriter::~RIFFWriter() {
+    die();
+}
+
+void RIFFWriter::die() {
+    close();
+    riff_writerFree(rw);
+}
+
+void RIFFWriter::take(RIFFWriter &rhs) {
+    file = std::exchange(rhs.file, nullptr);
+    rw = std::exchange(rhs.rw, nullptr);
+    type = std::exchange(rhs.type, CLOSED);
+    __latestError = std::exchange(rhs.__latestError, RIFF_ERROR_NONE);
+    stream = std::move(rhs.stream);
+}
+
+int RIFFWriter::openCFILE (const char * __filename, const char * __type) {
+    close();
+    file = std::fopen(__filename, "wb");
+    if (file == nullptr) return __latestError = RIFF_ERROR_ACCESS;
+    type = C_FILE;
+    return __latestError = riff_writer_open_file(rw, (std::FILE *)file, __type);
+}
+
+int RIFFWriter::openCFILE (std::FILE & __file, const char * __type) {
+    close();
+    file = &__file;
+    type = C_FILE|MANUAL;
+    return __latestError = riff_writer_open_file(rw, &__file, __type);
+}
+
+size_t write_fstream(riff_writer *rw, const void *ptr, size_t size){
+    auto stream = ((std::fstream *)rw->fh);
+    stream->write((const char *)ptr, size);
+    return stream->good() ? size : 0;
+}
+
+size_t seek_fstream_writer(riff_writer *rw, size_t pos){
+    auto stream = ((std::fstream *)rw->fh);
+    stream->seekp(pos);
+    return stream->tellp();
+}
+
+// std::fstream has no way to reach stable storage, so the durable policy is not honoured and every sync is a flush
+int sync_fstream(riff_writer *rw, int durable){
+    (void)durable;
+    auto stream = ((std::fstream *)rw->fh);
+    stream->flush();
+    return stream->good() ? 0 : -1;
+}
+
+int RIFFWriter::openFstream(const char * __filename, const char * __type) {
+    close();
+    std::unique_ptr<std::fstream> s(new std::fstream);
+    s->open(__filename, std::ios_base::out|std::ios_base::trunc|std::ios_base::binary);
+    if (!s->is_open()) return __latestError = RIFF_ERROR_ACCESS;
+    stream = std::move(s);
+    type = FSTREAM;
+    file = stream.get();
+    return openFstreamCommon(__type);
+}
+
+#if RIFF_CXX17_SUPPORT
+int RIFFWriter::openFstream(const std::filesystem::path & __filename, const char * __type) {
+    close();
+    std::unique_ptr<std::fstream> s(new std::fstream);
+    s->open(__filename, std::ios_base::out|std::ios_base::trunc|std::ios_base::binary);
+    if (!s->is_open()) return __latestError = RIFF_ERROR_ACCESS;
+    stream = std::move(s);
+    type = FSTREAM;
+    file = stream.get();
+    return openFstreamCommon(__type);
+}
+#endif
+
+int RIFFWriter::openFstream(std::fstream & __file, const char * __type) {
+    close();
+    if (!__file.is_open()) return __latestError = RIFF_ERROR_ACCESS;
+    type = FSTREAM|MANUAL;
+    file = &__file;
+    return openFstreamCommon(__type);
+}
+
+int RIFFWriter::openFstreamCommon(const char * __type) {
+    auto stream = (std::fstream*)file;
+    if(rw == NULL)
+        return __latestError = RIFF_ERROR_INVALID_HANDLE;
+    rw->fh = file;
+    rw->pos_start = stream->tellp(); //current file offset of stream considered as start of RIFF file
+
+    rw->fp_write = &write_fstream;
+    rw->fp_seek = &seek_fstream_writer;
+    rw->fp_sync = &sync_fstream;
+
+    return __latestError = riff_writerBegin(rw, __type);
+}
+
+int RIFFWriter::close () {
+    if (type == CLOSED) return RIFF_ERROR_NONE;
+    __latestError = riff_writerClose(rw);
+    if (!(type & MANUAL)) { // Must be automatically allocated to close
+        if (type == C_FILE) {
+            std::fclose((std::FILE *)file);
+        } else if (type == FSTREAM) {
+            stream.reset();     // closes the file
+        }
+    }
+    // the writer must not keep pointing at the closed stream
+    if (rw) {
+        rw->fh = NULL;
+        rw->fp_write = NULL;
+        rw->fp_seek = NULL;
+        rw->fp_sync = NULL;
+    }
+    file = nullptr;
+    type = CLOSED;
+    return __latestError;
+}
+
+#pragma endregion
+
+#pragma region mpwriter
+
+RIFFMPWriter::RIFFMPWriter() {
+    mw = riff_mpWriterAllocate();
+}
+
+RIFFMPWriter::RIFFMPWriter (RIFFMPWriter &&rhs) noexcept {
+    mw = rhs.mw;
+    rhs.mw = nullptr;
+}
+
+RIFFMPWriter & RIFFMPWriter::operator = (RIFFMPWriter &&rhs) noexcept {
+    if (&rhs == this)
+        return *this;
+
+    riff_mpWriterFree(mw);
+    mw = rhs.mw;
+    rhs.mw = nullptr;
+
+    return *this;
+}
+
+RIFFMPWriter::~RIFFMPWriter() {
+    riff_mpWriterFree(mw);
+}
+
+int RIFFMPWriter::begin (RIFFWriter & __writer, size_t __slots) {
+    mw->slots_size = __slots;
+    return riff_mpWriterBegin(mw, __writer.rw);
+}
+
+int RIFFMPWriter::writeChunk (const char * __id, const void * __ptr, size_t __size, uint32_t __flags) {
+    uint64_t __seq;
+    int __r;
+    if ((__r = riff_mpWriterReserve(mw, __id, __size, __flags, &__seq)) != RIFF_ERROR_NONE)
+        return __r;
+    __r = riff_mpWriterWrite(mw, __seq, 0, __ptr, __size);
+    // commit even after a failed write, otherwise end() waits forever
+    int __rc = riff_mpWriterCommit(mw, __seq);
+    return (__r != RIFF_ERROR_NONE) ? __r : __rc;
+}
+
+#pragma endregion
+
+#pragma region handlePool
+
+RIFFHandlePool::RIFFHandlePool(size_t max) {
+    pool = riff_handlePoolAllocate(max);
+}
+
+RIFFHandlePool::~RIFFHandlePool() {
+    riff_handlePoolFree(pool);
+}
+
+#pragma endregion
+
+#pragma region avidemux
+
+RIFFAVIDemux::RIFFAVIDemux() {
+    dm = riff_aviDemuxAllocate();
+}
+
+RIFFAVIDemux::RIFFAVIDemux (RIFFAVIDemux &&rhs) noexcept {
+    dm = rhs.dm;
+    rhs.dm = nullptr;
+}
+
+RIFFAVIDemux & RIFFAVIDemux::operator = (RIFFAVIDemux &&rhs) noexcept {
+    if (&rhs == this)
+        return *this;
+
+    riff_aviDemuxFree(dm);
+    dm = rhs.dm;
+    rhs.dm = nullptr;
+
+    return *this;
+}
+
+RIFFAVIDemux::~RIFFAVIDemux() {
+    riff_aviDemuxFree(dm);
+}
+
+int RIFFAVIDemux::begin (RIFFFile & __file, const riff_avi & __avi, size_t __queueBytes) {
+    dm->queue_bytes = __queueBytes;
+    return riff_aviDemuxBegin(dm, __file.rh, &__avi);
+}
+
+#pragma endregion
+
+#pragma region edit
+
+int RIFFFile::replaceChunk (const void * __data, size_t __size, RIFFWriter * __fallback, int * __path) {
+    return __latestError = riff_editReplaceChunk(rh, __data, __size, __fallback ? __fallback->rw : nullptr, __path);
+}
+
+int RIFFFile::copyFile (RIFFWriter & __writer) {
+    return __latestError = riff_editCopyFile(rh, __writer.rw);
+}
+
+int RIFFFile::applyEdits (RIFFEditScript & __script, RIFFWriter & __writer) {
+    return __latestError = riff_editApply(rh, __script.es, __writer.rw);
+}
+
+RIFFEditScript::RIFFEditScript() {
+    es = riff_editScriptAllocate();
+}
+
+RIFFEditScript::RIFFEditScript (RIFFEditScript &&rhs) noexcept {
+    es = rhs.es;
+    rhs.es = nullptr;
+}
+
+RIFFEditScript & RIFFEditScript::operator = (RIFFEditScript &&rhs) noexcept {
+    if (&rhs == this)
+        return *this;
+
+    riff_editScriptFree(es);
+    es = rhs.es;
+    rhs.es = nullptr;
+
+    return *this;
+}
+
+RIFFEditScript::~RIFFEditScript() {
+    riff_editScriptFree(es);
+}
+
+#pragma endregion
+
 }   // namespace RIFF
 
 #endif  // __RIFF_CPP__
\ No newline at end of file
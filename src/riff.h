@@ -8,6 +8,7 @@ License: zlib (https://opensource.org/licenses/Zlib)
 To read any RIFF files.
 Not specialized to specific types like AVI or WAV.
 Special chunks (e.g. "LIST") can contain a nested sub list of chunks
+Also reads the variants "RIFX" (big endian sizes) and "RF64"/"BW64" (64 bit sizes in the "ds64" chunk)
 
 
 Example structure of RIFF file:
@@ -53,6 +54,40 @@ Due to the size fields being 4 bytes, this library may not work for RIFF files l
  */
 #define	RIFF_CHUNK_DATA_OFFSET	8
 
+/**
+ * @defgroup FOURCC FOURCC values
+ * 
+ * Chunk IDs as 32 bit integers for comparing with a single instruction, e.g. `rh->c_fourcc == RIFF_FOURCC('f','m','t',' ')`.
+ * @{
+ */
+/**
+ * @brief FOURCC of 4 characters, in file order from the lowest byte on.
+ * 
+ * Equals the ID bytes read as little endian value, independent of the byte order of the host and of the file.
+ */
+#define RIFF_FOURCC(a, b, c, d)	((uint32_t)(uint8_t)(a) | ((uint32_t)(uint8_t)(b) << 8) | ((uint32_t)(uint8_t)(c) << 16) | ((uint32_t)(uint8_t)(d) << 24))
+/**
+ * @brief `"RIFF"`
+ */
+#define RIFF_FOURCC_RIFF	RIFF_FOURCC('R','I','F','F')
+/**
+ * @brief `"RIFX"`
+ */
+#define RIFF_FOURCC_RIFX	RIFF_FOURCC('R','I','F','X')
+/**
+ * @brief `"RF64"`
+ */
+#define RIFF_FOURCC_RF64	RIFF_FOURCC('R','F','6','4')
+/**
+ * @brief `"BW64"`
+ */
+#define RIFF_FOURCC_BW64	RIFF_FOURCC('B','W','6','4')
+/**
+ * @brief `"LIST"`
+ */
+#define RIFF_FOURCC_LIST	RIFF_FOURCC('L','I','S','T')
+///@}
+
 /**
  * @defgroup Errors Error codes
  * 
@@ -136,15 +171,32 @@ Due to the size fields being 4 bytes, this library may not work for RIFF files l
  */
 #define RIFF_ERROR_INVALID_HANDLE	8
 
+/**
+ * @brief Memory allocation failed.
+ */
+#define RIFF_ERROR_MEMORY	9
+
 ///@}
 
 /**
  * @brief The last RIFF_ERROR code.
  */
-#define RIFF_ERROR_MAX 8
+#define RIFF_ERROR_MAX 9
 
 ///@}
 
+/**
+ * @brief Amount of level stack entries inside of the riff_handle.
+ * 
+ * Most files nest less deep, deeper nesting moves the level stack to the heap (or to the storage given to riff_handleInit()).
+ */
+#define RIFF_LEVEL_INLINE	4
+
+/**
+ * @brief Size of the storage for riff_handleInit() with room for a level stack of the given depth.
+ */
+#define RIFF_HANDLE_STORAGE(levels)	(sizeof(riff_handle) + (levels) * sizeof(struct riff_levelStackE))
+
 /**
  * @brief Level stack entry struct.
  *
@@ -175,6 +227,155 @@ struct riff_levelStackE {
 	 * Should either be RIFF, LIST or BW64.
 	 */
 	char c_type[5];
+	/**
+	 * @brief riff_levelStackE::c_id as FOURCC value.
+	 */
+	uint32_t c_fourcc;
+	/**
+	 * @brief riff_levelStackE::c_type as FOURCC value.
+	 */
+	uint32_t c_type_fourcc;
+};
+
+/**
+ * @defgroup Walker Tree walker
+ * 
+ * Callback interface for riff_walk().
+ * @{
+ */
+
+/**
+ * @name Walker callback return values
+ * @{
+ */
+
+/**
+ * @brief Continue the walk.
+ */
+#define RIFF_WALK_CONTINUE	0
+/**
+ * @brief Do not descend into the current chunk list.
+ * 
+ * Only meaningful as return value of riff_walker::fp_chunk, treated like ::RIFF_WALK_CONTINUE otherwise.
+ */
+#define RIFF_WALK_SKIP		1
+/**
+ * @brief Stop the walk, the riff_handle stays positioned where the callback was called.
+ */
+#define RIFF_WALK_STOP		2
+
+///@}
+
+struct riff_handle;
+
+/**
+ * @brief Tree walker callbacks.
+ * 
+ * Every callback is optional (can be NULL) and gets the riff_handle positioned as described, as well as riff_walker::user.
+ * 
+ * Callbacks may read and seek inside of the current chunk, but must not change the level or seek to other chunks.
+ */
+struct riff_walker {
+	/**
+	 * @brief Called for every chunk, including chunk lists.
+	 * 
+	 * The riff_handle is at the current chunk, the chunk header has been read already.
+	 * 
+	 * Return ::RIFF_WALK_SKIP to not descend into a chunk list.
+	 */
+	int (*fp_chunk)(struct riff_handle *rh, void *user);
+	/**
+	 * @brief Called after entering a sub level.
+	 * 
+	 * The parent chunk list is at `ls[ls_level-1]`, the riff_handle is at the first chunk of the sub level, fp_chunk() is called for it afterwards.
+	 * For an empty chunk list the riff_handle is still at the chunk list, fp_leave() follows directly.
+	 */
+	int (*fp_enter)(struct riff_handle *rh, void *user);
+	/**
+	 * @brief Called after the last chunk of a sub level, before stepping back to the parent level.
+	 */
+	int (*fp_leave)(struct riff_handle *rh, void *user);
+	/**
+	 * @brief User pointer passed to every callback.
+	 */
+	void *user;
+};
+
+///@}
+
+/**
+ * @brief Resumable validator state.
+ * 
+ * Validates the same way as riff_fileValidate(), but in slices via riff_validatorStep().
+ * 
+ * The position inside the file is kept in the riff_handle (current chunk and level stack), riff_validatorSerialize() and riff_validatorRestore() save and load it together with this struct.
+ * 
+ * Members are public and intended for read access.
+ */
+struct riff_validator {
+	/**
+	 * @brief Bytes covered by the validation so far.
+	 * 
+	 * Everything from the start of the RIFF file up to this offset is validated.
+	 */
+	size_t covered;
+	/**
+	 * @brief Total size of the RIFF file, riff_handle::h_size + 8.
+	 */
+	size_t total;
+	/**
+	 * @brief Bytes of chunk headers read so far.
+	 */
+	size_t io_bytes;
+	/**
+	 * @brief 1 if the validation is finished, 0 otherwise.
+	 */
+	int done;
+	/**
+	 * @brief RIFF error code of the validation, valid once riff_validator::done is set.
+	 */
+	int result;
+};
+
+/**
+ * @brief Memory allocator, used for every allocation of the library.
+ * 
+ * All function pointers are required. They get riff_allocator::user as first argument.\n 
+ * The default allocator maps to `malloc()`, `realloc()` and `free()`.
+ */
+typedef struct riff_allocator {
+	/**
+	 * @brief Allocate size bytes, aligned for any type, NULL on failure.
+	 */
+	void *(*fp_malloc)(void *user, size_t size);
+	/**
+	 * @brief Resize an allocation, keeping its content, NULL on failure (ptr stays valid then).
+	 * 
+	 * ptr is never NULL, new allocations use fp_malloc.
+	 */
+	void *(*fp_realloc)(void *user, void *ptr, size_t size);
+	/**
+	 * @brief Free an allocation, ptr is never NULL.
+	 */
+	void (*fp_free)(void *user, void *ptr);
+	/**
+	 * @brief User pointer passed to every function, e.g. an arena.
+	 */
+	void *user;
+} riff_allocator;
+
+/**
+ * @brief ds64 table entry, 64 bit size of chunks with the 32 bit size field set to `0xFFFFFFFF`.
+ */
+struct riff_ds64E {
+	/**
+	 * @brief ID of chunk.
+	 */
+	char c_id[5];
+	/**
+	 * @brief 64 bit chunk size.
+	 */
+	uint64_t c_size;
 };
 
 /**
@@ -192,6 +393,62 @@ struct riff_levelStackE {
  * @todo Rename riff_handle struct to _riff_handle (2.0)
  */
 typedef struct riff_handle {
+	/**
+	 * @name Cursor
+	 * 
+	 * Fields of every step when walking chunk headers, first in the struct to share one cache line (64 bytes, on 64 bit hosts) if the handle is aligned accordingly, e.g. in storage of riff_handleInit().
+	 */
+	///@{
+	/**
+	 * @brief Absolute start position of current chunk.
+	 */
+	size_t c_pos_start;
+	/**
+	 * @brief Position in current chunk.
+	 * 
+	 * Relative to the start of the chunk's data block.
+	 */
+	size_t c_pos;
+	/**
+	 * @brief Size of current chunk.
+	 * 
+	 * Excludes chunk header - same value as stored in RIFF file.
+	 */
+	size_t c_size;
+	/**
+	 * @brief Current position in data stream.
+	 */
+	size_t pos;
+	/**
+	 * @brief Level stack pointer.
+	 * 
+	 * Resizes dynamically.
+	 * 
+	 * To access the parent chunk data use `ls[ls_level-1]`.
+	 */
+	struct riff_levelStackE *ls;
+	/**
+	 * @brief ID of current chunk as FOURCC value, see riff_handle::c_id and RIFF_FOURCC().
+	 */
+	uint32_t c_fourcc;
+	/**
+	 * @brief Current stack level.
+	 * 
+	 * Starts at 0.
+	 */
+	int ls_level;
+	/**
+	 * @brief Pad byte.
+	 * 
+	 * 1 if c_size is odd, else 0 (indicates unused extra byte at end of chunk).
+	 */
+	uint8_t pad;
+	/**
+	 * @brief Start position of RIFF file.
+	 */
+	size_t pos_start;
+	///@}
+
 	/**
 	 * @name RIFF file header info.
 	 * 
@@ -199,7 +456,7 @@ typedef struct riff_handle {
 	 */
 	///@{
 	/**
-	 * @brief Header ID, should be `"RIFF"`.
+	 * @brief Header ID, should be `"RIFF"`, `"RIFX"` (big endian sizes), `"RF64"` or `"BW64"` (64 bit sizes).
 	 * 
 	 * Contains terminator to be printable.
 	 */
@@ -219,9 +476,13 @@ typedef struct riff_handle {
 	 */
 	char h_type[5];
 	/**
-	 * @brief Start position of RIFF file.
+	 * @brief riff_handle::h_id as FOURCC value.
 	 */
-	size_t pos_start;
+	uint32_t h_fourcc;
+	/**
+	 * @brief riff_handle::h_type as FOURCC value.
+	 */
+	uint32_t h_type_fourcc;
 	///@}
 
 	/**
@@ -230,69 +491,78 @@ typedef struct riff_handle {
 	 * 0 means unspecified.
 	 */
 	size_t size;
-	/**
-	 * @brief Current position in data stream.
-	 */
-	size_t pos;
 	
 	/**
 	 * @name Current chunk's data.
 	 */
 	///@{
-	/**
-	 * @brief Absolute start position of current chunk.
-	 */
-	size_t c_pos_start;
-	/**
-	 * @brief Position in current chunk.
-	 * 
-	 * Relative to the start of the chunk's data block.
-	 */
-	size_t c_pos;
 	/**
 	 * @brief ID of current chunk.
 	 * 
 	 * Contains terminator to be printable.
 	 */
 	char c_id[5];
+	///@}
+
 	/**
-	 * @brief Size of current chunk.
-	 * 
-	 * Excludes chunk header - same value as stored in RIFF file.
+	 * @name Level stack data.
 	 */
-	size_t c_size;
+	///@{
 	/**
-	 * @brief Pad byte.
+	 * @brief Size of stack in entries, see riff_handle::ls.
 	 * 
-	 * 1 if c_size is odd, else 0 (indicates unused extra byte at end of chunk).
+	 * Stack extends automatically if needed.
 	 */
-	uint8_t pad;
+	size_t ls_size;
+	/**
+	 * @brief Inline level stack, riff_handle::ls points here until the nesting gets deeper than ::RIFF_LEVEL_INLINE.
+	 */
+	struct riff_levelStackE ls_inline[RIFF_LEVEL_INLINE];
+	/**
+	 * @brief 1 if riff_handle::ls is allocated with riff_handle::alloc, 0 if it is riff_handle::ls_inline or storage of riff_handleInit().
+	 */
+	uint8_t ls_heap;
+	/**
+	 * @brief 1 if the handle is in caller provided storage (riff_handleInit()), riff_handleFree() does not free it then.
+	 */
+	uint8_t storage;
 	///@}
-
+	
 	/**
-	 * @name Level stack data.
+	 * @name 64 bit size data.
+	 * 
+	 * Parsed from the "ds64" chunk of BW64/RF64 files when opening.
+	 * Chunks whose 32 bit size field is `0xFFFFFFFF` get their size from here when their header is read.
 	 */
 	///@{
 	/**
-	 * @brief Level stack pointer.
-	 * 
-	 * Resizes dynamically.
-	 * 
-	 * To access the parent chunk data use `ls[ls_level-1]`.
+	 * @brief 1 if a ds64 chunk was found.
 	 */
-	struct riff_levelStackE *ls;
+	int ds64;
 	/**
-	 * @brief Size of stack in entries.
-	 * 
-	 * Stack extends automatically if needed.
+	 * @brief Size of the "data" chunk.
 	 */
-	size_t ls_size;
+	uint64_t ds64_data;
 	/**
-	 * @brief Current stack level.
-	 * 
-	 * Starts at 0.
+	 * @brief Sample count.
 	 */
-	int ls_level;
+	uint64_t ds64_samples;
+	/**
+	 * @brief Sizes of other chunks.
+	 */
+	struct riff_ds64E *ds64_table;
+	/**
+	 * @brief Amount of ds64 table entries.
+	 */
+	size_t ds64_table_len;
+	/**
+	 * @brief Hash of table indices by chunk ID for constant time lookup, 0 is empty, else index + 1.
+	 */
+	uint32_t *ds64_hash;
+	/**
+	 * @brief Amount of hash buckets, power of 2.
+	 */
+	size_t ds64_hash_size;
 	///@}
 	
 	/**
@@ -326,6 +596,15 @@ typedef struct riff_handle {
 	 */
 	size_t (*fp_seek)(struct riff_handle *rh, size_t pos);
 	
+	/**
+	 * @brief Write bytes at the current position.
+	 * 
+	 * Only used for in-place editing (see riff_edit.h), can be NULL for read-only sources.
+	 * 
+	 * @return Amount of successfully written bytes.
+	 */
+	size_t (*fp_write)(struct riff_handle *rh, const void *ptr, size_t size);
+	
 	/**
 	 * @brief Print error.
 	 * 
@@ -335,10 +614,53 @@ typedef struct riff_handle {
 	 */
 	int (*fp_printf)(const char * format, ... );
 
+	/**
+	 * @brief Read the header of the chunk at the current position.
+	 * 
+	 * Set by riff_readHeader() to the reader for the byte order of the file, little endian for `"RIFF"`, `"RF64"` and `"BW64"`, big endian for `"RIFX"`.\n 
+	 * The byte order is thus picked once per file instead of per chunk.
+	 * 
+	 * @return RIFF error code.
+	 */
+	int (*fp_readChunkHeader)(struct riff_handle *rh);
+
 	///@}
 	
+	/**
+	 * @brief Allocator of the handle, its level stack and ds64 table, and of structures built from the handle (e.g. riff_avi, riff_meta).
+	 * 
+	 * Copied from the global allocator by riff_handleAllocate() or from the argument of riff_handleAllocateWith().\n 
+	 * Must not be modified, the handle itself is freed with it.
+	 */
+	riff_allocator alloc;
+	
 } riff_handle;
 
+/**
+ * @brief Pool of reset handles for opening many files in a row.
+ * 
+ * Handles returned to the pool keep their level stack, so a warm pool opens files without allocating.\n 
+ * Not thread safe, use one pool per thread.
+ */
+typedef struct riff_handlePool {
+	/**
+	 * @brief Idle handles, ready to be taken.
+	 */
+	riff_handle **handles;
+	/**
+	 * @brief Amount of idle handles.
+	 */
+	size_t handles_len;
+	/**
+	 * @brief Maximum amount of idle handles, further returned handles are freed.
+	 */
+	size_t max;
+	/**
+	 * @brief Allocator of the pool and its handles, copied from the global allocator by riff_handlePoolAllocate().
+	 */
+	riff_allocator alloc;
+} riff_handlePool;
+
 ///@}
 
 /**
@@ -355,13 +677,162 @@ typedef struct riff_handle {
  * @return Pointer to the intialized riff_handle.
  */
 riff_handle *riff_handleAllocate();
+/**
+ * @brief Allocate, initialize and return a riff_handle using an allocator.
+ * 
+ * Every allocation made through the handle uses the allocator, see riff_handle::alloc.
+ * 
+ * @param alloc The allocator, copied.
+ * 
+ * @return Pointer to the intialized riff_handle, NULL if allocation failed.
+ */
+riff_handle *riff_handleAllocateWith(const riff_allocator *alloc);
+/**
+ * @brief Initialize a riff_handle in caller provided storage, without allocation.
+ * 
+ * Storage beyond the riff_handle is used as level stack, if it has room for more than ::RIFF_LEVEL_INLINE entries, see ::RIFF_HANDLE_STORAGE().
+ * Opening and traversing a file within that nesting depth allocates nothing (except for the ds64 table of RF64/BW64 files).
+ * Deeper nesting moves the level stack to the heap of the global allocator.
+ * 
+ * @param buf The storage, aligned for `uint64_t`, e.g. a local array of `uint64_t`.
+ * @param len Size of the storage in bytes, at least `sizeof(riff_handle)`.
+ * 
+ * @return Pointer to the intialized riff_handle (at @p buf), NULL if the storage is too small or not aligned.
+ * 
+ * @note Call riff_handleFree() afterwards as for allocated handles, it frees what the handle allocated but not the storage.
+ */
+riff_handle *riff_handleInit(void *buf, size_t len);
 /**
  * @brief Free the memory allocated to a riff_handle.
  * 
+ * For handles of riff_handleInit() the storage itself is not freed.
+ * 
  * @param rh The riff_handle to free.
  */
 void riff_handleFree(riff_handle *rh);
+/**
+ * @brief Duplicate a riff_handle, a second cursor on the same data source.
+ * 
+ * The copy is at the same position with its own level stack and ds64 table, allocated with the allocator of @p rh.
+ * For typical nesting depths (up to ::RIFF_LEVEL_INLINE) only the handle itself is allocated.
+ * 
+ * The data source (riff_handle::fh) and I/O functions are shared.
+ * Memory sources can be read through both handles in any order, sources with an own stream position (e.g. the FILE of riff_open_file()) need I/O functions that seek to riff_handle::pos before each read.
+ * 
+ * @param rh The riff_handle to duplicate.
+ * 
+ * @return Pointer to the new riff_handle, free with riff_handleFree(), NULL if allocation failed.
+ */
+riff_handle *riff_handleDuplicate(const riff_handle *rh);
+/**
+ * @brief Return a riff_handle to the state after allocation, keeping its level stack allocated.
+ * 
+ * The print function (riff_handle::fp_printf) and allocator are kept, the I/O functions have to be set again by an open function.\n 
+ * The ds64 table of a RF64/BW64 file is freed.
+ * 
+ * @param rh The riff_handle to reset.
+ */
+void riff_handleReset(riff_handle *rh);
+/**
+ * @brief Allocate a pool of handles.
+ * 
+ * @param max Maximum amount of idle handles kept by the pool.
+ * 
+ * @return Pointer to the pool, NULL if allocation failed.
+ */
+riff_handlePool *riff_handlePoolAllocate(size_t max);
+/**
+ * @brief Free a pool and its idle handles.
+ * 
+ * Handles taken from the pool and not returned yet must be freed with riff_handleFree().
+ * 
+ * @param pool The pool to free.
+ */
+void riff_handlePoolFree(riff_handlePool *pool);
+/**
+ * @brief Take a handle from the pool, allocates a new one if the pool is empty.
+ * 
+ * @param pool The pool to take from.
+ * 
+ * @return Pointer to the handle in the state after allocation (see riff_handleReset()), NULL if allocation failed.
+ */
+riff_handle *riff_handlePoolGet(riff_handlePool *pool);
+/**
+ * @brief Return a handle to the pool, it is reset, or freed if the pool is full.
+ * 
+ * The data source (e.g. the FILE of riff_open_file()) is not closed.
+ * 
+ * @param pool The pool to return to.
+ * @param rh The handle, of riff_handlePoolGet() or riff_handleAllocate().
+ */
+void riff_handlePoolPut(riff_handlePool *pool, riff_handle *rh);
+/**
+ * @brief Set the global allocator.
+ * 
+ * Used by riff_handleAllocate() and by all objects not created from a riff_handle (e.g. riff_writer, riff_mpWriter, riff_aviDemux), they copy it when allocated.\n 
+ * Not thread safe, set it before any other `riff_...()` function is called.
+ * 
+ * @param alloc The allocator, copied. NULL restores the default allocator.
+ */
+void riff_setAllocator(const riff_allocator *alloc);
+/**
+ * @brief Get the global allocator.
+ * 
+ * @return The global allocator.
+ */
+const riff_allocator *riff_getAllocator();
+
+///@}
+
 
+/**
+ * @name FOURCC accessors
+ * 
+ * Chunk ID checks with integer compares instead of `memcmp()`, see @ref FOURCC.
+ * @{
+ */
+/**
+ * @brief FOURCC value of an ID string, for IDs known only at runtime.
+ * 
+ * @param id 4 characters, no terminator needed.
+ * 
+ * @return The FOURCC value.
+ */
+static inline uint32_t riff_fourcc(const char *id){
+	return RIFF_FOURCC(id[0], id[1], id[2], id[3]);
+}
+/**
+ * @brief Check the ID of the current chunk.
+ * 
+ * @param rh The riff_handle to use.
+ * @param fourcc The ID, e.g. `RIFF_FOURCC('d','a','t','a')`.
+ * 
+ * @return 1 if the current chunk has the ID, else 0.
+ */
+static inline int riff_chunkIs(const riff_handle *rh, uint32_t fourcc){
+	return rh->c_fourcc == fourcc;
+}
+/**
+ * @brief Check if the current chunk can contain subchunks.
+ * 
+ * @param rh The riff_handle to use.
+ * 
+ * @return 1 for "LIST", "RIFF", "RIFX", "RF64" and "BW64" chunks, else 0.
+ */
+static inline int riff_chunkIsList(const riff_handle *rh){
+	uint32_t v = rh->c_fourcc;
+	return v == RIFF_FOURCC_LIST  ||  v == RIFF_FOURCC_RIFF  ||  v == RIFF_FOURCC_RIFX  ||  v == RIFF_FOURCC_RF64  ||  v == RIFF_FOURCC_BW64;
+}
+/**
+ * @brief Type ID of the current list level.
+ * 
+ * @param rh The riff_handle to use.
+ * 
+ * @return The type of the list the current chunk is in, the file type (riff_handle::h_type_fourcc) at level 0.
+ */
+static inline uint32_t riff_levelType(const riff_handle *rh){
+	return (rh->ls_level > 0) ? rh->ls[rh->ls_level - 1].c_type_fourcc : rh->h_type_fourcc;
+}
 ///@}
 
 
@@ -451,6 +922,8 @@ int riff_seekLevelStart(struct riff_handle *rh);
 /**
  * @brief Go to sub level, load first chunk.
  * 
+ * An empty chunk list (only the type ID) is entered as well, but has no first chunk: ::RIFF_ERROR_EOCL is returned and the riff_handle stays at the chunk list.
+ * 
  * @note Automatically seeks to the start of parent chunk's data.
  * 
  * @param rh The riff_handle to use.
@@ -514,7 +987,7 @@ int riff_levelValidate(struct riff_handle *rh);
 /**
  * @brief Validate file structure.
  *
- * Rewinds to the first chunk of the file, then from header to header inside of the current chunk level. If a level can contain subchunks, it is recursively checked.
+ * Rewinds to the first chunk of the file, then from header to header inside of the current chunk level. If a level can contain subchunks, it is checked as well (via riff_walk(), so deep nesting does not use up the call stack).
  *
  * @note File position is changed by this function.
  * 
@@ -524,6 +997,86 @@ int riff_levelValidate(struct riff_handle *rh);
  */
 int riff_fileValidate(struct riff_handle *rh);
 
+/**
+ * @brief Start a resumable file validation.
+ * 
+ * Rewinds to the first chunk of the file and initializes @p v.
+ * 
+ * @note Between the following riff_validatorStep() calls the riff_handle must not be moved, or has to be restored via riff_validatorRestore().
+ * 
+ * @param rh The riff_handle to use.
+ * @param v The validator state to initialize.
+ * 
+ * @return RIFF error code.
+ */
+int riff_validatorInit(struct riff_handle *rh, struct riff_validator *v);
+
+/**
+ * @brief Continue a resumable file validation within a budget.
+ * 
+ * Validates chunk headers until the file is done or the budget is used up, whichever comes first.
+ * 
+ * @param rh The riff_handle to use.
+ * @param v The validator state.
+ * @param max_io Maximum amount of header bytes to read in this step, 0 for unlimited.
+ * @param max_ms Maximum time to spend in this step in milliseconds, 0 for unlimited.
+ * 
+ * @return RIFF error code, check riff_validator::done to see whether the validation is finished.
+ */
+int riff_validatorStep(struct riff_handle *rh, struct riff_validator *v, size_t max_io, uint32_t max_ms);
+
+/**
+ * @brief Serialize a resumable validation.
+ * 
+ * Stores @p v and the position of @p rh in a portable format (little endian), e.g. to survive process restarts.
+ * 
+ * @param rh The riff_handle the validation runs on.
+ * @param v The validator state.
+ * @param buf Buffer to write to, can be NULL to query the required size.
+ * @param size Size of @p buf.
+ * 
+ * @return The required buffer size, nothing is written if it is larger than @p size.
+ */
+size_t riff_validatorSerialize(const struct riff_handle *rh, const struct riff_validator *v, void *buf, size_t size);
+
+/**
+ * @brief Restore a serialized validation.
+ * 
+ * @p rh must be opened on the same RIFF file as when the state was serialized, the header is compared to make sure.\n 
+ * Every restored list must lie within its parent, otherwise ::RIFF_ERROR_ICSIZE is returned.
+ * 
+ * @param rh The riff_handle to restore the position of.
+ * @param v The validator state to restore.
+ * @param buf Serialized data from riff_validatorSerialize().
+ * @param size Size of the serialized data.
+ * 
+ * @return RIFF error code.
+ */
+int riff_validatorRestore(struct riff_handle *rh, struct riff_validator *v, const void *buf, size_t size);
+
+///@}
+
+/**
+ * @name Traversal functions
+ * @{
+ */
+
+/**
+ * @brief Walk the chunk tree depth first.
+ * 
+ * Seeks to the first chunk of the current level, then visits every chunk of this level and of all its sub levels in file order, calling the callbacks of @p w.
+ * 
+ * Iterative - the level stack of the riff_handle is the only traversal stack, so hostile files with deeply nested lists can not overflow the call stack.
+ * 
+ * @note File position is changed by this function. When the walk completes, the riff_handle is at the last chunk of the level it started in.
+ * 
+ * @param rh The riff_handle to use.
+ * @param w The callbacks, can be NULL to only walk (validate) the tree.
+ * 
+ * @return RIFF error code, ::RIFF_ERROR_NONE if the walk completed or was stopped by a callback.
+ */
+int riff_walk(struct riff_handle *rh, const struct riff_walker *w);
+
 ///@}
 
 /**
@@ -584,6 +1137,8 @@ const char *riff_errorToString(int e);
  * 
  * To be caled from user I/O functions.
  * 
+ * Accepts `"RIFF"`, `"RIFX"`, `"RF64"` and `"BW64"` and sets riff_handle::fp_readChunkHeader for the byte order of the file.
+ * 
  * @param rh The riff_handle to use.
  * 
  * @return RIFF error code.
@@ -608,6 +1163,7 @@ int riff_readHeader(riff_handle *rh);
  * @note File position must be at the start of the RIFF data (it can be nested in another file).
  * @note Since the file was opened by the user, it must be closed by the user.
  * @note The file size must be exact if > 0, use 0 for unknown size \n (the correct size helps to identify file corruption).
+ * @note Open the file in "r+b" mode to allow in-place editing.
  * 
  * @param rh The riff_handle to initialize.
  * @param f The FILE pointer to read from.
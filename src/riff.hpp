@@ -16,11 +16,27 @@
 #include <cstring>
 extern "C" {
     #include "riff.h"
+    #include "riff_writer.h"
+    #include "riff_edit.h"
+    #include "riff_copy.h"
+    #include "riff_mpwriter.h"
+    #include "riff_wav.h"
+    #include "riff_avi.h"
+    #include "riff_avidemux.h"
+    #include "riff_probe.h"
+    #include "riff_meta.h"
+    #include "riff_bank.h"
+    #include "riff_anim.h"
 }
 #include <fstream>
+#include <memory>
 #include <vector>
 #if RIFF_CXX17_SUPPORT
 #include <filesystem>
+#include <memory_resource>
+#endif
+#if __cplusplus >= 202002L
+#include <span>
 #endif
 
 namespace RIFF {
@@ -33,10 +49,89 @@ enum fileTypes : int {
     CLOSED      = -1
 };
 
+class RIFFWriter;
+class RIFFEditScript;
+class RIFFFile;
+
+/**
+ * @brief Allocator adaptor that leaves new elements uninitialised instead of zero-filling them.
+ * 
+ * Used by ChunkBuffer, so resizing before reading chunk data does not write the memory twice.
+ */
+template <typename T, typename A = std::allocator<T>>
+class DefaultInitAllocator : public A {
+    typedef std::allocator_traits<A> traits;
+
+    public:
+        template <typename U> struct rebind {
+            using other = DefaultInitAllocator<U, typename traits::template rebind_alloc<U>>;
+        };
+
+        using A::A;
+        DefaultInitAllocator () = default;
+        DefaultInitAllocator (const A & a) noexcept : A(a) {}
+
+        template <typename U> void construct (U * ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+            {::new(static_cast<void *>(ptr)) U;}
+        template <typename U, typename... Args> void construct (U * ptr, Args &&... args)
+            {traits::construct(static_cast<A &>(*this), ptr, std::forward<Args>(args)...);}
+};
+
+/**
+ * @brief Byte buffer for chunk data, new elements are not initialised, see RIFFFile::readChunkBuffer().
+ */
+typedef std::vector<uint8_t, DefaultInitAllocator<uint8_t>> ChunkBuffer;
+
+#if RIFF_CXX17_SUPPORT
+namespace pmr {
+/**
+ * @brief ChunkBuffer allocating from a std::pmr::memory_resource.
+ */
+typedef std::vector<uint8_t, DefaultInitAllocator<uint8_t, std::pmr::polymorphic_allocator<uint8_t>>> ChunkBuffer;
+}
+#endif
+
+/**
+ * @brief A lightweight wrapper class around riff_handlePool
+ * 
+ * RIFFFile objects constructed with the pool borrow their riff_handle from it and return it when destroyed, so opening many files in a row does not allocate a handle per file.
+ * 
+ * Must outlive the RIFFFile objects borrowing from it. Not thread safe, use one pool per thread.
+ */
+class RIFFHandlePool {
+    public:
+        /**
+         * @brief Construct a new RIFFHandlePool object, allocates a riff_handlePool for it.
+         * 
+         * @param max Maximum amount of idle handles kept by the pool.
+         */
+        RIFFHandlePool (size_t max = 16);
+
+        RIFFHandlePool (const RIFFHandlePool &rhs) = delete;
+        RIFFHandlePool & operator = (const RIFFHandlePool &rhs) = delete;
+
+        /**
+         * @brief Destroy the RIFFHandlePool object, deallocates the riff_handlePool and its idle handles.
+         */
+        ~RIFFHandlePool ();
+
+        /**
+         * @brief Amount of idle handles in the pool.
+         */
+        inline size_t idle () {return pool ? pool->handles_len : 0;}
+
+    private:
+        riff_handlePool * pool = nullptr;
+
+        friend class RIFFFile;
+};
+
 /**
  * @brief A lightweight wrapper class around riff_handle
  * 
  * This class allows you to forget about the difficulties of manually managing the riff_handle's memory, while still providing very direct access to it (as well as a few wrapper functions).
+ * 
+ * Move-only, it owns its riff_handle and the files it opened. A second cursor on the same file is made explicitly with duplicate().
  */
 class RIFFFile {
     public:
@@ -48,26 +143,16 @@ class RIFFFile {
         RIFFFile ();
 
         /**
-         * @brief Copy-construct a new RIFFFile object.
-         * 
-         * Constructs a new RIFFFile object, copies the other RIFFFile object's data (and allocates a new riff_handle for it).
+         * @brief Construct a new RIFFFile object with a riff_handle of a pool.
          * 
-         * @note While it copies the riff_handle data, the file / memory pointer stays the exact same as the old one, meaning 2 RIFFFile objects are accessing the same data!
+         * The handle is returned to the pool when the object is destroyed.
          * 
-         * @param rhs The RIFFFile object to copy.
+         * @param pool The pool to borrow the handle from, must outlive the object.
          */
-        RIFFFile (const RIFFFile &rhs);
+        explicit RIFFFile (RIFFHandlePool & pool);
 
-        /**
-         * @brief Copy RIFFFile object data.
-         * 
-         * Copies the other RIFFFile object's data (and allocates a new riff_handle for it).
-         * 
-         * @note While it copies the riff_handle data, the file / memory pointer stays the exact same as the old one, meaning 2 RIFFFile objects are accessing the same data!
-         * 
-         * @param rhs The RIFFFile object to copy.
-         */
-        RIFFFile & operator = (const RIFFFile &rhs);
+        RIFFFile (const RIFFFile &rhs) = delete;
+        RIFFFile & operator = (const RIFFFile &rhs) = delete;
 
         /**
          * @brief Move-construct a new RIFFFile object
@@ -272,8 +357,51 @@ class RIFFFile {
          * @brief Closes the file.
          * 
          * @note Only actually closes the file if it was opened automatically (if it was opened by the user, the user must close it).
+         * @note A C FILE opened automatically stays open while duplicates (see duplicate()) read from it, the last one closes it.
+         * @note The std::fstream of openFstream() is kept for the next openFstream() call, it is deallocated with the object.
          */
         void close ();
+        /**
+         * @brief Create a second cursor on the same file, at the same position.
+         * 
+         * The riff_handle is copied (see riff_handleDuplicate()), the I/O functions of this object are kept.
+         * The new object reads at its own position without moving the position of this one:
+         * a C FILE is shared and read with pread() (reopened on Windows), a std::fstream of openFstream() with a file name is reopened.
+         * 
+         * @note A std::fstream passed by the caller is shared, the new object restores its position after each read.
+         *       Then the objects must not be used from different threads at once.
+         * 
+         * @return The new RIFFFile object, its latestError() is ::RIFF_ERROR_MEMORY if allocation failed, ::RIFF_ERROR_ACCESS if the file can't be reopened.
+         */
+        RIFFFile duplicate ();
+
+        ///@}
+
+        /**
+         * @name FOURCC accessors
+         * @{
+         */
+
+        /**
+         * @brief ID of the current chunk as FOURCC value, see RIFF_FOURCC().
+         */
+        inline uint32_t chunkFourcc () {return rh->c_fourcc;};
+        /**
+         * @brief Check the ID of the current chunk with an integer compare.
+         * 
+         * @param fourcc The ID, e.g. `RIFF_FOURCC('d','a','t','a')`.
+         * 
+         * @return true if the current chunk has the ID.
+         */
+        inline bool chunkIs (uint32_t fourcc) {return riff_chunkIs(rh, fourcc);};
+        /**
+         * @brief Check if the current chunk can contain subchunks ("LIST", "RIFF" and variants).
+         */
+        inline bool chunkIsList () {return riff_chunkIsList(rh);};
+        /**
+         * @brief Type ID of the current list level as FOURCC value, the file type at level 0.
+         */
+        inline uint32_t levelType () {return riff_levelType(rh);};
 
         ///@}
 
@@ -299,10 +427,71 @@ class RIFFFile {
          * @brief Read current chunk's data.
          * 
          * @note Returns an empty vector if an error occurred.
+         * @note Allocates and zero-fills a new vector on every call, see the other overloads and readChunkBuffer() for large chunks.
          * 
          * @return std::vector<uint8_t> with the data.
          */
         std::vector<uint8_t> readChunkData ();
+        /**
+         * @brief Read current chunk's data into caller provided storage.
+         * 
+         * Reads from the start of the chunk data, at most @p size bytes.
+         * 
+         * @param to Storage to read into.
+         * @param size Size of the storage.
+         * 
+         * @return Amount of bytes read, the chunk size if the storage is large enough. latestError() is set.
+         */
+        size_t readChunkData (void * to, size_t size);
+        #if __cplusplus >= 202002L
+        /**
+         * @brief Read current chunk's data into a caller provided span.
+         * 
+         * @param to Storage to read into, at most `to.size()` bytes are read.
+         * 
+         * @return Amount of bytes read. latestError() is set.
+         */
+        inline size_t readChunkData (std::span<uint8_t> to) {return readChunkData(to.data(), to.size());};
+        #endif
+        /**
+         * @brief Read current chunk's data into a reusable buffer.
+         * 
+         * The buffer is resized to the data read, its capacity is kept for the next call.
+         * With a ChunkBuffer the bytes are not zero-filled before reading.
+         * 
+         * @param buf The buffer, any `std::vector<uint8_t>` (e.g. ChunkBuffer or pmr::ChunkBuffer).
+         * 
+         * @return RIFF error code.
+         */
+        template <typename A>
+        int readChunkData (std::vector<uint8_t, A> & buf) {
+            buf.resize(rh->c_size);
+            buf.resize(readChunkData(buf.data(), buf.size()));
+            return __latestError;
+        };
+        /**
+         * @brief Read current chunk's data into a new buffer that is not zero-filled before reading.
+         * 
+         * @note Returns an empty buffer if an error occurred.
+         * 
+         * @return ChunkBuffer with the data.
+         */
+        inline ChunkBuffer readChunkBuffer () {ChunkBuffer buf; readChunkData(buf); return buf;};
+        #if RIFF_CXX17_SUPPORT
+        /**
+         * @brief Read current chunk's data into a new buffer allocated from a memory resource.
+         * 
+         * The buffer is not zero-filled before reading.
+         * 
+         * @note Returns an empty buffer if an error occurred.
+         * 
+         * @param mr The memory resource, e.g. a std::pmr::monotonic_buffer_resource reused per frame.
+         * 
+         * @return pmr::ChunkBuffer with the data.
+         */
+        inline pmr::ChunkBuffer readChunkData (std::pmr::memory_resource * mr)
+            {pmr::ChunkBuffer buf{pmr::ChunkBuffer::allocator_type(mr)}; readChunkData(buf); return buf;};
+        #endif
         /**
          * @brief Seek in current chunk.
          * 
@@ -417,7 +606,7 @@ class RIFFFile {
         /**
          * @brief Validate file structure.
          *
-         * Rewinds to the first chunk of the file, then from header to header inside of the current chunk level. If a level can contain subchunks, it is recursively checked.
+         * Rewinds to the first chunk of the file, then from header to header inside of the current chunk level. If a level can contain subchunks, it is checked as well.
          *
          * @note File position is changed by this function.
          * 
@@ -425,6 +614,64 @@ class RIFFFile {
          */
         inline int fileValidate () {return __latestError = riff_fileValidate(rh);}
 
+        /**
+         * @brief Start a resumable file validation.
+         *
+         * @note Between the following validatorStep() calls the file position must not be changed, or has to be restored via validatorRestore().
+         *
+         * @param v The validator state to initialize.
+         *
+         * @return RIFF error code.
+         */
+        inline int validatorInit (riff_validator & v) {return __latestError = riff_validatorInit(rh, &v);}
+        /**
+         * @brief Continue a resumable file validation within a budget.
+         *
+         * @param v The validator state.
+         * @param maxIO Maximum amount of header bytes to read in this step, 0 for unlimited.
+         * @param maxMs Maximum time to spend in this step in milliseconds, 0 for unlimited.
+         *
+         * @return RIFF error code, check riff_validator::done to see whether the validation is finished.
+         */
+        inline int validatorStep (riff_validator & v, size_t maxIO, uint32_t maxMs = 0) {return __latestError = riff_validatorStep(rh, &v, maxIO, maxMs);}
+        /**
+         * @brief Serialize a resumable validation.
+         *
+         * @param v The validator state.
+         *
+         * @return The serialized validator state and file position.
+         */
+        std::vector<uint8_t> validatorSerialize (const riff_validator & v);
+        /**
+         * @brief Restore a serialized validation.
+         *
+         * @param v The validator state to restore.
+         * @param data Serialized data from validatorSerialize().
+         *
+         * @return RIFF error code.
+         */
+        inline int validatorRestore (riff_validator & v, const std::vector<uint8_t> & data) {return __latestError = riff_validatorRestore(rh, &v, data.data(), data.size());}
+
+        ///@}
+
+        /**
+         * @name Traversal functions
+         * @{
+         */
+
+        /**
+         * @brief Walk the chunk tree depth first.
+         *
+         * Visits every chunk of the current level and of all its sub levels in file order, without recursion.
+         *
+         * @note File position is changed by this function.
+         *
+         * @param w The callbacks, the callbacks get the raw riff_handle.
+         *
+         * @return RIFF error code.
+         */
+        inline int walk (const riff_walker & w) {return __latestError = riff_walk(rh, &w);}
+
         ///@}
 
         /**
@@ -459,59 +706,982 @@ class RIFFFile {
         ///@}
 
         /**
-         * @brief Return raw error string.
-         * 
-         * @param errorCode The error code to print.
-         * 
-         * @return Error string.
+         * @name Editing functions
+         * @{
          */
-        static inline std::string errorToString (int errorCode) {return riff_errorToString (errorCode);};
 
         /**
-         * @brief Return latest error's string with position.
-         * 
-         * Includes the position where the problem occured.
-         * 
-         * @return Error string with position.
+         * @brief Replace the data of the current chunk.
+         *
+         * Overwrites the chunk in place if possible, size changes are absorbed by neighbouring "JUNK"/"PAD " chunks, a last chunk of the file may grow. Otherwise the file is rewritten to @p fallback.
+         *
+         * @note The file must be opened for writing, e.g. via openCFILE() with a user opened file in "r+b" mode.
+         *
+         * @param data The new chunk data.
+         * @param size The new chunk data size.
+         * @param fallback Freshly opened RIFFWriter for the rewrite, can be nullptr.
+         * @param path Receives the `RIFF_EDIT_...` path that was taken, can be nullptr.
+         *
+         * @return RIFF error code.
          */
-        std::string latestErrorToString ();
+        int replaceChunk (const void * data, size_t size, RIFFWriter * fallback = nullptr, int * path = nullptr);
+        /**
+         * @brief Replace the data of the current chunk.
+         *
+         * @param data The new chunk data.
+         * @param fallback Freshly opened RIFFWriter for the rewrite, can be nullptr.
+         * @param path Receives the `RIFF_EDIT_...` path that was taken, can be nullptr.
+         *
+         * @return RIFF error code.
+         */
+        inline int replaceChunk (const std::vector<uint8_t> & data, RIFFWriter * fallback = nullptr, int * path = nullptr)
+            {return replaceChunk(data.data(), data.size(), fallback, path);};
+        /**
+         * @brief Copy the whole RIFF file to a RIFFWriter.
+         *
+         * @note File position is changed by this function.
+         *
+         * @param writer Freshly opened RIFFWriter, closed afterwards.
+         *
+         * @return RIFF error code.
+         */
+        int copyFile (RIFFWriter & writer);
+        /**
+         * @brief Write the file with all operations of an edit script applied to a RIFFWriter.
+         *
+         * The file is read once from start to end, the output is written sequentially.
+         *
+         * @note File position is changed by this function.
+         *
+         * @param script The edit script to apply.
+         * @param writer Freshly opened RIFFWriter, closed afterwards.
+         *
+         * @return RIFF error code.
+         */
+        int applyEdits (RIFFEditScript & script, RIFFWriter & writer);
+
+        ///@}
 
         /**
-         * @brief Access the riff_handle object.
-         * 
-         * @return The riff_handle.
+         * @name Copying methods
+         *
+         * Copy to a file descriptor, by the kernel if the file was opened with openCFILE() and the OS supports it.
+         * @{
          */
-        inline const riff_handle & operator() () {return *rh;}
+
+        /**
+         * @brief Copy the rest of the current chunk data to a file descriptor.
+         *
+         * @param fd The destination file descriptor.
+         *
+         * @return Amount of copied bytes.
+         */
+        inline size_t copyChunkTo (int fd) {return riff_copyChunkTo(rh, fd);};
+        /**
+         * @brief Copy the current chunk including header and all subchunks to a file descriptor.
+         *
+         * @param fd The destination file descriptor.
+         *
+         * @return Amount of copied bytes.
+         */
+        inline size_t copySubtreeTo (int fd) {return riff_copySubtreeTo(rh, fd);};
+        /**
+         * @brief Copy byte ranges of the file to a file descriptor.
+         *
+         * @param fd The destination file descriptor.
+         * @param ranges The ranges to copy.
+         *
+         * @return Amount of copied bytes.
+         */
+        inline size_t copyRangesTo (int fd, const std::vector<riff_range> & ranges)
+            {return riff_copyRangesTo(rh, fd, ranges.data(), ranges.size());};
 
         ///@}
 
         /**
-         * @brief Returns the error code of the latest error.
-         * 
-         * @return The latest error.
+         * @name WAVE methods
+         * @{
          */
-        inline const int latestError() {return __latestError;}
 
         /**
-         * @brief File pointer
-         * 
-         * The pointer to the file object as provided by open() methods
+         * @brief Find the "fmt " and "data" chunks of a WAVE file and cache the format.
+         *
+         * @param wav The riff_wav to fill.
+         *
+         * @return RIFF error code.
          */
-        void * file = nullptr;
+        inline int wavOpen (riff_wav & wav) {return __latestError = riff_wavOpen(rh, &wav);};
+        /**
+         * @brief Read sample frames.
+         *
+         * @param wav The riff_wav filled by wavOpen().
+         * @param start First frame to read.
+         * @param count Amount of frames to read.
+         * @param buf Destination, at least `count * block_align` bytes.
+         *
+         * @return Amount of frames read.
+         */
+        inline size_t wavReadFrames (const riff_wav & wav, uint64_t start, size_t count, void * buf)
+            {return riff_wavReadFrames(rh, &wav, start, count, buf);};
+        /**
+         * @brief Read several regions of sample frames, in file order.
+         *
+         * @param wav The riff_wav filled by wavOpen().
+         * @param regions The regions to read, riff_wavRegion::read is set for each.
+         *
+         * @return Total amount of frames read.
+         */
+        inline size_t wavReadRegions (const riff_wav & wav, std::vector<riff_wavRegion> & regions)
+            {return riff_wavReadRegions(rh, &wav, regions.data(), regions.size());};
+        /**
+         * @brief Read sample frames as float samples, full scale is -1.0 to 1.0.
+         *
+         * @param wav The riff_wav filled by wavOpen().
+         * @param start First frame to read.
+         * @param count Amount of frames to read.
+         * @param dst Destination, `count * channels` samples.
+         * @param planar false for interleaved samples, true for one plane of `count` samples per channel.
+         *
+         * @return Amount of frames read, 0 if the format is not supported.
+         */
+        inline size_t wavReadConverted (const riff_wav & wav, uint64_t start, size_t count, float * dst, bool planar = false)
+            {return riff_wavReadConverted(rh, &wav, start, count, dst, RIFF_WAV_SAMPLE_FLOAT, planar);};
+        /**
+         * @brief Read sample frames as 16 bit integer samples.
+         *
+         * @param wav The riff_wav filled by wavOpen().
+         * @param start First frame to read.
+         * @param count Amount of frames to read.
+         * @param dst Destination, `count * channels` samples.
+         * @param planar false for interleaved samples, true for one plane of `count` samples per channel.
+         *
+         * @return Amount of frames read, 0 if the format is not supported.
+         */
+        inline size_t wavReadConverted (const riff_wav & wav, uint64_t start, size_t count, int16_t * dst, bool planar = false)
+            {return riff_wavReadConverted(rh, &wav, start, count, dst, RIFF_WAV_SAMPLE_INT16, planar);};
 
-    private:
-        riff_handle * rh = nullptr;
+        ///@}
 
-        int type = CLOSED;
+        /**
+         * @name AVI methods
+         * @{
+         */
 
-        int __latestError = RIFF_ERROR_NONE;
+        /**
+         * @brief Read the headers of an AVI file and load the index of every stream.
+         *
+         * @param avi The riff_avi to fill, free with riff_aviClose() even on failure.
+         *
+         * @return RIFF error code.
+         */
+        inline int aviOpen (riff_avi & avi) {return __latestError = riff_aviOpen(rh, &avi);};
+        /**
+         * @brief Position on the chunk of a frame, constant time.
+         *
+         * @param avi The riff_avi filled by aviOpen().
+         * @param stream Stream number.
+         * @param frame Frame number.
+         *
+         * @return RIFF error code.
+         */
+        inline int aviSeekFrame (const riff_avi & avi, size_t stream, size_t frame)
+            {return __latestError = riff_aviSeekFrame(rh, &avi, stream, frame);};
 
-        int openFstreamCommon (size_t);
-        void setAutomaticFstream ();
-        size_t detectFstreamSize (bool);
+        ///@}
 
-        void die ();
-        void reset ();
+        /**
+         * @name Metadata methods
+         * @{
+         */
+
+        /**
+         * @brief Record the tags of the "LIST INFO" and "bext" chunks, without reading values.
+         *
+         * @param meta The riff_meta to fill, zero initialized or used before, free with riff_metaClose().
+         *
+         * @return RIFF error code.
+         */
+        inline int metaOpen (riff_meta & meta) {return __latestError = riff_metaOpen(rh, &meta);};
+        /**
+         * @brief Get a value, read and decoded on first access.
+         *
+         * @param meta The riff_meta filled by metaOpen().
+         * @param key The key, e.g. "INAM" or "Description".
+         *
+         * @return The value, nullptr if there is no such tag.
+         */
+        inline const char * metaGet (riff_meta & meta, const char * key) {return riff_metaGet(rh, &meta, key);};
+        /**
+         * @brief Get several values, those not decoded yet are read in file order.
+         *
+         * @param meta The riff_meta filled by metaOpen().
+         * @param keys The keys.
+         * @param values Resized to the amount of keys, receives the values, nullptr for missing tags.
+         *
+         * @return Amount of values found.
+         */
+        inline size_t metaFetch (riff_meta & meta, const std::vector<const char *> & keys, std::vector<const char *> & values) {
+            values.resize(keys.size());
+            return riff_metaFetch(rh, &meta, keys.data(), keys.size(), values.data());
+        };
+
+        ///@}
+
+        /**
+         * @name Sample bank methods
+         * @{
+         */
+
+        /**
+         * @brief Parse the headers of an SF2 or DLS file, sample data is not read.
+         *
+         * @param bank The riff_bank to fill, free with riff_bankClose() even on failure.
+         *
+         * @return RIFF error code.
+         */
+        inline int bankOpen (riff_bank & bank) {return __latestError = riff_bankOpen(rh, &bank);};
+        /**
+         * @brief Read bytes of a sample slice, copied from memory for memory based handles.
+         *
+         * @param slice The slice, e.g. from riff_bankSample().
+         * @param offset Offset in the slice.
+         * @param dst Destination.
+         * @param size Amount of bytes to read.
+         *
+         * @return Amount of bytes read.
+         */
+        inline size_t bankRead (const riff_bankSlice & slice, size_t offset, void * dst, size_t size)
+            {return riff_bankRead(rh, &slice, offset, dst, size);};
+
+        ///@}
+
+        /**
+         * @name Animation methods
+         * @{
+         */
+
+        /**
+         * @brief Build the frame index of a WebP or ANI file, image data is not read.
+         *
+         * @param anim The riff_anim to fill, free with riff_animClose() even on failure.
+         *
+         * @return RIFF error code.
+         */
+        inline int animOpen (riff_anim & anim) {return __latestError = riff_animOpen(rh, &anim);};
+        /**
+         * @brief Position on the image data of a frame in constant time, read it with readInChunk().
+         *
+         * @param anim The riff_anim filled by animOpen().
+         * @param frame Frame number.
+         *
+         * @return RIFF error code.
+         */
+        inline int animSeekFrame (const riff_anim & anim, size_t frame)
+            {return __latestError = riff_animSeekFrame(rh, &anim, frame);};
+        /**
+         * @brief Position on the alpha data of a frame in constant time, read it with readInChunk().
+         *
+         * @param anim The riff_anim filled by animOpen().
+         * @param frame Frame number.
+         *
+         * @return RIFF error code, ::RIFF_ERROR_EOC if the frame has no alpha data.
+         */
+        inline int animSeekAlpha (const riff_anim & anim, size_t frame)
+            {return __latestError = riff_animSeekAlpha(rh, &anim, frame);};
+
+        ///@}
+
+        /**
+         * @brief Return raw error string.
+         * 
+         * @param errorCode The error code to print.
+         * 
+         * @return Error string.
+         */
+        static inline std::string errorToString (int errorCode) {return riff_errorToString (errorCode);};
+
+        /**
+         * @brief Return latest error's string with position.
+         * 
+         * Includes the position where the problem occured.
+         * 
+         * @return Error string with position.
+         */
+        std::string latestErrorToString ();
+
+        /**
+         * @brief Access the riff_handle object.
+         * 
+         * @return The riff_handle.
+         */
+        inline const riff_handle & operator() () {return *rh;}
+
+        ///@}
+
+        /**
+         * @brief Returns the error code of the latest error.
+         * 
+         * @return The latest error.
+         */
+        inline int latestError() {return __latestError;}
+
+        /**
+         * @brief File pointer
+         * 
+         * The pointer to the file object as provided by open() methods
+         */
+        void * file = nullptr;
+
+    private:
+        riff_handle * rh = nullptr;
+
+        int type = CLOSED;
+
+        int __latestError = RIFF_ERROR_NONE;
+
+        riff_handlePool * pool = nullptr;           // pool the handle is borrowed from
+        std::shared_ptr<std::FILE> cfile;           // automatic file of openCFILE(), shared with duplicates
+        std::unique_ptr<std::fstream> stream;       // automatic stream of openFstream(), reused
+        #if RIFF_CXX17_SUPPORT
+        std::filesystem::path streamPath;           // name of the automatic stream, reopened by duplicate()
+        #else
+        std::string streamPath;
+        #endif
+
+        explicit RIFFFile (riff_handle * handle);
+
+        int openFstreamCommon (size_t);
+        void setAutomaticFstream ();
+        size_t detectFstreamSize (bool);
+
+        void die ();
+        void reset ();
+        void take (RIFFFile &rhs);
+
+        friend class RIFFAVIDemux;
+};
+
+/**
+ * @brief A lightweight wrapper class around riff_writer
+ *
+ * Writes a RIFF file chunk by chunk, chunk sizes are filled in automatically once a chunk is ended.
+ *
+ * Can not be copied, since two writers can not write the same file at once.
+ */
+class RIFFWriter {
+    public:
+        /**
+         * @brief Construct a new RIFFWriter object.
+         *
+         * Constructs a new RIFFWriter object, allocates a riff_writer for it.
+         */
+        RIFFWriter ();
+
+        RIFFWriter (const RIFFWriter &rhs) = delete;
+        RIFFWriter & operator = (const RIFFWriter &rhs) = delete;
+
+        /**
+         * @brief Move-construct a new RIFFWriter object
+         *
+         * @param rhs The RIFFWriter object to move.
+         */
+        RIFFWriter (RIFFWriter &&rhs) noexcept;
+
+        /**
+         * @brief Move RIFFWriter object data.
+         *
+         * @param rhs The RIFFWriter object to move.
+         */
+        RIFFWriter & operator = (RIFFWriter &&rhs) noexcept;
+
+        /**
+         * @brief Destroy the RIFFWriter object.
+         *
+         * Ends the RIFF file, deallocates riff_writer, closes the file.
+         */
+        ~RIFFWriter ();
+
+        /**
+         * @defgroup RIFF_CPP_Writer C++ RIFF writer functions
+         * @{
+         */
+
+        /**
+         * @name Opening/closing methods
+         * @{
+         */
+
+        /**
+         * @brief Create a RIFF file with C's `fopen()`.
+         *
+         * @param filename Filename in fopen()'s format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        int openCFILE (const char * filename, const char * type);
+        /**
+         * @brief Create a RIFF file with C's `fopen()`.
+         *
+         * @param filename Filename in fopen()'s format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        inline int openCFILE (const std::string & filename, const char * type)
+            {return openCFILE (filename.c_str(), type);};
+        #if RIFF_CXX17_SUPPORT
+        /**
+         * @brief Create a RIFF file with C's `fopen()`.
+         *
+         * @param filename Filename in fopen()'s format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        inline int openCFILE (const std::filesystem::path & filename, const char * type)
+            {return openCFILE (filename.c_str(), type);};
+        #endif
+        /**
+         * @brief Write a RIFF file to an existing C FILE object.
+         *
+         * @note Since the file object was opened by the user, the close() function of the class will not close the file object.
+         *
+         * @param file The C FILE object, opened for writing in binary mode.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        int openCFILE (std::FILE & file, const char * type);
+
+        /**
+         * @brief Create a RIFF file with C++'s std::fstream.
+         *
+         * @param filename Filename in std::fstream's format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        int openFstream (const char * filename, const char * type);
+        /**
+         * @brief Create a RIFF file with C++'s std::fstream.
+         *
+         * @param filename Filename in std::fstream's format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        inline int openFstream (const std::string & filename, const char * type)
+            {return openFstream (filename.c_str(), type);};
+        #if RIFF_CXX17_SUPPORT
+        /**
+         * @brief Create a RIFF file with C++'s std::fstream.
+         *
+         * @param filename Filename in std::fstream's format.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        int openFstream (const std::filesystem::path & filename, const char * type);
+        #endif
+        /**
+         * @brief Write a RIFF file to an existing std::fstream object.
+         *
+         * @note Since the file object was opened by the user, the close() function of the class will not close the file object.
+         *
+         * @param file The std::fstream object, opened for writing in binary mode.
+         * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+         *
+         * @return RIFF error code.
+         */
+        int openFstream (std::fstream & file, const char * type);
+
+        /**
+         * @brief Ends all open chunks and the RIFF file, closes the file.
+         *
+         * @note Only actually closes the file if it was opened automatically (if it was opened by the user, the user must close it).
+         *
+         * @return RIFF error code.
+         */
+        int close ();
+
+        ///@}
+
+        /**
+         * @name Writing methods
+         * @{
+         */
+
+        /**
+         * @brief Reserve space for 64 bit sizes.
+         *
+         * The file is turned into a 64 bit file in place once it exceeds 4 GB.
+         *
+         * @note Must be called right after opening, before any chunk is written.
+         *
+         * @param id The header ID of a 64 bit file, `"BW64"` or `"RF64"`.
+         * @param tableEntries Amount of ds64 table entries to reserve for chunks other than "data".
+         *
+         * @return RIFF error code.
+         */
+        inline int reserveDs64 (const char * id = "BW64", int tableEntries = 0) {return __latestError = riff_writerReserveDs64(rw, id, tableEntries);};
+        /**
+         * @brief Set the sample count written to the ds64 chunk.
+         *
+         * @param samples The sample count.
+         */
+        inline void setDs64Samples (uint64_t samples) {rw->ds64_samples = samples;};
+        /**
+         * @brief Begin a chunk inside of the current chunk list.
+         *
+         * @param id The chunk ID (4 bytes).
+         *
+         * @return RIFF error code.
+         */
+        inline int beginChunk (const char * id) {return __latestError = riff_writerBeginChunk(rw, id);};
+        /**
+         * @brief Begin a chunk of known size inside of the current chunk list.
+         *
+         * The size is written with the header, no seeking back is needed when the chunk is ended.
+         *
+         * @param id The chunk ID (4 bytes).
+         * @param size The chunk data size.
+         *
+         * @return RIFF error code.
+         */
+        inline int beginChunk (const char * id, size_t size) {return __latestError = riff_writerBeginChunkSized(rw, id, size);};
+        /**
+         * @brief Begin a "LIST" chunk inside of the current chunk list.
+         *
+         * @param type The list type ID (4 bytes).
+         *
+         * @return RIFF error code.
+         */
+        inline int beginList (const char * type) {return __latestError = riff_writerBeginList(rw, type);};
+        /**
+         * @brief Write data to the current chunk.
+         *
+         * @param ptr The data to write.
+         * @param size The amount of data to write.
+         *
+         * @return Amount of successfully written bytes.
+         */
+        inline size_t write (const void * ptr, size_t size) {return riff_writerWrite(rw, ptr, size);};
+        /**
+         * @brief Write data to the current chunk.
+         *
+         * @param data The data to write.
+         *
+         * @return Amount of successfully written bytes.
+         */
+        inline size_t write (const std::vector<uint8_t> & data) {return riff_writerWrite(rw, data.data(), data.size());};
+        /**
+         * @brief End the innermost open chunk or chunk list.
+         *
+         * @return RIFF error code.
+         */
+        inline int end () {return __latestError = riff_writerEnd(rw);};
+        /**
+         * @brief Write a complete chunk.
+         *
+         * @param id The chunk ID (4 bytes).
+         * @param ptr The chunk data.
+         * @param size The chunk data size.
+         *
+         * @return RIFF error code.
+         */
+        inline int writeChunk (const char * id, const void * ptr, size_t size) {return __latestError = riff_writerWriteChunk(rw, id, ptr, size);};
+        /**
+         * @brief Write a complete chunk.
+         *
+         * @param id The chunk ID (4 bytes).
+         * @param data The chunk data.
+         *
+         * @return RIFF error code.
+         */
+        inline int writeChunk (const char * id, const std::vector<uint8_t> & data) {return __latestError = riff_writerWriteChunk(rw, id, data.data(), data.size());};
+        /**
+         * @brief Write all buffered data to the file.
+         *
+         * @return RIFF error code.
+         */
+        inline int flush () {return __latestError = riff_writerFlush(rw);};
+        /**
+         * @brief Commit the sizes of all open chunks.
+         *
+         * Makes the file parseable up to the current position, even if the process dies afterwards.
+         *
+         * @return RIFF error code.
+         */
+        inline int commit () {return __latestError = riff_writerCommit(rw);};
+        /**
+         * @brief Set up automatic commits for recording growing files.
+         *
+         * The first failed automatic commit stops them and is returned by commit(), end() and close(), write() still returns the written byte count.
+         *
+         * @note Files opened via openFstream() are only flushed, std::fstream can't sync to stable storage, so `RIFF_WRITER_SYNC_FULL` and `RIFF_WRITER_SYNC_HEADER` give no durability guarantee there.
+         *
+         * @param interval Commit after this many bytes, 0 to disable automatic commits.
+         * @param sync Sync policy, one of the `RIFF_WRITER_SYNC_...` values.
+         */
+        inline void setCommitPolicy (size_t interval, int sync = RIFF_WRITER_SYNC_NONE) {riff_writerSetCommitPolicy(rw, interval, sync);};
+
+        ///@}
+
+        /**
+         * @brief Access the riff_writer object.
+         *
+         * @return The riff_writer.
+         */
+        inline const riff_writer & operator() () {return *rw;}
+
+        ///@}
+
+        /**
+         * @brief Returns the error code of the latest error.
+         *
+         * @return The latest error.
+         */
+        inline int latestError() {return __latestError;}
+
+        /**
+         * @brief File pointer
+         *
+         * The pointer to the file object as provided by open() methods
+         */
+        void * file = nullptr;
+
+    private:
+        riff_writer * rw = nullptr;
+
+        int type = CLOSED;
+
+        std::unique_ptr<std::fstream> stream;       // automatic stream of openFstream()
+
+        int __latestError = RIFF_ERROR_NONE;
+
+        int openFstreamCommon (const char *);
+
+        friend class RIFFFile;
+        friend class RIFFMPWriter;
+
+        void die ();
+        void take (RIFFWriter &rhs);
+};
+
+/**
+ * @brief A lightweight wrapper class around riff_editScript
+ *
+ * Queues edits of a RIFF file, applied in one pass by RIFFFile::applyEdits().
+ * Chunks are addressed by their start position riff_handle::c_pos_start.
+ * Chunk data is not copied, it must stay valid until the script is applied.
+ *
+ * Can not be copied, only moved.
+ */
+class RIFFEditScript {
+    public:
+        /**
+         * @brief Construct a new, empty RIFFEditScript object.
+         */
+        RIFFEditScript ();
+
+        RIFFEditScript (const RIFFEditScript &rhs) = delete;
+        RIFFEditScript & operator = (const RIFFEditScript &rhs) = delete;
+
+        /**
+         * @brief Move-construct a new RIFFEditScript object
+         *
+         * @param rhs The RIFFEditScript object to move.
+         */
+        RIFFEditScript (RIFFEditScript &&rhs) noexcept;
+
+        /**
+         * @brief Move RIFFEditScript object data.
+         *
+         * @param rhs The RIFFEditScript object to move.
+         */
+        RIFFEditScript & operator = (RIFFEditScript &&rhs) noexcept;
+
+        /**
+         * @brief Destroy the RIFFEditScript object, deallocates riff_editScript.
+         */
+        ~RIFFEditScript ();
+
+        /**
+         * @brief Queue replacing the data of a chunk.
+         *
+         * @param pos Start position of the chunk.
+         * @param data The new chunk data, for chunk lists starting with the list type.
+         * @param size The new chunk data size.
+         *
+         * @return RIFF error code.
+         */
+        inline int replace (size_t pos, const void * data, size_t size) {return riff_editScriptReplace(es, pos, data, size);};
+        /**
+         * @brief Queue replacing the data of a chunk.
+         *
+         * @param pos Start position of the chunk.
+         * @param data The new chunk data, for chunk lists starting with the list type.
+         *
+         * @return RIFF error code.
+         */
+        inline int replace (size_t pos, const std::vector<uint8_t> & data) {return replace(pos, data.data(), data.size());};
+        /**
+         * @brief Queue deleting a chunk or chunk list.
+         *
+         * @param pos Start position of the chunk.
+         *
+         * @return RIFF error code.
+         */
+        inline int erase (size_t pos) {return riff_editScriptDelete(es, pos);};
+        /**
+         * @brief Queue inserting a new chunk before a chunk.
+         *
+         * @param pos Start position of the chunk to insert before.
+         * @param id The ID of the new chunk (4 bytes).
+         * @param data The new chunk data.
+         * @param size The new chunk data size.
+         *
+         * @return RIFF error code.
+         */
+        inline int insert (size_t pos, const char * id, const void * data, size_t size) {return riff_editScriptInsert(es, pos, id, data, size);};
+        /**
+         * @brief Queue appending a new chunk at the end of a chunk list.
+         *
+         * @param pos Start position of the chunk list, riff_handle::pos_start for the RIFF chunk.
+         * @param id The ID of the new chunk (4 bytes).
+         * @param data The new chunk data.
+         * @param size The new chunk data size.
+         *
+         * @return RIFF error code.
+         */
+        inline int append (size_t pos, const char * id, const void * data, size_t size) {return riff_editScriptAppend(es, pos, id, data, size);};
+        /**
+         * @brief Remove all queued operations.
+         */
+        inline void clear () {riff_editScriptClear(es);};
+        /**
+         * @brief Amount of queued operations.
+         */
+        inline size_t size () const {return es->ops_len;};
+
+        /**
+         * @brief Returns a const reference to the internal riff_editScript.
+         *
+         * @return const riff_editScript&
+         */
+        inline const riff_editScript & operator() () {return *es;}
+
+    private:
+        riff_editScript * es = nullptr;
+
+        friend class RIFFFile;
+};
+
+/**
+ * @brief A lightweight wrapper class around riff_mpWriter
+ *
+ * Writes chunks from several threads into the innermost open chunk list of a RIFFWriter.
+ * reserve(), write() and commit() are thread safe.
+ *
+ * Can not be copied, only moved.
+ */
+class RIFFMPWriter {
+    public:
+        /**
+         * @brief Construct a new RIFFMPWriter object, allocates a riff_mpWriter for it.
+         */
+        RIFFMPWriter ();
+
+        RIFFMPWriter (const RIFFMPWriter &rhs) = delete;
+        RIFFMPWriter & operator = (const RIFFMPWriter &rhs) = delete;
+
+        /**
+         * @brief Move-construct a new RIFFMPWriter object
+         *
+         * @param rhs The RIFFMPWriter object to move.
+         */
+        RIFFMPWriter (RIFFMPWriter &&rhs) noexcept;
+
+        /**
+         * @brief Move RIFFMPWriter object data.
+         *
+         * @param rhs The RIFFMPWriter object to move.
+         */
+        RIFFMPWriter & operator = (RIFFMPWriter &&rhs) noexcept;
+
+        /**
+         * @brief Destroy the RIFFMPWriter object, deallocates riff_mpWriter.
+         */
+        ~RIFFMPWriter ();
+
+        /**
+         * @brief Start writing chunks from several threads into the innermost open chunk list of a RIFFWriter.
+         *
+         * @param writer The RIFFWriter, must not be used until end().
+         * @param slots Amount of slots that can be outstanding at once.
+         *
+         * @return RIFF error code.
+         */
+        int begin (RIFFWriter & writer, size_t slots = RIFF_MPWRITER_SLOTS);
+        /**
+         * @brief Reserve a slot for a chunk, blocks while all slots are outstanding.
+         *
+         * @param id The chunk ID (4 bytes).
+         * @param size The chunk data size.
+         * @param flags Index flags.
+         * @param seq Receives the sequence number of the slot.
+         *
+         * @return RIFF error code.
+         */
+        inline int reserve (const char * id, size_t size, uint32_t flags, uint64_t & seq)
+            {return riff_mpWriterReserve(mw, id, size, flags, &seq);};
+        /**
+         * @brief Write chunk data to a reserved slot.
+         *
+         * @param seq The sequence number of the slot.
+         * @param offset Offset in the chunk data.
+         * @param ptr The data to write.
+         * @param size The amount of data to write.
+         *
+         * @return RIFF error code.
+         */
+        inline int write (uint64_t seq, size_t offset, const void * ptr, size_t size)
+            {return riff_mpWriterWrite(mw, seq, offset, ptr, size);};
+        /**
+         * @brief Commit a slot whose data was written completely.
+         *
+         * @param seq The sequence number of the slot.
+         *
+         * @return RIFF error code.
+         */
+        inline int commit (uint64_t seq) {return riff_mpWriterCommit(mw, seq);};
+        /**
+         * @brief Reserve, write and commit a whole chunk at once.
+         *
+         * @param id The chunk ID (4 bytes).
+         * @param ptr The chunk data.
+         * @param size The chunk data size.
+         * @param flags Index flags.
+         *
+         * @return RIFF error code.
+         */
+        int writeChunk (const char * id, const void * ptr, size_t size, uint32_t flags = 0);
+        /**
+         * @brief Stop writing from several threads, waits for all reserved slots to be committed.
+         *
+         * @return RIFF error code.
+         */
+        inline int end () {return riff_mpWriterEnd(mw);};
+        /**
+         * @brief Write the index of all published chunks as AVI 1.0 "idx1" chunk to the RIFFWriter.
+         *
+         * @return RIFF error code.
+         */
+        inline int writeIdx1 () {return riff_mpWriterWriteIdx1(mw);};
+
+        /**
+         * @brief Returns a const reference to the internal riff_mpWriter.
+         *
+         * @return const riff_mpWriter&
+         */
+        inline const riff_mpWriter & operator() () {return *mw;}
+
+    private:
+        riff_mpWriter * mw = nullptr;
+};
+
+/**
+ * @brief A lightweight wrapper class around riff_aviDemux
+ *
+ * Walks the "movi" lists of an AVI file once and queues the packets of every stream.
+ * run() is called on the reader thread, pull() and stop() are thread safe.
+ *
+ * Can not be copied, only moved.
+ */
+class RIFFAVIDemux {
+    public:
+        /**
+         * @brief Construct a new RIFFAVIDemux object, allocates a riff_aviDemux for it.
+         */
+        RIFFAVIDemux ();
+
+        RIFFAVIDemux (const RIFFAVIDemux &rhs) = delete;
+        RIFFAVIDemux & operator = (const RIFFAVIDemux &rhs) = delete;
+
+        /**
+         * @brief Move-construct a new RIFFAVIDemux object
+         *
+         * @param rhs The RIFFAVIDemux object to move.
+         */
+        RIFFAVIDemux (RIFFAVIDemux &&rhs) noexcept;
+
+        /**
+         * @brief Move RIFFAVIDemux object data.
+         *
+         * @param rhs The RIFFAVIDemux object to move.
+         */
+        RIFFAVIDemux & operator = (RIFFAVIDemux &&rhs) noexcept;
+
+        /**
+         * @brief Destroy the RIFFAVIDemux object, deallocates riff_aviDemux and all queued packets.
+         */
+        ~RIFFAVIDemux ();
+
+        /**
+         * @brief Prepare demultiplexing, all streams are enabled.
+         *
+         * @param file The RIFFFile, must not be used until run() returned.
+         * @param avi The riff_avi filled by riff_aviOpenHeaders() or RIFFFile::aviOpen().
+         * @param queueBytes Maximum amount of queued data bytes per stream.
+         *
+         * @return RIFF error code.
+         */
+        int begin (RIFFFile & file, const riff_avi & avi, size_t queueBytes = RIFF_AVIDEMUX_QUEUE_BYTES);
+        /**
+         * @brief Enable or disable the packets of a stream, call before run().
+         *
+         * @param stream Stream number.
+         * @param enabled false to skip the packets of the stream.
+         *
+         * @return RIFF error code.
+         */
+        inline int select (size_t stream, bool enabled) {return riff_aviDemuxSelect(dm, stream, enabled);};
+        /**
+         * @brief Read all "movi" lists and queue their packets, blocks while a queue is full.
+         *
+         * @return RIFF error code.
+         */
+        inline int run () {return riff_aviDemuxRun(dm);};
+        /**
+         * @brief Take the next packet of a stream, blocks while its queue is empty.
+         *
+         * @param stream Stream number.
+         * @param pkt Receives the packet, free with packetFree(). nullptr if there is none.
+         *
+         * @return RIFF error code, ::RIFF_ERROR_EOCL after the last packet of the stream.
+         */
+        inline int pull (size_t stream, riff_aviPacket * & pkt) {return riff_aviDemuxPull(dm, stream, &pkt);};
+        /**
+         * @brief Stop the reader early.
+         */
+        inline void stop () {riff_aviDemuxStop(dm);};
+        /**
+         * @brief Free a pulled packet.
+         *
+         * @param pkt The packet to free.
+         */
+        static inline void packetFree (riff_aviPacket * pkt) {riff_aviDemuxPacketFree(pkt);};
+
+        /**
+         * @brief Returns a const reference to the internal riff_aviDemux.
+         *
+         * @return const riff_aviDemux&
+         */
+        inline const riff_aviDemux & operator() () {return *dm;}
+
+    private:
+        riff_aviDemux * dm = nullptr;
 };
 
 }       // namespace RIFF
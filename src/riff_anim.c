@@ -0,0 +1,429 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => riff_animOpen() only uses riff_handle functions, riff_animSeekFrame() sets the positions like riff_aviSeekFrame()
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_anim.h"
+#include "riff_internal.h"
+
+
+#define RIFF_ANIM_ALLOC 64   //number of frames allocated at least
+
+//WebP chunk sizes read at most
+#define WEBP_VP8X 10
+#define WEBP_ANIM 6
+#define WEBP_ANMF 16         //frame header before the sub chunks
+#define WEBP_VP8_HEADER 10   //bitstream header up to the image size
+
+//ANI
+#define ANI_ANIH 36
+#define ANI_JIFFY_RATE 60    //"rate" and "anih" display rates are in 1/60 seconds
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//make room for len frames
+int anim_reserve(riff_anim *anim, size_t len){
+	if(len <= anim->frames_size)
+		return RIFF_ERROR_NONE;
+	size_t frames_size_new = anim->frames_size * 2; //double size
+	if(frames_size_new < len)
+		frames_size_new = len;
+	if(frames_size_new < RIFF_ANIM_ALLOC)
+		frames_size_new = RIFF_ANIM_ALLOC;
+	struct riff_animFrame *framesnew = mem_realloc(&anim->alloc, anim->frames, frames_size_new * sizeof(struct riff_animFrame));
+	if(framesnew == NULL)
+		return RIFF_ERROR_MEMORY;
+	anim->frames = framesnew;
+	anim->frames_size = frames_size_new;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//append zeroed frame, NULL if allocation failed
+struct riff_animFrame *anim_append(riff_anim *anim){
+	if(anim_reserve(anim, anim->frames_len + 1) != RIFF_ERROR_NONE)
+		return NULL;
+	struct riff_animFrame *f = anim->frames + anim->frames_len++;
+	memset(f, 0, sizeof(struct riff_animFrame));
+	return f;
+}
+
+
+/*****************************************************************************/
+//pass pointer to 24 bit LE value and convert
+static uint32_t convUInt24LE(const uint8_t *c){
+	return c[0] | (c[1] << 8) | ((uint32_t)c[2] << 16);
+}
+
+
+/*****************************************************************************/
+//size of a still WebP image from the bitstream header of the current "VP8 " or "VP8L" chunk
+void anim_webpStillSize(riff_handle *rh, struct riff_animFrame *f){
+	uint8_t buf[WEBP_VP8_HEADER];
+	riff_readChunkStart(rh, buf, sizeof(buf));
+	//lossy: 3 byte frame tag, start code 0x9d 0x01 0x2a, 14 bit width and height
+	if(memcmp(f->c_id, "VP8 ", 4) == 0  &&  buf[3] == 0x9d  &&  buf[4] == 0x01  &&  buf[5] == 0x2a){
+		f->width = convUInt16LE(buf + 6) & 0x3fff;
+		f->height = convUInt16LE(buf + 8) & 0x3fff;
+	}
+	//lossless: signature 0x2f, 14 bit width - 1 and height - 1
+	else if(memcmp(f->c_id, "VP8L", 4) == 0  &&  buf[0] == 0x2f){
+		uint32_t v = convUInt32LE(buf + 1);
+		f->width = (v & 0x3fff) + 1;
+		f->height = ((v >> 14) & 0x3fff) + 1;
+	}
+}
+
+/*****************************************************************************/
+//add the frame of the current "ANMF" chunk, its sub chunks are visited by their headers only
+int anim_webpFrame(riff_handle *rh, riff_anim *anim){
+	uint8_t buf[WEBP_ANMF];
+	riff_readChunkStart(rh, buf, sizeof(buf));
+	struct riff_animFrame *f = anim_append(anim);
+	if(f == NULL)
+		return RIFF_ERROR_MEMORY;
+	f->pos = rh->c_pos_start;
+	f->x = convUInt24LE(buf) * 2;
+	f->y = convUInt24LE(buf + 3) * 2;
+	f->width = convUInt24LE(buf + 6) + 1;
+	f->height = convUInt24LE(buf + 9) + 1;
+	f->duration = convUInt24LE(buf + 12);
+	f->flags = buf[15] & (RIFF_ANIM_DISPOSE | RIFF_ANIM_NO_BLEND);
+	f->image = (uint32_t)anim->images++;
+
+	//optional "ALPH" and the "VP8 " or "VP8L" chunk, unknown chunks are skipped
+	size_t off = WEBP_ANMF;
+	while(off + RIFF_CHUNK_DATA_OFFSET <= rh->c_size){
+		char hdr[RIFF_CHUNK_DATA_OFFSET];
+		if(riff_seekInChunk(rh, off) != RIFF_ERROR_NONE  ||  riff_readInChunk(rh, hdr, sizeof(hdr)) != sizeof(hdr))
+			break;
+		size_t size = convUInt32LE(hdr + 4);
+		size_t pos = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + off + RIFF_CHUNK_DATA_OFFSET;
+		//data cut off by the end of the chunk is missing
+		if(size > rh->c_size - off - RIFF_CHUNK_DATA_OFFSET)
+			size = rh->c_size - off - RIFF_CHUNK_DATA_OFFSET;
+		if(memcmp(hdr, "ALPH", 4) == 0){
+			f->alpha_pos = pos;
+			f->alpha_size = (uint32_t)size;
+		}
+		else if(memcmp(hdr, "VP8 ", 4) == 0  ||  memcmp(hdr, "VP8L", 4) == 0){
+			memcpy(f->c_id, hdr, 4);
+			f->data_pos = pos;
+			f->data_size = (uint32_t)size;
+			break;
+		}
+		off += RIFF_CHUNK_DATA_OFFSET + size + (size & 1);
+	}
+	if(f->data_pos == 0){
+		anim->frames_len--;
+		anim->images--;
+		if(rh->fp_printf)
+			rh->fp_printf("No image data in \"ANMF\" chunk at pos %llu\n", (unsigned long long)rh->c_pos_start);
+		return RIFF_ERROR_ICSIZE;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//frames of a WebP file, only chunks of level 0
+int anim_webp(riff_handle *rh, riff_anim *anim, int *r){
+	uint8_t buf[WEBP_VP8X];
+	//alpha of a still image is an own chunk before the image
+	size_t alpha_pos = 0, alpha_size = 0;
+	int rr = RIFF_ERROR_NONE;
+	for(*r = riff_seekLevelStart(rh); *r == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; *r = riff_seekNextChunk(rh)){
+		if(memcmp(rh->c_id, "VP8X", 4) == 0){
+			riff_readChunkStart(rh, buf, WEBP_VP8X);
+			anim->flags = buf[0];
+			anim->width = convUInt24LE(buf + 4) + 1;
+			anim->height = convUInt24LE(buf + 7) + 1;
+		}
+		else if(memcmp(rh->c_id, "ANIM", 4) == 0){
+			riff_readChunkStart(rh, buf, WEBP_ANIM);
+			anim->background = convUInt32LE(buf);
+			anim->loops = convUInt16LE(buf + 4);
+		}
+		else if(memcmp(rh->c_id, "ANMF", 4) == 0)
+			rr = anim_webpFrame(rh, anim);
+		else if(memcmp(rh->c_id, "ALPH", 4) == 0){
+			alpha_pos = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET;
+			alpha_size = rh->c_size;
+		}
+		else if((memcmp(rh->c_id, "VP8 ", 4) == 0  ||  memcmp(rh->c_id, "VP8L", 4) == 0)  &&  anim->frames_len == 0){
+			struct riff_animFrame *f = anim_append(anim);
+			if(f == NULL)
+				return RIFF_ERROR_MEMORY;
+			f->pos = rh->c_pos_start;
+			f->data_pos = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET;
+			f->data_size = rh->c_size;
+			f->alpha_pos = alpha_pos;
+			f->alpha_size = alpha_size;
+			memcpy(f->c_id, rh->c_id, 4);
+			f->image = (uint32_t)anim->images++;
+			//simple format without "VP8X" chunk, the canvas is the image
+			if(anim->width == 0){
+				anim_webpStillSize(rh, f);
+				anim->width = f->width;
+				anim->height = f->height;
+			}
+			else {
+				f->width = anim->width;
+				f->height = anim->height;
+			}
+		}
+	}
+	return rr;
+}
+
+
+/*****************************************************************************/
+//read the 32 bit values of the current chunk into a new array
+//returns error code, array and amount of values via arr and len
+int anim_readValues(riff_handle *rh, uint32_t **arr, size_t *len){
+	//repeated chunk, last one wins
+	mem_free(&rh->alloc, *arr);
+	*arr = NULL;
+	*len = 0;
+	//a table cut off by the end of the file is shorter
+	size_t size = riff_availAt(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size);
+	size_t n = size / 4;
+	if(n == 0)
+		return RIFF_ERROR_NONE;
+	*arr = mem_alloc(&rh->alloc, n * 4);
+	if(*arr == NULL)
+		return RIFF_ERROR_MEMORY;
+	n = riff_readInChunk(rh, *arr, n * 4) / 4;
+	size_t i;
+	for(i = 0; i < n; i++)
+		(*arr)[i] = convUInt32LE(*arr + i);
+	*len = n;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//frames of an ANI file: "icon" chunks of the "LIST fram" chunk, in the order of the "seq " chunk if any
+int anim_ani(riff_handle *rh, riff_anim *anim, int *r){
+	uint8_t buf[ANI_ANIH] = {0};
+	uint32_t *rate = NULL, *seq = NULL;
+	size_t rate_len = 0, seq_len = 0;
+	//images are collected as frames first, expanded to the display steps at the end
+	int rr = RIFF_ERROR_NONE;
+	for(*r = riff_seekLevelStart(rh); *r == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; *r = riff_seekNextChunk(rh)){
+		if(memcmp(rh->c_id, "anih", 4) == 0)
+			riff_readChunkStart(rh, buf, ANI_ANIH);
+		else if(memcmp(rh->c_id, "rate", 4) == 0)
+			rr = anim_readValues(rh, &rate, &rate_len);
+		else if(memcmp(rh->c_id, "seq ", 4) == 0)
+			rr = anim_readValues(rh, &seq, &seq_len);
+		else if(memcmp(rh->c_id, "LIST", 4) == 0  &&  rh->c_size >= 4 + RIFF_CHUNK_DATA_OFFSET){
+			char type[4];
+			if(riff_readInChunk(rh, type, 4) != 4  ||  memcmp(type, "fram", 4) != 0  ||  anim->list_pos != 0)
+				continue;
+			anim->list_pos = rh->c_pos_start;
+			anim->list_size = rh->c_size;
+			int level = rh->ls_level;
+			int ri;
+			for(ri = riff_seekLevelSub(rh); ri == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+				if(memcmp(rh->c_id, "icon", 4) != 0)
+					continue;
+				struct riff_animFrame *f = anim_append(anim);
+				if(f == NULL){
+					rr = RIFF_ERROR_MEMORY;
+					break;
+				}
+				f->pos = rh->c_pos_start;
+				f->data_pos = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET;
+				f->data_size = rh->c_size;
+				memcpy(f->c_id, "icon", 4);
+				f->image = (uint32_t)anim->images++;
+			}
+			if(rh->ls_level > level)
+				riff_levelParent(rh);
+			//images cut off, the index is kept up to them
+			if(rr == RIFF_ERROR_NONE  &&  ri != RIFF_ERROR_EOCL)
+				rr = ri;
+		}
+	}
+
+	uint32_t steps = convUInt32LE(buf + 8);
+	uint32_t jiffies = convUInt32LE(buf + 28);
+	anim->width = convUInt32LE(buf + 12);
+	anim->height = convUInt32LE(buf + 16);
+	anim->flags = convUInt32LE(buf + 32);
+	if(steps == 0)
+		steps = (uint32_t)anim->images;
+	//without sequence the steps show the images in order
+	if(seq != NULL  &&  steps > seq_len)
+		steps = (uint32_t)seq_len;
+	if(seq == NULL  &&  steps > anim->images)
+		steps = (uint32_t)anim->images;
+
+	//images found before an error are still expanded
+	int rx = (rr == RIFF_ERROR_MEMORY) ? rr : anim_reserve(anim, steps);
+	if(rx == RIFF_ERROR_NONE){
+		//without sequence the steps are expanded in place, step i reads image i after writing at most slot i
+		struct riff_animFrame *images = anim->frames;
+		if(seq != NULL  &&  anim->images > 0){
+			images = mem_alloc(&anim->alloc, anim->images * sizeof(struct riff_animFrame));
+			if(images == NULL)
+				rx = RIFF_ERROR_MEMORY;
+			else
+				memcpy(images, anim->frames, anim->images * sizeof(struct riff_animFrame));
+		}
+		if(rx == RIFF_ERROR_NONE){
+			size_t i, n = 0;
+			for(i = 0; i < steps; i++){
+				uint32_t image = (seq != NULL) ? seq[i] : (uint32_t)i;
+				if(image >= anim->images)
+					continue; //invalid step
+				struct riff_animFrame *f = anim->frames + n++;
+				*f = images[image];
+				f->width = anim->width;
+				f->height = anim->height;
+				f->duration = (uint32_t)((uint64_t)((rate != NULL  &&  i < rate_len) ? rate[i] : jiffies) * 1000 / ANI_JIFFY_RATE);
+			}
+			anim->frames_len = n;
+		}
+		if(images != anim->frames)
+			mem_free(&anim->alloc, images);
+	}
+	if(rx != RIFF_ERROR_NONE)
+		rr = rx;
+	mem_free(&rh->alloc, rate);
+	mem_free(&rh->alloc, seq);
+	return rr;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_animOpen(riff_handle *rh, riff_anim *anim){
+	checkValidRiffHandle(rh);
+	if(anim == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(anim, 0, sizeof(riff_anim));
+	anim->alloc = rh->alloc;
+
+	if(memcmp(rh->h_type, "WEBP", 4) == 0)
+		anim->type = RIFF_ANIM_WEBP;
+	else if(memcmp(rh->h_type, "ACON", 4) == 0)
+		anim->type = RIFF_ANIM_ANI;
+	else {
+		if(rh->fp_printf)
+			rh->fp_printf("Not an animation, form type \"%s\"\n", rh->h_type);
+		return RIFF_ERROR_ILLID;
+	}
+
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	int r;
+	int rr = (anim->type == RIFF_ANIM_WEBP) ? anim_webp(rh, anim, &r) : anim_ani(rh, anim, &r);
+
+	size_t i;
+	for(i = 0; i < anim->frames_len; i++){
+		anim->frames[i].start = anim->duration;
+		anim->duration += anim->frames[i].duration;
+	}
+
+	if(rr == RIFF_ERROR_MEMORY  &&  rh->fp_printf)
+		rh->fp_printf("Failed to allocate frame index\n");
+	int rw = riff_rewind(rh);
+	if(rr != RIFF_ERROR_NONE)
+		return rr;
+	if(r != RIFF_ERROR_EOCL)
+		return r;
+	return rw;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_animClose(riff_anim *anim){
+	if(anim == NULL)
+		return;
+	mem_free(&anim->alloc, anim->frames);
+	memset(anim, 0, sizeof(riff_anim));
+}
+
+/*****************************************************************************/
+//put the handle on the chunk at pos, at data_pos within it
+static int seekData(riff_handle *rh, const riff_anim *anim, uint64_t pos, uint64_t data_pos){
+	//enter the "LIST fram" chunk if not in it
+	if(anim->list_pos == 0){
+		while(rh->ls_level > 0)
+			riff_levelParent(rh);
+	}
+	else if(rh->ls_level != 1  ||  rh->ls[0].c_pos_start != anim->list_pos){
+		while(rh->ls_level > 0)
+			riff_levelParent(rh);
+		rh->c_pos_start = anim->list_pos;
+		memcpy(rh->c_id, "LIST", 5);
+		rh->c_fourcc = RIFF_FOURCC_LIST;
+		rh->c_size = anim->list_size;
+		rh->pad = rh->c_size & 0x1;
+		int r = stack_push(rh, "fram");
+		if(r != RIFF_ERROR_NONE)
+			return r;
+	}
+
+	rh->pos = (size_t)pos;
+	rh->fp_seek(rh, rh->pos);
+	int r = riff_readChunkHeader(rh);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+	return riff_seekInChunk(rh, (size_t)(data_pos - pos - RIFF_CHUNK_DATA_OFFSET));
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_animSeekFrame(riff_handle *rh, const riff_anim *anim, size_t frame){
+	checkValidRiffHandle(rh);
+	if(anim == NULL  ||  frame >= anim->frames_len)
+		return RIFF_ERROR_EOC;
+	const struct riff_animFrame *f = anim->frames + frame;
+	return seekData(rh, anim, f->pos, f->data_pos);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_animSeekAlpha(riff_handle *rh, const riff_anim *anim, size_t frame){
+	checkValidRiffHandle(rh);
+	if(anim == NULL  ||  frame >= anim->frames_len  ||  anim->frames[frame].alpha_pos == 0)
+		return RIFF_ERROR_EOC;
+	const struct riff_animFrame *f = anim->frames + frame;
+	//still image: own "ALPH" chunk before the image chunk
+	uint64_t pos = (f->alpha_pos < f->pos) ? f->alpha_pos - RIFF_CHUNK_DATA_OFFSET : f->pos;
+	return seekData(rh, anim, pos, f->alpha_pos);
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_animFrameAt(const riff_anim *anim, uint64_t time){
+	if(anim == NULL  ||  anim->frames_len == 0)
+		return (size_t)-1;
+	//last frame starting at or before time
+	size_t lo = 0, hi = anim->frames_len;
+	while(hi - lo > 1){
+		size_t mid = lo + (hi - lo) / 2;
+		if(anim->frames[mid].start <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
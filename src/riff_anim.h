@@ -0,0 +1,246 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Frame index of animated images: WebP ("RIFF WEBP") and animated cursors ("RIFF ACON", .ani files).
+Opening reads only chunk headers and the small frame headers ("ANMF" header, "anih", "rate", "seq "), no image data.
+Afterwards the riff_handle is positioned on the image data of any frame in constant time.
+
+WebP: one frame per "ANMF" chunk, a still image ("VP8 " or "VP8L" chunk of level 0) is a single frame.
+ANI: one frame per display step, steps of a "seq " chunk can show the same "icon" chunk, see riff_animFrame::image.
+
+
+Usage:
+Open the file with the usual riff_handle functions
+Call riff_animOpen() to build the frame index
+Call riff_animSeekFrame() to position the riff_handle on the image data of a frame, read it with riff_readInChunk()
+Call riff_animFrameAt() to find the frame shown at a point in time
+Call riff_animClose() to free the index
+*/
+
+#ifndef _RIFF_ANIM_H_
+#define _RIFF_ANIM_H_
+
+#include "riff.h"
+
+/**
+ * @defgroup Anim_types Animation types
+ * @{
+ */
+/**
+ * @brief No animation opened.
+ */
+#define RIFF_ANIM_NONE		0
+/**
+ * @brief WebP image, "RIFF WEBP".
+ */
+#define RIFF_ANIM_WEBP		1
+/**
+ * @brief Animated cursor, "RIFF ACON".
+ */
+#define RIFF_ANIM_ANI		2
+///@}
+
+/**
+ * @defgroup Anim_flags Frame flags
+ * @{
+ */
+/**
+ * @brief Dispose the frame area to the background color before the next frame, WebP only.
+ */
+#define RIFF_ANIM_DISPOSE	0x01
+/**
+ * @brief Overwrite the canvas instead of alpha blending, WebP only.
+ */
+#define RIFF_ANIM_NO_BLEND	0x02
+///@}
+
+/**
+ * @brief Frame of an animation.
+ */
+struct riff_animFrame {
+	/**
+	 * @brief Absolute position of the chunk holding the frame: "ANMF", "icon" or "VP8 "/"VP8L" of a still WebP.
+	 */
+	uint64_t pos;
+	/**
+	 * @brief Absolute position of the image data, the data of the "VP8 "/"VP8L" or "icon" chunk.
+	 */
+	uint64_t data_pos;
+	/**
+	 * @brief Size of the image data.
+	 */
+	uint32_t data_size;
+	/**
+	 * @brief Size of the alpha data ("ALPH" chunk data), 0 if none.
+	 */
+	uint32_t alpha_size;
+	/**
+	 * @brief Absolute position of the alpha data.
+	 */
+	uint64_t alpha_pos;
+	/**
+	 * @brief ID of the chunk of the image data: "VP8 ", "VP8L" or "icon".
+	 */
+	char c_id[5];
+	/**
+	 * @brief Frame flags, see @ref Anim_flags.
+	 */
+	uint8_t flags;
+	/**
+	 * @brief Left offset on the canvas in pixels.
+	 */
+	uint32_t x;
+	/**
+	 * @brief Top offset on the canvas in pixels.
+	 */
+	uint32_t y;
+	/**
+	 * @brief Width in pixels, for ANI files the one of the "anih" chunk, 0 if not known.
+	 */
+	uint32_t width;
+	/**
+	 * @brief Height in pixels, see riff_animFrame::width.
+	 */
+	uint32_t height;
+	/**
+	 * @brief Display duration in milliseconds.
+	 */
+	uint32_t duration;
+	/**
+	 * @brief Start time in milliseconds, sum of the durations of all frames before.
+	 */
+	uint64_t start;
+	/**
+	 * @brief Number of the image in file order, frames of an ANI sequence can share an image.
+	 */
+	uint32_t image;
+};
+
+/**
+ * @brief Frame index of an animation.
+ */
+typedef struct riff_anim {
+	/**
+	 * @brief Animation type, see @ref Anim_types.
+	 */
+	int type;
+	/**
+	 * @brief Canvas width in pixels, 0 if not known.
+	 */
+	uint32_t width;
+	/**
+	 * @brief Canvas height in pixels, 0 if not known.
+	 */
+	uint32_t height;
+	/**
+	 * @brief Flags of the "VP8X" or "anih" chunk.
+	 */
+	uint32_t flags;
+	/**
+	 * @brief Loop count of the "ANIM" chunk, 0 for infinite.
+	 */
+	uint32_t loops;
+	/**
+	 * @brief Background color of the "ANIM" chunk, bytes [blue, green, red, alpha] as little endian value.
+	 */
+	uint32_t background;
+	/**
+	 * @brief Total duration in milliseconds.
+	 */
+	uint64_t duration;
+	/**
+	 * @brief Amount of images ("ANMF", "icon" chunks), riff_anim::frames_len for WebP.
+	 */
+	size_t images;
+
+	/**
+	 * @brief Frames in display order, frame `n` is entry `n`.
+	 */
+	struct riff_animFrame *frames;
+	/**
+	 * @brief Amount of frames.
+	 */
+	size_t frames_len;
+	/**
+	 * @brief Amount of allocated frames.
+	 */
+	size_t frames_size;
+
+	/**
+	 * @brief Absolute position of the "LIST fram" chunk holding the frames of an ANI file, 0 if the frames are on level 0.
+	 */
+	size_t list_pos;
+	/**
+	 * @brief Data size of the "LIST fram" chunk.
+	 */
+	size_t list_size;
+
+	/**
+	 * @brief Allocator of the index, the one of the riff_handle it was opened with.
+	 */
+	riff_allocator alloc;
+} riff_anim;
+
+/**
+ * @defgroup RIFF_C_Anim C animation functions
+ * @{
+ */
+/**
+ * @brief Build the frame index of a WebP or ANI file, image data is not read.
+ *
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param rh The riff_handle to use, opened WebP or ANI file.
+ * @param anim The riff_anim to fill, free with riff_animClose() even on failure.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ILLID if the file is no WebP or ANI file.
+ */
+int riff_animOpen(riff_handle *rh, riff_anim *anim);
+/**
+ * @brief Free the frame index.
+ *
+ * @param anim The riff_anim filled by riff_animOpen().
+ */
+void riff_animClose(riff_anim *anim);
+/**
+ * @brief Position the riff_handle on the image data of a frame, in constant time.
+ *
+ * The handle is in the chunk of the frame (riff_animFrame::pos), read `riff_animFrame::data_size` bytes with riff_readInChunk().
+ *
+ * @param rh The riff_handle of the file.
+ * @param anim The riff_anim filled by riff_animOpen().
+ * @param frame Frame number.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the frame does not exist.
+ */
+int riff_animSeekFrame(riff_handle *rh, const riff_anim *anim, size_t frame);
+/**
+ * @brief Position the riff_handle on the alpha data of a frame, in constant time.
+ *
+ * The handle is in the "ANMF" chunk of the frame or, for a still WebP, in the "ALPH" chunk.
+ * Read `riff_animFrame::alpha_size` bytes with riff_readInChunk().
+ *
+ * @param rh The riff_handle of the file.
+ * @param anim The riff_anim filled by riff_animOpen().
+ * @param frame Frame number.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the frame does not exist or has no alpha data.
+ */
+int riff_animSeekAlpha(riff_handle *rh, const riff_anim *anim, size_t frame);
+/**
+ * @brief Find the frame shown at a point in time, looping is not applied.
+ *
+ * @param anim The riff_anim filled by riff_animOpen().
+ * @param time Time in milliseconds.
+ *
+ * @return Frame number, the last frame for times beyond the end, `(size_t)-1` if there are no frames.
+ */
+size_t riff_animFrameAt(const riff_anim *anim, uint64_t time);
+
+///@}
+
+#endif // _RIFF_ANIM_H_
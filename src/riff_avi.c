@@ -0,0 +1,585 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => index data and "RIFF AVIX" chunks lie outside of the level structure of the handle, they are read with riff_readAt(),
+//      riff_aviOpen() ends with riff_rewind() to get consistent positions again
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_avi.h"
+#include "riff_internal.h"
+
+
+#define RIFF_AVI_IDX_ALLOC 1024       //number of index entries allocated per stream at least
+#define RIFF_AVI_READ_BUFFER 65536    //index data read at once
+
+#define AVI_AVIH_SIZE 40   //used part of the main header
+#define AVI_STRH_SIZE 48   //stream header up to the sample size
+#define AVI_IDX1_ENTRY 16
+#define AVI_INDEX_HEADER 32   //chunk header and OpenDML index header
+#define AVI_INDEX_OF_INDEXES 0x00
+#define AVI_INDEX_OF_CHUNKS 0x01
+#define AVI_IDX1_LIST 0x01    //AVIIF_LIST, entry of a "rec " list
+#define AVI_ODML_NOKEY 0x80000000    //standard index size bit of non key frames
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//stream number of chunk ID "##xx", -1 if none or not a frame (palette change)
+int avi_streamOf(const riff_avi *avi, const char *id){
+	if(id[0] < '0'  ||  id[0] > '9'  ||  id[1] < '0'  ||  id[1] > '9')
+		return -1;
+	if(id[2] == 'p'  &&  id[3] == 'c')
+		return -1;
+	int n = (id[0] - '0') * 10 + (id[1] - '0');
+	if((size_t)n >= avi->streams_len)
+		return -1;
+	return n;
+}
+
+
+/*****************************************************************************/
+//make room for len index entries
+int avi_reserve(const riff_allocator *a, struct riff_aviStream *st, size_t len){
+	if(len <= st->idx_size)
+		return RIFF_ERROR_NONE;
+	size_t idx_size_new = st->idx_size * 2; //double size
+	if(idx_size_new < len)
+		idx_size_new = len;
+	if(idx_size_new < RIFF_AVI_IDX_ALLOC)
+		idx_size_new = RIFF_AVI_IDX_ALLOC;
+	struct riff_aviEntry *idxnew = mem_realloc(a, st->idx, idx_size_new * sizeof(struct riff_aviEntry));
+	if(idxnew == NULL)
+		return RIFF_ERROR_MEMORY;
+	st->idx = idxnew;
+	st->idx_size = idx_size_new;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+int avi_append(const riff_allocator *a, struct riff_aviStream *st, uint64_t pos, uint32_t size, uint32_t flags){
+	if(st->idx_len >= st->idx_size){
+		int r = avi_reserve(a, st, st->idx_len + 1);
+		if(r != RIFF_ERROR_NONE)
+			return r;
+	}
+	struct riff_aviEntry *e = st->idx + st->idx_len++;
+	e->pos = pos;
+	e->size = size;
+	e->flags = flags;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+int avi_addMovi(riff_avi *avi, size_t pos, size_t size){
+	struct riff_aviMovi *movinew = mem_realloc(&avi->alloc, avi->movi, (avi->movi_len + 1) * sizeof(struct riff_aviMovi));
+	if(movinew == NULL)
+		return RIFF_ERROR_MEMORY;
+	avi->movi = movinew;
+	avi->movi[avi->movi_len].pos = pos;
+	avi->movi[avi->movi_len].size = size;
+	avi->movi_len++;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//"movi" list containing position, NULL if none
+const struct riff_aviMovi *avi_findMovi(const riff_avi *avi, uint64_t pos){
+	size_t lo = 0, hi = avi->movi_len;
+	while(lo < hi){
+		size_t mid = lo + (hi - lo) / 2;
+		const struct riff_aviMovi *m = avi->movi + mid;
+		if(pos < m->pos + RIFF_HEADER_SIZE)
+			hi = mid;
+		else if(pos >= m->pos + RIFF_CHUNK_DATA_OFFSET + m->size)
+			lo = mid + 1;
+		else
+			return m;
+	}
+	return NULL;
+}
+
+
+/*****************************************************************************/
+//description: see riff_internal.h
+int avi_moviNext(const riff_avi *avi, struct avi_moviCursor *mc){
+	while(mc->pos + RIFF_CHUNK_DATA_OFFSET > mc->end){
+		if(mc->k >= avi->movi_len)
+			return 0;
+		const struct riff_aviMovi *mv = avi->movi + mc->k++;
+		mc->pos = mv->pos + RIFF_HEADER_SIZE;
+		mc->end = mv->pos + RIFF_CHUNK_DATA_OFFSET + mv->size;
+	}
+	return 1;
+}
+
+/*****************************************************************************/
+//description: see riff_internal.h
+int avi_moviSkip(struct avi_moviCursor *mc, const uint8_t *h){
+	//chunks of "rec " lists follow each other just like those of the "movi" list
+	if(memcmp(h, "LIST", 4) == 0){
+		mc->pos += RIFF_HEADER_SIZE;
+		return 1;
+	}
+	size_t size = convUInt32LE(h + 4);
+	mc->pos += RIFF_CHUNK_DATA_OFFSET + size + (size & 0x1);
+	return 0;
+}
+
+
+/*****************************************************************************/
+//read type of current chunk list, at chunk data start
+static int listType(riff_handle *rh, char *type){
+	riff_seekChunkStart(rh);
+	if(riff_readInChunk(rh, type, 4) != 4)
+		return 0;
+	type[4] = 0;
+	return 1;
+}
+
+
+/*****************************************************************************/
+//parse stream header list, handle is at its first sub chunk
+int avi_readStrl(riff_handle *rh, riff_avi *avi){
+	struct riff_aviStream *streamsnew = mem_realloc(&avi->alloc, avi->streams, (avi->streams_len + 1) * sizeof(struct riff_aviStream));
+	if(streamsnew == NULL)
+		return RIFF_ERROR_MEMORY;
+	avi->streams = streamsnew;
+	struct riff_aviStream *st = avi->streams + avi->streams_len++;
+	memset(st, 0, sizeof(struct riff_aviStream));
+
+	int r = RIFF_ERROR_NONE;
+	while(r == RIFF_ERROR_NONE){
+		if(memcmp(rh->c_id, "strh", 4) == 0){
+			uint8_t buf[AVI_STRH_SIZE] = {0};
+			riff_readInChunk(rh, buf, AVI_STRH_SIZE);
+			memcpy(st->type, buf, 4);
+			memcpy(st->handler, buf + 4, 4);
+			st->scale = convUInt32LE(buf + 20);
+			st->rate = convUInt32LE(buf + 24);
+			st->start = convUInt32LE(buf + 28);
+			st->length = convUInt32LE(buf + 32);
+			st->sample_size = convUInt32LE(buf + 44);
+		}
+		else if(memcmp(rh->c_id, "indx", 4) == 0)
+			st->indx_pos = rh->c_pos_start;
+		r = riff_seekNextChunk(rh);
+	}
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//parse header list, handle is at its first sub chunk
+//broken sub chunks end the list, the streams found so far are kept
+int avi_readHdrl(riff_handle *rh, riff_avi *avi){
+	int r = RIFF_ERROR_NONE;
+	char type[5];
+	while(r == RIFF_ERROR_NONE){
+		if(memcmp(rh->c_id, "avih", 4) == 0){
+			uint8_t buf[AVI_AVIH_SIZE] = {0};
+			riff_readInChunk(rh, buf, AVI_AVIH_SIZE);
+			avi->usec_per_frame = convUInt32LE(buf);
+			avi->flags = convUInt32LE(buf + 12);
+			if(avi->total_frames == 0)
+				avi->total_frames = convUInt32LE(buf + 16);
+			avi->width = convUInt32LE(buf + 32);
+			avi->height = convUInt32LE(buf + 36);
+		}
+		else if(memcmp(rh->c_id, "LIST", 4) == 0  &&  listType(rh, type)){
+			int level = rh->ls_level;
+			if(memcmp(type, "strl", 4) == 0  &&  riff_seekLevelSub(rh) == RIFF_ERROR_NONE)
+				r = avi_readStrl(rh, avi);
+			//OpenDML header, total frames of all "RIFF" chunks
+			else if(memcmp(type, "odml", 4) == 0  &&  riff_seekLevelSub(rh) == RIFF_ERROR_NONE){
+				if(memcmp(rh->c_id, "dmlh", 4) == 0){
+					uint8_t buf[4];
+					if(riff_readInChunk(rh, buf, 4) == 4)
+						avi->total_frames = convUInt32LE(buf);
+				}
+			}
+			if(rh->ls_level > level)
+				riff_levelParent(rh);
+			if(r != RIFF_ERROR_NONE)
+				return r;
+		}
+		r = riff_seekNextChunk(rh);
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//load OpenDML standard index chunk at pos
+int avi_loadStd(riff_handle *rh, struct riff_aviStream *st, size_t pos, uint8_t *buf){
+	uint8_t h[AVI_INDEX_HEADER];
+	if(riff_readAt(rh, pos, h, AVI_INDEX_HEADER) != AVI_INDEX_HEADER)
+		return RIFF_ERROR_EOF;
+	size_t size = convUInt32LE(h + 4);
+	size_t esize = (size_t)convUInt16LE(h + 8) * 4;
+	if(h[11] != AVI_INDEX_OF_CHUNKS  ||  esize < 8  ||  size < AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET){
+		if(rh->fp_printf)
+			rh->fp_printf("Invalid OpenDML standard index at pos %zu\n", pos);
+		return RIFF_ERROR_ILLID;
+	}
+	size_t n = convUInt32LE(h + 12);
+	if(n > (size - (AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET)) / esize)
+		n = (size - (AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET)) / esize;
+	//entries cut off by the end of the file are lost
+	n = riff_availAt(rh, pos + AVI_INDEX_HEADER, n * esize) / esize;
+	uint64_t base = convUInt64LE(h + 20);
+
+	//offsets point to the chunk data
+	//the index grows with the entries actually read, the counts of the header may be made up
+	size_t per = RIFF_AVI_READ_BUFFER / esize;
+	size_t done = 0, i, m, got;
+	pos += AVI_INDEX_HEADER;
+	while(done < n){
+		m = n - done;
+		if(m > per)
+			m = per;
+		got = riff_readAt(rh, pos + done * esize, buf, m * esize) / esize;
+		int r = avi_reserve(&rh->alloc, st, st->idx_len + got);
+		if(r != RIFF_ERROR_NONE)
+			return r;
+		for(i = 0; i < got; i++){
+			const uint8_t *p = buf + i * esize;
+			uint32_t sz = convUInt32LE(p + 4);
+			struct riff_aviEntry *e = st->idx + st->idx_len++;
+			e->pos = base + convUInt32LE(p) - RIFF_CHUNK_DATA_OFFSET;
+			e->size = sz & ~AVI_ODML_NOKEY;
+			e->flags = (sz & AVI_ODML_NOKEY) ? 0 : RIFF_AVI_KEYFRAME;
+		}
+		done += got;
+		//the end of the file, also where its size is unknown
+		if(got < m)
+			break;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//load OpenDML super index of stream, the "indx" chunk may be a standard index itself
+int avi_loadIndx(riff_handle *rh, struct riff_aviStream *st, uint8_t *buf){
+	uint8_t h[AVI_INDEX_HEADER];
+	if(riff_readAt(rh, st->indx_pos, h, AVI_INDEX_HEADER) != AVI_INDEX_HEADER)
+		return RIFF_ERROR_EOF;
+	if(h[11] == AVI_INDEX_OF_CHUNKS)
+		return avi_loadStd(rh, st, st->indx_pos, buf);
+
+	size_t size = convUInt32LE(h + 4);
+	size_t esize = (size_t)convUInt16LE(h + 8) * 4;
+	if(h[11] != AVI_INDEX_OF_INDEXES  ||  esize < 16  ||  size < AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET){
+		if(rh->fp_printf)
+			rh->fp_printf("Invalid OpenDML super index at pos %zu\n", st->indx_pos);
+		return RIFF_ERROR_ILLID;
+	}
+	size_t n = convUInt32LE(h + 12);
+	if(n > (size - (AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET)) / esize)
+		n = (size - (AVI_INDEX_HEADER - RIFF_CHUNK_DATA_OFFSET)) / esize;
+	size_t want = n;    //a cut off super index is still reported
+	n = riff_availAt(rh, st->indx_pos + AVI_INDEX_HEADER, n * esize) / esize;
+
+	//super index entries first, the buffer is reused for the standard indexes
+	//they are kept as far as read, like the standard index entries
+	uint64_t *std = NULL;
+	size_t per = RIFF_AVI_READ_BUFFER / esize;
+	size_t done = 0, i, m;
+	int r = RIFF_ERROR_NONE;
+	while(done < n){
+		m = n - done;
+		if(m > per)
+			m = per;
+		m = riff_readAt(rh, st->indx_pos + AVI_INDEX_HEADER + done * esize, buf, m * esize) / esize;
+		if(m == 0)
+			break;
+		uint64_t *stdnew = mem_realloc(&rh->alloc, std, (done + m) * sizeof(uint64_t));
+		if(stdnew == NULL){
+			mem_free(&rh->alloc, std);
+			return RIFF_ERROR_MEMORY;
+		}
+		std = stdnew;
+		for(i = 0; i < m; i++)
+			std[done + i] = convUInt64LE(buf + i * esize);
+		done += m;
+	}
+	for(i = 0; i < done  &&  r == RIFF_ERROR_NONE; i++)
+		r = avi_loadStd(rh, st, (size_t)std[i], buf);
+	mem_free(&rh->alloc, std);
+	if(r == RIFF_ERROR_NONE  &&  done < want)
+		r = RIFF_ERROR_EOF;
+	return r;
+}
+
+
+/*****************************************************************************/
+//load AVI 1.0 index for all streams without index
+int avi_loadIdx1(riff_handle *rh, riff_avi *avi, size_t size, uint8_t *buf){
+	size_t n = size / AVI_IDX1_ENTRY;
+	size_t per = RIFF_AVI_READ_BUFFER / AVI_IDX1_ENTRY;
+	size_t done = 0, i, m;
+	int based = 0;
+	uint64_t base = avi->movi[0].pos + RIFF_CHUNK_DATA_OFFSET; //relative to the "movi" list type by default
+	while(done < n){
+		m = n - done;
+		if(m > per)
+			m = per;
+		m = riff_readAt(rh, avi->idx1_pos + RIFF_CHUNK_DATA_OFFSET + done * AVI_IDX1_ENTRY, buf, m * AVI_IDX1_ENTRY) / AVI_IDX1_ENTRY;
+		if(m == 0)
+			break;
+		for(i = 0; i < m; i++){
+			const uint8_t *p = buf + i * AVI_IDX1_ENTRY;
+			uint32_t flags = convUInt32LE(p + 4);
+			int s = avi_streamOf(avi, (const char *)p);
+			if(s < 0  ||  (flags & AVI_IDX1_LIST)  ||  avi->streams[s].index != RIFF_AVI_INDEX_IDX1)
+				continue;
+			uint32_t off = convUInt32LE(p + 8);
+
+			//first entry tells if offsets are relative or absolute: which position has the chunk ID?
+			if(!based){
+				char id[4];
+				based = 1;
+				if(!(riff_readAt(rh, base + off, id, 4) == 4  &&  memcmp(id, p, 4) == 0)
+				  &&  riff_readAt(rh, off, id, 4) == 4  &&  memcmp(id, p, 4) == 0)
+					base = 0;
+			}
+
+			int r = avi_append(&avi->alloc, avi->streams + s, base + off, convUInt32LE(p + 12), flags);
+			if(r != RIFF_ERROR_NONE)
+				return r;
+		}
+		done += m;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//build index from all "movi" lists for streams without index
+int avi_scanMovi(riff_handle *rh, riff_avi *avi){
+	struct avi_moviCursor mc = {0, 0, 0};
+	uint8_t h[RIFF_CHUNK_DATA_OFFSET];
+	while(avi_moviNext(avi, &mc)){
+		//a cut off list ends here, the next one may still be there
+		if(riff_readAt(rh, mc.pos, h, RIFF_CHUNK_DATA_OFFSET) != RIFF_CHUNK_DATA_OFFSET){
+			mc.pos = mc.end;
+			continue;
+		}
+		size_t pos = mc.pos;
+		if(avi_moviSkip(&mc, h))
+			continue;
+		int s = avi_streamOf(avi, (const char *)h);
+		if(s >= 0  &&  avi->streams[s].index == RIFF_AVI_INDEX_SCAN){
+			int r = avi_append(&avi->alloc, avi->streams + s, pos, convUInt32LE(h + 4), RIFF_AVI_KEYFRAME);
+			if(r != RIFF_ERROR_NONE)
+				return r;
+		}
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//find "movi" lists of "RIFF AVIX" chunks following the first "RIFF" chunk
+int avi_findAvix(riff_handle *rh, riff_avi *avi){
+	size_t pos = rh->pos_start + RIFF_CHUNK_DATA_OFFSET + rh->h_size + (rh->h_size & 0x1);
+	uint8_t h[2 * RIFF_HEADER_SIZE];
+	while(riff_readAt(rh, pos, h, 2 * RIFF_HEADER_SIZE) == 2 * RIFF_HEADER_SIZE){
+		if(memcmp(h, "RIFF", 4) != 0  ||  memcmp(h + 8, "AVIX", 4) != 0)
+			break;
+		size_t size = convUInt32LE(h + 4);
+		if(memcmp(h + 12, "LIST", 4) == 0  &&  memcmp(h + 20, "movi", 4) == 0){
+			int r = avi_addMovi(avi, pos + RIFF_HEADER_SIZE, convUInt32LE(h + 16));
+			if(r != RIFF_ERROR_NONE)
+				return r;
+		}
+		pos += RIFF_CHUNK_DATA_OFFSET + size + (size & 0x1);
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviOpenHeaders(riff_handle *rh, riff_avi *avi){
+	checkValidRiffHandle(rh);
+	if(avi == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(avi, 0, sizeof(riff_avi));
+	avi->alloc = rh->alloc;
+
+	if(memcmp(rh->h_type, "AVI ", 4) != 0){
+		if(rh->fp_printf)
+			rh->fp_printf("Not an AVI file, form type \"%s\"\n", rh->h_type);
+		return RIFF_ERROR_ILLID;
+	}
+
+	//single scan of the top level
+	int hdrl = 0;
+	char type[5];
+	int r = riff_rewind(rh);
+	while(r == RIFF_ERROR_NONE){
+		if(memcmp(rh->c_id, "LIST", 4) == 0  &&  listType(rh, type)){
+			if(!hdrl  &&  memcmp(type, "hdrl", 4) == 0){
+				hdrl = 1;
+				if(riff_seekLevelSub(rh) == RIFF_ERROR_NONE)
+					r = avi_readHdrl(rh, avi);
+				if(rh->ls_level > 0)
+					riff_levelParent(rh);
+				if(r != RIFF_ERROR_NONE)
+					break;
+			}
+			else if(avi->movi_len == 0  &&  memcmp(type, "movi", 4) == 0){
+				if((r = avi_addMovi(avi, rh->c_pos_start, rh->c_size)) != RIFF_ERROR_NONE)
+					break;
+			}
+		}
+		else if(avi->idx1_pos == 0  &&  memcmp(rh->c_id, "idx1", 4) == 0){
+			avi->idx1_pos = rh->c_pos_start;
+			avi->idx1_size = rh->c_size;
+		}
+		r = riff_seekNextChunk(rh);
+	}
+	if(r == RIFF_ERROR_MEMORY){
+		riff_rewind(rh);
+		return r;
+	}
+
+	if(!hdrl  ||  avi->movi_len == 0){
+		if(rh->fp_printf)
+			rh->fp_printf("AVI file without \"%s\" list\n", hdrl ? "movi" : "hdrl");
+		riff_rewind(rh);
+		return RIFF_ERROR_ILLID;
+	}
+	r = avi_findAvix(rh, avi);
+	riff_rewind(rh);
+	return r;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviOpen(riff_handle *rh, riff_avi *avi){
+	int r = riff_aviOpenHeaders(rh, avi);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+
+	uint8_t *buf = mem_alloc(&avi->alloc, RIFF_AVI_READ_BUFFER);
+	if(buf == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate index buffer\n");
+		riff_rewind(rh);
+		return RIFF_ERROR_MEMORY;
+	}
+
+	//OpenDML index where present, a broken one is replaced by the next source
+	size_t i;
+	int scan = 0;
+	r = RIFF_ERROR_NONE;
+	for(i = 0; i < avi->streams_len  &&  r != RIFF_ERROR_MEMORY; i++){
+		struct riff_aviStream *st = avi->streams + i;
+		if(st->indx_pos == 0)
+			continue;
+		r = avi_loadIndx(rh, st, buf);
+		if(r == RIFF_ERROR_NONE)
+			st->index = RIFF_AVI_INDEX_ODML;
+		else
+			st->idx_len = 0;
+	}
+	//then "idx1" or scan
+	for(i = 0; i < avi->streams_len; i++){
+		struct riff_aviStream *st = avi->streams + i;
+		if(st->index == RIFF_AVI_INDEX_NONE){
+			st->index = (avi->idx1_pos != 0) ? RIFF_AVI_INDEX_IDX1 : RIFF_AVI_INDEX_SCAN;
+			scan |= (st->index == RIFF_AVI_INDEX_SCAN);
+		}
+	}
+	if(r != RIFF_ERROR_MEMORY)
+		r = RIFF_ERROR_NONE;
+	if(r == RIFF_ERROR_NONE  &&  avi->idx1_pos != 0)
+		r = avi_loadIdx1(rh, avi, avi->idx1_size, buf);
+	if(r == RIFF_ERROR_NONE  &&  scan)
+		r = avi_scanMovi(rh, avi);
+	mem_free(&avi->alloc, buf);
+
+	if(r == RIFF_ERROR_MEMORY  &&  rh->fp_printf)
+		rh->fp_printf("Failed to allocate AVI index\n");
+	riff_rewind(rh);
+	return r;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_aviClose(riff_avi *avi){
+	if(avi == NULL)
+		return;
+	size_t i;
+	for(i = 0; i < avi->streams_len; i++)
+		mem_free(&avi->alloc, avi->streams[i].idx);
+	mem_free(&avi->alloc, avi->streams);
+	mem_free(&avi->alloc, avi->movi);
+	memset(avi, 0, sizeof(riff_avi));
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviSeekFrame(riff_handle *rh, const riff_avi *avi, size_t stream, size_t frame){
+	checkValidRiffHandle(rh);
+	if(avi == NULL  ||  stream >= avi->streams_len  ||  frame >= avi->streams[stream].idx_len)
+		return RIFF_ERROR_EOC;
+	const struct riff_aviEntry *e = avi->streams[stream].idx + frame;
+	const struct riff_aviMovi *mv = avi_findMovi(avi, e->pos);
+	if(mv == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Index entry at pos %llu is outside of the \"movi\" lists\n", (unsigned long long)e->pos);
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	//enter the "movi" list if not in it, those of "RIFF AVIX" chunks are entered from level 0 as well
+	if(rh->ls_level != 1  ||  rh->ls[0].c_pos_start != mv->pos){
+		while(rh->ls_level > 0)
+			riff_levelParent(rh);
+		rh->c_pos_start = mv->pos;
+		memcpy(rh->c_id, "LIST", 5);
+		rh->c_fourcc = RIFF_FOURCC_LIST;
+		rh->c_size = mv->size;
+		rh->pad = rh->c_size & 0x1;
+		int r = stack_push(rh, "movi");
+		if(r != RIFF_ERROR_NONE)
+			return r;
+	}
+
+	rh->pos = (size_t)e->pos;
+	rh->fp_seek(rh, rh->pos);
+	return riff_readChunkHeader(rh);
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_aviKeyFrame(const riff_avi *avi, size_t stream, size_t frame){
+	if(avi == NULL  ||  stream >= avi->streams_len)
+		return (size_t)-1;
+	const struct riff_aviStream *st = avi->streams + stream;
+	if(st->idx_len == 0)
+		return (size_t)-1;
+	if(frame >= st->idx_len)
+		frame = st->idx_len - 1;
+	while(!(st->idx[frame].flags & RIFF_AVI_KEYFRAME)){
+		if(frame == 0)
+			return (size_t)-1;
+		frame--;
+	}
+	return frame;
+}
@@ -0,0 +1,265 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Frame index of AVI files, including OpenDML (AVI 2.0) files with "RIFF AVIX" extension chunks.
+Works on an opened riff_handle, the index of every stream is loaded into a compact array once.
+Afterwards the riff_handle is positioned on the chunk of any frame in constant time.
+
+Index sources, per stream:
+  OpenDML super index ("indx" in the stream header list) and its standard index chunks ("ix##")
+  AVI 1.0 index ("idx1"), offsets relative to the "movi" list or absolute are detected automatically
+  Scan of all "movi" lists if a stream has no index, every chunk found is marked as key frame
+
+
+Usage:
+Open the file with the usual riff_handle functions
+Call riff_aviOpen() to read the stream headers and load the index of every stream
+Call riff_aviSeekFrame() to position the riff_handle on the chunk of a frame, read it with riff_readInChunk()
+Call riff_aviKeyFrame() to find the key frame to start decoding from
+Call riff_aviClose() to free the index
+*/
+
+#ifndef _RIFF_AVI_H_
+#define _RIFF_AVI_H_
+
+#include "riff.h"
+
+/**
+ * @brief Index flag of key frames, `AVIIF_KEYFRAME`.
+ */
+#define RIFF_AVI_KEYFRAME	0x10
+
+/**
+ * @defgroup AVI_index Index sources
+ * @{
+ */
+/**
+ * @brief No index loaded.
+ */
+#define RIFF_AVI_INDEX_NONE	0
+/**
+ * @brief OpenDML super and standard indexes.
+ */
+#define RIFF_AVI_INDEX_ODML	1
+/**
+ * @brief AVI 1.0 "idx1" index.
+ */
+#define RIFF_AVI_INDEX_IDX1	2
+/**
+ * @brief Scan of the "movi" lists.
+ */
+#define RIFF_AVI_INDEX_SCAN	3
+///@}
+
+/**
+ * @brief Index entry, one chunk of a stream.
+ */
+struct riff_aviEntry {
+	/**
+	 * @brief Absolute chunk position in file stream.
+	 */
+	uint64_t pos;
+	/**
+	 * @brief Chunk data size.
+	 */
+	uint32_t size;
+	/**
+	 * @brief Index flags, ::RIFF_AVI_KEYFRAME for key frames.
+	 */
+	uint32_t flags;
+};
+
+/**
+ * @brief Stream of an AVI file with its index.
+ */
+struct riff_aviStream {
+	/**
+	 * @brief Stream type, e.g. "vids" or "auds".
+	 */
+	char type[5];
+	/**
+	 * @brief Codec FOURCC of the stream header.
+	 */
+	char handler[5];
+	/**
+	 * @brief Time scale, `rate / scale` is the amount of samples per second.
+	 */
+	uint32_t scale;
+	/**
+	 * @brief Rate, see riff_aviStream::scale.
+	 */
+	uint32_t rate;
+	/**
+	 * @brief Start time in units of `scale / rate`.
+	 */
+	uint32_t start;
+	/**
+	 * @brief Length in units of `scale / rate`.
+	 */
+	uint32_t length;
+	/**
+	 * @brief Sample size, 0 if samples vary in size (e.g. video frames).
+	 */
+	uint32_t sample_size;
+	/**
+	 * @brief Absolute position of the "indx" chunk, 0 if none.
+	 */
+	size_t indx_pos;
+
+	/**
+	 * @brief Index source, see @ref AVI_index.
+	 */
+	int index;
+	/**
+	 * @brief Index entries in file order, entry `n` is frame `n`.
+	 */
+	struct riff_aviEntry *idx;
+	/**
+	 * @brief Amount of index entries.
+	 */
+	size_t idx_len;
+	/**
+	 * @brief Amount of allocated index entries.
+	 */
+	size_t idx_size;
+};
+
+/**
+ * @brief Position of a "movi" list.
+ */
+struct riff_aviMovi {
+	/**
+	 * @brief Absolute position of the "LIST" chunk.
+	 */
+	size_t pos;
+	/**
+	 * @brief Chunk data size.
+	 */
+	size_t size;
+};
+
+/**
+ * @brief Main header, streams and index of an AVI file.
+ *
+ * Filled by riff_aviOpen(), freed by riff_aviClose().
+ */
+typedef struct riff_avi {
+	/**
+	 * @brief Microseconds per frame.
+	 */
+	uint32_t usec_per_frame;
+	/**
+	 * @brief Main header flags, `AVIF_...`.
+	 */
+	uint32_t flags;
+	/**
+	 * @brief Total amount of frames, from the OpenDML header if present.
+	 */
+	uint32_t total_frames;
+	/**
+	 * @brief Width of the video.
+	 */
+	uint32_t width;
+	/**
+	 * @brief Height of the video.
+	 */
+	uint32_t height;
+
+	/**
+	 * @brief Streams, in the order of the stream header lists.
+	 */
+	struct riff_aviStream *streams;
+	/**
+	 * @brief Amount of streams.
+	 */
+	size_t streams_len;
+
+	/**
+	 * @brief "movi" lists, the one of the "RIFF AVI " chunk first, then those of "RIFF AVIX" chunks.
+	 */
+	struct riff_aviMovi *movi;
+	/**
+	 * @brief Amount of "movi" lists.
+	 */
+	size_t movi_len;
+
+	/**
+	 * @brief Absolute position of the "idx1" chunk, 0 if none.
+	 */
+	size_t idx1_pos;
+	/**
+	 * @brief Data size of the "idx1" chunk.
+	 */
+	size_t idx1_size;
+
+	/**
+	 * @brief Allocator of the index, the one of the riff_handle it was opened with.
+	 */
+	riff_allocator alloc;
+} riff_avi;
+
+/**
+ * @defgroup RIFF_C_AVI C AVI functions
+ * @{
+ */
+/**
+ * @brief Read the headers of an AVI file and load the index of every stream.
+ *
+ * Streams with an OpenDML index use it, others the "idx1" index, the "movi" lists are scanned as last resort.
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param rh The riff_handle to use, opened AVI file.
+ * @param avi The riff_avi to fill, free with riff_aviClose() even on failure.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ILLID if the file is no AVI file or a required list is missing.
+ */
+int riff_aviOpen(riff_handle *rh, riff_avi *avi);
+/**
+ * @brief Read the headers of an AVI file and find its "movi" lists, without loading any index.
+ *
+ * Enough for demultiplexing with riff_aviDemuxRun(), riff_aviSeekFrame() needs riff_aviOpen().
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param rh The riff_handle to use, opened AVI file.
+ * @param avi The riff_avi to fill, free with riff_aviClose() even on failure.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ILLID if the file is no AVI file or a required list is missing.
+ */
+int riff_aviOpenHeaders(riff_handle *rh, riff_avi *avi);
+/**
+ * @brief Free the streams and index of a riff_avi.
+ *
+ * @param avi The riff_avi filled by riff_aviOpen().
+ */
+void riff_aviClose(riff_avi *avi);
+/**
+ * @brief Position the riff_handle on the chunk of a frame, constant time.
+ *
+ * The riff_handle is at the start of the chunk data, in the sub level of the "movi" list containing it.
+ *
+ * @param rh The riff_handle to use.
+ * @param avi The riff_avi filled by riff_aviOpen().
+ * @param stream Stream number.
+ * @param frame Frame number, index entry of the stream.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the stream or frame does not exist.
+ */
+int riff_aviSeekFrame(riff_handle *rh, const riff_avi *avi, size_t stream, size_t frame);
+/**
+ * @brief Find the last key frame at or before a frame.
+ *
+ * @param avi The riff_avi filled by riff_aviOpen().
+ * @param stream Stream number.
+ * @param frame Frame number.
+ *
+ * @return Frame number of the key frame, `(size_t)-1` if there is none.
+ */
+size_t riff_aviKeyFrame(const riff_avi *avi, size_t stream, size_t frame);
+
+///@}
+
+#endif // _RIFF_AVI_H_
@@ -0,0 +1,338 @@
+// take care: the riff_handle belongs to the reader between riff_aviDemuxBegin() and the end of riff_aviDemuxRun()
+//   => the "movi" lists are read with riff_readAt() outside of the level structure, riff_aviDemuxRun() ends with riff_rewind()
+//   => queues, done, stop and r are guarded by the lock, the read buffer belongs to the reader
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_avidemux.h"
+#include "riff_internal.h"
+
+
+#define checkValidDemux(dm) if (dm == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//copy bytes at absolute position before end of the current "movi" list
+//through the read buffer, large blocks directly, memory without buffer
+int dm_read(riff_aviDemux *dm, size_t pos, void *dst, size_t size, size_t end){
+	riff_handle *rh = dm->rh;
+	if(rh->fp_read == &read_mem){
+		if(rh->size > 0  &&  (pos > rh->size  ||  size > rh->size - pos))
+			return 0;
+		memcpy(dst, (const uint8_t *)rh->fh + pos, size);
+		return 1;
+	}
+
+	uint8_t *d = (uint8_t *)dst;
+	//what is buffered already
+	if(pos >= dm->buf_pos  &&  pos < dm->buf_pos + dm->buf_len){
+		size_t n = dm->buf_pos + dm->buf_len - pos;
+		if(n > size)
+			n = size;
+		memcpy(d, dm->buf + (pos - dm->buf_pos), n);
+		d += n;
+		pos += n;
+		size -= n;
+	}
+	if(size == 0)
+		return 1;
+	if(size >= dm->read_size)
+		return riff_readAt(rh, pos, d, size) == size;
+
+	//read ahead
+	size_t n = (end > pos) ? end - pos : 0;
+	if(n > dm->read_size)
+		n = dm->read_size;
+	if(n < size)
+		n = size;
+	dm->buf_pos = pos;
+	dm->buf_len = riff_readAt(rh, pos, dm->buf, n);
+	if(dm->buf_len < size)
+		return 0;
+	memcpy(d, dm->buf, size);
+	return 1;
+}
+
+
+/*****************************************************************************/
+//queue packet, blocks while the queue is full
+//returns 0 if stopped, the packet is freed then, also if the stream was disabled meanwhile
+int dm_push(riff_aviDemux *dm, struct riff_aviPacket *pkt){
+	struct riff_aviQueue *q = dm->queues + pkt->stream;
+	sync_lock(dm->sync);
+	//backpressure, a packet larger than the queue goes into the empty queue
+	while(!dm->stop  &&  q->enabled  &&  q->len > 0  &&  q->bytes + pkt->size > q->max_bytes)
+		sync_wait(dm->sync);
+	if(dm->stop  ||  !q->enabled){
+		int r = !dm->stop;
+		sync_unlock(dm->sync);
+		mem_free(&dm->alloc, pkt);
+		return r;
+	}
+	pkt->frame = q->frames++;
+	pkt->next = NULL;
+	if(q->tail != NULL)
+		q->tail->next = pkt;
+	else
+		q->head = pkt;
+	q->tail = pkt;
+	q->len++;
+	q->bytes += pkt->size;
+	sync_broadcast(dm->sync);
+	sync_unlock(dm->sync);
+	return 1;
+}
+
+
+/*****************************************************************************/
+//whether the stream is selected, riff_aviDemuxSelect() may change it from another thread
+static int dmEnabled(riff_aviDemux *dm, size_t stream){
+	sync_lock(dm->sync);
+	int enabled = dm->queues[stream].enabled;
+	sync_unlock(dm->sync);
+	return enabled;
+}
+
+/*****************************************************************************/
+//free queued packets of a stream
+static void dmClearQueue(riff_aviDemux *dm, struct riff_aviQueue *q){
+	while(q->head != NULL){
+		struct riff_aviPacket *next = q->head->next;
+		mem_free(&dm->alloc, q->head);
+		q->head = next;
+	}
+	q->tail = NULL;
+	q->len = 0;
+	q->bytes = 0;
+}
+
+/*****************************************************************************/
+//free all queued packets
+void dm_clear(riff_aviDemux *dm){
+	size_t i;
+	for(i = 0; i < dm->queues_len; i++)
+		dmClearQueue(dm, dm->queues + i);
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+riff_aviDemux *riff_aviDemuxAllocate(){
+	riff_aviDemux *dm = mem_calloc(&alloc_global, 1, sizeof(riff_aviDemux));
+	if(dm == NULL)
+		return NULL;
+	dm->alloc = alloc_global;
+	dm->sync = sync_allocate(&dm->alloc);
+	if(dm->sync == NULL){
+		mem_free(&alloc_global, dm);
+		return NULL;
+	}
+	dm->queue_bytes = RIFF_AVIDEMUX_QUEUE_BYTES;
+	dm->read_size = RIFF_AVIDEMUX_READ_SIZE;
+	return dm;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_aviDemuxFree(riff_aviDemux *dm){
+	if(dm == NULL)
+		return;
+	dm_clear(dm);
+	riff_allocator alloc = dm->alloc;
+	sync_free(&alloc, dm->sync);
+	mem_free(&alloc, dm->queues);
+	mem_free(&alloc, dm->buf);
+	mem_free(&alloc, dm);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviDemuxBegin(riff_aviDemux *dm, riff_handle *rh, const riff_avi *avi){
+	checkValidDemux(dm);
+	if(rh == NULL  ||  avi == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	dm_clear(dm);
+
+	if(dm->queue_bytes == 0)
+		dm->queue_bytes = RIFF_AVIDEMUX_QUEUE_BYTES;
+	if(dm->read_size == 0)
+		dm->read_size = RIFF_AVIDEMUX_READ_SIZE;
+
+	struct riff_aviQueue *queuesnew = mem_realloc(&dm->alloc, dm->queues, (avi->streams_len + 1) * sizeof(struct riff_aviQueue));
+	uint8_t *bufnew = mem_realloc(&dm->alloc, dm->buf, dm->read_size);
+	if(queuesnew != NULL)
+		dm->queues = queuesnew;
+	if(bufnew != NULL)
+		dm->buf = bufnew;
+	if(queuesnew == NULL  ||  bufnew == NULL){
+		dm->queues_len = 0;
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate demultiplexer\n");
+		return RIFF_ERROR_MEMORY;
+	}
+	memset(dm->queues, 0, avi->streams_len * sizeof(struct riff_aviQueue));
+	dm->queues_len = avi->streams_len;
+	size_t i;
+	for(i = 0; i < dm->queues_len; i++){
+		dm->queues[i].max_bytes = dm->queue_bytes;
+		dm->queues[i].enabled = 1;
+	}
+
+	dm->rh = rh;
+	dm->avi = avi;
+	dm->buf_pos = 0;
+	dm->buf_len = 0;
+	dm->done = 0;
+	dm->stop = 0;
+	dm->r = RIFF_ERROR_NONE;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviDemuxSelect(riff_aviDemux *dm, size_t stream, int enabled){
+	checkValidDemux(dm);
+	if(stream >= dm->queues_len)
+		return RIFF_ERROR_EOC;
+	sync_lock(dm->sync);
+	dm->queues[stream].enabled = enabled;
+	//nobody pulls them anymore, also wakes a reader blocked on the full queue
+	if(!enabled)
+		dmClearQueue(dm, dm->queues + stream);
+	sync_broadcast(dm->sync);
+	sync_unlock(dm->sync);
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviDemuxRun(riff_aviDemux *dm){
+	checkValidDemux(dm);
+	if(dm->rh == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	riff_handle *rh = dm->rh;
+	const riff_avi *avi = dm->avi;
+
+	int r = RIFF_ERROR_NONE;
+	struct avi_moviCursor mc = {0, 0, 0};
+	uint8_t h[RIFF_CHUNK_DATA_OFFSET];
+	while(avi_moviNext(avi, &mc)){
+		if(!dm_read(dm, mc.pos, h, RIFF_CHUNK_DATA_OFFSET, mc.end)){
+			r = RIFF_ERROR_EOF;
+			break;
+		}
+		size_t pos = mc.pos;
+		if(avi_moviSkip(&mc, h))
+			continue;
+		size_t size = convUInt32LE(h + 4);
+
+		//skipped streams are never read, dm_push() checks again if the stream is disabled meanwhile
+		int s = avi_streamOf(avi, (const char *)h);
+		if(s < 0  ||  !dmEnabled(dm, (size_t)s))
+			continue;
+		if(pos + RIFF_CHUNK_DATA_OFFSET + size > mc.end){
+			if(rh->fp_printf)
+				rh->fp_printf("Chunk at pos %zu exceeds its \"movi\" list!\n", pos);
+			r = RIFF_ERROR_ICSIZE;
+			break;
+		}
+
+		//header and data in one block
+		struct riff_aviPacket *pkt = mem_alloc(&dm->alloc, sizeof(struct riff_aviPacket) + size);
+		if(pkt == NULL){
+			if(rh->fp_printf)
+				rh->fp_printf("Failed to allocate packet of %zu bytes\n", size);
+			r = RIFF_ERROR_MEMORY;
+			break;
+		}
+		pkt->stream = (size_t)s;
+		pkt->pos = pos;
+		memcpy(pkt->c_id, h, 4);
+		pkt->c_id[4] = '\0';
+		pkt->size = size;
+		pkt->data = (uint8_t *)(pkt + 1);
+		pkt->alloc = dm->alloc;
+		if(!dm_read(dm, pos + RIFF_CHUNK_DATA_OFFSET, pkt->data, size, mc.end)){
+			mem_free(&dm->alloc, pkt);
+			r = RIFF_ERROR_EOF;
+			break;
+		}
+		if(!dm_push(dm, pkt))
+			break;
+	}
+
+	sync_lock(dm->sync);
+	dm->r = r;
+	dm->done = 1;
+	sync_broadcast(dm->sync);
+	sync_unlock(dm->sync);
+
+	dm->buf_len = 0;
+	riff_rewind(rh);
+	return r;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_aviDemuxPull(riff_aviDemux *dm, size_t stream, struct riff_aviPacket **pkt){
+	checkValidDemux(dm);
+	if(pkt == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	*pkt = NULL;
+	if(stream >= dm->queues_len)
+		return RIFF_ERROR_EOC;
+
+	struct riff_aviQueue *q = dm->queues + stream;
+	sync_lock(dm->sync);
+	while(q->len == 0  &&  q->enabled  &&  !dm->done  &&  !dm->stop)
+		sync_wait(dm->sync);
+	if(q->len == 0){
+		int r = (dm->r != RIFF_ERROR_NONE) ? dm->r : RIFF_ERROR_EOCL;
+		sync_unlock(dm->sync);
+		return r;
+	}
+	*pkt = q->head;
+	q->head = q->head->next;
+	if(q->head == NULL)
+		q->tail = NULL;
+	q->len--;
+	q->bytes -= (*pkt)->size;
+	//room for the reader
+	sync_broadcast(dm->sync);
+	sync_unlock(dm->sync);
+	(*pkt)->next = NULL;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_aviDemuxStop(riff_aviDemux *dm){
+	if(dm == NULL)
+		return;
+	sync_lock(dm->sync);
+	dm->stop = 1;
+	sync_broadcast(dm->sync);
+	sync_unlock(dm->sync);
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_aviDemuxPacketFree(struct riff_aviPacket *pkt){
+	if(pkt == NULL)
+		return;
+	riff_allocator alloc = pkt->alloc;
+	mem_free(&alloc, pkt);
+}
@@ -0,0 +1,268 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Demultiplexer for the "movi" lists of AVI files, for decoding several streams from different threads.
+One reader walks all "movi" lists (also "rec " lists and those of "RIFF AVIX" chunks) once, with large sequential reads.
+Every frame chunk ("##dc", "##db", "##wb", "##tx", ...) becomes a packet in the bounded queue of its stream.
+The reader blocks while the queue of the next packet is full (backpressure), consumers pull packets of their stream independently.
+
+
+Usage:
+Open the file with the usual riff_handle functions, call riff_aviOpenHeaders() or riff_aviOpen()
+Allocate a riff_aviDemux with riff_aviDemuxAllocate() and start it with riff_aviDemuxBegin()
+  Disable streams nobody pulls with riff_aviDemuxSelect(), their queues would fill up and stall the reader
+  The riff_handle must not be used until riff_aviDemuxRun() returned
+Call riff_aviDemuxRun() on the reader thread
+From consumer threads:
+  riff_aviDemuxPull() the next packet of a stream, blocks while its queue is empty
+  riff_aviDemuxPacketFree() the packet when done
+riff_aviDemuxStop() ends reading early from any thread, riff_aviDemuxFree() frees all queued packets
+*/
+
+#ifndef _RIFF_AVIDEMUX_H_
+#define _RIFF_AVIDEMUX_H_
+
+#include "riff_avi.h"
+
+/**
+ * @brief Default maximum amount of data bytes queued per stream.
+ *
+ * A larger packet is still queued if the queue is empty.
+ */
+#define RIFF_AVIDEMUX_QUEUE_BYTES	(4 << 20)
+/**
+ * @brief Default amount of bytes read at once, larger chunks are read directly into their packet.
+ */
+#define RIFF_AVIDEMUX_READ_SIZE		(1 << 20)
+
+/**
+ * @brief Packet, the data of one frame chunk.
+ */
+struct riff_aviPacket {
+	/**
+	 * @brief Next packet in the queue, internal.
+	 */
+	struct riff_aviPacket *next;
+	/**
+	 * @brief Stream number.
+	 */
+	size_t stream;
+	/**
+	 * @brief Number of the packet in its stream, same as the frame number of riff_aviSeekFrame().
+	 */
+	uint64_t frame;
+	/**
+	 * @brief Absolute chunk position in file stream.
+	 */
+	uint64_t pos;
+	/**
+	 * @brief ID of chunk.
+	 */
+	char c_id[5];
+	/**
+	 * @brief Size of the data.
+	 */
+	size_t size;
+	/**
+	 * @brief Chunk data, allocated with the packet.
+	 */
+	uint8_t *data;
+	/**
+	 * @brief Allocator of the packet, the one of the riff_aviDemux.
+	 */
+	riff_allocator alloc;
+};
+
+/**
+ * @brief Packet queue of one stream.
+ */
+struct riff_aviQueue {
+	/**
+	 * @brief Oldest packet, pulled next.
+	 */
+	struct riff_aviPacket *head;
+	/**
+	 * @brief Newest packet.
+	 */
+	struct riff_aviPacket *tail;
+	/**
+	 * @brief Amount of queued packets.
+	 */
+	size_t len;
+	/**
+	 * @brief Amount of queued data bytes.
+	 */
+	size_t bytes;
+	/**
+	 * @brief Maximum amount of queued data bytes.
+	 */
+	size_t max_bytes;
+	/**
+	 * @brief 0 if the packets of the stream are skipped.
+	 */
+	int enabled;
+	/**
+	 * @brief Amount of packets demultiplexed so far.
+	 */
+	uint64_t frames;
+};
+
+/**
+ * @brief The AVI demultiplexer.
+ *
+ * Members are public and intended for read access, only while riff_aviDemuxRun() is not running.
+ */
+typedef struct riff_aviDemux {
+	/**
+	 * @brief The riff_handle to read from.
+	 */
+	riff_handle *rh;
+	/**
+	 * @brief Streams and "movi" lists.
+	 */
+	const riff_avi *avi;
+	/**
+	 * @brief Queues, one per stream.
+	 */
+	struct riff_aviQueue *queues;
+	/**
+	 * @brief Amount of queues.
+	 */
+	size_t queues_len;
+
+	/**
+	 * @brief Maximum amount of queued data bytes per stream.
+	 *
+	 * Can be set before riff_aviDemuxBegin(), defaults to ::RIFF_AVIDEMUX_QUEUE_BYTES.
+	 */
+	size_t queue_bytes;
+	/**
+	 * @brief Amount of bytes read at once.
+	 *
+	 * Can be set before riff_aviDemuxBegin(), defaults to ::RIFF_AVIDEMUX_READ_SIZE.
+	 */
+	size_t read_size;
+
+	/**
+	 * @brief Read buffer.
+	 */
+	uint8_t *buf;
+	/**
+	 * @brief Absolute position of the read buffer data.
+	 */
+	size_t buf_pos;
+	/**
+	 * @brief Amount of bytes in the read buffer.
+	 */
+	size_t buf_len;
+
+	/**
+	 * @brief 1 once the reader is finished, queued packets can still be pulled.
+	 */
+	int done;
+	/**
+	 * @brief 1 if riff_aviDemuxStop() was called.
+	 */
+	int stop;
+	/**
+	 * @brief Error of the reader, RIFF error code.
+	 */
+	int r;
+
+	/**
+	 * @brief Lock and condition variable, platform specific.
+	 */
+	void *sync;
+
+	/**
+	 * @brief Allocator of the demultiplexer and its packets, the global one when allocated.
+	 */
+	riff_allocator alloc;
+} riff_aviDemux;
+
+/**
+ * @defgroup RIFF_C_AVIDemux C AVI demultiplexer functions
+ * @{
+ */
+/**
+ * @brief Allocate, initialize and return a riff_aviDemux.
+ *
+ * @return Pointer to the allocated riff_aviDemux, NULL if allocation failed.
+ */
+riff_aviDemux *riff_aviDemuxAllocate();
+/**
+ * @brief Free the memory allocated to a riff_aviDemux and all queued packets.
+ *
+ * The riff_handle and riff_avi are not touched.
+ *
+ * @param dm The riff_aviDemux to free.
+ */
+void riff_aviDemuxFree(riff_aviDemux *dm);
+/**
+ * @brief Prepare demultiplexing, all streams are enabled.
+ *
+ * @param dm The riff_aviDemux to use.
+ * @param rh The riff_handle of the AVI file.
+ * @param avi The riff_avi filled by riff_aviOpenHeaders() or riff_aviOpen().
+ *
+ * @return RIFF error code.
+ */
+int riff_aviDemuxBegin(riff_aviDemux *dm, riff_handle *rh, const riff_avi *avi);
+/**
+ * @brief Enable or disable the packets of a stream.
+ *
+ * Can be called while riff_aviDemuxRun() is running: disabling frees the queued packets of the stream,
+ *   a reader blocked on its full queue continues, riff_aviDemuxPull() of the stream returns ::RIFF_ERROR_EOCL.
+ *
+ * @param dm The riff_aviDemux to use.
+ * @param stream Stream number.
+ * @param enabled 0 to skip the packets of the stream.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the stream does not exist.
+ */
+int riff_aviDemuxSelect(riff_aviDemux *dm, size_t stream, int enabled);
+/**
+ * @brief Read all "movi" lists and queue their packets, call on the reader thread.
+ *
+ * Blocks while the queue of the next packet is full.
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param dm The riff_aviDemux to use.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_NONE if stopped by riff_aviDemuxStop().
+ */
+int riff_aviDemuxRun(riff_aviDemux *dm);
+/**
+ * @brief Take the next packet of a stream, thread safe.
+ *
+ * Blocks while the queue of the stream is empty and the reader is not finished.
+ *
+ * @param dm The riff_aviDemux to use.
+ * @param stream Stream number.
+ * @param pkt Receives the packet, free with riff_aviDemuxPacketFree(). NULL if there is none.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOCL after the last packet of the stream, the reader error if it failed.
+ */
+int riff_aviDemuxPull(riff_aviDemux *dm, size_t stream, struct riff_aviPacket **pkt);
+/**
+ * @brief Stop the reader early, thread safe.
+ *
+ * Blocked calls return, packets queued so far can still be pulled.
+ *
+ * @param dm The riff_aviDemux to use.
+ */
+void riff_aviDemuxStop(riff_aviDemux *dm);
+/**
+ * @brief Free a pulled packet.
+ *
+ * @param pkt The packet to free.
+ */
+void riff_aviDemuxPacketFree(struct riff_aviPacket *pkt);
+
+///@}
+
+#endif // _RIFF_AVIDEMUX_H_
@@ -0,0 +1,574 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => riff_bankOpen() only uses riff_handle functions, riff_bankRead() reads with riff_readAt() and seeks back afterwards
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_bank.h"
+#include "riff_internal.h"
+
+
+#define RIFF_BANK_ALLOC 64   //number of DLS instruments, regions or waves allocated per step at least
+
+//SF2 record sizes
+#define SF2_PHDR 38
+#define SF2_BAG 4
+#define SF2_MOD 10
+#define SF2_GEN 4
+#define SF2_INST 22
+#define SF2_SHDR 46
+#define SF2_NAME 20
+
+//DLS chunk sizes read at most
+#define DLS_INSH 12
+#define DLS_RGNH 12
+#define DLS_WLNK 12
+#define DLS_WSMP 20        //without loops
+#define DLS_WSMP_LOOP 16
+#define DLS_FMT 16
+#define DLS_PTBL 8         //without cues
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//slice at absolute position, points into memory for memory based handles
+void bank_slice(riff_handle *rh, size_t pos, size_t size, struct riff_bankSlice *s){
+	s->pos = pos;
+	//data cut off by the end of the file is missing
+	s->size = riff_availAt(rh, pos, size);
+	s->data = (rh->fp_read == &read_mem) ? (const uint8_t *)rh->fh + s->pos : NULL;
+}
+
+
+/*****************************************************************************/
+//enter the list of the current chunk and get its type
+//returns 0 if it can't be entered, the handle stays on the list then
+int bank_enter(riff_handle *rh, char *type){
+	if(memcmp(rh->c_id, "LIST", 4) != 0  ||  rh->c_size < 4 + RIFF_CHUNK_DATA_OFFSET)
+		return 0;
+	int level = rh->ls_level;
+	int r = riff_seekLevelSub(rh);
+	if(rh->ls_level > level)
+		memcpy(type, rh->ls[level].c_type, 4);
+	if(r != RIFF_ERROR_NONE){
+		if(rh->ls_level > level)
+			riff_levelParent(rh);
+		return 0;
+	}
+	return 1;
+}
+
+
+/*****************************************************************************/
+//make room for one more element
+int bank_grow(const riff_allocator *a, void **arr, size_t *size, size_t len, size_t elem){
+	if(len < *size)
+		return RIFF_ERROR_NONE;
+	size_t sizenew = *size * 2;
+	if(sizenew < RIFF_BANK_ALLOC)
+		sizenew = RIFF_BANK_ALLOC;
+	void *arrnew = mem_realloc(a, *arr, sizenew * elem);
+	if(arrnew == NULL)
+		return RIFF_ERROR_MEMORY;
+	*arr = arrnew;
+	*size = sizenew;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//copy name field, always terminated
+static void copyName(char *dst, const uint8_t *src, size_t size){
+	memcpy(dst, src, size);
+	dst[size] = '\0';
+}
+
+
+/*****************************************************************************/
+//decode records of a "pdta" sub chunk into a new array
+//returns error code, array and amount of records via arr and len
+int bank_sf2Records(riff_handle *rh, uint8_t **buf, size_t *buf_size, size_t rec, size_t elem, void **arr, size_t *len){
+	//repeated chunk, last one wins
+	mem_free(&rh->alloc, *arr);
+	*arr = NULL;
+	*len = 0;
+	//records cut off by the end of the file are lost
+	size_t size = riff_availAt(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size);
+	size_t n = size / rec;
+	if(n == 0)
+		return RIFF_ERROR_NONE;
+	if(*buf_size < n * rec){
+		uint8_t *bufnew = mem_realloc(&rh->alloc, *buf, n * rec);
+		if(bufnew == NULL)
+			return RIFF_ERROR_MEMORY;
+		*buf = bufnew;
+		*buf_size = n * rec;
+	}
+	*arr = mem_calloc(&rh->alloc, n, elem);
+	if(*arr == NULL)
+		return RIFF_ERROR_MEMORY;
+	*len = riff_readInChunk(rh, *buf, n * rec) / rec;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//parse "pdta" list, handle is in its sub level
+int bank_sf2Pdta(riff_handle *rh, riff_bank *bank){
+	uint8_t *buf = NULL;
+	size_t buf_size = 0, i;
+	int r = RIFF_ERROR_NONE, rr = RIFF_ERROR_NONE;
+
+	for(; r == RIFF_ERROR_NONE; r = riff_seekNextChunk(rh)){
+		const uint8_t *p;
+		if(memcmp(rh->c_id, "phdr", 4) == 0){
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_PHDR, sizeof(struct riff_sf2Preset), (void **)&bank->presets, &bank->presets_len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < bank->presets_len; i++, p += SF2_PHDR){
+				struct riff_sf2Preset *e = bank->presets + i;
+				copyName(e->name, p, SF2_NAME);
+				e->preset = convUInt16LE(p + 20);
+				e->bank = convUInt16LE(p + 22);
+				e->bag = convUInt16LE(p + 24);
+				e->library = convUInt32LE(p + 26);
+				e->genre = convUInt32LE(p + 30);
+				e->morphology = convUInt32LE(p + 34);
+			}
+		}
+		else if(memcmp(rh->c_id, "pbag", 4) == 0  ||  memcmp(rh->c_id, "ibag", 4) == 0){
+			struct riff_sf2Bag **arr = (rh->c_id[0] == 'p') ? &bank->preset_bags : &bank->inst_bags;
+			size_t *len = (rh->c_id[0] == 'p') ? &bank->preset_bags_len : &bank->inst_bags_len;
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_BAG, sizeof(struct riff_sf2Bag), (void **)arr, len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < *len; i++, p += SF2_BAG){
+				(*arr)[i].gen = convUInt16LE(p);
+				(*arr)[i].mod = convUInt16LE(p + 2);
+			}
+		}
+		else if(memcmp(rh->c_id, "pmod", 4) == 0  ||  memcmp(rh->c_id, "imod", 4) == 0){
+			struct riff_sf2Mod **arr = (rh->c_id[0] == 'p') ? &bank->preset_mods : &bank->inst_mods;
+			size_t *len = (rh->c_id[0] == 'p') ? &bank->preset_mods_len : &bank->inst_mods_len;
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_MOD, sizeof(struct riff_sf2Mod), (void **)arr, len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < *len; i++, p += SF2_MOD){
+				struct riff_sf2Mod *e = *arr + i;
+				e->src = convUInt16LE(p);
+				e->dest = convUInt16LE(p + 2);
+				e->amount = (int16_t)convUInt16LE(p + 4);
+				e->amount_src = convUInt16LE(p + 6);
+				e->transform = convUInt16LE(p + 8);
+			}
+		}
+		else if(memcmp(rh->c_id, "pgen", 4) == 0  ||  memcmp(rh->c_id, "igen", 4) == 0){
+			struct riff_sf2Gen **arr = (rh->c_id[0] == 'p') ? &bank->preset_gens : &bank->inst_gens;
+			size_t *len = (rh->c_id[0] == 'p') ? &bank->preset_gens_len : &bank->inst_gens_len;
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_GEN, sizeof(struct riff_sf2Gen), (void **)arr, len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < *len; i++, p += SF2_GEN){
+				(*arr)[i].oper = convUInt16LE(p);
+				(*arr)[i].amount = convUInt16LE(p + 2);
+			}
+		}
+		else if(memcmp(rh->c_id, "inst", 4) == 0){
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_INST, sizeof(struct riff_sf2Inst), (void **)&bank->insts, &bank->insts_len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < bank->insts_len; i++, p += SF2_INST){
+				copyName(bank->insts[i].name, p, SF2_NAME);
+				bank->insts[i].bag = convUInt16LE(p + 20);
+			}
+		}
+		else if(memcmp(rh->c_id, "shdr", 4) == 0){
+			if((rr = bank_sf2Records(rh, &buf, &buf_size, SF2_SHDR, sizeof(struct riff_sf2Sample), (void **)&bank->samples, &bank->samples_len)) != RIFF_ERROR_NONE)
+				break;
+			for(i = 0, p = buf; i < bank->samples_len; i++, p += SF2_SHDR){
+				struct riff_sf2Sample *e = bank->samples + i;
+				copyName(e->name, p, SF2_NAME);
+				e->start = convUInt32LE(p + 20);
+				e->end = convUInt32LE(p + 24);
+				e->loop_start = convUInt32LE(p + 28);
+				e->loop_end = convUInt32LE(p + 32);
+				e->sample_rate = convUInt32LE(p + 36);
+				e->pitch = p[40];
+				e->correction = (int8_t)p[41];
+				e->link = convUInt16LE(p + 42);
+				e->type = convUInt16LE(p + 44);
+			}
+		}
+	}
+	mem_free(&rh->alloc, buf);
+
+	if(r == RIFF_ERROR_NONE){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate \"%s\" records\n", rh->c_id);
+		return rr;
+	}
+	return (r == RIFF_ERROR_EOCL) ? RIFF_ERROR_NONE : r;
+}
+
+
+/*****************************************************************************/
+//parse current "wsmp" chunk
+void bank_dlsWsmp(riff_handle *rh, struct riff_dlsWsmp *w){
+	uint8_t buf[DLS_WSMP + DLS_WSMP_LOOP];
+	riff_readChunkStart(rh, buf, DLS_WSMP);
+	size_t cb = convUInt32LE(buf);
+	w->present = 1;
+	w->unity_note = convUInt16LE(buf + 4);
+	w->fine_tune = (int16_t)convUInt16LE(buf + 6);
+	w->gain = (int32_t)convUInt32LE(buf + 8);
+	w->options = convUInt32LE(buf + 12);
+	w->loops = convUInt32LE(buf + 16);
+	//loops follow the structure of cbSize bytes
+	if(w->loops > 0  &&  cb >= DLS_WSMP  &&  riff_seekInChunk(rh, cb) == RIFF_ERROR_NONE){
+		memset(buf, 0, DLS_WSMP_LOOP);
+		if(riff_readInChunk(rh, buf, DLS_WSMP_LOOP) == DLS_WSMP_LOOP){
+			w->loop_type = convUInt32LE(buf + 4);
+			w->loop_start = convUInt32LE(buf + 8);
+			w->loop_length = convUInt32LE(buf + 12);
+		}
+	}
+}
+
+
+/*****************************************************************************/
+//parse "rgn " or "rgn2" list into a new region, handle is in its sub level
+int bank_dlsRegion(riff_handle *rh, riff_bank *bank){
+	int r;
+	if((r = bank_grow(&bank->alloc, (void **)&bank->regions, &bank->regions_size, bank->regions_len, sizeof(struct riff_dlsRegion))) != RIFF_ERROR_NONE)
+		return r;
+	struct riff_dlsRegion *rg = bank->regions + bank->regions_len++;
+	memset(rg, 0, sizeof(struct riff_dlsRegion));
+	rg->wave = (size_t)-1;
+
+	uint8_t buf[DLS_RGNH];
+	for(r = RIFF_ERROR_NONE; r == RIFF_ERROR_NONE; r = riff_seekNextChunk(rh)){
+		if(memcmp(rh->c_id, "rgnh", 4) == 0){
+			riff_readChunkStart(rh, buf, DLS_RGNH);
+			rg->key_lo = convUInt16LE(buf);
+			rg->key_hi = convUInt16LE(buf + 2);
+			rg->vel_lo = convUInt16LE(buf + 4);
+			rg->vel_hi = convUInt16LE(buf + 6);
+			rg->options = convUInt16LE(buf + 8);
+			rg->key_group = convUInt16LE(buf + 10);
+		}
+		else if(memcmp(rh->c_id, "wlnk", 4) == 0){
+			riff_readChunkStart(rh, buf, DLS_WLNK);
+			rg->channel = convUInt32LE(buf + 4);
+			rg->table_index = convUInt32LE(buf + 8);
+		}
+		else if(memcmp(rh->c_id, "wsmp", 4) == 0)
+			bank_dlsWsmp(rh, &rg->wsmp);
+	}
+	return (r == RIFF_ERROR_EOCL) ? RIFF_ERROR_NONE : r;
+}
+
+
+/*****************************************************************************/
+//parse "ins " list into a new instrument, handle is in its sub level
+int bank_dlsInstrument(riff_handle *rh, riff_bank *bank){
+	int r;
+	if((r = bank_grow(&bank->alloc, (void **)&bank->instruments, &bank->instruments_size, bank->instruments_len, sizeof(struct riff_dlsInstrument))) != RIFF_ERROR_NONE)
+		return r;
+	struct riff_dlsInstrument *ins = bank->instruments + bank->instruments_len++;
+	memset(ins, 0, sizeof(struct riff_dlsInstrument));
+	ins->region = bank->regions_len;
+
+	uint8_t buf[DLS_INSH];
+	char type[4];
+	for(r = RIFF_ERROR_NONE; r == RIFF_ERROR_NONE; r = riff_seekNextChunk(rh)){
+		if(memcmp(rh->c_id, "insh", 4) == 0){
+			riff_readChunkStart(rh, buf, DLS_INSH);
+			ins->bank = convUInt32LE(buf + 4);
+			ins->program = convUInt32LE(buf + 8);
+		}
+		else if(bank_enter(rh, type)){
+			int rr = RIFF_ERROR_NONE;
+			if(memcmp(type, "lrgn", 4) == 0){
+				//regions of the instrument
+				int ri;
+				for(ri = RIFF_ERROR_NONE; ri == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+					if(bank_enter(rh, type)){
+						if(memcmp(type, "rgn ", 4) == 0  ||  memcmp(type, "rgn2", 4) == 0)
+							rr = bank_dlsRegion(rh, bank);
+						riff_levelParent(rh);
+					}
+				}
+			}
+			else if(memcmp(type, "INFO", 4) == 0){
+				int ri;
+				for(ri = RIFF_ERROR_NONE; ri == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+					if(memcmp(rh->c_id, "INAM", 4) == 0)
+						riff_readInChunk(rh, ins->name, sizeof(ins->name) - 1);
+				}
+			}
+			riff_levelParent(rh);
+			if(rr != RIFF_ERROR_NONE)
+				return rr;
+		}
+	}
+	ins->regions_len = bank->regions_len - ins->region;
+	return (r == RIFF_ERROR_EOCL) ? RIFF_ERROR_NONE : r;
+}
+
+
+/*****************************************************************************/
+//parse "wave" list into a new wave, handle is in its sub level
+int bank_dlsWave(riff_handle *rh, riff_bank *bank, size_t offset){
+	int r;
+	if((r = bank_grow(&bank->alloc, (void **)&bank->waves, &bank->waves_size, bank->waves_len, sizeof(struct riff_dlsWave))) != RIFF_ERROR_NONE)
+		return r;
+	struct riff_dlsWave *w = bank->waves + bank->waves_len++;
+	memset(w, 0, sizeof(struct riff_dlsWave));
+	w->offset = offset;
+
+	uint8_t buf[DLS_FMT];
+	for(r = RIFF_ERROR_NONE; r == RIFF_ERROR_NONE; r = riff_seekNextChunk(rh)){
+		if(memcmp(rh->c_id, "fmt ", 4) == 0){
+			riff_readChunkStart(rh, buf, DLS_FMT);
+			w->format_tag = convUInt16LE(buf);
+			w->channels = convUInt16LE(buf + 2);
+			w->sample_rate = convUInt32LE(buf + 4);
+			w->block_align = convUInt16LE(buf + 12);
+			w->bits_per_sample = convUInt16LE(buf + 14);
+		}
+		else if(memcmp(rh->c_id, "wsmp", 4) == 0)
+			bank_dlsWsmp(rh, &w->wsmp);
+		else if(memcmp(rh->c_id, "data", 4) == 0)
+			bank_slice(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size, &w->data);
+	}
+	return (r == RIFF_ERROR_EOCL) ? RIFF_ERROR_NONE : r;
+}
+
+
+/*****************************************************************************/
+//parse current "ptbl" chunk
+int bank_dlsPtbl(riff_handle *rh, riff_bank *bank){
+	if(bank->cues != NULL)
+		return RIFF_ERROR_NONE;
+	uint8_t buf[DLS_PTBL];
+	riff_readChunkStart(rh, buf, DLS_PTBL);
+	size_t cb = convUInt32LE(buf);
+	size_t n = convUInt32LE(buf + 4);
+	//cues follow the structure of cbSize bytes
+	if(cb < DLS_PTBL  ||  cb > rh->c_size)
+		return RIFF_ERROR_NONE;
+	if(n > (rh->c_size - cb) / 4)
+		n = (rh->c_size - cb) / 4;
+	if(n == 0)
+		return RIFF_ERROR_NONE;
+	bank->cues = mem_alloc(&bank->alloc, n * 4);
+	if(bank->cues == NULL)
+		return RIFF_ERROR_MEMORY;
+	riff_seekInChunk(rh, cb);
+	bank->cues_len = riff_readInChunk(rh, bank->cues, n * 4) / 4;
+	size_t i;
+	for(i = 0; i < bank->cues_len; i++)
+		bank->cues[i] = convUInt32LE(bank->cues + i);
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//find wave of pool table index
+//via the offset in the pool table, the table index is the wave number if there is no table
+size_t bank_dlsWaveOf(const riff_bank *bank, uint32_t ti){
+	if(bank->cues_len == 0)
+		return (ti < bank->waves_len) ? ti : (size_t)-1;
+	if(ti >= bank->cues_len)
+		return (size_t)-1;
+	//waves are in file order
+	size_t lo = 0, hi = bank->waves_len;
+	while(lo < hi){
+		size_t mid = lo + (hi - lo) / 2;
+		if(bank->waves[mid].offset < bank->cues[ti])
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if(lo < bank->waves_len  &&  bank->waves[lo].offset == bank->cues[ti])
+		return lo;
+	return (size_t)-1;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_bankOpen(riff_handle *rh, riff_bank *bank){
+	checkValidRiffHandle(rh);
+	if(bank == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(bank, 0, sizeof(riff_bank));
+	bank->alloc = rh->alloc;
+
+	if(memcmp(rh->h_type, "sfbk", 4) == 0)
+		bank->type = RIFF_BANK_SF2;
+	else if(memcmp(rh->h_type, "DLS ", 4) == 0)
+		bank->type = RIFF_BANK_DLS;
+	else {
+		if(rh->fp_printf)
+			rh->fp_printf("Not a sample bank, form type \"%s\"\n", rh->h_type);
+		return RIFF_ERROR_ILLID;
+	}
+
+	//only headers and the lists holding them are visited, sample data is skipped
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	char type[4];
+	int r, rr = RIFF_ERROR_NONE;
+	for(r = riff_seekLevelStart(rh); r == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; r = riff_seekNextChunk(rh)){
+		if(bank->type == RIFF_BANK_DLS  &&  memcmp(rh->c_id, "ptbl", 4) == 0){
+			rr = bank_dlsPtbl(rh, bank);
+			continue;
+		}
+		if(!bank_enter(rh, type))
+			continue;
+		int ri;
+		if(bank->type == RIFF_BANK_SF2  &&  memcmp(type, "sdta", 4) == 0){
+			for(ri = RIFF_ERROR_NONE; ri == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+				if(memcmp(rh->c_id, "smpl", 4) == 0)
+					bank_slice(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size, &bank->smpl);
+				else if(memcmp(rh->c_id, "sm24", 4) == 0)
+					bank_slice(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size, &bank->sm24);
+			}
+		}
+		else if(bank->type == RIFF_BANK_SF2  &&  memcmp(type, "pdta", 4) == 0)
+			rr = bank_sf2Pdta(rh, bank);
+		else if(bank->type == RIFF_BANK_DLS  &&  memcmp(type, "lins", 4) == 0){
+			for(ri = RIFF_ERROR_NONE; ri == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+				if(bank_enter(rh, type)){
+					if(memcmp(type, "ins ", 4) == 0)
+						rr = bank_dlsInstrument(rh, bank);
+					riff_levelParent(rh);
+				}
+			}
+		}
+		else if(bank->type == RIFF_BANK_DLS  &&  memcmp(type, "wvpl", 4) == 0){
+			//pool offsets are relative to the first byte after the list type
+			size_t base = rh->ls[rh->ls_level - 1].c_pos_start + RIFF_HEADER_SIZE;
+			bank_slice(rh, base, rh->ls[rh->ls_level - 1].c_size - 4, &bank->smpl);
+			for(ri = RIFF_ERROR_NONE; ri == RIFF_ERROR_NONE  &&  rr == RIFF_ERROR_NONE; ri = riff_seekNextChunk(rh)){
+				size_t offset = rh->c_pos_start - base;
+				if(bank_enter(rh, type)){
+					if(memcmp(type, "wave", 4) == 0)
+						rr = bank_dlsWave(rh, bank, offset);
+					riff_levelParent(rh);
+				}
+			}
+		}
+		riff_levelParent(rh);
+	}
+
+	//regions without "wsmp" chunk use the one of their wave
+	size_t i;
+	for(i = 0; i < bank->regions_len; i++){
+		struct riff_dlsRegion *rg = bank->regions + i;
+		rg->wave = bank_dlsWaveOf(bank, rg->table_index);
+		if(!rg->wsmp.present  &&  rg->wave != (size_t)-1)
+			rg->wsmp = bank->waves[rg->wave].wsmp;
+	}
+
+	int rw = riff_rewind(rh);
+	if(rr != RIFF_ERROR_NONE)
+		return rr;
+	if(r != RIFF_ERROR_EOCL)
+		return r;
+	return rw;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_bankClose(riff_bank *bank){
+	if(bank == NULL)
+		return;
+	mem_free(&bank->alloc, bank->presets);
+	mem_free(&bank->alloc, bank->preset_bags);
+	mem_free(&bank->alloc, bank->preset_mods);
+	mem_free(&bank->alloc, bank->preset_gens);
+	mem_free(&bank->alloc, bank->insts);
+	mem_free(&bank->alloc, bank->inst_bags);
+	mem_free(&bank->alloc, bank->inst_mods);
+	mem_free(&bank->alloc, bank->inst_gens);
+	mem_free(&bank->alloc, bank->samples);
+	mem_free(&bank->alloc, bank->instruments);
+	mem_free(&bank->alloc, bank->regions);
+	mem_free(&bank->alloc, bank->waves);
+	mem_free(&bank->alloc, bank->cues);
+	memset(bank, 0, sizeof(riff_bank));
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_bankSample(const riff_bank *bank, size_t i, struct riff_bankSlice *slice){
+	if(bank == NULL  ||  slice == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(slice, 0, sizeof(struct riff_bankSlice));
+
+	if(bank->type == RIFF_BANK_DLS){
+		if(i >= bank->waves_len)
+			return RIFF_ERROR_EOC;
+		*slice = bank->waves[i].data;
+		return RIFF_ERROR_NONE;
+	}
+
+	if(i >= bank->samples_len)
+		return RIFF_ERROR_EOC;
+	const struct riff_sf2Sample *s = bank->samples + i;
+	if(s->end < s->start  ||  (size_t)s->end * 2 > bank->smpl.size)
+		return RIFF_ERROR_ICSIZE;
+	slice->pos = bank->smpl.pos + (size_t)s->start * 2;
+	slice->size = (size_t)(s->end - s->start) * 2;
+	if(bank->smpl.data != NULL)
+		slice->data = bank->smpl.data + (size_t)s->start * 2;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_bankSample24(const riff_bank *bank, size_t i, struct riff_bankSlice *slice){
+	if(bank == NULL  ||  slice == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(slice, 0, sizeof(struct riff_bankSlice));
+	if(bank->type != RIFF_BANK_SF2  ||  i >= bank->samples_len  ||  bank->sm24.size == 0)
+		return RIFF_ERROR_EOC;
+
+	const struct riff_sf2Sample *s = bank->samples + i;
+	if(s->end < s->start  ||  s->end > bank->sm24.size)
+		return RIFF_ERROR_ICSIZE;
+	slice->pos = bank->sm24.pos + s->start;
+	slice->size = s->end - s->start;
+	if(bank->sm24.data != NULL)
+		slice->data = bank->sm24.data + s->start;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_bankRead(riff_handle *rh, const struct riff_bankSlice *slice, size_t offset, void *dst, size_t size){
+	if(rh == NULL  ||  slice == NULL  ||  offset >= slice->size)
+		return 0;
+	if(size > slice->size - offset)
+		size = slice->size - offset;
+	if(slice->data != NULL){
+		memcpy(dst, slice->data + offset, size);
+		return size;
+	}
+	size_t pos = rh->pos;
+	size_t n = riff_readAt(rh, slice->pos + offset, dst, size);
+	rh->pos = pos;
+	rh->fp_seek(rh, pos);
+	return n;
+}
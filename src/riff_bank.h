@@ -0,0 +1,582 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Sample banks: SoundFont 2 ("RIFF sfbk") and DLS ("RIFF DLS ") files.
+Opening parses the preset, instrument and sample headers into compact arrays, sample data is not read.
+Samples are slices of the sample pool ("sdta" list of SF2, "wvpl" list of DLS).
+For memory based handles each slice points into the memory directly, no sample is copied.
+Large banks can be mapped into memory (e.g. with mmap()) and opened with riff_open_mem() for that.
+For other handles riff_bankRead() reads from a slice.
+
+SF2 arrays hold all records of the "pdta" list as stored, including the terminal records ("EOP", "EOI", "EOS").
+Preset `i` has the zones `preset_bags[presets[i].bag]` up to `preset_bags[presets[i + 1].bag]`, same for instruments and generators.
+
+
+Usage:
+Open the file with the usual riff_handle functions
+Call riff_bankOpen() to parse the headers
+Call riff_bankSample() to get the slice of a sample, use riff_bankSlice::data or riff_bankRead()
+Call riff_bankClose() to free the arrays
+*/
+
+#ifndef _RIFF_BANK_H_
+#define _RIFF_BANK_H_
+
+#include "riff.h"
+
+/**
+ * @defgroup Bank_types Bank types
+ * @{
+ */
+/**
+ * @brief No bank opened.
+ */
+#define RIFF_BANK_NONE		0
+/**
+ * @brief SoundFont 2, "RIFF sfbk".
+ */
+#define RIFF_BANK_SF2		1
+/**
+ * @brief Downloadable Sounds, "RIFF DLS ".
+ */
+#define RIFF_BANK_DLS		2
+///@}
+
+/**
+ * @brief Slice of the file, e.g. sample data.
+ */
+struct riff_bankSlice {
+	/**
+	 * @brief Absolute position in file stream.
+	 */
+	size_t pos;
+	/**
+	 * @brief Size in bytes.
+	 */
+	size_t size;
+	/**
+	 * @brief The bytes in memory for memory based handles, NULL otherwise.
+	 */
+	const uint8_t *data;
+};
+
+/**
+ * @brief SF2 preset header, "phdr" record.
+ */
+struct riff_sf2Preset {
+	/**
+	 * @brief Name.
+	 */
+	char name[21];
+	/**
+	 * @brief MIDI preset number.
+	 */
+	uint16_t preset;
+	/**
+	 * @brief MIDI bank number.
+	 */
+	uint16_t bank;
+	/**
+	 * @brief Index of the first zone in riff_bank::preset_bags.
+	 */
+	uint16_t bag;
+	/**
+	 * @brief Reserved.
+	 */
+	uint32_t library;
+	/**
+	 * @brief Reserved.
+	 */
+	uint32_t genre;
+	/**
+	 * @brief Reserved.
+	 */
+	uint32_t morphology;
+};
+
+/**
+ * @brief SF2 zone, "pbag" and "ibag" record.
+ */
+struct riff_sf2Bag {
+	/**
+	 * @brief Index of the first generator of the zone.
+	 */
+	uint16_t gen;
+	/**
+	 * @brief Index of the first modulator of the zone.
+	 */
+	uint16_t mod;
+};
+
+/**
+ * @brief SF2 modulator, "pmod" and "imod" record.
+ */
+struct riff_sf2Mod {
+	/**
+	 * @brief Source.
+	 */
+	uint16_t src;
+	/**
+	 * @brief Destination generator.
+	 */
+	uint16_t dest;
+	/**
+	 * @brief Amount.
+	 */
+	int16_t amount;
+	/**
+	 * @brief Amount source.
+	 */
+	uint16_t amount_src;
+	/**
+	 * @brief Transform.
+	 */
+	uint16_t transform;
+};
+
+/**
+ * @brief SF2 generator, "pgen" and "igen" record.
+ */
+struct riff_sf2Gen {
+	/**
+	 * @brief Generator type.
+	 */
+	uint16_t oper;
+	/**
+	 * @brief Amount, a signed or unsigned value or a range with the low byte as lower bound, depending on the type.
+	 */
+	uint16_t amount;
+};
+
+/**
+ * @brief SF2 instrument header, "inst" record.
+ */
+struct riff_sf2Inst {
+	/**
+	 * @brief Name.
+	 */
+	char name[21];
+	/**
+	 * @brief Index of the first zone in riff_bank::inst_bags.
+	 */
+	uint16_t bag;
+};
+
+/**
+ * @brief SF2 sample header, "shdr" record.
+ */
+struct riff_sf2Sample {
+	/**
+	 * @brief Name.
+	 */
+	char name[21];
+	/**
+	 * @brief First sample point in the "smpl" chunk.
+	 */
+	uint32_t start;
+	/**
+	 * @brief First sample point after the sample.
+	 */
+	uint32_t end;
+	/**
+	 * @brief First sample point of the loop.
+	 */
+	uint32_t loop_start;
+	/**
+	 * @brief First sample point after the loop.
+	 */
+	uint32_t loop_end;
+	/**
+	 * @brief Sample rate in Hz.
+	 */
+	uint32_t sample_rate;
+	/**
+	 * @brief MIDI key of the recorded pitch.
+	 */
+	uint8_t pitch;
+	/**
+	 * @brief Pitch correction in cents.
+	 */
+	int8_t correction;
+	/**
+	 * @brief Index of the linked sample, e.g. the other channel of a stereo sample.
+	 */
+	uint16_t link;
+	/**
+	 * @brief Sample type, e.g. 1 for mono, 2 for right, 4 for left.
+	 */
+	uint16_t type;
+};
+
+/**
+ * @brief DLS sample parameters, "wsmp" chunk with its first loop.
+ */
+struct riff_dlsWsmp {
+	/**
+	 * @brief 1 if a "wsmp" chunk was found.
+	 */
+	int present;
+	/**
+	 * @brief MIDI key of the recorded pitch.
+	 */
+	uint16_t unity_note;
+	/**
+	 * @brief Fine tune in 1/65536 cents.
+	 */
+	int16_t fine_tune;
+	/**
+	 * @brief Gain in 1/655360 dB.
+	 */
+	int32_t gain;
+	/**
+	 * @brief Options, `F_WSMP_...`.
+	 */
+	uint32_t options;
+	/**
+	 * @brief Amount of loops.
+	 */
+	uint32_t loops;
+	/**
+	 * @brief Type of the first loop.
+	 */
+	uint32_t loop_type;
+	/**
+	 * @brief First sample frame of the first loop.
+	 */
+	uint32_t loop_start;
+	/**
+	 * @brief Length of the first loop in sample frames.
+	 */
+	uint32_t loop_length;
+};
+
+/**
+ * @brief DLS instrument, "ins " list.
+ */
+struct riff_dlsInstrument {
+	/**
+	 * @brief Name from the "INAM" tag, cut off to 31 characters.
+	 */
+	char name[32];
+	/**
+	 * @brief MIDI bank, `ulBank` with the drum flag.
+	 */
+	uint32_t bank;
+	/**
+	 * @brief MIDI program.
+	 */
+	uint32_t program;
+	/**
+	 * @brief Index of the first region in riff_bank::regions.
+	 */
+	size_t region;
+	/**
+	 * @brief Amount of regions.
+	 */
+	size_t regions_len;
+};
+
+/**
+ * @brief DLS region, "rgn " or "rgn2" list.
+ */
+struct riff_dlsRegion {
+	/**
+	 * @brief Lowest key.
+	 */
+	uint16_t key_lo;
+	/**
+	 * @brief Highest key.
+	 */
+	uint16_t key_hi;
+	/**
+	 * @brief Lowest velocity.
+	 */
+	uint16_t vel_lo;
+	/**
+	 * @brief Highest velocity.
+	 */
+	uint16_t vel_hi;
+	/**
+	 * @brief Options, `F_RGN_...`.
+	 */
+	uint16_t options;
+	/**
+	 * @brief Key group, 0 for none.
+	 */
+	uint16_t key_group;
+	/**
+	 * @brief Channel of the wave link.
+	 */
+	uint32_t channel;
+	/**
+	 * @brief Pool table index of the wave link.
+	 */
+	uint32_t table_index;
+	/**
+	 * @brief Index of the wave in riff_bank::waves, `(size_t)-1` if not found.
+	 */
+	size_t wave;
+	/**
+	 * @brief Sample parameters, those of the wave if the region has none.
+	 */
+	struct riff_dlsWsmp wsmp;
+};
+
+/**
+ * @brief DLS wave, "wave" list of the wave pool.
+ */
+struct riff_dlsWave {
+	/**
+	 * @brief Format tag, 1 for PCM.
+	 */
+	uint16_t format_tag;
+	/**
+	 * @brief Amount of channels.
+	 */
+	uint16_t channels;
+	/**
+	 * @brief Sample rate in Hz.
+	 */
+	uint32_t sample_rate;
+	/**
+	 * @brief Bytes per sample frame.
+	 */
+	uint16_t block_align;
+	/**
+	 * @brief Bits per sample.
+	 */
+	uint16_t bits_per_sample;
+	/**
+	 * @brief Offset of the "wave" list in the wave pool, as in the pool table.
+	 */
+	size_t offset;
+	/**
+	 * @brief Sample parameters.
+	 */
+	struct riff_dlsWsmp wsmp;
+	/**
+	 * @brief The "data" chunk data.
+	 */
+	struct riff_bankSlice data;
+};
+
+/**
+ * @brief Headers of a sample bank.
+ *
+ * Filled by riff_bankOpen(), freed by riff_bankClose().
+ */
+typedef struct riff_bank {
+	/**
+	 * @brief Bank type, see @ref Bank_types.
+	 */
+	int type;
+
+	/**
+	 * @brief SF2 "smpl" chunk data, 16 bit samples. DLS "wvpl" list data.
+	 */
+	struct riff_bankSlice smpl;
+	/**
+	 * @brief SF2 "sm24" chunk data, the low bytes of 24 bit samples. Size 0 if none.
+	 */
+	struct riff_bankSlice sm24;
+
+	/**
+	 * @name SF2 headers.
+	 * Records of the "pdta" list including the terminal records.
+	 */
+	///@{
+	/**
+	 * @brief Preset headers, "phdr".
+	 */
+	struct riff_sf2Preset *presets;
+	/**
+	 * @brief Amount of preset headers.
+	 */
+	size_t presets_len;
+	/**
+	 * @brief Preset zones, "pbag".
+	 */
+	struct riff_sf2Bag *preset_bags;
+	/**
+	 * @brief Amount of preset zones.
+	 */
+	size_t preset_bags_len;
+	/**
+	 * @brief Preset modulators, "pmod".
+	 */
+	struct riff_sf2Mod *preset_mods;
+	/**
+	 * @brief Amount of preset modulators.
+	 */
+	size_t preset_mods_len;
+	/**
+	 * @brief Preset generators, "pgen".
+	 */
+	struct riff_sf2Gen *preset_gens;
+	/**
+	 * @brief Amount of preset generators.
+	 */
+	size_t preset_gens_len;
+	/**
+	 * @brief Instrument headers, "inst".
+	 */
+	struct riff_sf2Inst *insts;
+	/**
+	 * @brief Amount of instrument headers.
+	 */
+	size_t insts_len;
+	/**
+	 * @brief Instrument zones, "ibag".
+	 */
+	struct riff_sf2Bag *inst_bags;
+	/**
+	 * @brief Amount of instrument zones.
+	 */
+	size_t inst_bags_len;
+	/**
+	 * @brief Instrument modulators, "imod".
+	 */
+	struct riff_sf2Mod *inst_mods;
+	/**
+	 * @brief Amount of instrument modulators.
+	 */
+	size_t inst_mods_len;
+	/**
+	 * @brief Instrument generators, "igen".
+	 */
+	struct riff_sf2Gen *inst_gens;
+	/**
+	 * @brief Amount of instrument generators.
+	 */
+	size_t inst_gens_len;
+	/**
+	 * @brief Sample headers, "shdr".
+	 */
+	struct riff_sf2Sample *samples;
+	/**
+	 * @brief Amount of sample headers.
+	 */
+	size_t samples_len;
+	///@}
+
+	/**
+	 * @name DLS headers.
+	 */
+	///@{
+	/**
+	 * @brief Instruments, in file order.
+	 */
+	struct riff_dlsInstrument *instruments;
+	/**
+	 * @brief Amount of instruments.
+	 */
+	size_t instruments_len;
+	/**
+	 * @brief Amount of allocated instruments.
+	 */
+	size_t instruments_size;
+	/**
+	 * @brief Regions of all instruments.
+	 */
+	struct riff_dlsRegion *regions;
+	/**
+	 * @brief Amount of regions.
+	 */
+	size_t regions_len;
+	/**
+	 * @brief Amount of allocated regions.
+	 */
+	size_t regions_size;
+	/**
+	 * @brief Waves of the wave pool, in file order.
+	 */
+	struct riff_dlsWave *waves;
+	/**
+	 * @brief Amount of waves.
+	 */
+	size_t waves_len;
+	/**
+	 * @brief Amount of allocated waves.
+	 */
+	size_t waves_size;
+	/**
+	 * @brief Pool table, "ptbl", offset of the wave of each table index.
+	 */
+	uint32_t *cues;
+	/**
+	 * @brief Amount of pool table entries.
+	 */
+	size_t cues_len;
+	///@}
+
+	/**
+	 * @brief Allocator of the arrays, the one of the riff_handle the bank was opened with.
+	 */
+	riff_allocator alloc;
+} riff_bank;
+
+/**
+ * @defgroup RIFF_C_Bank C sample bank functions
+ * @{
+ */
+/**
+ * @brief Parse the headers of an SF2 or DLS file, sample data is not read.
+ *
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param rh The riff_handle to use, opened SF2 or DLS file.
+ * @param bank The riff_bank to fill, free with riff_bankClose() even on failure.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ILLID if the file is no sample bank.
+ */
+int riff_bankOpen(riff_handle *rh, riff_bank *bank);
+/**
+ * @brief Free the arrays of a riff_bank.
+ *
+ * @param bank The riff_bank filled by riff_bankOpen().
+ */
+void riff_bankClose(riff_bank *bank);
+/**
+ * @brief Get the slice of a sample, SF2 sample header or DLS wave.
+ *
+ * SF2 slices are 16 bit samples of the "smpl" chunk, DLS slices the data of the wave in its format.
+ *
+ * @param bank The riff_bank filled by riff_bankOpen().
+ * @param i Sample number, index of riff_bank::samples or riff_bank::waves.
+ * @param slice Receives the slice.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the sample does not exist, ::RIFF_ERROR_ICSIZE if it exceeds the sample pool.
+ */
+int riff_bankSample(const riff_bank *bank, size_t i, struct riff_bankSlice *slice);
+/**
+ * @brief Get the slice of the low bytes of a 24 bit SF2 sample, one byte per sample point.
+ *
+ * @param bank The riff_bank filled by riff_bankOpen().
+ * @param i Sample number, index of riff_bank::samples.
+ * @param slice Receives the slice.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_EOC if the sample does not exist or the bank has no "sm24" chunk.
+ */
+int riff_bankSample24(const riff_bank *bank, size_t i, struct riff_bankSlice *slice);
+/**
+ * @brief Read bytes of a slice, copied from memory for memory based handles.
+ *
+ * The position of the riff_handle is not changed.
+ *
+ * @param rh The riff_handle of the file.
+ * @param slice The slice, e.g. from riff_bankSample().
+ * @param offset Offset in the slice.
+ * @param dst Destination.
+ * @param size Amount of bytes to read.
+ *
+ * @return Amount of bytes read, not beyond the end of the slice.
+ */
+size_t riff_bankRead(riff_handle *rh, const struct riff_bankSlice *slice, size_t offset, void *dst, size_t size);
+
+///@}
+
+#endif // _RIFF_BANK_H_
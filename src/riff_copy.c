@@ -0,0 +1,188 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => kernel copies use explicit offsets and don't move the source, buffered copies seek back to rh->pos afterwards
+
+
+#if defined(__linux__)  &&  !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  //copy_file_range(), splice()
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#define writeFD(fd, ptr, size) _write(fd, ptr, (unsigned int)(size))
+#else
+#include <unistd.h>
+#define writeFD(fd, ptr, size) write(fd, ptr, size)
+#endif
+
+//kernel side copy between descriptors
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#define RIFF_COPY_SENDFILE
+#if defined(__GLIBC__)  &&  (__GLIBC__ > 2  ||  (__GLIBC__ == 2  &&  __GLIBC_MINOR__ >= 27))
+#define RIFF_COPY_FILE_RANGE
+#endif
+#endif
+
+#include "riff_copy.h"
+#include "riff_internal.h"
+
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return 0
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//description: see riff_internal.h
+size_t copy_kernel(int fd_in, size_t pos, int fd_out, size_t *pos_out, size_t size){
+	size_t left = size;
+#if defined(RIFF_COPY_SENDFILE)
+	off_t off_in = pos;
+	off_t off_out = (pos_out != NULL) ? (off_t)*pos_out : 0;
+	ssize_t n = 0;
+
+	#if defined(RIFF_COPY_FILE_RANGE)
+	//file to file, may share extents on copy-on-write file systems
+	while(left > 0  &&  (n = copy_file_range(fd_in, &off_in, fd_out, (pos_out != NULL) ? &off_out : NULL, left, 0)) > 0)
+		left -= n;
+	#endif
+
+	//not supported between these descriptors (other file system, socket, old kernel), sendfile() writes at the current offset
+	if(left > 0  &&  (pos_out == NULL  ||  lseek(fd_out, off_out, SEEK_SET) == off_out)){
+		while(left > 0  &&  (n = sendfile(fd_out, fd_in, &off_in, left)) > 0){
+			left -= n;
+			off_out += n;
+		}
+	}
+
+	//pipe on kernels where sendfile() can't write to it
+	if(left > 0  &&  pos_out == NULL){
+		while(left > 0  &&  (n = splice(fd_in, &off_in, fd_out, NULL, left, SPLICE_F_MORE)) > 0)
+			left -= n;
+	}
+
+	if(pos_out != NULL)
+		*pos_out = off_out;
+#else
+	(void)fd_in;  (void)pos;  (void)fd_out;  (void)pos_out;
+#endif
+	return size - left;
+}
+
+
+/*****************************************************************************/
+//write whole block to descriptor, returns number of written bytes
+size_t copy_writeAll(int fd, const uint8_t *ptr, size_t size){
+	size_t done = 0;
+	while(done < size){
+		size_t block = size - done;
+		if(block > RIFF_COPY_BUFFER_SIZE)
+			block = RIFF_COPY_BUFFER_SIZE;
+		long n = (long)writeFD(fd, ptr + done, block);
+		if(n <= 0)
+			break;
+		done += n;
+	}
+	return done;
+}
+
+
+/*****************************************************************************/
+//copy absolute range of source to descriptor, returns number of copied bytes
+//file position of rh is changed, rh->pos is not
+size_t copy_range(riff_handle *rh, size_t pos, size_t size, int fd){
+	//don't copy beyond end of source
+	if(rh->size > 0){
+		if(pos >= rh->size)
+			return 0;
+		if(size > rh->size - pos)
+			size = rh->size - pos;
+	}
+
+	//in memory, write from there
+	if(rh->fp_read == &read_mem)
+		return copy_writeAll(fd, (const uint8_t *)rh->fh + pos, size);
+
+	size_t done = 0;
+	if(rh->fp_read == &read_file)
+		done = copy_kernel(fileno((FILE*)(rh->fh)), pos, fd, NULL, size);
+	if(done == size)
+		return done;
+
+	//rest through buffer
+	size_t bufsize = size - done;
+	if(bufsize > RIFF_COPY_BUFFER_SIZE)
+		bufsize = RIFF_COPY_BUFFER_SIZE;
+	uint8_t *buf = mem_alloc(&rh->alloc, bufsize);
+	if(buf == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate copy buffer\n");
+		return done;
+	}
+	rh->fp_seek(rh, pos + done);
+	while(done < size){
+		size_t block = size - done;
+		if(block > bufsize)
+			block = bufsize;
+		size_t n = rh->fp_read(rh, buf, block);
+		size_t w = copy_writeAll(fd, buf, n);
+		done += w;
+		if(n < block  ||  w < n)
+			break;
+	}
+	mem_free(&rh->alloc, buf);
+	return done;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_copyChunkTo(riff_handle *rh, int fd){
+	checkValidRiffHandle(rh);
+
+	size_t n = copy_range(rh, rh->pos, rh->c_size - rh->c_pos, fd);
+	rh->pos += n;
+	rh->c_pos += n;
+	rh->fp_seek(rh, rh->pos);
+	return n;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_copySubtreeTo(riff_handle *rh, int fd){
+	checkValidRiffHandle(rh);
+
+	size_t n = copy_range(rh, rh->c_pos_start, RIFF_CHUNK_DATA_OFFSET + rh->c_size + rh->pad, fd);
+	rh->fp_seek(rh, rh->pos);
+	return n;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_copyRangesTo(riff_handle *rh, int fd, const struct riff_range *ranges, size_t count){
+	checkValidRiffHandle(rh);
+
+	size_t i, n, total = 0;
+	for(i = 0; i < count; i++){
+		n = copy_range(rh, ranges[i].pos, ranges[i].size, fd);
+		total += n;
+		if(n < ranges[i].size)
+			break;
+	}
+	rh->fp_seek(rh, rh->pos);
+	return total;
+}
@@ -0,0 +1,88 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+To copy chunk data out of a RIFF file to a file descriptor without passing it through user buffers.
+Works on an opened riff_handle, the destination is an open file descriptor (file, pipe or socket), written at its current offset.
+
+
+Usage:
+Navigate to the chunk with the usual riff_handle functions
+Call riff_copyChunkTo() to copy the chunk data, riff_copySubtreeTo() to copy the whole chunk with header and subchunks
+  or riff_copyRangesTo() to copy a list of byte ranges of the file
+  If the source was opened with riff_open_file() the kernel copies the data where supported (Linux: copy_file_range(), sendfile(), splice())
+  If it was opened with riff_open_mem() the data is written straight from memory
+  Otherwise the data is copied through a large buffer
+*/
+
+#ifndef _RIFF_COPY_H_
+#define _RIFF_COPY_H_
+
+#include "riff.h"
+
+/**
+ * @brief Size of the buffer used if the kernel can't copy.
+ */
+#define RIFF_COPY_BUFFER_SIZE	(1 << 20)
+
+/**
+ * @brief Byte range of the RIFF file.
+ */
+struct riff_range {
+	/**
+	 * @brief Absolute position in the file stream, e.g. riff_handle::c_pos_start.
+	 */
+	size_t pos;
+	/**
+	 * @brief Amount of bytes.
+	 */
+	size_t size;
+};
+
+/**
+ * @defgroup RIFF_C_Copy C RIFF copy functions
+ * @{
+ */
+/**
+ * @brief Copy the rest of the current chunk data to a file descriptor.
+ *
+ * Starts at riff_handle::c_pos like riff_readInChunk(), the pad byte is not copied.
+ * Afterwards the riff_handle is at the end of the chunk data.
+ *
+ * @param rh The riff_handle to use.
+ * @param fd The destination file descriptor.
+ *
+ * @return Amount of copied bytes, less than the rest of the chunk on error.
+ */
+size_t riff_copyChunkTo(riff_handle *rh, int fd);
+/**
+ * @brief Copy the current chunk including header, pad byte and all subchunks to a file descriptor.
+ *
+ * The riff_handle position is not changed.
+ *
+ * @param rh The riff_handle to use.
+ * @param fd The destination file descriptor.
+ *
+ * @return Amount of copied bytes, less than the chunk size on error.
+ */
+size_t riff_copySubtreeTo(riff_handle *rh, int fd);
+/**
+ * @brief Copy byte ranges of the file to a file descriptor, one after another.
+ *
+ * The riff_handle position is not changed.
+ *
+ * @param rh The riff_handle to use.
+ * @param fd The destination file descriptor.
+ * @param ranges The ranges to copy.
+ * @param count Amount of ranges.
+ *
+ * @return Amount of copied bytes, less than the sum of the range sizes on error.
+ */
+size_t riff_copyRangesTo(riff_handle *rh, int fd, const struct riff_range *ranges, size_t count);
+
+///@}
+
+#endif // _RIFF_COPY_H_
@@ -0,0 +1,603 @@
+// take care: whenever we call rh->fp_read(), rh->fp_seek() or rh->fp_write()
+//   we must adjust rh->c_pos and rh->pos
+//   => in-place edits seek around freely and end with riff_seekChunkStart() to get consistent positions again
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_edit.h"
+#include "riff_internal.h"
+
+
+#define RIFF_EDIT_COPY_BUFFER 65536  //buffer size for copying chunk data, smaller chunks are always copied through it
+#define RIFF_EDIT_OPS_ALLOC 16       //number of edit script operations allocated per step
+#define RIFF_EDIT_JUNK_MAX 0xFFFFFFFE  //largest even 32 bit chunk size, larger gaps get several JUNK chunks
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//write at absolute position
+int edit_writeAt(riff_handle *rh, size_t pos, const void *ptr, size_t size){
+	rh->fp_seek(rh, pos);
+	if(rh->fp_write(rh, ptr, size) != size){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to write %zu bytes at pos %zu!\n", size, pos);
+		return RIFF_ERROR_ACCESS;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//write size field in the byte order of the file
+void edit_putSize(riff_handle *rh, void *p, size_t size){
+	if(isBigEndian(rh))
+		writeUInt32BE(p, (uint32_t)size);
+	else
+		writeUInt32LE(p, (uint32_t)size);
+}
+
+
+/*****************************************************************************/
+//write chunk header with ID and size at absolute position
+int edit_writeHeader(riff_handle *rh, size_t pos, const char *id, size_t size){
+	uint8_t hdr[RIFF_CHUNK_DATA_OFFSET];
+	memcpy(hdr, id, 4);
+	edit_putSize(rh, hdr + 4, size);
+	return edit_writeAt(rh, pos, hdr, RIFF_CHUNK_DATA_OFFSET);
+}
+
+
+/*****************************************************************************/
+//fill total bytes at pos with JUNK chunks, total is even and 0 or at least RIFF_CHUNK_DATA_OFFSET
+int edit_writeJunk(riff_handle *rh, size_t pos, size_t total){
+	int r;
+	while(total > 0){
+		size_t size = total - RIFF_CHUNK_DATA_OFFSET;
+		if(size > RIFF_EDIT_JUNK_MAX){
+			size = RIFF_EDIT_JUNK_MAX;
+			//leave room for the header of the next one
+			if(total - RIFF_CHUNK_DATA_OFFSET - size < RIFF_CHUNK_DATA_OFFSET)
+				size -= RIFF_CHUNK_DATA_OFFSET;
+		}
+		if((r = edit_writeHeader(rh, pos, "JUNK", size)) != RIFF_ERROR_NONE)
+			return r;
+		pos += RIFF_CHUNK_DATA_OFFSET + size;
+		total -= RIFF_CHUNK_DATA_OFFSET + size;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//write new data of current chunk: size field, data, pad byte
+int edit_writeChunk(riff_handle *rh, const void *data, size_t size){
+	int r;
+	uint8_t buf[4];
+	edit_putSize(rh, buf, size);
+	if((r = edit_writeAt(rh, rh->c_pos_start + 4, buf, 4)) != RIFF_ERROR_NONE)
+		return r;
+	if((r = edit_writeAt(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, data, size)) != RIFF_ERROR_NONE)
+		return r;
+	if(size & 0x1){
+		uint8_t pad = 0;
+		if((r = edit_writeAt(rh, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + size, &pad, 1)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	rh->c_size = size;
+	rh->pad = size & 0x1;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//end of current list level without pad byte
+size_t edit_listEnd(riff_handle *rh, int level){
+	if(level > 0)
+		return rh->ls[level - 1].c_pos_start + RIFF_CHUNK_DATA_OFFSET + rh->ls[level - 1].c_size;
+	return rh->pos_start + RIFF_CHUNK_DATA_OFFSET + rh->h_size;
+}
+
+
+/*****************************************************************************/
+//read chunk header at absolute position
+//returns total size of the chunk including header and pad byte, 0 on read error
+size_t edit_readHeader(riff_handle *rh, size_t pos, uint8_t *hdr){
+	rh->fp_seek(rh, pos);
+	if(rh->fp_read(rh, hdr, RIFF_CHUNK_DATA_OFFSET) != RIFF_CHUNK_DATA_OFFSET)
+		return 0;
+	size_t size = isBigEndian(rh) ? convUInt32BE(hdr + 4) : convUInt32LE(hdr + 4);
+	if(size == 0xFFFFFFFF  &&  rh->ds64)
+		size = ds64Size(rh, (const char *)hdr);
+	return RIFF_CHUNK_DATA_OFFSET + size + (size & 0x1);
+}
+
+
+/*****************************************************************************/
+//check if chunk header is "JUNK" or "PAD "
+int edit_isJunk(const uint8_t *hdr){
+	return memcmp(hdr, "JUNK", 4) == 0  ||  memcmp(hdr, "PAD ", 4) == 0;
+}
+
+
+/*****************************************************************************/
+//read header of the chunk following the current one, if it's "JUNK" or "PAD "
+//returns total size of that chunk including header and pad byte, 0 if there is none
+size_t edit_nextJunk(riff_handle *rh){
+	size_t next = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + rh->c_size + rh->pad;
+	size_t end = edit_listEnd(rh, rh->ls_level);
+	if(next + RIFF_CHUNK_DATA_OFFSET > end)
+		return 0;
+
+	uint8_t hdr[RIFF_CHUNK_DATA_OFFSET];
+	size_t total = edit_readHeader(rh, next, hdr);
+	if(!edit_isJunk(hdr)  ||  total > end - next)
+		return 0; //corrupt, don't touch
+	return total;
+}
+
+
+/*****************************************************************************/
+//find the chunk in front of the current one, if it's "JUNK" or "PAD "
+//chunks have no back links, so the level is scanned header by header from its start
+//returns total size of that chunk including header and pad byte, 0 if there is none
+size_t edit_prevJunk(riff_handle *rh){
+	size_t pos = (rh->ls_level > 0) ? rh->ls[rh->ls_level - 1].c_pos_start : rh->pos_start;
+	pos += RIFF_CHUNK_DATA_OFFSET + 4;
+
+	uint8_t hdr[RIFF_CHUNK_DATA_OFFSET];
+	size_t total = 0;
+	while(pos < rh->c_pos_start){
+		total = edit_readHeader(rh, pos, hdr);
+		if(total == 0  ||  total > rh->c_pos_start - pos)
+			return 0; //corrupt, don't touch
+		pos += total;
+	}
+	if(total == 0  ||  !edit_isJunk(hdr))
+		return 0;
+	return total;
+}
+
+
+/*****************************************************************************/
+//check if a chunk ending at end leaves a gap to region_end that JUNK chunks can fill
+int edit_fits(size_t end, size_t region_end){
+	return end == region_end  ||  end + RIFF_CHUNK_DATA_OFFSET <= region_end;
+}
+
+
+/*****************************************************************************/
+//check if the current chunk is the last one of every level and of the file
+int edit_isLastChunk(riff_handle *rh){
+	size_t end = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + rh->c_size + rh->pad;
+	int i;
+	for(i = rh->ls_level; i >= 0; i--){
+		if(edit_listEnd(rh, i) != end)
+			return 0;
+	}
+	//file must end there as well
+	return rh->size == 0  ||  rh->size == end;
+}
+
+
+/*****************************************************************************/
+//try to replace current chunk data without moving other chunks
+//returns RIFF_EDIT_NONE if there is no slack
+int edit_inPlace(riff_handle *rh, const void *data, size_t size, int *r){
+	size_t old_total = RIFF_CHUNK_DATA_OFFSET + rh->c_size + rh->pad;
+	size_t new_total = RIFF_CHUNK_DATA_OFFSET + size + (size & 0x1);
+	size_t old_end = rh->c_pos_start + old_total;
+	size_t new_end = rh->c_pos_start + new_total;
+	size_t junk, prev;
+
+	//same padded size
+	if(new_total == old_total){
+		*r = edit_writeChunk(rh, data, size);
+		return RIFF_EDIT_INPLACE;
+	}
+
+	//shrink, freed space becomes new JUNK
+	if(new_total + RIFF_CHUNK_DATA_OFFSET <= old_total){
+		if((*r = edit_writeChunk(rh, data, size)) == RIFF_ERROR_NONE)
+			*r = edit_writeJunk(rh, new_end, old_total - new_total);
+		return RIFF_EDIT_JUNK;
+	}
+
+	//following JUNK chunk absorbs the size change, it moves so it still starts right after the chunk
+	junk = edit_nextJunk(rh);
+	if(junk > 0  &&  edit_fits(new_end, old_end + junk)){
+		if((*r = edit_writeChunk(rh, data, size)) == RIFF_ERROR_NONE)
+			*r = edit_writeJunk(rh, new_end, old_end + junk - new_end);
+		return RIFF_EDIT_JUNK;
+	}
+
+	//preceding JUNK chunk takes the rest, the chunk moves to its start
+	if(new_total > old_total  &&  (prev = edit_prevJunk(rh)) > 0){
+		size_t start = rh->c_pos_start - prev;
+		if(edit_fits(start + new_total, old_end + junk)){
+			rh->c_pos_start = start;
+			if((*r = edit_writeHeader(rh, start, rh->c_id, size)) == RIFF_ERROR_NONE  &&  (*r = edit_writeChunk(rh, data, size)) == RIFF_ERROR_NONE)
+				*r = edit_writeJunk(rh, start + new_total, old_end + junk - start - new_total);
+			return RIFF_EDIT_JUNK;
+		}
+	}
+
+	//last chunk of the file grows, fix up all parent sizes
+	//not for 64 bit files, their size is in the ds64 chunk
+	if(new_total > old_total  &&  (memcmp(rh->h_id, "RIFF", 4) == 0  ||  isBigEndian(rh))  &&  edit_isLastChunk(rh)){
+		size_t grow = new_total - old_total;
+		if(rh->h_size + grow > 0xFFFFFFFF)
+			return RIFF_EDIT_NONE;
+
+		if((*r = edit_writeChunk(rh, data, size)) != RIFF_ERROR_NONE)
+			return RIFF_EDIT_RESIZE;
+		uint8_t buf[4];
+		int i;
+		for(i = 0; i < rh->ls_level; i++){
+			rh->ls[i].c_size += grow;
+			edit_putSize(rh, buf, rh->ls[i].c_size);
+			if((*r = edit_writeAt(rh, rh->ls[i].c_pos_start + 4, buf, 4)) != RIFF_ERROR_NONE)
+				return RIFF_EDIT_RESIZE;
+		}
+		rh->h_size += grow;
+		if(rh->size > 0)
+			rh->size += grow;
+		edit_putSize(rh, buf, rh->h_size);
+		*r = edit_writeAt(rh, rh->pos_start + 4, buf, 4);
+		return RIFF_EDIT_RESIZE;
+	}
+
+	return RIFF_EDIT_NONE;
+}
+
+
+/*****************************************************************************/
+//copy rest of current chunk data to writer
+//between two files the kernel copies large chunks without passing the data through user space where available
+int edit_copyData(riff_handle *rh, riff_writer *rw, uint8_t *buf){
+	size_t left = rh->c_size - rh->c_pos;
+
+	if(left >= RIFF_EDIT_COPY_BUFFER  &&  rh->fp_read == &read_file  &&  rw->fp_write == &write_file){
+		if(writer_flush(rw) != RIFF_ERROR_NONE  ||  fflush((FILE*)(rw->fh)) != 0)
+			return RIFF_ERROR_ACCESS;
+
+		size_t pos_out = rw->buf_pos;
+		size_t copied = copy_kernel(fileno((FILE*)(rh->fh)), rh->pos, fileno((FILE*)(rw->fh)), &pos_out, left);
+		rw->buf_pos += copied;
+		rw->pos += copied;
+		rw->seek_pending = 1; //FILE position is stale, seek before the next write
+		rh->pos += copied;
+		rh->c_pos += copied;
+		left -= copied;
+		//rest, if any, is copied through the buffer
+		rh->fp_seek(rh, rh->pos);
+	}
+
+	size_t n;
+	while((n = riff_readInChunk(rh, buf, RIFF_EDIT_COPY_BUFFER)) > 0){
+		if(riff_writerWrite(rw, buf, n) != n)
+			return RIFF_ERROR_ACCESS;
+		left -= n;
+	}
+	if(left > 0)
+		return RIFF_ERROR_EOF;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//order operations by position, same position in queued order
+static int compareOps(const void *a, const void *b){
+	const struct riff_editOp *x = (const struct riff_editOp *)a;
+	const struct riff_editOp *y = (const struct riff_editOp *)b;
+	if(x->pos != y->pos)
+		return (x->pos < y->pos) ? -1 : 1;
+	return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/*****************************************************************************/
+//find first operation at pos in sorted script, returns ops_len if there is none
+size_t edit_findOps(const riff_editScript *es, size_t pos){
+	size_t lo = 0, hi = es->ops_len;
+	while(lo < hi){
+		size_t mid = lo + (hi - lo) / 2;
+		if(es->ops[mid].pos < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if(lo < es->ops_len  &&  es->ops[lo].pos == pos)
+		return lo;
+	return es->ops_len;
+}
+
+
+//state of a file copy, passed to the walker callbacks
+struct editCopy {
+	riff_writer *rw;
+	const riff_editScript *es;  //sorted operations, can be NULL
+	uint8_t *buf;               //copy buffer
+	int r;                      //first error
+};
+
+/*****************************************************************************/
+//write new chunks of operations "op" at pos
+int edit_writeNew(struct editCopy *c, size_t pos, int op){
+	size_t i;
+	int r;
+	if(c->es == NULL)
+		return RIFF_ERROR_NONE;
+	for(i = edit_findOps(c->es, pos); i < c->es->ops_len  &&  c->es->ops[i].pos == pos; i++){
+		const struct riff_editOp *o = c->es->ops + i;
+		if(o->op == op  &&  (r = riff_writerWriteChunk(c->rw, o->c_id, o->data, o->size)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+//walker callback: insert new chunks, copy or replace a chunk, lists are started in copyEnter()
+static int copyChunk(riff_handle *rh, void *user){
+	struct editCopy *c = (struct editCopy *)user;
+	const struct riff_editOp *rep = NULL;
+	size_t i;
+
+	if((c->r = edit_writeNew(c, rh->c_pos_start, RIFF_EDIT_OP_INSERT)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+
+	if(c->es != NULL){
+		for(i = edit_findOps(c->es, rh->c_pos_start); i < c->es->ops_len  &&  c->es->ops[i].pos == rh->c_pos_start; i++){
+			if(c->es->ops[i].op == RIFF_EDIT_OP_DELETE)
+				return RIFF_WALK_SKIP;
+			if(c->es->ops[i].op == RIFF_EDIT_OP_REPLACE)
+				rep = c->es->ops + i;
+		}
+	}
+
+	if(rep != NULL){
+		if((c->r = riff_writerWriteChunk(c->rw, rh->c_id, rep->data, rep->size)) != RIFF_ERROR_NONE)
+			return RIFF_WALK_STOP;
+		return RIFF_WALK_SKIP;
+	}
+
+	if(riff_chunkIsList(rh))
+		return RIFF_WALK_CONTINUE;
+
+	//size is known, no back-patching
+	if((c->r = riff_writerBeginChunkSized(c->rw, rh->c_id, rh->c_size)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	if((c->r = edit_copyData(rh, c->rw, c->buf)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	if((c->r = riff_writerEnd(c->rw)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	return RIFF_WALK_CONTINUE;
+}
+
+//walker callback: start copy of a chunk list
+static int copyEnter(riff_handle *rh, void *user){
+	struct editCopy *c = (struct editCopy *)user;
+	struct riff_levelStackE *ls = rh->ls + rh->ls_level - 1;
+	if((c->r = writer_begin(c->rw, ls->c_id, ls->c_type, RIFF_WRITER_SIZE_UNKNOWN)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	return RIFF_WALK_CONTINUE;
+}
+
+//walker callback: append new chunks and end copy of a chunk list
+static int copyLeave(riff_handle *rh, void *user){
+	struct editCopy *c = (struct editCopy *)user;
+	if((c->r = edit_writeNew(c, rh->ls[rh->ls_level - 1].c_pos_start, RIFF_EDIT_OP_APPEND)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	if((c->r = riff_writerEnd(c->rw)) != RIFF_ERROR_NONE)
+		return RIFF_WALK_STOP;
+	return RIFF_WALK_CONTINUE;
+}
+
+
+/*****************************************************************************/
+//copy whole file to writer, applying the operations of the sorted script if any
+int edit_copy(riff_handle *rh, riff_writer *rw, const riff_editScript *es){
+	if(rw == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+
+	struct editCopy c = {0};
+	c.rw = rw;
+	c.es = es;
+	c.buf = mem_alloc(&rh->alloc, RIFF_EDIT_COPY_BUFFER);
+	if(c.buf == NULL)
+		return RIFF_ERROR_MEMORY;
+
+	struct riff_walker w = {0};
+	w.fp_chunk = &copyChunk;
+	w.fp_enter = &copyEnter;
+	w.fp_leave = &copyLeave;
+	w.user = &c;
+
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	int r = riff_walk(rh, &w);
+	mem_free(&rh->alloc, c.buf);
+
+	if(c.r != RIFF_ERROR_NONE)
+		return c.r;
+	if(r != RIFF_ERROR_NONE)
+		return r;
+	//chunks appended to the RIFF chunk itself
+	if((r = edit_writeNew(&c, rh->pos_start, RIFF_EDIT_OP_APPEND)) != RIFF_ERROR_NONE)
+		return r;
+	return riff_writerClose(rw);
+}
+
+
+/*****************************************************************************/
+//queue operation
+int edit_queue(riff_editScript *es, int op, size_t pos, const char *id, const void *data, size_t size){
+	if(es == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	if(id != NULL  &&  !isValidID(id))
+		return RIFF_ERROR_ILLID;
+	if(size > 0xFFFFFFFF  ||  (size > 0  &&  data == NULL))
+		return RIFF_ERROR_ICSIZE;
+
+	//need to enlarge?
+	if(es->ops_len >= es->ops_size){
+		size_t ops_size_new = es->ops_size * 2; //double size
+		if(ops_size_new == 0)
+			ops_size_new = RIFF_EDIT_OPS_ALLOC;
+		struct riff_editOp *opsnew = mem_realloc(&es->alloc, es->ops, ops_size_new * sizeof(struct riff_editOp));
+		if(opsnew == NULL)
+			return RIFF_ERROR_MEMORY;
+		es->ops = opsnew;
+		es->ops_size = ops_size_new;
+	}
+
+	struct riff_editOp *o = es->ops + es->ops_len;
+	memset(o, 0, sizeof(struct riff_editOp));
+	o->pos = pos;
+	o->seq = es->ops_len;
+	o->op = op;
+	if(id != NULL)
+		memcpy(o->c_id, id, 4);
+	o->data = data;
+	o->size = size;
+	es->ops_len++;
+	return RIFF_ERROR_NONE;
+}
+
+
+
+//**** user access ****
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_editReplaceChunk(riff_handle *rh, const void *data, size_t size, riff_writer *fallback, int *path){
+	checkValidRiffHandle(rh);
+
+	int r = RIFF_ERROR_NONE;
+	int p = RIFF_EDIT_NONE;
+	if(path != NULL)
+		*path = RIFF_EDIT_NONE;
+
+	if(riff_chunkIsList(rh)){
+		if(rh->fp_printf)
+			rh->fp_printf("Can't replace chunk list \"%s\" with data\n", rh->c_id);
+		return RIFF_ERROR_ILLID;
+	}
+	if(size > 0xFFFFFFFF){
+		if(rh->fp_printf)
+			rh->fp_printf("Chunk data exceeds 4 GB\n");
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	if(rh->fp_write != NULL){
+		p = edit_inPlace(rh, data, size, &r);
+		if(p != RIFF_EDIT_NONE){
+			if(path != NULL)
+				*path = p;
+			if(r != RIFF_ERROR_NONE)
+				return r;
+			return riff_seekChunkStart(rh);
+		}
+	}
+
+	//no slack, rewrite
+	if(fallback == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("No space to replace chunk \"%s\" in place and no fallback writer given\n", rh->c_id);
+		riff_seekChunkStart(rh); //the JUNK lookups may have moved the position
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	//single operation, sorted already
+	struct riff_editOp op = {0};
+	riff_editScript es = {0};
+	op.pos = rh->c_pos_start;
+	op.op = RIFF_EDIT_OP_REPLACE;
+	op.data = data;
+	op.size = size;
+	es.ops = &op;
+	es.ops_len = 1;
+	if(path != NULL)
+		*path = RIFF_EDIT_REWRITE;
+	return edit_copy(rh, fallback, &es);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editCopyFile(riff_handle *rh, riff_writer *rw){
+	checkValidRiffHandle(rh);
+	return edit_copy(rh, rw, NULL);
+}
+
+/*****************************************************************************/
+//description: see header file
+riff_editScript *riff_editScriptAllocate(){
+	riff_editScript *es = mem_calloc(&alloc_global, 1, sizeof(riff_editScript));
+	if(es != NULL)
+		es->alloc = alloc_global;
+	return es;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_editScriptFree(riff_editScript *es){
+	if(es == NULL)
+		return;
+	riff_allocator alloc = es->alloc;
+	mem_free(&alloc, es->ops);
+	mem_free(&alloc, es);
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_editScriptClear(riff_editScript *es){
+	if(es != NULL)
+		es->ops_len = 0;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editScriptReplace(riff_editScript *es, size_t pos, const void *data, size_t size){
+	return edit_queue(es, RIFF_EDIT_OP_REPLACE, pos, NULL, data, size);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editScriptDelete(riff_editScript *es, size_t pos){
+	return edit_queue(es, RIFF_EDIT_OP_DELETE, pos, NULL, NULL, 0);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editScriptInsert(riff_editScript *es, size_t pos, const char *id, const void *data, size_t size){
+	if(id == NULL)
+		return RIFF_ERROR_ILLID;
+	return edit_queue(es, RIFF_EDIT_OP_INSERT, pos, id, data, size);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editScriptAppend(riff_editScript *es, size_t pos, const char *id, const void *data, size_t size){
+	if(id == NULL)
+		return RIFF_ERROR_ILLID;
+	return edit_queue(es, RIFF_EDIT_OP_APPEND, pos, id, data, size);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_editApply(riff_handle *rh, riff_editScript *es, riff_writer *rw){
+	checkValidRiffHandle(rh);
+	if(es == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+
+	//stable order: seq is unique
+	qsort(es->ops, es->ops_len, sizeof(struct riff_editOp), &compareOps);
+	return edit_copy(rh, rw, es);
+}
@@ -0,0 +1,272 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+To edit RIFF files in place.
+Works on an opened riff_handle, the source must be writable (riff_handle::fp_write set, e.g. a file opened with "r+b").
+
+
+Usage:
+Navigate to the chunk to edit with the usual riff_handle functions
+Call riff_editReplaceChunk() with the new chunk data
+  The chunk is overwritten in place if possible, size changes are absorbed by a neighbouring "JUNK"/"PAD " chunk
+  If the chunk is the last one of the file, the file grows and all parent chunk list sizes are fixed up
+  Otherwise the whole file is rewritten to a fallback riff_writer
+  In-place edits keep the big endian sizes of "RIFX" files, riff_writer output is always little endian
+
+To apply many edits at once:
+Allocate a riff_editScript with riff_editScriptAllocate()
+Queue operations with riff_editScriptReplace(), riff_editScriptDelete(), riff_editScriptInsert(), riff_editScriptAppend()
+  Chunks are addressed by their start position riff_handle::c_pos_start, e.g. collected while walking the file
+Call riff_editApply() to write the edited file to a riff_writer in one sequential pass
+  Unchanged chunk data is copied by the kernel if both files are FILE based and the OS supports it
+*/
+
+#ifndef _RIFF_EDIT_H_
+#define _RIFF_EDIT_H_
+
+#include "riff.h"
+#include "riff_writer.h"
+
+/**
+ * @defgroup Edit_paths Edit paths
+ *
+ * How riff_editReplaceChunk() applied an edit.
+ * @{
+ */
+/**
+ * @brief Nothing was written.
+ */
+#define RIFF_EDIT_NONE		0
+/**
+ * @brief The chunk was overwritten in place, its padded size did not change.
+ */
+#define RIFF_EDIT_INPLACE	1
+/**
+ * @brief The size change was absorbed by a neighbouring or newly created "JUNK"/"PAD " chunk.
+ */
+#define RIFF_EDIT_JUNK		2
+/**
+ * @brief The chunk is the last one of the file, the file was extended and all parent sizes were fixed up.
+ */
+#define RIFF_EDIT_RESIZE	3
+/**
+ * @brief No slack was available, the whole file was rewritten to the fallback riff_writer.
+ */
+#define RIFF_EDIT_REWRITE	4
+///@}
+
+/**
+ * @defgroup Edit_ops Edit script operations
+ *
+ * Operations of a riff_editScript.
+ * @{
+ */
+/**
+ * @brief Replace the data of the chunk, for chunk lists the data starts with the list type.
+ */
+#define RIFF_EDIT_OP_REPLACE	0
+/**
+ * @brief Delete the chunk or chunk list with all its subchunks.
+ */
+#define RIFF_EDIT_OP_DELETE	1
+/**
+ * @brief Insert a new chunk before the chunk.
+ */
+#define RIFF_EDIT_OP_INSERT	2
+/**
+ * @brief Append a new chunk at the end of the chunk list.
+ */
+#define RIFF_EDIT_OP_APPEND	3
+///@}
+
+/**
+ * @brief Edit script operation.
+ */
+struct riff_editOp {
+	/**
+	 * @brief Absolute position of the chunk (riff_handle::c_pos_start) the operation applies to.
+	 */
+	size_t pos;
+	/**
+	 * @brief Order in which the operation was queued.
+	 */
+	size_t seq;
+	/**
+	 * @brief The `RIFF_EDIT_OP_...` operation.
+	 */
+	int op;
+	/**
+	 * @brief ID of the new chunk for ::RIFF_EDIT_OP_INSERT and ::RIFF_EDIT_OP_APPEND.
+	 */
+	char c_id[5];
+	/**
+	 * @brief New chunk data, not copied, must be valid until the script is applied.
+	 */
+	const void *data;
+	/**
+	 * @brief New chunk data size.
+	 */
+	size_t size;
+};
+
+/**
+ * @brief Edit script, a queue of operations applied in one pass by riff_editApply().
+ *
+ * Members are public and intended for read access.
+ */
+typedef struct riff_editScript {
+	/**
+	 * @brief Queued operations, sorted by position when applied.
+	 */
+	struct riff_editOp *ops;
+	/**
+	 * @brief Amount of queued operations.
+	 */
+	size_t ops_len;
+	/**
+	 * @brief Amount of allocated operations.
+	 */
+	size_t ops_size;
+	/**
+	 * @brief Allocator, the global one when allocated.
+	 */
+	riff_allocator alloc;
+} riff_editScript;
+
+/**
+ * @defgroup RIFF_C_Edit C RIFF editing functions
+ * @{
+ */
+/**
+ * @brief Replace the data of the current chunk.
+ *
+ * Tries the cheapest way first:
+ * -# Same padded size: the chunk is overwritten in place
+ * -# Smaller by at least 8 bytes: the freed space becomes a new "JUNK" chunk
+ * -# Next chunk in the level is "JUNK" or "PAD ": it grows or shrinks to absorb the size change
+ * -# Previous chunk in the level is "JUNK" or "PAD ": the chunk moves to its start, the rest of the space (and of a following "JUNK" chunk) becomes "JUNK" behind it
+ * -# Last chunk of the file: the file grows, the sizes of all parent lists on the level stack and the RIFF header are fixed up
+ * -# Otherwise the file is rewritten with the new data to @p fallback, if given
+ *
+ * Freed space that exceeds a 32 bit chunk size (e.g. from a ds64 sized chunk) is split into several "JUNK" chunks.
+ * Finding the previous chunk reads the chunk headers of the level from its start.
+ *
+ * After an in-place edit the riff_handle is at the data start of the edited chunk, which may have moved.
+ * After a rewrite the riff_handle still refers to the unchanged original file.
+ *
+ * @param rh The riff_handle to use, positioned at the chunk to replace.
+ * @param data The new chunk data.
+ * @param size The new chunk data size.
+ * @param fallback Freshly opened riff_writer (RIFF header written, no chunks yet) for the rewrite, can be NULL. It is closed after the rewrite.
+ * @param path Receives the `RIFF_EDIT_...` path that was taken, can be NULL.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ICSIZE if no slack is available and there is no @p fallback.
+ */
+int riff_editReplaceChunk(riff_handle *rh, const void *data, size_t size, riff_writer *fallback, int *path);
+
+/**
+ * @brief Copy the whole RIFF file to a riff_writer.
+ *
+ * Walks the file and writes every chunk list and chunk to @p rw, chunk sizes are recomputed.
+ *
+ * @note File position is changed by this function.
+ *
+ * @param rh The riff_handle to copy from.
+ * @param rw Freshly opened riff_writer (RIFF header written, no chunks yet), closed afterwards.
+ *
+ * @return RIFF error code.
+ */
+int riff_editCopyFile(riff_handle *rh, riff_writer *rw);
+
+/**
+ * @brief Allocate, initialize and return an empty riff_editScript.
+ *
+ * @return Pointer to the allocated riff_editScript, NULL if allocation failed.
+ */
+riff_editScript *riff_editScriptAllocate();
+/**
+ * @brief Free the memory allocated to a riff_editScript, the chunk data of its operations is not freed.
+ *
+ * @param es The riff_editScript to free.
+ */
+void riff_editScriptFree(riff_editScript *es);
+/**
+ * @brief Remove all queued operations, the allocated memory is kept for reuse.
+ *
+ * @param es The riff_editScript to clear.
+ */
+void riff_editScriptClear(riff_editScript *es);
+/**
+ * @brief Queue replacing the data of a chunk.
+ *
+ * If a chunk is replaced more than once, the last queued replacement wins.
+ *
+ * @param es The riff_editScript to use.
+ * @param pos Start position of the chunk (riff_handle::c_pos_start).
+ * @param data The new chunk data, for chunk lists starting with the list type. Not copied, must stay valid until applied.
+ * @param size The new chunk data size.
+ *
+ * @return RIFF error code.
+ */
+int riff_editScriptReplace(riff_editScript *es, size_t pos, const void *data, size_t size);
+/**
+ * @brief Queue deleting a chunk or chunk list.
+ *
+ * Deleting takes precedence over replacing, operations inside of a deleted chunk list are dropped.
+ *
+ * @param es The riff_editScript to use.
+ * @param pos Start position of the chunk (riff_handle::c_pos_start).
+ *
+ * @return RIFF error code.
+ */
+int riff_editScriptDelete(riff_editScript *es, size_t pos);
+/**
+ * @brief Queue inserting a new chunk before a chunk.
+ *
+ * Chunks inserted at the same position are written in the order they were queued.
+ *
+ * @param es The riff_editScript to use.
+ * @param pos Start position of the chunk (riff_handle::c_pos_start) to insert before.
+ * @param id The ID of the new chunk (4 bytes).
+ * @param data The new chunk data. Not copied, must stay valid until applied.
+ * @param size The new chunk data size.
+ *
+ * @return RIFF error code.
+ */
+int riff_editScriptInsert(riff_editScript *es, size_t pos, const char *id, const void *data, size_t size);
+/**
+ * @brief Queue appending a new chunk at the end of a chunk list.
+ *
+ * @param es The riff_editScript to use.
+ * @param pos Start position of the chunk list (riff_handle::c_pos_start), riff_handle::pos_start for the RIFF chunk.
+ * @param id The ID of the new chunk (4 bytes).
+ * @param data The new chunk data. Not copied, must stay valid until applied.
+ * @param size The new chunk data size.
+ *
+ * @return RIFF error code.
+ */
+int riff_editScriptAppend(riff_editScript *es, size_t pos, const char *id, const void *data, size_t size);
+/**
+ * @brief Write the file with all queued operations applied to a riff_writer.
+ *
+ * The source is read once from start to end, the output is written sequentially.
+ * Sizes of all chunk lists and the RIFF chunk are recomputed.
+ * Operations at positions where no chunk starts are ignored.
+ *
+ * @note File position is changed by this function.
+ *
+ * @param rh The riff_handle to read from.
+ * @param es The riff_editScript to apply, its operations are sorted by position.
+ * @param rw Freshly opened riff_writer (RIFF header written, no chunks yet), closed afterwards.
+ *
+ * @return RIFF error code.
+ */
+int riff_editApply(riff_handle *rh, riff_editScript *es, riff_writer *rw);
+
+///@}
+
+#endif // _RIFF_EDIT_H_
@@ -0,0 +1,203 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Internal helpers shared between the libriff translation units.
+Not part of the public API, do not include from user code.
+*/
+
+#ifndef _RIFF_INTERNAL_H_
+#define _RIFF_INTERNAL_H_
+
+#include <string.h>
+
+#include "riff.h"
+
+//default print function, maps to vfprintf(stderr, ...)
+int riff_printf(const char *format, ... );
+
+//default FILE and memory read functions, to recognize FILE and memory based handles
+size_t read_file(riff_handle *rh, void *ptr, size_t size);
+size_t read_mem(riff_handle *rh, void *ptr, size_t size);
+
+//read at absolute position outside of the level structure, not beyond the file size if known, see riff.c
+size_t riff_readAt(riff_handle *rh, size_t pos, void *ptr, size_t size);
+
+//bytes of [pos, pos + size) available in the file, all of them if the file size is unknown
+static inline size_t riff_availAt(const riff_handle *rh, size_t pos, size_t size){
+	if(rh->size == 0  ||  (pos <= rh->size  &&  size <= rh->size - pos))
+		return size;
+	return (pos < rh->size) ? rh->size - pos : 0;
+}
+
+//read start of current chunk data, handle is at its start, the rest of buf is zeroed
+static inline void riff_readChunkStart(riff_handle *rh, void *buf, size_t size){
+	memset(buf, 0, size);
+	riff_readInChunk(rh, buf, size);
+}
+
+//copy from descriptor position to descriptor in the kernel, see riff_copy.c
+//written at *pos_out which is advanced, at the current offset if pos_out is NULL
+//returns number of copied bytes, 0 where not supported
+size_t copy_kernel(int fd_in, size_t pos, int fd_out, size_t *pos_out, size_t size);
+
+//64 bit size of chunk with size field 0xFFFFFFFF from the ds64 chunk, 0xFFFFFFFF if not listed, see riff.c
+uint64_t ds64Size(const riff_handle *rh, const char *id);
+
+//read chunk header of little endian files ("RIFF", "RF64", "BW64"), see riff.c
+int readChunkHeaderLE(riff_handle *rh);
+
+//read header of the chunk at the current position
+//in the byte order of the file, picked once by riff_readHeader(), see riff.c
+//little endian files call their reader directly, only RIFX goes through the pointer
+static inline int riff_readChunkHeader(riff_handle *rh){
+	if(rh->fp_readChunkHeader == &readChunkHeaderLE)
+		return readChunkHeaderLE(rh);
+	return rh->fp_readChunkHeader(rh);
+}
+
+//global allocator, set by riff_setAllocator(), see riff.c
+extern riff_allocator alloc_global;
+
+//allocate via allocator, see riff_allocator
+static inline void *mem_alloc(const riff_allocator *a, size_t size){
+	return a->fp_malloc(a->user, size);
+}
+
+//resize via allocator, allocates if p is NULL
+static inline void *mem_realloc(const riff_allocator *a, void *p, size_t size){
+	if(p == NULL)
+		return a->fp_malloc(a->user, size);
+	return a->fp_realloc(a->user, p, size);
+}
+
+//free via allocator, p may be NULL
+static inline void mem_free(const riff_allocator *a, void *p){
+	if(p != NULL)
+		a->fp_free(a->user, p);
+}
+
+//allocate n zeroed elements via allocator, NULL on overflow, see riff.c
+void *mem_calloc(const riff_allocator *a, size_t n, size_t size);
+
+//push current chunk as list of the given type to the level stack, see riff.c
+int stack_push(riff_handle *rh, const char *type);
+
+//pass pointer to 32 bit LE value and convert, return in native byte order
+uint32_t convUInt32LE(const void *p);
+
+//pass pointer to 16 bit LE value and convert, return in native byte order
+static inline uint16_t convUInt16LE(const void *p){
+	const uint8_t *c = (const uint8_t *)p;
+	return (uint16_t)(c[0] | (c[1] << 8));
+}
+
+//pass pointer to 64 bit LE value and convert, return in native byte order
+static inline uint64_t convUInt64LE(const void *p){
+	return ((uint64_t)convUInt32LE((const uint8_t *)p + 4) << 32) | convUInt32LE(p);
+}
+
+//pass pointer to 32 bit BE value and convert, return in native byte order
+static inline uint32_t convUInt32BE(const void *p){
+	const uint8_t *c = (const uint8_t *)p;
+	return ((uint32_t)c[0] << 24) | ((uint32_t)c[1] << 16) | ((uint32_t)c[2] << 8) | c[3];
+}
+
+//write native value as 32 bit LE
+static inline void writeUInt32LE(void *p, uint32_t v){
+	uint8_t *c = (uint8_t *)p;
+	c[0] = v;  c[1] = v >> 8;  c[2] = v >> 16;  c[3] = v >> 24;
+}
+
+//write native value as 32 bit BE
+static inline void writeUInt32BE(void *p, uint32_t v){
+	uint8_t *c = (uint8_t *)p;
+	c[0] = v >> 24;  c[1] = v >> 16;  c[2] = v >> 8;  c[3] = v;
+}
+
+//write native value as 64 bit LE
+static inline void writeUInt64LE(void *p, uint64_t v){
+	writeUInt32LE(p, (uint32_t)v);
+	writeUInt32LE((uint8_t *)p + 4, (uint32_t)(v >> 32));
+}
+
+//check if the sizes of the opened file are big endian ("RIFX")
+//for rarely used paths, chunk headers are read via riff_handle::fp_readChunkHeader
+static inline int isBigEndian(const riff_handle *rh){
+	return memcmp(rh->h_id, "RIFX", 4) == 0;
+}
+
+//check if ID (or type) contains only printable ASCII chars
+static inline int isValidID(const char *id){
+	int i;
+	for(i = 0; i < 4; i++) {
+		if(id[i] < 0x20  ||  id[i] > 0x7e)
+			return 0;
+	}
+	return 1;
+}
+
+
+//** writer internals, see riff_writer.c **
+
+struct riff_writer;
+
+//default FILE write function, to recognize FILE based writers
+size_t write_file(struct riff_writer *rw, const void *ptr, size_t size);
+
+//write buffered data to output
+int writer_flush(struct riff_writer *rw);
+
+//begin chunk (type NULL) or chunk list with any ID inside of the innermost open chunk list
+//size is written with the header, RIFF_WRITER_SIZE_UNKNOWN for a placeholder
+int writer_begin(struct riff_writer *rw, const char *id, const char *type, size_t size);
+
+struct riff_wav;
+
+//put handle on the "data" chunk if it's not there, see riff_wav.c
+int wav_toData(riff_handle *rh, const struct riff_wav *wav);
+
+//** PCM internals, see riff_pcm.c **
+
+//source sample types of the conversion kernels
+enum { PCM_U8, PCM_S16, PCM_S24, PCM_S32, PCM_F32, PCM_F64, PCM_TYPES };
+
+//convert n interleaved samples of a source type to a RIFF_WAV_SAMPLE_... type
+typedef void (*pcm_kernel)(const uint8_t *src, void *dst, size_t n);
+
+//kernel of implementation "scalar", "sse2", "avx2" or "neon", NULL if it has no own kernel or the CPU lacks it
+//impl NULL gives the kernel riff_wavConvert() picked for this CPU
+pcm_kernel pcm_kernelOf(const char *impl, int type, int sample);
+
+struct riff_avi;
+
+//stream number of frame chunk ID "##xx", -1 if none
+int avi_streamOf(const struct riff_avi *avi, const char *id);
+
+//position in the chunks of the "movi" lists, all zero before the first one
+struct avi_moviCursor {
+	size_t k;       //next "movi" list
+	size_t pos;     //header of the next chunk
+	size_t end;     //end of the current "movi" list
+};
+
+//move on to the next "movi" list if the current one has no further chunk header, see riff_avi.c
+//returns 0 after the last list
+int avi_moviNext(const struct riff_avi *avi, struct avi_moviCursor *mc);
+
+//advance past the chunk whose header h was read at mc->pos
+//returns 1 for a chunk list ("rec "), its chunks come next, there is no frame data
+int avi_moviSkip(struct avi_moviCursor *mc, const uint8_t *h);
+
+//lock with one condition variable, platform specific, see riff_mpwriter.c
+void *sync_allocate(const riff_allocator *a);
+void sync_free(const riff_allocator *a, void *s);
+void sync_lock(void *s);
+void sync_unlock(void *s);
+void sync_wait(void *s);
+void sync_broadcast(void *s);
+
+#endif // _RIFF_INTERNAL_H_
@@ -0,0 +1,435 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => riff_metaOpen() only uses riff_handle functions, values are read with riff_readAt() outside of the level structure,
+//      the user functions seek back to the position of the handle afterwards
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_meta.h"
+#include "riff_internal.h"
+
+
+#define RIFF_META_TAGS_ALLOC 32   //number of tags allocated per step at least
+#define RIFF_META_KEYS_ALLOC 32   //number of interned keys allocated per step at least
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+//"bext" fields, offset and size in the chunk data
+struct metaField {
+	const char *key;
+	size_t off;
+	size_t size;
+	int format;
+};
+
+static const struct metaField meta_bext[] = {
+	{"Description",            0, 256, RIFF_META_TEXT},
+	{"Originator",           256,  32, RIFF_META_TEXT},
+	{"OriginatorReference",  288,  32, RIFF_META_TEXT},
+	{"OriginationDate",      320,  10, RIFF_META_TEXT},
+	{"OriginationTime",      330,   8, RIFF_META_TEXT},
+	{"TimeReference",        338,   8, RIFF_META_UINT},
+	{"Version",              346,   2, RIFF_META_UINT},
+	{"LoudnessValue",        412,   2, RIFF_META_INT},
+	{"LoudnessRange",        414,   2, RIFF_META_INT},
+	{"MaxTruePeakLevel",     416,   2, RIFF_META_INT},
+	{"MaxMomentaryLoudness", 418,   2, RIFF_META_INT},
+	{"MaxShortTermLoudness", 420,   2, RIFF_META_INT},
+};
+#define META_BEXT_FIELDS (sizeof(meta_bext) / sizeof(meta_bext[0]))
+#define META_BEXT_HISTORY 602   //offset of "CodingHistory", up to the end of the chunk
+
+//states of riff_metaTag::value besides decoded values
+static const char meta_pending[1] = "";  //queued by riff_metaFetch()
+static const char meta_failed[1] = "";   //read error, not retried
+
+
+//memory block of an arena, data follows
+struct metaBlock {
+	struct metaBlock *next;
+	size_t size;
+	size_t used;
+};
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//allocate from the first block with enough room, a new block if there is none
+char *meta_alloc(const riff_allocator *a, void **arena, size_t size){
+	struct metaBlock *b;
+	for(b = (struct metaBlock *)*arena; b != NULL; b = b->next){
+		if(b->size - b->used >= size)
+			break;
+	}
+	if(b == NULL){
+		size_t bsize = (size > RIFF_META_ARENA_BLOCK) ? size : RIFF_META_ARENA_BLOCK;
+		b = mem_alloc(a, sizeof(struct metaBlock) + bsize);
+		if(b == NULL)
+			return NULL;
+		b->size = bsize;
+		b->used = 0;
+		b->next = (struct metaBlock *)*arena;
+		*arena = b;
+	}
+	char *p = (char *)(b + 1) + b->used;
+	b->used += size;
+	return p;
+}
+
+
+/*****************************************************************************/
+//mark all blocks as empty, memory is kept
+void meta_reset(void *arena){
+	struct metaBlock *b;
+	for(b = (struct metaBlock *)arena; b != NULL; b = b->next)
+		b->used = 0;
+}
+
+
+/*****************************************************************************/
+//free all blocks
+void meta_free(const riff_allocator *a, void *arena){
+	struct metaBlock *b = (struct metaBlock *)arena;
+	while(b != NULL){
+		struct metaBlock *next = b->next;
+		mem_free(a, b);
+		b = next;
+	}
+}
+
+
+/*****************************************************************************/
+//find interned key, by pointer first, NULL if not interned
+const char *meta_find(const riff_meta *meta, const char *key){
+	size_t i;
+	for(i = 0; i < meta->keys_len; i++){
+		if(meta->keys[i] == key)
+			return key;
+	}
+	for(i = 0; i < meta->keys_len; i++){
+		if(strcmp(meta->keys[i], key) == 0)
+			return meta->keys[i];
+	}
+	return NULL;
+}
+
+
+/*****************************************************************************/
+//first tag of interned key, NULL if none
+struct riff_metaTag *meta_tag(riff_meta *meta, const char *key){
+	if(key == NULL)
+		return NULL;
+	size_t i;
+	for(i = 0; i < meta->tags_len; i++){
+		if(meta->tags[i].key == key)
+			return meta->tags + i;
+	}
+	return NULL;
+}
+
+
+/*****************************************************************************/
+//record tag, value is not read
+int meta_add(riff_meta *meta, const char *key, const char *c_id, size_t pos, size_t size, int format){
+	const char *k = riff_metaKey(meta, key);
+	if(k == NULL)
+		return RIFF_ERROR_MEMORY;
+	if(meta->tags_len == meta->tags_size){
+		size_t tags_size = meta->tags_size * 2;
+		if(tags_size < RIFF_META_TAGS_ALLOC)
+			tags_size = RIFF_META_TAGS_ALLOC;
+		struct riff_metaTag *tagsnew = mem_realloc(&meta->alloc, meta->tags, tags_size * sizeof(struct riff_metaTag));
+		if(tagsnew == NULL)
+			return RIFF_ERROR_MEMORY;
+		meta->tags = tagsnew;
+		meta->tags_size = tags_size;
+	}
+	struct riff_metaTag *t = meta->tags + meta->tags_len++;
+	t->key = k;
+	memcpy(t->c_id, c_id, 4);
+	t->c_id[4] = '\0';
+	t->pos = pos;
+	t->size = size;
+	t->format = format;
+	t->value = NULL;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//record the tags of the current "LIST INFO" chunk, the handle is left in its sub level
+int meta_scanInfo(riff_handle *rh, riff_meta *meta){
+	int r = riff_seekLevelSub(rh);
+	while(r == RIFF_ERROR_NONE){
+		if((r = meta_add(meta, rh->c_id, rh->c_id, rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET, rh->c_size, RIFF_META_TEXT)) != RIFF_ERROR_NONE)
+			return r;
+		r = riff_seekNextChunk(rh);
+	}
+	return (r == RIFF_ERROR_EOCL) ? RIFF_ERROR_NONE : r;
+}
+
+
+/*****************************************************************************/
+//record the fields of the current "bext" chunk
+int meta_scanBext(riff_handle *rh, riff_meta *meta){
+	size_t data = rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET;
+	int r;
+	size_t i;
+	for(i = 0; i < META_BEXT_FIELDS; i++){
+		const struct metaField *f = meta_bext + i;
+		if(f->off + f->size > rh->c_size)
+			break;
+		if((r = meta_add(meta, f->key, rh->c_id, data + f->off, f->size, f->format)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	if(rh->c_size > META_BEXT_HISTORY)
+		return meta_add(meta, "CodingHistory", rh->c_id, data + META_BEXT_HISTORY, rh->c_size - META_BEXT_HISTORY, RIFF_META_TEXT);
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//record the tags of the top level, values of earlier files stay in the arena
+int meta_scan(riff_handle *rh, riff_meta *meta){
+	meta->tags_len = 0;
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	int r = riff_seekLevelStart(rh);
+	while(r == RIFF_ERROR_NONE){
+		if(memcmp(rh->c_id, "LIST", 4) == 0){
+			//only the list type is read of other lists, empty lists are skipped
+			char type[4];
+			if(rh->c_size >= 4 + RIFF_CHUNK_DATA_OFFSET  &&  riff_readInChunk(rh, type, 4) == 4  &&  memcmp(type, "INFO", 4) == 0){
+				r = meta_scanInfo(rh, meta);
+				if(rh->ls_level > 0)
+					riff_levelParent(rh);
+				if(r != RIFF_ERROR_NONE)
+					break;
+			}
+		}
+		else if(memcmp(rh->c_id, "bext", 4) == 0){
+			if((r = meta_scanBext(rh, meta)) != RIFF_ERROR_NONE)
+				break;
+		}
+		r = riff_seekNextChunk(rh);
+	}
+
+	int rr = riff_rewind(rh);
+	if(r == RIFF_ERROR_EOCL)
+		return rr;
+	return r;
+}
+
+
+/*****************************************************************************/
+//read and decode value into the arena, sets riff_metaTag::value
+void meta_decode(riff_handle *rh, riff_meta *meta, struct riff_metaTag *t){
+	if(t->format == RIFF_META_TEXT){
+		//text cut off by the end of the file is missing
+		size_t size = riff_availAt(rh, t->pos, t->size);
+		char *v = meta_alloc(&meta->alloc, &meta->arena, size + 1);
+		if(v == NULL  ||  riff_readAt(rh, t->pos, v, size) != size){
+			t->value = meta_failed;
+			return;
+		}
+		v[size] = '\0';
+		t->value = v;
+		return;
+	}
+
+	uint8_t buf[8] = {0};
+	char num[24];
+	if(t->size > 8  ||  riff_readAt(rh, t->pos, buf, t->size) != t->size){
+		t->value = meta_failed;
+		return;
+	}
+	uint64_t u = convUInt64LE(buf);
+	if(t->format == RIFF_META_INT  &&  t->size < 8  &&  (u >> (t->size * 8 - 1)) & 0x1)
+		u |= ~(uint64_t)0 << (t->size * 8); //sign extension
+	if(t->format == RIFF_META_INT)
+		snprintf(num, sizeof(num), "%lld", (long long)u);
+	else
+		snprintf(num, sizeof(num), "%llu", (unsigned long long)u);
+	char *v = meta_alloc(&meta->alloc, &meta->arena, strlen(num) + 1);
+	if(v == NULL){
+		t->value = meta_failed;
+		return;
+	}
+	strcpy(v, num);
+	t->value = v;
+}
+
+
+/*****************************************************************************/
+//value of tag, decoded if not yet
+const char *meta_value(riff_handle *rh, riff_meta *meta, struct riff_metaTag *t){
+	if(t->value == NULL  ||  t->value == meta_pending)
+		meta_decode(rh, meta, t);
+	return (t->value == meta_failed) ? NULL : t->value;
+}
+
+
+/*****************************************************************************/
+//decode values of the keys in file order
+size_t meta_fetch(riff_handle *rh, riff_meta *meta, const char * const *keys, size_t count, const char **values){
+	size_t i, k, found = 0;
+	int read = 0;
+	//tags are in file order, mark the ones to read
+	for(k = 0; k < count; k++){
+		struct riff_metaTag *t = meta_tag(meta, meta_find(meta, keys[k]));
+		if(t != NULL  &&  t->value == NULL){
+			t->value = meta_pending;
+			read = 1;
+		}
+	}
+	if(read){
+		for(i = 0; i < meta->tags_len; i++){
+			if(meta->tags[i].value == meta_pending)
+				meta_decode(rh, meta, meta->tags + i);
+		}
+	}
+	for(k = 0; k < count; k++){
+		struct riff_metaTag *t = meta_tag(meta, meta_find(meta, keys[k]));
+		values[k] = (t != NULL  &&  t->value != meta_failed) ? t->value : NULL;
+		if(values[k] != NULL)
+			found++;
+	}
+	return found;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_metaOpen(riff_handle *rh, riff_meta *meta){
+	checkValidRiffHandle(rh);
+	if(meta == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	if(meta->alloc.fp_malloc == NULL)
+		meta->alloc = rh->alloc;
+	meta_reset(meta->arena);
+	return meta_scan(rh, meta);
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_metaClose(riff_meta *meta){
+	if(meta == NULL)
+		return;
+	mem_free(&meta->alloc, meta->tags);
+	mem_free(&meta->alloc, (void *)meta->keys);
+	meta_free(&meta->alloc, meta->arena);
+	meta_free(&meta->alloc, meta->key_arena);
+	memset(meta, 0, sizeof(riff_meta));
+}
+
+/*****************************************************************************/
+//description: see header file
+const char *riff_metaKey(riff_meta *meta, const char *key){
+	if(meta == NULL  ||  key == NULL)
+		return NULL;
+	const char *k = meta_find(meta, key);
+	if(k != NULL)
+		return k;
+	if(meta->alloc.fp_malloc == NULL)
+		meta->alloc = alloc_global;
+
+	if(meta->keys_len == meta->keys_size){
+		size_t keys_size = meta->keys_size * 2;
+		if(keys_size < RIFF_META_KEYS_ALLOC)
+			keys_size = RIFF_META_KEYS_ALLOC;
+		const char **keysnew = mem_realloc(&meta->alloc, (void *)meta->keys, keys_size * sizeof(const char *));
+		if(keysnew == NULL)
+			return NULL;
+		meta->keys = keysnew;
+		meta->keys_size = keys_size;
+	}
+	size_t len = strlen(key);
+	char *kn = meta_alloc(&meta->alloc, &meta->key_arena, len + 1);
+	if(kn == NULL)
+		return NULL;
+	memcpy(kn, key, len + 1);
+	meta->keys[meta->keys_len++] = kn;
+	return kn;
+}
+
+/*****************************************************************************/
+//description: see header file
+const char *riff_metaGet(riff_handle *rh, riff_meta *meta, const char *key){
+	if(rh == NULL  ||  meta == NULL  ||  key == NULL)
+		return NULL;
+	struct riff_metaTag *t = meta_tag(meta, meta_find(meta, key));
+	if(t == NULL)
+		return NULL;
+	if(t->value != NULL  &&  t->value != meta_pending)
+		return (t->value == meta_failed) ? NULL : t->value;
+	size_t pos = rh->pos;
+	const char *v = meta_value(rh, meta, t);
+	rh->pos = pos;
+	rh->fp_seek(rh, pos);
+	return v;
+}
+
+/*****************************************************************************/
+//description: see header file
+const char *riff_metaValue(riff_handle *rh, riff_meta *meta, size_t i){
+	if(rh == NULL  ||  meta == NULL  ||  i >= meta->tags_len)
+		return NULL;
+	struct riff_metaTag *t = meta->tags + i;
+	if(t->value != NULL  &&  t->value != meta_pending)
+		return (t->value == meta_failed) ? NULL : t->value;
+	size_t pos = rh->pos;
+	const char *v = meta_value(rh, meta, t);
+	rh->pos = pos;
+	rh->fp_seek(rh, pos);
+	return v;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_metaFetch(riff_handle *rh, riff_meta *meta, const char * const *keys, size_t count, const char **values){
+	if(rh == NULL  ||  meta == NULL  ||  values == NULL)
+		return 0;
+	size_t pos = rh->pos;
+	size_t found = meta_fetch(rh, meta, keys, count, values);
+	rh->pos = pos;
+	rh->fp_seek(rh, pos);
+	return found;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_metaBatch(riff_handle *rh, riff_meta *meta, size_t files, int (*fp_open)(riff_handle *rh, size_t i, void *user), void *user,
+	const char * const *keys, size_t count, const char **values){
+	if(rh == NULL  ||  meta == NULL  ||  fp_open == NULL  ||  values == NULL)
+		return 0;
+	if(meta->alloc.fp_malloc == NULL)
+		meta->alloc = rh->alloc;
+	meta_reset(meta->arena);
+	size_t i, k, found = 0;
+	for(i = 0; i < files; i++){
+		const char **v = values + i * count;
+		if(fp_open(rh, i, user) >= RIFF_ERROR_CRITICAL){
+			for(k = 0; k < count; k++)
+				v[k] = NULL;
+			continue;
+		}
+		//tags found before a scan error are still fetched
+		meta_scan(rh, meta);
+		found += riff_metaFetch(rh, meta, keys, count, v);
+	}
+	meta->tags_len = 0;
+	return found;
+}
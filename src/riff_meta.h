@@ -0,0 +1,223 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Metadata of RIFF files: the tags of "LIST INFO" chunks (e.g. "INAM", "IART", "ICMT") and the fields of the BWF "bext" chunk.
+Opening only reads chunk headers of the top level and of "INFO" lists and records where each value is, no value is read.
+A value is read and decoded on first access into the memory arena of the riff_meta, later accesses return the same string.
+Keys are interned, tags refer to the one copy of their key, lookups by an interned key compare pointers only.
+
+Keys:
+  "LIST INFO" tags by their chunk ID, e.g. "INAM"
+  "bext" fields by their name in the BWF specification:
+    "Description", "Originator", "OriginatorReference", "OriginationDate", "OriginationTime", "CodingHistory" as text
+    "TimeReference", "Version" and the loudness fields "LoudnessValue", "LoudnessRange", "MaxTruePeakLevel",
+    "MaxMomentaryLoudness", "MaxShortTermLoudness" as decimal numbers (loudness in 1/100 units as stored)
+
+
+Usage:
+Zero initialize a riff_meta, e.g. `riff_meta meta = {0};`
+Open the file with the usual riff_handle functions and call riff_metaOpen()
+Call riff_metaGet() for single values or riff_metaFetch() for several values in file order
+  Values stay valid until the next riff_metaOpen() or riff_metaClose()
+Reuse the riff_meta for the next file, its memory is kept, or call riff_metaBatch() to fetch values of many files at once
+Call riff_metaClose() to free it
+*/
+
+#ifndef _RIFF_META_H_
+#define _RIFF_META_H_
+
+#include "riff.h"
+
+/**
+ * @brief Size of the memory blocks of the value and key arenas, larger values get a block of their own.
+ */
+#define RIFF_META_ARENA_BLOCK	4096
+
+/**
+ * @defgroup Meta_formats Value formats
+ * @{
+ */
+/**
+ * @brief Text, cut off at the first null byte.
+ */
+#define RIFF_META_TEXT		0
+/**
+ * @brief Little endian unsigned integer of the value size, decoded as decimal number.
+ */
+#define RIFF_META_UINT		1
+/**
+ * @brief Little endian signed integer of the value size, decoded as decimal number.
+ */
+#define RIFF_META_INT		2
+///@}
+
+/**
+ * @brief Tag, location of one value in the file.
+ */
+struct riff_metaTag {
+	/**
+	 * @brief Interned key.
+	 */
+	const char *key;
+	/**
+	 * @brief ID of the chunk containing the value, e.g. "INAM" or "bext".
+	 */
+	char c_id[5];
+	/**
+	 * @brief Absolute position of the value in file stream.
+	 */
+	size_t pos;
+	/**
+	 * @brief Size of the value in the file.
+	 */
+	size_t size;
+	/**
+	 * @brief Value format, see @ref Meta_formats.
+	 */
+	int format;
+	/**
+	 * @brief Decoded value in the arena, NULL until first accessed.
+	 */
+	const char *value;
+};
+
+/**
+ * @brief Tags of an opened file, interned keys and decoded values.
+ *
+ * Must be zero initialized before its first use.
+ */
+typedef struct riff_meta {
+	/**
+	 * @brief Tags in file order.
+	 */
+	struct riff_metaTag *tags;
+	/**
+	 * @brief Amount of tags.
+	 */
+	size_t tags_len;
+	/**
+	 * @brief Amount of allocated tags.
+	 */
+	size_t tags_size;
+
+	/**
+	 * @brief Interned keys, kept across files.
+	 */
+	const char **keys;
+	/**
+	 * @brief Amount of interned keys.
+	 */
+	size_t keys_len;
+	/**
+	 * @brief Amount of allocated keys.
+	 */
+	size_t keys_size;
+
+	/**
+	 * @brief Memory blocks of the decoded values, reused for the next file.
+	 */
+	void *arena;
+	/**
+	 * @brief Memory blocks of the interned keys.
+	 */
+	void *key_arena;
+
+	/**
+	 * @brief Allocator, the one of the riff_handle of the first riff_metaOpen() or riff_metaBatch(), the global one if riff_metaKey() came first.
+	 */
+	riff_allocator alloc;
+} riff_meta;
+
+/**
+ * @defgroup RIFF_C_Meta C metadata functions
+ * @{
+ */
+/**
+ * @brief Record the tags of the "LIST INFO" and "bext" chunks of the top level, without reading values.
+ *
+ * Values of the previous file are dropped, their memory is reused.
+ * Afterwards the riff_handle is at the first chunk of level 0.
+ *
+ * @param rh The riff_handle to use, opened file.
+ * @param meta The riff_meta to fill, zero initialized or used before.
+ *
+ * @return RIFF error code, tags found before an error are kept.
+ */
+int riff_metaOpen(riff_handle *rh, riff_meta *meta);
+/**
+ * @brief Free the tags, keys and values of a riff_meta.
+ *
+ * @param meta The riff_meta to free, zero initialized afterwards.
+ */
+void riff_metaClose(riff_meta *meta);
+/**
+ * @brief Intern a key.
+ *
+ * @param meta The riff_meta to use.
+ * @param key The key.
+ *
+ * @return The interned key, valid until riff_metaClose(). NULL if allocation failed.
+ */
+const char *riff_metaKey(riff_meta *meta, const char *key);
+/**
+ * @brief Get a value, read and decoded on first access.
+ *
+ * The position of the riff_handle is not changed.
+ *
+ * @param rh The riff_handle of the file.
+ * @param meta The riff_meta filled by riff_metaOpen().
+ * @param key The key, compared by pointer if interned with riff_metaKey().
+ *
+ * @return The value, NULL if there is no such tag or it could not be read. The first tag wins for repeated keys.
+ */
+const char *riff_metaGet(riff_handle *rh, riff_meta *meta, const char *key);
+/**
+ * @brief Get the value of a tag, read and decoded on first access.
+ *
+ * @param rh The riff_handle of the file.
+ * @param meta The riff_meta filled by riff_metaOpen().
+ * @param i Tag number.
+ *
+ * @return The value, NULL if the tag does not exist or could not be read.
+ */
+const char *riff_metaValue(riff_handle *rh, riff_meta *meta, size_t i);
+/**
+ * @brief Get several values, those not decoded yet are read in file order.
+ *
+ * @param rh The riff_handle of the file.
+ * @param meta The riff_meta filled by riff_metaOpen().
+ * @param keys The keys.
+ * @param count Amount of keys.
+ * @param values Receives `count` values, NULL for missing tags.
+ *
+ * @return Amount of values found.
+ */
+size_t riff_metaFetch(riff_handle *rh, riff_meta *meta, const char * const *keys, size_t count, const char **values);
+/**
+ * @brief Get several values of many files, one after another through the same riff_handle.
+ *
+ * Only headers and the chosen values are read, values of all files stay valid until the next riff_metaOpen() or riff_metaClose().
+ * Afterwards the riff_meta has no tags.
+ *
+ * @param rh The riff_handle to open the files with.
+ * @param meta The riff_meta to use, zero initialized or used before.
+ * @param files Amount of files.
+ * @param fp_open Opens file `i` with rh, e.g. with riff_open_file(), and closes the previous one. Returns RIFF error code.
+ *   Files with a critical error (::RIFF_ERROR_CRITICAL or above) get NULL values.
+ * @param user Passed to fp_open.
+ * @param keys The keys.
+ * @param count Amount of keys.
+ * @param values Receives `files * count` values, those of file `i` start at `values[i * count]`.
+ *
+ * @return Amount of values found.
+ */
+size_t riff_metaBatch(riff_handle *rh, riff_meta *meta, size_t files, int (*fp_open)(riff_handle *rh, size_t i, void *user), void *user,
+	const char * const *keys, size_t count, const char **values);
+
+///@}
+
+#endif // _RIFF_META_H_
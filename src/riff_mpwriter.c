@@ -0,0 +1,433 @@
+// take care: the riff_writer is not touched between riff_mpWriterBegin() and riff_mpWriterEnd()
+//   => producers write with mw->fp_pwrite() at positions assigned under the lock, nothing shares a stream position
+//   => everything in the riff_mpWriter except slot data of reserved slots is guarded by the lock
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#include "riff_mpwriter.h"
+#include "riff_internal.h"
+
+
+#define RIFF_MPWRITER_IDX_ALLOC 1024  //number of index entries allocated per step
+
+#define checkValidMPWriter(mw) if (mw == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+//*** platform specific ***
+
+
+#if defined(_WIN32)
+
+struct mpSync {
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE cond;
+};
+
+void *sync_allocate(const riff_allocator *a){
+	struct mpSync *s = mem_alloc(a, sizeof(struct mpSync));
+	if(s == NULL)
+		return NULL;
+	InitializeCriticalSection(&s->lock);
+	InitializeConditionVariable(&s->cond);
+	return s;
+}
+void sync_free(const riff_allocator *a, void *s){
+	if(s == NULL)
+		return;
+	DeleteCriticalSection(&((struct mpSync *)s)->lock);
+	mem_free(a, s);
+}
+void sync_lock(void *s){ EnterCriticalSection(&((struct mpSync *)s)->lock); }
+void sync_unlock(void *s){ LeaveCriticalSection(&((struct mpSync *)s)->lock); }
+void sync_wait(void *s){ SleepConditionVariableCS(&((struct mpSync *)s)->cond, &((struct mpSync *)s)->lock, INFINITE); }
+void sync_broadcast(void *s){ WakeAllConditionVariable(&((struct mpSync *)s)->cond); }
+
+/*****************************************************************************/
+//positional write to the FILE of the riff_writer
+size_t pwrite_file(riff_mpWriter *mw, const void *ptr, size_t size, size_t pos){
+	HANDLE h = (HANDLE)_get_osfhandle(_fileno((FILE*)(mw->rw->fh)));
+	size_t done = 0;
+	while(done < size){
+		OVERLAPPED ov = {0};
+		uint64_t at = pos + done;
+		ov.Offset = (DWORD)at;
+		ov.OffsetHigh = (DWORD)(at >> 32);
+		DWORD block = (size - done > 0x40000000) ? 0x40000000 : (DWORD)(size - done);
+		DWORD n = 0;
+		if(!WriteFile(h, (const uint8_t *)ptr + done, block, &n, &ov)  ||  n == 0)
+			break;
+		done += n;
+	}
+	return done;
+}
+
+#else
+
+struct mpSync {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+void *sync_allocate(const riff_allocator *a){
+	struct mpSync *s = mem_alloc(a, sizeof(struct mpSync));
+	if(s == NULL)
+		return NULL;
+	if(pthread_mutex_init(&s->lock, NULL) != 0){
+		mem_free(a, s);
+		return NULL;
+	}
+	if(pthread_cond_init(&s->cond, NULL) != 0){
+		pthread_mutex_destroy(&s->lock);
+		mem_free(a, s);
+		return NULL;
+	}
+	return s;
+}
+void sync_free(const riff_allocator *a, void *s){
+	if(s == NULL)
+		return;
+	pthread_cond_destroy(&((struct mpSync *)s)->cond);
+	pthread_mutex_destroy(&((struct mpSync *)s)->lock);
+	mem_free(a, s);
+}
+void sync_lock(void *s){ pthread_mutex_lock(&((struct mpSync *)s)->lock); }
+void sync_unlock(void *s){ pthread_mutex_unlock(&((struct mpSync *)s)->lock); }
+void sync_wait(void *s){ pthread_cond_wait(&((struct mpSync *)s)->cond, &((struct mpSync *)s)->lock); }
+void sync_broadcast(void *s){ pthread_cond_broadcast(&((struct mpSync *)s)->cond); }
+
+/*****************************************************************************/
+//positional write to the FILE of the riff_writer
+size_t pwrite_file(riff_mpWriter *mw, const void *ptr, size_t size, size_t pos){
+	int fd = fileno((FILE*)(mw->rw->fh));
+	size_t done = 0;
+	while(done < size){
+		ssize_t n = pwrite(fd, (const uint8_t *)ptr + done, size - done, pos + done);
+		if(n <= 0)
+			break;
+		done += n;
+	}
+	return done;
+}
+
+#endif
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//record first error and wake up blocked producers, lock must be held
+void mp_fail(riff_mpWriter *mw, int r){
+	if(mw->r == RIFF_ERROR_NONE)
+		mw->r = r;
+	sync_broadcast(mw->sync);
+}
+
+
+/*****************************************************************************/
+//positional write of a whole block, records error
+int mp_write(riff_mpWriter *mw, const void *ptr, size_t size, size_t pos){
+	if(mw->fp_pwrite(mw, ptr, size, pos) == size)
+		return RIFF_ERROR_NONE;
+
+	void *s = mw->sync;
+	sync_lock(s);
+	if(mw->rw->fp_printf)
+		mw->rw->fp_printf("Failed to write %zu bytes at pos %zu!\n", size, pos);
+	mp_fail(mw, RIFF_ERROR_ACCESS);
+	sync_unlock(s);
+	return RIFF_ERROR_ACCESS;
+}
+
+
+/*****************************************************************************/
+//write sizes of all open chunk lists up to the published end, lock must be held
+//sizes beyond 32 bit are left to riff_writerEnd() which knows about ds64
+void mp_publishSizes(riff_mpWriter *mw){
+	riff_writer *rw = mw->rw;
+	uint8_t buf[4];
+	int i;
+	for(i = 0; i < rw->ls_level; i++){
+		size_t size = mw->pub_pos - rw->ls[i].c_pos_start - RIFF_CHUNK_DATA_OFFSET;
+		if(size > 0xFFFFFFFF  ||  (i == 0  &&  rw->ds64_promoted))
+			continue;
+		writeUInt32LE(buf, (uint32_t)size);
+		if(mw->fp_pwrite(mw, buf, 4, rw->ls[i].c_pos_start + 4) != 4){
+			mp_fail(mw, RIFF_ERROR_ACCESS);
+			return;
+		}
+	}
+	mw->commit_pos = mw->pub_pos;
+}
+
+
+/*****************************************************************************/
+//publish committed slots in order, starting with the oldest one, lock must be held
+void mp_publish(riff_mpWriter *mw){
+	int advanced = 0;
+	while(mw->seq_pub < mw->seq_next){
+		struct riff_mpSlot *sl = mw->slots + (mw->seq_pub % mw->slots_size);
+		if(!sl->done)
+			break;
+
+		//need to enlarge index?
+		if(mw->idx_len >= mw->idx_size){
+			size_t idx_size_new = mw->idx_size * 2; //double size
+			if(idx_size_new == 0)
+				idx_size_new = RIFF_MPWRITER_IDX_ALLOC;
+			struct riff_mpIndexE *idxnew = mem_realloc(&mw->alloc, mw->idx, idx_size_new * sizeof(struct riff_mpIndexE));
+			if(idxnew == NULL){
+				mp_fail(mw, RIFF_ERROR_MEMORY);
+				return;
+			}
+			mw->idx = idxnew;
+			mw->idx_size = idx_size_new;
+		}
+		struct riff_mpIndexE *e = mw->idx + mw->idx_len++;
+		e->c_pos_start = sl->c_pos_start;
+		e->c_size = sl->c_size;
+		memcpy(e->c_id, sl->c_id, 5);
+		e->flags = sl->flags;
+
+		mw->pub_pos = sl->c_pos_start + RIFF_CHUNK_DATA_OFFSET + sl->c_size + (sl->c_size & 0x1);
+		sl->done = 0;
+		mw->seq_pub++;
+		advanced = 1;
+	}
+	if(!advanced)
+		return;
+
+	//batched size update, same policy as riff_writerCommit()
+	if(mw->rw->commit_interval > 0  &&  mw->pub_pos - mw->commit_pos >= mw->rw->commit_interval)
+		mp_publishSizes(mw);
+	//slots were freed
+	sync_broadcast(mw->sync);
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+riff_mpWriter *riff_mpWriterAllocate(){
+	riff_mpWriter *mw = mem_calloc(&alloc_global, 1, sizeof(riff_mpWriter));
+	if(mw == NULL)
+		return NULL;
+	mw->alloc = alloc_global;
+	mw->sync = sync_allocate(&mw->alloc);
+	if(mw->sync == NULL){
+		mem_free(&alloc_global, mw);
+		return NULL;
+	}
+	mw->slots_size = RIFF_MPWRITER_SLOTS;
+	return mw;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_mpWriterFree(riff_mpWriter *mw){
+	if(mw == NULL)
+		return;
+	riff_allocator alloc = mw->alloc;
+	sync_free(&alloc, mw->sync);
+	mem_free(&alloc, mw->slots);
+	mem_free(&alloc, mw->idx);
+	mem_free(&alloc, mw);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterBegin(riff_mpWriter *mw, riff_writer *rw){
+	checkValidMPWriter(mw);
+	if(rw == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+
+	//only chunk lists can contain subchunks
+	if(rw->ls_level <= 0  ||  rw->ls[rw->ls_level - 1].c_type[0] == '\0'){
+		if(rw->fp_printf)
+			rw->fp_printf("Can't write chunks from several threads at pos %zu, innermost open chunk is no chunk list\n", rw->pos);
+		return RIFF_ERROR_ILLID;
+	}
+	mw->rw = rw;
+	if(mw->fp_pwrite == NULL  &&  rw->fp_write == &write_file)
+		mw->fp_pwrite = &pwrite_file;
+	if(mw->fp_pwrite == NULL){
+		if(rw->fp_printf)
+			rw->fp_printf("Positional write function pointer not set\n"); //fatal user error
+		return RIFF_ERROR_INVALID_HANDLE;
+	}
+
+	//everything buffered must reach the output before producers write around it
+	int r = riff_writerFlush(rw);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+	if(rw->fp_sync != NULL  &&  rw->fp_sync(rw, 0) != 0)
+		return RIFF_ERROR_ACCESS;
+
+	if(mw->slots_size == 0)
+		mw->slots_size = RIFF_MPWRITER_SLOTS;
+	struct riff_mpSlot *slotsnew = mem_realloc(&mw->alloc, mw->slots, mw->slots_size * sizeof(struct riff_mpSlot));
+	if(slotsnew == NULL){
+		if(rw->fp_printf)
+			rw->fp_printf("Failed to allocate slots\n");
+		return RIFF_ERROR_MEMORY;
+	}
+	mw->slots = slotsnew;
+	memset(mw->slots, 0, mw->slots_size * sizeof(struct riff_mpSlot));
+
+	mw->list_pos = rw->ls[rw->ls_level - 1].c_pos_start + RIFF_CHUNK_DATA_OFFSET;
+	mw->pos = rw->pos;
+	mw->pub_pos = rw->pos;
+	mw->commit_pos = rw->pos;
+	mw->seq_next = 0;
+	mw->seq_pub = 0;
+	mw->idx_len = 0;
+	mw->r = RIFF_ERROR_NONE;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterReserve(riff_mpWriter *mw, const char *id, size_t size, uint32_t flags, uint64_t *seq){
+	checkValidMPWriter(mw);
+	if(!isValidID(id))
+		return RIFF_ERROR_ILLID;
+	if(size > 0xFFFFFFFF)
+		return RIFF_ERROR_ICSIZE;
+
+	void *s = mw->sync;
+	sync_lock(s);
+	//backpressure, wait for the oldest slots to be published
+	while(mw->seq_next - mw->seq_pub >= mw->slots_size  &&  mw->r == RIFF_ERROR_NONE)
+		sync_wait(s);
+	if(mw->r != RIFF_ERROR_NONE){
+		int r = mw->r;
+		sync_unlock(s);
+		return r;
+	}
+
+	struct riff_mpSlot *sl = mw->slots + (mw->seq_next % mw->slots_size);
+	sl->c_pos_start = mw->pos;
+	sl->c_size = size;
+	memcpy(sl->c_id, id, 4);
+	sl->c_id[4] = '\0';
+	sl->flags = flags;
+	sl->done = 0;
+	mw->pos += RIFF_CHUNK_DATA_OFFSET + size + (size & 0x1);
+	*seq = mw->seq_next++;
+	sync_unlock(s);
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterWrite(riff_mpWriter *mw, uint64_t seq, size_t offset, const void *ptr, size_t size){
+	checkValidMPWriter(mw);
+
+	//reserved slot is owned by the producer until committed
+	struct riff_mpSlot *sl = mw->slots + (seq % mw->slots_size);
+	if(offset > sl->c_size  ||  size > sl->c_size - offset)
+		return RIFF_ERROR_ICSIZE;
+	return mp_write(mw, ptr, size, sl->c_pos_start + RIFF_CHUNK_DATA_OFFSET + offset);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterCommit(riff_mpWriter *mw, uint64_t seq){
+	checkValidMPWriter(mw);
+
+	struct riff_mpSlot *sl = mw->slots + (seq % mw->slots_size);
+	uint8_t hdr[RIFF_CHUNK_DATA_OFFSET];
+	memcpy(hdr, sl->c_id, 4);
+	writeUInt32LE(hdr + 4, (uint32_t)sl->c_size);
+	int r = mp_write(mw, hdr, RIFF_CHUNK_DATA_OFFSET, sl->c_pos_start);
+	if(r == RIFF_ERROR_NONE  &&  (sl->c_size & 0x1)){
+		uint8_t pad = 0;
+		r = mp_write(mw, &pad, 1, sl->c_pos_start + RIFF_CHUNK_DATA_OFFSET + sl->c_size);
+	}
+
+	//sequencer: whoever completes the oldest slot publishes
+	void *s = mw->sync;
+	sync_lock(s);
+	sl->done = 1;
+	if(mw->seq_pub == seq)
+		mp_publish(mw);
+	if(r == RIFF_ERROR_NONE)
+		r = mw->r;
+	sync_unlock(s);
+	return r;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterEnd(riff_mpWriter *mw){
+	checkValidMPWriter(mw);
+	if(mw->rw == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+
+	//wait for outstanding slots
+	void *s = mw->sync;
+	sync_lock(s);
+	while(mw->seq_pub < mw->seq_next  &&  mw->r == RIFF_ERROR_NONE)
+		sync_wait(s);
+	int r = mw->r;
+	sync_unlock(s);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+
+	//riff_writer continues after the last chunk, its stream position is stale
+	riff_writer *rw = mw->rw;
+	rw->pos = mw->pos;
+	rw->buf_pos = mw->pos;
+	rw->seek_pending = 1;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_mpWriterWriteIdx1(riff_mpWriter *mw){
+	checkValidMPWriter(mw);
+	if(mw->rw == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+
+	riff_writer *rw = mw->rw;
+	int r;
+	if((r = riff_writerBeginChunkSized(rw, "idx1", mw->idx_len * 16)) != RIFF_ERROR_NONE)
+		return r;
+
+	uint8_t e[16];
+	size_t i;
+	for(i = 0; i < mw->idx_len; i++){
+		const struct riff_mpIndexE *ie = mw->idx + i;
+		size_t offset = ie->c_pos_start - mw->list_pos;
+		if(offset > 0xFFFFFFFF){
+			if(rw->fp_printf)
+				rw->fp_printf("Chunk at pos %zu is out of range of the idx1 chunk\n", ie->c_pos_start);
+			return RIFF_ERROR_ICSIZE;
+		}
+		memcpy(e, ie->c_id, 4);
+		writeUInt32LE(e + 4, ie->flags);
+		writeUInt32LE(e + 8, (uint32_t)offset);
+		writeUInt32LE(e + 12, (uint32_t)ie->c_size);
+		if(riff_writerWrite(rw, e, 16) != 16)
+			return RIFF_ERROR_ACCESS;
+	}
+	return riff_writerEnd(rw);
+}
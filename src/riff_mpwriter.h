@@ -0,0 +1,279 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+To write chunks from several threads at once into the innermost open chunk list of a riff_writer, e.g. the "movi" list of an AVI file.
+Producers never share a stream: each chunk gets its position when it is reserved and is written with positional writes.
+Chunks appear in the file in reservation order, whichever thread finishes the oldest outstanding chunk publishes it (sequencer):
+  its index entry is appended and, with a commit interval set on the riff_writer, the list sizes are updated in order.
+
+
+Usage:
+Open a riff_writer and begin the chunk list, e.g. riff_writerBeginList(rw, "movi")
+Allocate a riff_mpWriter with riff_mpWriterAllocate() and start it with riff_mpWriterBegin()
+  The riff_writer must not be used until riff_mpWriterEnd()
+From any thread:
+  riff_mpWriterReserve() with the chunk ID and size to get a slot, blocks while too many slots are outstanding
+  riff_mpWriterWrite() the chunk data to the slot, in as many pieces as needed
+  riff_mpWriterCommit() the slot once its data is complete
+Call riff_mpWriterEnd(), it waits for all reserved slots to be committed, the riff_writer continues after the last chunk
+End the list with riff_writerEnd(), riff_mpWriterWriteIdx1() writes the collected AVI 1.0 index
+*/
+
+#ifndef _RIFF_MPWRITER_H_
+#define _RIFF_MPWRITER_H_
+
+#include "riff_writer.h"
+
+/**
+ * @brief Default amount of slots that can be outstanding (reserved, not committed) at once.
+ */
+#define RIFF_MPWRITER_SLOTS	64
+
+/**
+ * @brief Slot of a chunk written by a producer.
+ */
+struct riff_mpSlot {
+	/**
+	 * @brief Absolute chunk position in file stream.
+	 */
+	size_t c_pos_start;
+	/**
+	 * @brief Chunk data size.
+	 */
+	size_t c_size;
+	/**
+	 * @brief ID of chunk.
+	 */
+	char c_id[5];
+	/**
+	 * @brief Index flags, e.g. `0x10` for AVI key frames.
+	 */
+	uint32_t flags;
+	/**
+	 * @brief 1 once committed and not yet published.
+	 */
+	int done;
+};
+
+/**
+ * @brief Index entry of a published chunk.
+ */
+struct riff_mpIndexE {
+	/**
+	 * @brief Absolute chunk position in file stream.
+	 */
+	size_t c_pos_start;
+	/**
+	 * @brief Chunk data size.
+	 */
+	size_t c_size;
+	/**
+	 * @brief ID of chunk.
+	 */
+	char c_id[5];
+	/**
+	 * @brief Index flags as passed to riff_mpWriterReserve().
+	 */
+	uint32_t flags;
+};
+
+/**
+ * @brief The multi-producer RIFF writer.
+ *
+ * Members are public and intended for read access, only while no producer is active.
+ */
+typedef struct riff_mpWriter {
+	/**
+	 * @brief The riff_writer whose innermost open chunk list is written.
+	 */
+	riff_writer *rw;
+	/**
+	 * @brief Position of the list type of the chunk list, AVI 1.0 index offsets are relative to it.
+	 */
+	size_t list_pos;
+	/**
+	 * @brief Position of the next reserved chunk.
+	 */
+	size_t pos;
+	/**
+	 * @brief End of the published chunks.
+	 *
+	 * All chunks before this position are written completely.
+	 */
+	size_t pub_pos;
+	/**
+	 * @brief Published end covered by the last size update.
+	 */
+	size_t commit_pos;
+
+	/**
+	 * @name Slot ring.
+	 */
+	///@{
+	/**
+	 * @brief Outstanding slots, slot of sequence number `n` is `slots[n % slots_size]`.
+	 */
+	struct riff_mpSlot *slots;
+	/**
+	 * @brief Amount of slots.
+	 *
+	 * Can be set before riff_mpWriterBegin(), defaults to ::RIFF_MPWRITER_SLOTS.
+	 */
+	size_t slots_size;
+	/**
+	 * @brief Sequence number of the next reserved slot.
+	 */
+	uint64_t seq_next;
+	/**
+	 * @brief Sequence number of the oldest unpublished slot.
+	 */
+	uint64_t seq_pub;
+	///@}
+
+	/**
+	 * @name Index of published chunks, in file order.
+	 */
+	///@{
+	/**
+	 * @brief Index entries.
+	 */
+	struct riff_mpIndexE *idx;
+	/**
+	 * @brief Amount of index entries.
+	 */
+	size_t idx_len;
+	/**
+	 * @brief Amount of allocated index entries.
+	 */
+	size_t idx_size;
+	///@}
+
+	/**
+	 * @brief First error of any producer, RIFF error code.
+	 */
+	int r;
+
+	/**
+	 * @brief Lock and condition variable, platform specific.
+	 */
+	void *sync;
+
+	/**
+	 * @name Internal functions
+	 *
+	 * Function pointers for e.g. defining your own output methods
+	 */
+	///@{
+	/**
+	 * @brief Write bytes at an absolute position without moving a shared stream position.
+	 *
+	 * Called from several threads at once.
+	 * Set by riff_mpWriterBegin() if the riff_writer was opened with riff_writer_open_file() and not set before.
+	 *
+	 * @return Amount of successfully written bytes.
+	 *
+	 * @note Required for proper operation.
+	 */
+	size_t (*fp_pwrite)(struct riff_mpWriter *mw, const void *ptr, size_t size, size_t pos);
+	///@}
+
+	/**
+	 * @brief Allocator, the global one when allocated.
+	 */
+	riff_allocator alloc;
+} riff_mpWriter;
+
+/**
+ * @defgroup RIFF_C_MPWriter C multi-producer RIFF writer functions
+ * @{
+ */
+/**
+ * @brief Allocate, initialize and return a riff_mpWriter.
+ *
+ * @return Pointer to the allocated riff_mpWriter, NULL if allocation failed.
+ */
+riff_mpWriter *riff_mpWriterAllocate();
+/**
+ * @brief Free the memory allocated to a riff_mpWriter, the riff_writer is not touched.
+ *
+ * @param mw The riff_mpWriter to free.
+ */
+void riff_mpWriterFree(riff_mpWriter *mw);
+/**
+ * @brief Start writing chunks from several threads into the innermost open chunk list of a riff_writer.
+ *
+ * The riff_writer is flushed and must not be used until riff_mpWriterEnd().
+ *
+ * @param mw The riff_mpWriter to use.
+ * @param rw The riff_writer, its innermost open chunk must be a chunk list.
+ *
+ * @return RIFF error code.
+ */
+int riff_mpWriterBegin(riff_mpWriter *mw, riff_writer *rw);
+/**
+ * @brief Reserve a slot for a chunk, thread safe.
+ *
+ * The chunk gets its position in the file, after the chunk of the previous reservation.
+ * Blocks while riff_mpWriter::slots_size slots are outstanding.
+ *
+ * @param mw The riff_mpWriter to use.
+ * @param id The chunk ID (4 bytes).
+ * @param size The chunk data size, must fit into 32 bit.
+ * @param flags Index flags, stored in the index entry.
+ * @param seq Receives the sequence number of the slot.
+ *
+ * @return RIFF error code, the first error of any producer after one occured.
+ */
+int riff_mpWriterReserve(riff_mpWriter *mw, const char *id, size_t size, uint32_t flags, uint64_t *seq);
+/**
+ * @brief Write chunk data to a reserved slot, thread safe.
+ *
+ * @param mw The riff_mpWriter to use.
+ * @param seq The sequence number of the slot.
+ * @param offset Offset in the chunk data.
+ * @param ptr The data to write.
+ * @param size The amount of data to write, must not exceed the reserved chunk size.
+ *
+ * @return RIFF error code.
+ */
+int riff_mpWriterWrite(riff_mpWriter *mw, uint64_t seq, size_t offset, const void *ptr, size_t size);
+/**
+ * @brief Commit a slot whose data was written completely, thread safe.
+ *
+ * Writes the chunk header and pad byte.
+ * If the slot is the oldest outstanding one, it and all following committed slots are published.
+ *
+ * @param mw The riff_mpWriter to use.
+ * @param seq The sequence number of the slot.
+ *
+ * @return RIFF error code.
+ */
+int riff_mpWriterCommit(riff_mpWriter *mw, uint64_t seq);
+/**
+ * @brief Stop writing from several threads.
+ *
+ * Blocks until all reserved slots are committed, the riff_writer continues after the last chunk.
+ *
+ * @param mw The riff_mpWriter to use.
+ *
+ * @return RIFF error code, the first error of any producer.
+ */
+int riff_mpWriterEnd(riff_mpWriter *mw);
+/**
+ * @brief Write the index of all published chunks as AVI 1.0 "idx1" chunk to the riff_writer.
+ *
+ * Call after riff_mpWriterEnd() and ending the chunk list. Offsets are relative to the list type of the chunk list.
+ *
+ * @param mw The riff_mpWriter to use.
+ *
+ * @return RIFF error code.
+ */
+int riff_mpWriterWriteIdx1(riff_mpWriter *mw);
+
+///@}
+
+#endif // _RIFF_MPWRITER_H_
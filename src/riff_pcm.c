@@ -0,0 +1,626 @@
+// PCM sample conversion of the WAVE layer, see riff_wav.h
+// kernels convert n interleaved samples, SIMD versions are picked once at runtime:
+//   x86: SSE2 (baseline on x86-64), AVX2 if the CPU supports it (GCC/Clang only)
+//   ARM: NEON on AArch64
+//   else scalar, also used for the tails of the SIMD kernels
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(__x86_64__)  ||  defined(_M_X64)  ||  (defined(__i386__)  &&  defined(__SSE2__))
+#define RIFF_PCM_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)  ||  defined(__clang__)
+#define RIFF_PCM_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__)
+#define RIFF_PCM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "riff_wav.h"
+#include "riff_internal.h"
+
+
+#define PCM_SCRATCH 4096            //samples converted at once for planar output
+#define PCM_READ_BUFFER 65536       //raw data read at once from non-memory sources
+
+//full scale factors
+#define PCM_S8_SCALE  (1.0f / 128.0f)
+#define PCM_S16_SCALE (1.0f / 32768.0f)
+#define PCM_S24_SCALE (1.0f / 8388608.0f)
+#define PCM_S32_SCALE (1.0f / 2147483648.0f)
+
+//kernels per source type (PCM_...) and output sample type (RIFF_WAV_SAMPLE_...)
+//SIMD tables are NULL where the scalar kernel is used
+typedef pcm_kernel pcm_table[PCM_TYPES][2];
+
+
+
+//*** scalar kernels ***
+
+
+/*****************************************************************************/
+//read little endian samples as native
+static inline int32_t pcm_s24(const uint8_t *p){
+	return (int32_t)((uint32_t)p[0] << 8  |  (uint32_t)p[1] << 16  |  (uint32_t)p[2] << 24) >> 8;
+}
+static inline float pcm_f32(const uint8_t *p){
+	uint32_t v = convUInt32LE(p);
+	float f;
+	memcpy(&f, &v, 4);
+	return f;
+}
+static inline double pcm_f64(const uint8_t *p){
+	uint64_t v = convUInt64LE(p);
+	double d;
+	memcpy(&d, &v, 8);
+	return d;
+}
+
+/*****************************************************************************/
+//float to int16 with saturation, rounds half to even like the SIMD kernels
+static inline int16_t pcm_toS16(float f){
+	f *= 32768.0f;
+	if(f >= 32767.0f)
+		return 32767;
+	if(!(f > -32768.0f))	//also NaN, as the SIMD kernels
+		return -32768;
+	//adding 1.5 * 2^23 leaves no fraction bits
+	return (int16_t)((f + 12582912.0f) - 12582912.0f);
+}
+
+static void u8_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = ((int)src[i] - 128) * PCM_S8_SCALE;
+}
+static void s16_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int16_t)convUInt16LE(src + 2 * i) * PCM_S16_SCALE;
+}
+static void s24_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = pcm_s24(src + 3 * i) * PCM_S24_SCALE;
+}
+static void s32_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int32_t)convUInt32LE(src + 4 * i) * PCM_S32_SCALE;
+}
+static void f32_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = pcm_f32(src + 4 * i);
+}
+static void f64_f32(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (float)pcm_f64(src + 8 * i);
+}
+
+static void u8_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int16_t)(((int)src[i] - 128) * 256);
+}
+static void s16_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int16_t)convUInt16LE(src + 2 * i);
+}
+static void s24_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int16_t)(pcm_s24(src + 3 * i) >> 8);
+}
+static void s32_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = (int16_t)((int32_t)convUInt32LE(src + 4 * i) >> 16);
+}
+static void f32_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = pcm_toS16(pcm_f32(src + 4 * i));
+}
+static void f64_s16(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	size_t i;
+	for(i = 0; i < n; i++)
+		d[i] = pcm_toS16((float)pcm_f64(src + 8 * i));
+}
+
+static const pcm_table kernels_scalar = {
+	{ &u8_f32,  &u8_s16  },
+	{ &s16_f32, &s16_s16 },
+	{ &s24_f32, &s24_s16 },
+	{ &s32_f32, &s32_s16 },
+	{ &f32_f32, &f32_s16 },
+	{ &f64_f32, &f64_s16 },
+};
+
+
+
+//*** SSE2 kernels ***
+
+
+#if defined(RIFF_PCM_SSE2)
+
+static void s16_f32_sse2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	const __m128 scale = _mm_set1_ps(PCM_S16_SCALE);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8){
+		__m128i x = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		_mm_storeu_ps(d + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(d + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+	s16_f32(src + 2 * i, d + i, n - i);
+}
+
+static void s32_f32_sse2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	const __m128 scale = _mm_set1_ps(PCM_S32_SCALE);
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4){
+		__m128i x = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		_mm_storeu_ps(d + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+	}
+	s32_f32(src + 4 * i, d + i, n - i);
+}
+
+static void f64_f32_sse2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4){
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd((const double *)(src + 8 * i)));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd((const double *)(src + 8 * i + 16)));
+		_mm_storeu_ps(d + i, _mm_movelh_ps(lo, hi));
+	}
+	f64_f32(src + 8 * i, d + i, n - i);
+}
+
+static void f32_s16_sse2(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 min = _mm_set1_ps(-32768.0f);
+	const __m128 max = _mm_set1_ps(32767.0f);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8){
+		__m128 a = _mm_loadu_ps((const float *)(src + 4 * i));
+		__m128 b = _mm_loadu_ps((const float *)(src + 4 * i + 16));
+		a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(a, scale), min), max);
+		b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(b, scale), min), max);
+		__m128i x = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+		_mm_storeu_si128((__m128i *)(d + i), x);
+	}
+	f32_s16(src + 4 * i, d + i, n - i);
+}
+
+static const pcm_table kernels_sse2 = {
+	{ NULL,          NULL          },
+	{ &s16_f32_sse2, NULL          },
+	{ NULL,          NULL          },
+	{ &s32_f32_sse2, NULL          },
+	{ NULL,          &f32_s16_sse2 },
+	{ &f64_f32_sse2, NULL          },
+};
+
+#endif
+
+
+
+//*** AVX2 kernels ***
+
+
+#if defined(RIFF_PCM_AVX2)
+
+__attribute__((target("avx2")))
+static void s16_f32_avx2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	const __m256 scale = _mm256_set1_ps(PCM_S16_SCALE);
+	size_t i = 0;
+	for(; i + 16 <= n; i += 16){
+		__m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + 2 * i)));
+		__m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + 2 * i + 16)));
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+		_mm256_storeu_ps(d + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+	}
+	s16_f32(src + 2 * i, d + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void s24_f32_avx2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	const __m256 scale = _mm256_set1_ps(PCM_S24_SCALE);
+	//lane 0 gets bytes 0..15, lane 1 bytes 12..27
+	const __m256i perm = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+	//each 3 byte sample into the upper 3 bytes of a dword, sign extended by the shift
+	const __m256i shuf = _mm256_setr_epi8(
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	size_t i = 0;
+	//8 samples use 24 bytes, the load reads 32
+	for(; i + 11 <= n; i += 8){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(src + 3 * i));
+		x = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(x, perm), shuf);
+		x = _mm256_srai_epi32(x, 8);
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	s24_f32(src + 3 * i, d + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void s32_f32_avx2(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	const __m256 scale = _mm256_set1_ps(PCM_S32_SCALE);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8){
+		__m256i x = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+		_mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	s32_f32(src + 4 * i, d + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void f32_s16_avx2(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	const __m256 scale = _mm256_set1_ps(32768.0f);
+	const __m256 min = _mm256_set1_ps(-32768.0f);
+	const __m256 max = _mm256_set1_ps(32767.0f);
+	size_t i = 0;
+	for(; i + 16 <= n; i += 16){
+		__m256 a = _mm256_loadu_ps((const float *)(src + 4 * i));
+		__m256 b = _mm256_loadu_ps((const float *)(src + 4 * i + 32));
+		a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(a, scale), min), max);
+		b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(b, scale), min), max);
+		//packs works per 128 bit lane, restore order
+		__m256i x = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+		x = _mm256_permute4x64_epi64(x, 0xD8);
+		_mm256_storeu_si256((__m256i *)(d + i), x);
+	}
+	f32_s16(src + 4 * i, d + i, n - i);
+}
+
+static const pcm_table kernels_avx2 = {
+	{ NULL,          NULL          },
+	{ &s16_f32_avx2, NULL          },
+	{ &s24_f32_avx2, NULL          },
+	{ &s32_f32_avx2, NULL          },
+	{ NULL,          &f32_s16_avx2 },
+	{ NULL,          NULL          },
+};
+
+#endif
+
+
+
+//*** NEON kernels ***
+
+
+#if defined(RIFF_PCM_NEON)
+
+static void s16_f32_neon(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8){
+		int16x8_t x = vld1q_s16((const int16_t *)(src + 2 * i));
+		vst1q_f32(d + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), PCM_S16_SCALE));
+		vst1q_f32(d + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), PCM_S16_SCALE));
+	}
+	s16_f32(src + 2 * i, d + i, n - i);
+}
+
+static void s32_f32_neon(const uint8_t *src, void *dst, size_t n){
+	float *d = (float *)dst;
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4){
+		int32x4_t x = vld1q_s32((const int32_t *)(src + 4 * i));
+		vst1q_f32(d + i, vmulq_n_f32(vcvtq_f32_s32(x), PCM_S32_SCALE));
+	}
+	s32_f32(src + 4 * i, d + i, n - i);
+}
+
+static void f32_s16_neon(const uint8_t *src, void *dst, size_t n){
+	int16_t *d = (int16_t *)dst;
+	const float32x4_t min = vdupq_n_f32(-32768.0f);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8){
+		float32x4_t a = vmulq_n_f32(vld1q_f32((const float *)(src + 4 * i)), 32768.0f);
+		float32x4_t b = vmulq_n_f32(vld1q_f32((const float *)(src + 4 * i + 16)), 32768.0f);
+		//NaN to -32768 like the scalar kernel, the conversion would make it 0
+		a = vbslq_f32(vceqq_f32(a, a), a, min);
+		b = vbslq_f32(vceqq_f32(b, b), b, min);
+		//round to nearest, saturating narrow
+		int16x8_t x = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b)));
+		vst1q_s16(d + i, x);
+	}
+	f32_s16(src + 4 * i, d + i, n - i);
+}
+
+static const pcm_table kernels_neon = {
+	{ NULL,          NULL          },
+	{ &s16_f32_neon, NULL          },
+	{ NULL,          NULL          },
+	{ &s32_f32_neon, NULL          },
+	{ NULL,          &f32_s16_neon },
+	{ NULL,          NULL          },
+};
+
+#endif
+
+
+
+// **** internal ****
+
+
+static pcm_table kernels;
+static const char *kernels_impl = NULL;
+
+//implementations in the order they are preferred, each replaces the kernels it has
+static const char *const kernels_impls[] = { "scalar", "sse2", "avx2", "neon" };
+
+/*****************************************************************************/
+//kernel table of implementation, NULL if it is not built in or the CPU lacks it
+static const pcm_table *pcm_tableOf(const char *impl){
+	if(strcmp(impl, "scalar") == 0)
+		return &kernels_scalar;
+#if defined(RIFF_PCM_SSE2)
+	if(strcmp(impl, "sse2") == 0)
+		return &kernels_sse2;
+#endif
+#if defined(RIFF_PCM_AVX2)
+	if(strcmp(impl, "avx2") == 0){
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? &kernels_avx2 : NULL;
+	}
+#endif
+#if defined(RIFF_PCM_NEON)
+	if(strcmp(impl, "neon") == 0)
+		return &kernels_neon;
+#endif
+	return NULL;
+}
+
+/*****************************************************************************/
+//pick kernels, only called through pcm_init()
+static void pcm_select(void){
+	pcm_table k;
+	const char *impl = NULL;
+	size_t i;
+	int t, s;
+	for(i = 0; i < sizeof(kernels_impls) / sizeof(kernels_impls[0]); i++){
+		const pcm_table *p = pcm_tableOf(kernels_impls[i]);
+		if(p == NULL)
+			continue;
+		for(t = 0; t < PCM_TYPES; t++){
+			for(s = 0; s < 2; s++){
+				if((*p)[t][s] != NULL)
+					k[t][s] = (*p)[t][s];
+			}
+		}
+		impl = kernels_impls[i];
+	}
+
+	memcpy(kernels, k, sizeof(kernels));
+	kernels_impl = impl;
+}
+
+/*****************************************************************************/
+//pick kernels exactly once, concurrent callers wait until the table is complete
+#if defined(_WIN32)
+
+static INIT_ONCE kernels_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK pcm_selectOnce(PINIT_ONCE once, PVOID param, PVOID *ctx){
+	(void)once; (void)param; (void)ctx;
+	pcm_select();
+	return TRUE;
+}
+
+static void pcm_init(void){
+	InitOnceExecuteOnce(&kernels_once, &pcm_selectOnce, NULL, NULL);
+}
+
+#else
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void pcm_init(void){
+	pthread_once(&kernels_once, &pcm_select);
+}
+
+#endif
+
+
+/*****************************************************************************/
+//source sample type of format, -1 if not supported
+static int pcm_type(const riff_wav *wav){
+	if(wav->channels == 0  ||  (size_t)wav->block_align != (size_t)wav->channels * (wav->bits_per_sample / 8))
+		return -1;
+	if(wav->format == RIFF_WAV_FORMAT_PCM){
+		switch(wav->bits_per_sample){
+			case 8:  return PCM_U8;
+			case 16: return PCM_S16;
+			case 24: return PCM_S24;
+			case 32: return PCM_S32;
+		}
+	}
+	else if(wav->format == RIFF_WAV_FORMAT_FLOAT){
+		switch(wav->bits_per_sample){
+			case 32: return PCM_F32;
+			case 64: return PCM_F64;
+		}
+	}
+	return -1;
+}
+
+
+/*****************************************************************************/
+//convert frames to dst, starting at frame "offset" of the output
+//planar output has plane_len frames per channel
+static void pcm_convert(pcm_kernel k, const riff_wav *wav, const uint8_t *src, size_t frames, void *dst, size_t offset, size_t plane_len, int sample, int planar){
+	size_t ch = wav->channels;
+	size_t osize = (sample == RIFF_WAV_SAMPLE_FLOAT) ? sizeof(float) : sizeof(int16_t);
+
+	if(!planar){
+		k(src, (uint8_t *)dst + offset * ch * osize, frames * ch);
+		return;
+	}
+
+	//convert interleaved to scratch, then scatter to the planes
+	union { float f[PCM_SCRATCH]; int16_t s[PCM_SCRATCH]; } tmp;
+	size_t per = PCM_SCRATCH / ch;
+	size_t done, n, c, i;
+	for(done = 0; done < frames; done += n){
+		n = frames - done;
+		if(n > per)
+			n = per;
+		k(src + done * wav->block_align, &tmp, n * ch);
+		for(c = 0; c < ch; c++){
+			if(sample == RIFF_WAV_SAMPLE_FLOAT){
+				float *p = (float *)dst + c * plane_len + offset + done;
+				for(i = 0; i < n; i++)
+					p[i] = tmp.f[i * ch + c];
+			}
+			else {
+				int16_t *p = (int16_t *)dst + c * plane_len + offset + done;
+				for(i = 0; i < n; i++)
+					p[i] = tmp.s[i * ch + c];
+			}
+		}
+	}
+}
+
+
+/*****************************************************************************/
+//kernel for format and output sample type, NULL if not supported
+static pcm_kernel pcm_kernelFor(const riff_wav *wav, int sample){
+	int t = pcm_type(wav);
+	if(t < 0  ||  (sample != RIFF_WAV_SAMPLE_FLOAT  &&  sample != RIFF_WAV_SAMPLE_INT16))
+		return NULL;
+	if(wav->channels > PCM_SCRATCH)
+		return NULL;
+	pcm_init();
+	return kernels[t][sample];
+}
+
+/*****************************************************************************/
+//description: see riff_internal.h
+pcm_kernel pcm_kernelOf(const char *impl, int type, int sample){
+	if(type < 0  ||  type >= PCM_TYPES  ||  (sample != RIFF_WAV_SAMPLE_FLOAT  &&  sample != RIFF_WAV_SAMPLE_INT16))
+		return NULL;
+	if(impl == NULL){
+		pcm_init();
+		return kernels[type][sample];
+	}
+	const pcm_table *p = pcm_tableOf(impl);
+	return (p != NULL) ? (*p)[type][sample] : NULL;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_wavConvert(const riff_wav *wav, const void *src, size_t frames, void *dst, int sample, int planar){
+	if(wav == NULL  ||  src == NULL  ||  dst == NULL)
+		return 0;
+	pcm_kernel k = pcm_kernelFor(wav, sample);
+	if(k == NULL)
+		return 0;
+	pcm_convert(k, wav, (const uint8_t *)src, frames, dst, 0, frames, sample, planar);
+	return frames;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_wavReadConverted(riff_handle *rh, const riff_wav *wav, uint64_t start, size_t count, void *dst, int sample, int planar){
+	if(rh == NULL  ||  wav == NULL  ||  dst == NULL)
+		return 0;
+	pcm_kernel k = pcm_kernelFor(wav, sample);
+	if(k == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Can't convert format 0x%04x with %u bits per sample\n", wav->format, wav->bits_per_sample);
+		return 0;
+	}
+	if(start >= wav->frames)
+		return 0;
+	if(count > wav->frames - start)
+		count = (size_t)(wav->frames - start);
+
+	if(wav_toData(rh, wav) != RIFF_ERROR_NONE)
+		return 0;
+	size_t at = (size_t)(start * wav->block_align);
+
+	//in memory, convert from there
+	if(rh->fp_read == &read_mem){
+		const uint8_t *src = (const uint8_t *)rh->fh + wav->data_pos + RIFF_CHUNK_DATA_OFFSET + at;
+		pcm_convert(k, wav, src, count, dst, 0, count, sample, planar);
+		riff_seekInChunk(rh, at + count * wav->block_align);
+		return count;
+	}
+
+	//read blocks of whole frames, convert each
+	size_t per = PCM_READ_BUFFER / wav->block_align;
+	if(per == 0)
+		per = 1;
+	uint8_t *buf = mem_alloc(&rh->alloc, per * wav->block_align);
+	if(buf == NULL){
+		if(rh->fp_printf)
+			rh->fp_printf("Failed to allocate read buffer\n");
+		return 0;
+	}
+	if(riff_seekInChunk(rh, at) != RIFF_ERROR_NONE){
+		mem_free(&rh->alloc, buf);
+		return 0;
+	}
+	size_t done = 0, n;
+	while(done < count){
+		n = count - done;
+		if(n > per)
+			n = per;
+		n = riff_readInChunk(rh, buf, n * wav->block_align) / wav->block_align;
+		if(n == 0)
+			break;
+		pcm_convert(k, wav, buf, n, dst, done, count, sample, planar);
+		done += n;
+	}
+	mem_free(&rh->alloc, buf);
+	return done;
+}
+
+/*****************************************************************************/
+//description: see header file
+const char *riff_wavConvertImpl(){
+	pcm_init();
+	return kernels_impl;
+}
@@ -0,0 +1,99 @@
+// no riff_handle, no allocation, no output: only the passed buffer is looked at
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_probe.h"
+#include "riff_internal.h"
+
+
+#define PROBE_DS64_SIZE_POS 20  //form size in the data of a first "ds64" chunk
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_probe(const void *buf, size_t len, uint64_t file_size, struct riff_probeResult *res){
+	const uint8_t *b = (const uint8_t *)buf;
+	memset(res, 0, sizeof(struct riff_probeResult));
+	if(buf == NULL  ||  len < 4)
+		return 0;
+
+	//container ID first, most buffers are rejected here
+	uint32_t id;
+	memcpy(&id, b, 4);
+	uint32_t riff, rifx, rf64, bw64;
+	memcpy(&riff, "RIFF", 4);
+	memcpy(&rifx, "RIFX", 4);
+	memcpy(&rf64, "RF64", 4);
+	memcpy(&bw64, "BW64", 4);
+	if(id == riff)
+		res->container = RIFF_PROBE_RIFF;
+	else if(id == rifx)
+		res->container = RIFF_PROBE_RIFX;
+	else if(id == rf64)
+		res->container = RIFF_PROBE_RF64;
+	else if(id == bw64)
+		res->container = RIFF_PROBE_BW64;
+	else
+		return 0;
+	res->score = 30;
+
+	int be = (res->container == RIFF_PROBE_RIFX);
+	if(len < RIFF_HEADER_SIZE)
+		return res->score;
+	res->h_size = be ? convUInt32BE(b + 4) : convUInt32LE(b + 4);
+	memcpy(res->h_type, b + 8, 4);
+	if(isValidID(res->h_type))
+		res->score += 20;
+
+	int c_valid = 0;
+	if(len >= RIFF_HEADER_SIZE + RIFF_CHUNK_DATA_OFFSET){
+		memcpy(res->c_id, b + RIFF_HEADER_SIZE, 4);
+		res->c_size = be ? convUInt32BE(b + 16) : convUInt32LE(b + 16);
+		c_valid = isValidID(res->c_id);
+		if(c_valid)
+			res->score += 20;
+	}
+
+	//64 bit form size is in the "ds64" chunk
+	int h_known = 1;
+	if(res->h_size == 0xFFFFFFFF  &&  (res->container == RIFF_PROBE_RF64  ||  res->container == RIFF_PROBE_BW64)){
+		if(len >= PROBE_DS64_SIZE_POS + 8  &&  memcmp(res->c_id, "ds64", 4) == 0)
+			res->h_size = convUInt64LE(b + PROBE_DS64_SIZE_POS);
+		else
+			h_known = 0;
+	}
+
+	//first chunk must fit into the form, type ID included
+	if(c_valid  &&  h_known  &&  res->h_size >= 4 + RIFF_CHUNK_DATA_OFFSET  &&  res->c_size <= res->h_size - 4 - RIFF_CHUNK_DATA_OFFSET)
+		res->score += 10;
+
+	//form size against file size, extra data after the form is common (e.g. "RIFF AVIX" chunks)
+	if(h_known  &&  res->h_size >= 4){
+		//saturated, a 64 bit size from "ds64" can be close to the maximum
+		uint64_t total = (res->h_size <= (uint64_t)-1 - RIFF_CHUNK_DATA_OFFSET) ? res->h_size + RIFF_CHUNK_DATA_OFFSET : (uint64_t)-1;
+		if(file_size == 0  ||  (total <= file_size  &&  file_size - total <= 1))
+			res->score += 20;
+		else if(total < file_size)
+			res->score += 10;
+	}
+	return res->score;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_probeBatch(const void * const *bufs, const size_t *lens, const uint64_t *file_sizes, size_t count, struct riff_probeResult *res){
+	size_t i, n = 0;
+	for(i = 0; i < count; i++){
+		if(riff_probe(bufs[i], lens[i], file_sizes ? file_sizes[i] : 0, res + i) > 0)
+			n++;
+	}
+	return n;
+}
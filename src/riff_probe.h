@@ -0,0 +1,118 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Classify RIFF files from a small prefix buffer, without a riff_handle, allocations or I/O.
+Recognizes RIFF, RIFX (big endian), RF64 and BW64 (64 bit sizes in the "ds64" chunk).
+Nothing is printed, suspicious sizes only lower the plausibility score.
+
+
+Usage:
+Read the first ::RIFF_PROBE_SIZE bytes of a file, fewer if the file is shorter
+Call riff_probe() with the buffer and the file size if known, or riff_probeBatch() for many buffers at once
+Open files with a high enough riff_probeResult::score with the usual riff_handle functions
+*/
+
+#ifndef _RIFF_PROBE_H_
+#define _RIFF_PROBE_H_
+
+#include "riff.h"
+
+/**
+ * @brief Prefix size needed for all checks: RIFF header, first chunk header and the form size of a "ds64" chunk.
+ */
+#define RIFF_PROBE_SIZE		32
+
+/**
+ * @defgroup Probe_containers Container types
+ * @{
+ */
+/**
+ * @brief No RIFF file.
+ */
+#define RIFF_PROBE_NONE		0
+/**
+ * @brief "RIFF", little endian.
+ */
+#define RIFF_PROBE_RIFF		1
+/**
+ * @brief "RIFX", big endian.
+ */
+#define RIFF_PROBE_RIFX		2
+/**
+ * @brief "RF64", 64 bit sizes in the "ds64" chunk.
+ */
+#define RIFF_PROBE_RF64		3
+/**
+ * @brief "BW64", 64 bit sizes in the "ds64" chunk.
+ */
+#define RIFF_PROBE_BW64		4
+///@}
+
+/**
+ * @brief Result of riff_probe().
+ */
+struct riff_probeResult {
+	/**
+	 * @brief Container type, see @ref Probe_containers.
+	 */
+	int container;
+	/**
+	 * @brief Form type, e.g. "WAVE" or "AVI ", empty if not in the buffer.
+	 */
+	char h_type[5];
+	/**
+	 * @brief Form size as in the header, from the "ds64" chunk for 64 bit files if in the buffer.
+	 */
+	uint64_t h_size;
+	/**
+	 * @brief ID of the first chunk, empty if not in the buffer.
+	 */
+	char c_id[5];
+	/**
+	 * @brief Size of the first chunk.
+	 */
+	uint64_t c_size;
+	/**
+	 * @brief Plausibility from 0 (no RIFF file) to 100.
+	 *
+	 * 30 for the container ID, 20 for a valid form type, 20 for a valid first chunk ID,
+	 * 10 if the first chunk fits into the form, 20 if the form size matches the file size (or is plausible if unknown).
+	 */
+	int score;
+};
+
+/**
+ * @defgroup RIFF_C_Probe C probe functions
+ * @{
+ */
+/**
+ * @brief Classify a prefix buffer of a file.
+ *
+ * @param buf The first bytes of the file.
+ * @param len Amount of bytes in buf, ::RIFF_PROBE_SIZE for all checks.
+ * @param file_size Size of the file, 0 if unknown.
+ * @param res Receives the result.
+ *
+ * @return Plausibility score, riff_probeResult::score.
+ */
+int riff_probe(const void *buf, size_t len, uint64_t file_size, struct riff_probeResult *res);
+/**
+ * @brief Classify many prefix buffers at once.
+ *
+ * @param bufs The prefix buffers.
+ * @param lens Amount of bytes in each buffer.
+ * @param file_sizes Size of each file, NULL if all unknown.
+ * @param count Amount of buffers.
+ * @param res Receives `count` results.
+ *
+ * @return Amount of buffers recognized as RIFF files (score above 0).
+ */
+size_t riff_probeBatch(const void * const *bufs, const size_t *lens, const uint64_t *file_sizes, size_t count, struct riff_probeResult *res);
+
+///@}
+
+#endif // _RIFF_PROBE_H_
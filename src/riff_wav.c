@@ -0,0 +1,199 @@
+// take care: whenever we call rh->fp_read() or rh->fp_seek()
+//   we must adjust rh->c_pos and rh->pos
+//   => only riff_handle functions are used, wav_toData() puts the handle back on the data chunk without scanning
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_wav.h"
+#include "riff_internal.h"
+
+
+#define WAV_FMT_SIZE		16	//minimum "fmt " chunk size, WAVEFORMAT + bits per sample
+#define WAV_FMT_EXT_SIZE	40	//WAVEFORMATEXTENSIBLE
+
+#define checkValidRiffHandle(rh) if (rh == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+// **** internal ****
+
+
+
+/*****************************************************************************/
+//parse data of current chunk as "fmt " chunk
+int wav_readFmt(riff_handle *rh, riff_wav *wav){
+	uint8_t buf[WAV_FMT_EXT_SIZE] = {0};
+	size_t n = riff_readInChunk(rh, buf, WAV_FMT_EXT_SIZE);
+	if(n < WAV_FMT_SIZE){
+		if(rh->fp_printf)
+			rh->fp_printf("\"fmt \" chunk too small, %zu bytes\n", n);
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	wav->format_tag = convUInt16LE(buf);
+	wav->channels = convUInt16LE(buf + 2);
+	wav->sample_rate = convUInt32LE(buf + 4);
+	wav->byte_rate = convUInt32LE(buf + 8);
+	wav->block_align = convUInt16LE(buf + 12);
+	wav->bits_per_sample = convUInt16LE(buf + 14);
+	wav->format = wav->format_tag;
+	wav->valid_bits = wav->bits_per_sample;
+
+	//sub format GUID starts with the actual format tag
+	if(wav->format_tag == RIFF_WAV_FORMAT_EXTENSIBLE  &&  n >= WAV_FMT_EXT_SIZE){
+		wav->valid_bits = convUInt16LE(buf + 18);
+		wav->channel_mask = convUInt32LE(buf + 20);
+		memcpy(wav->sub_format, buf + 24, 16);
+		wav->format = convUInt16LE(buf + 24);
+	}
+
+	if(wav->channels == 0  ||  wav->block_align == 0){
+		if(rh->fp_printf)
+			rh->fp_printf("Invalid \"fmt \" chunk, %u channels, block align %u\n", wav->channels, wav->block_align);
+		return RIFF_ERROR_ILLID;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//put handle on data chunk if it's not there, constant time
+int wav_toData(riff_handle *rh, const riff_wav *wav){
+	if(rh->ls_level == 0  &&  rh->c_pos_start == wav->data_pos)
+		return RIFF_ERROR_NONE;
+
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	rh->pos = wav->data_pos;
+	rh->fp_seek(rh, rh->pos);
+	int r = riff_readChunkHeader(rh);
+	//truncated data chunk was accepted by riff_wavOpen()
+	if(r != RIFF_ERROR_NONE  &&  rh->c_pos_start != wav->data_pos)
+		return r;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//order regions by start frame
+static int compareRegions(const void *a, const void *b){
+	const struct riff_wavRegion *x = *(const struct riff_wavRegion * const *)a;
+	const struct riff_wavRegion *y = *(const struct riff_wavRegion * const *)b;
+	if(x->start != y->start)
+		return (x->start < y->start) ? -1 : 1;
+	return 0;
+}
+
+
+
+//**** user access ****
+
+
+
+/*****************************************************************************/
+//description: see header file
+int riff_wavOpen(riff_handle *rh, riff_wav *wav){
+	checkValidRiffHandle(rh);
+	if(wav == NULL)
+		return RIFF_ERROR_INVALID_HANDLE;
+	memset(wav, 0, sizeof(riff_wav));
+
+	if(memcmp(rh->h_type, "WAVE", 4) != 0){
+		if(rh->fp_printf)
+			rh->fp_printf("Not a WAVE file, form type \"%s\"\n", rh->h_type);
+		return RIFF_ERROR_ILLID;
+	}
+	//format fields and samples of "RIFX" files are big endian as well
+	if(isBigEndian(rh)){
+		if(rh->fp_printf)
+			rh->fp_printf("Big endian WAVE files are not supported\n");
+		return RIFF_ERROR_ILLID;
+	}
+
+	//single scan of the top level, stops once both chunks are found
+	while(rh->ls_level > 0)
+		riff_levelParent(rh);
+	int fmt = 0, data = 0;
+	size_t last = 0;
+	int r = riff_seekLevelStart(rh);
+	while(1){
+		//header was read if the position moved on, a cut off "data" chunk is still usable
+		if(r != RIFF_ERROR_NONE  &&  (rh->c_pos_start == last  ||  memcmp(rh->c_id, "data", 4) != 0))
+			break;
+		last = rh->c_pos_start;
+
+		if(!fmt  &&  memcmp(rh->c_id, "fmt ", 4) == 0){
+			if((r = wav_readFmt(rh, wav)) != RIFF_ERROR_NONE)
+				return r;
+			fmt = 1;
+		}
+		else if(!data  &&  memcmp(rh->c_id, "data", 4) == 0){
+			wav->data_pos = rh->c_pos_start;
+			wav->data_size = rh->c_size;
+			//data beyond the end of the file is missing
+			if(rh->size > 0  &&  rh->c_pos_start + RIFF_CHUNK_DATA_OFFSET + wav->data_size > rh->size)
+				wav->data_size = rh->size - rh->c_pos_start - RIFF_CHUNK_DATA_OFFSET;
+			data = 1;
+		}
+		if(fmt  &&  data)
+			break;
+		if(r != RIFF_ERROR_NONE)
+			break;
+		r = riff_seekNextChunk(rh);
+	}
+
+	if(!fmt  ||  !data){
+		if(rh->fp_printf)
+			rh->fp_printf("WAVE file without \"%s\" chunk\n", fmt ? "data" : "fmt ");
+		return RIFF_ERROR_ILLID;
+	}
+
+	wav->frames = wav->data_size / wav->block_align;
+	if((r = wav_toData(rh, wav)) != RIFF_ERROR_NONE)
+		return r;
+	return riff_seekChunkStart(rh);
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_wavReadFrames(riff_handle *rh, const riff_wav *wav, uint64_t start, size_t count, void *buf){
+	if(rh == NULL  ||  wav == NULL  ||  wav->block_align == 0)
+		return 0;
+	if(start >= wav->frames)
+		return 0;
+	if(count > wav->frames - start)
+		count = (size_t)(wav->frames - start);
+
+	if(wav_toData(rh, wav) != RIFF_ERROR_NONE)
+		return 0;
+	if(riff_seekInChunk(rh, (size_t)(start * wav->block_align)) != RIFF_ERROR_NONE)
+		return 0;
+	return riff_readInChunk(rh, buf, count * wav->block_align) / wav->block_align;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_wavReadRegions(riff_handle *rh, const riff_wav *wav, struct riff_wavRegion *regions, size_t count){
+	if(rh == NULL  ||  wav == NULL  ||  regions == NULL)
+		return 0;
+
+	//file order, in the given order if the order can't be allocated
+	struct riff_wavRegion **order = mem_alloc(&rh->alloc, count * sizeof(struct riff_wavRegion *));
+	size_t i, total = 0;
+	if(order != NULL){
+		for(i = 0; i < count; i++)
+			order[i] = regions + i;
+		qsort(order, count, sizeof(struct riff_wavRegion *), &compareRegions);
+	}
+
+	for(i = 0; i < count; i++){
+		struct riff_wavRegion *rg = (order != NULL) ? order[i] : regions + i;
+		rg->read = riff_wavReadFrames(rh, wav, rg->start, rg->count, rg->buf);
+		total += rg->read;
+	}
+	mem_free(&rh->alloc, order);
+	return total;
+}
@@ -0,0 +1,224 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Sample frame access to WAVE files (also BW64/RF64).
+Works on an opened riff_handle, the format and data position are found in one scan of the top level chunks.
+
+
+Usage:
+Open the file with the usual riff_handle functions
+Call riff_wavOpen() to find the "fmt " and "data" chunks, the format is cached in a riff_wav struct
+Call riff_wavReadFrames() to read sample frames at any position, seeking is constant time
+Call riff_wavReadRegions() to read several ranges of frames at once, e.g. for waveform previews
+Call riff_wavReadConverted() to read frames as float or int16 samples, interleaved or planar
+  riff_wavConvert() does the same for raw frames already in memory
+  8/16/24/32 bit integer and 32/64 bit float PCM is converted with SIMD kernels where available (SSE2, AVX2, NEON)
+*/
+
+#ifndef _RIFF_WAV_H_
+#define _RIFF_WAV_H_
+
+#include "riff.h"
+
+/**
+ * @defgroup WAV_formats WAVE format tags
+ * @{
+ */
+/**
+ * @brief Integer PCM.
+ */
+#define RIFF_WAV_FORMAT_PCM		0x0001
+/**
+ * @brief IEEE floating point.
+ */
+#define RIFF_WAV_FORMAT_FLOAT		0x0003
+/**
+ * @brief Extensible format, the actual format is in the sub format GUID.
+ */
+#define RIFF_WAV_FORMAT_EXTENSIBLE	0xFFFE
+///@}
+
+/**
+ * @defgroup WAV_samples Converted sample types
+ * @{
+ */
+/**
+ * @brief 32 bit float, full scale is -1.0 to 1.0.
+ */
+#define RIFF_WAV_SAMPLE_FLOAT	0
+/**
+ * @brief 16 bit signed integer, wider samples are truncated, float samples rounded and clipped.
+ */
+#define RIFF_WAV_SAMPLE_INT16	1
+///@}
+
+/**
+ * @brief Cached WAVE format and data chunk position.
+ *
+ * Filled by riff_wavOpen().
+ */
+typedef struct riff_wav {
+	/**
+	 * @brief Format tag as stored in the "fmt " chunk.
+	 */
+	uint16_t format_tag;
+	/**
+	 * @brief Actual format tag, from the sub format GUID for ::RIFF_WAV_FORMAT_EXTENSIBLE.
+	 */
+	uint16_t format;
+	/**
+	 * @brief Amount of channels.
+	 */
+	uint16_t channels;
+	/**
+	 * @brief Sample frames per second.
+	 */
+	uint32_t sample_rate;
+	/**
+	 * @brief Bytes per second.
+	 */
+	uint32_t byte_rate;
+	/**
+	 * @brief Bytes per sample frame (all channels).
+	 */
+	uint16_t block_align;
+	/**
+	 * @brief Bits per sample, container size.
+	 */
+	uint16_t bits_per_sample;
+	/**
+	 * @brief Valid bits per sample, same as riff_wav::bits_per_sample if not extensible.
+	 */
+	uint16_t valid_bits;
+	/**
+	 * @brief Speaker position mask of extensible formats, 0 if not given.
+	 */
+	uint32_t channel_mask;
+	/**
+	 * @brief Sub format GUID of extensible formats.
+	 */
+	uint8_t sub_format[16];
+
+	/**
+	 * @brief Absolute position of the "data" chunk.
+	 */
+	size_t data_pos;
+	/**
+	 * @brief Size of the "data" chunk, from the ds64 chunk for 64 bit files.
+	 */
+	uint64_t data_size;
+	/**
+	 * @brief Amount of complete sample frames in the "data" chunk.
+	 */
+	uint64_t frames;
+} riff_wav;
+
+/**
+ * @brief Region of sample frames to read with riff_wavReadRegions().
+ */
+struct riff_wavRegion {
+	/**
+	 * @brief First frame.
+	 */
+	uint64_t start;
+	/**
+	 * @brief Amount of frames.
+	 */
+	size_t count;
+	/**
+	 * @brief Destination, at least `count * block_align` bytes.
+	 */
+	void *buf;
+	/**
+	 * @brief Receives the amount of frames read.
+	 */
+	size_t read;
+};
+
+/**
+ * @defgroup RIFF_C_WAV C WAVE functions
+ * @{
+ */
+/**
+ * @brief Find the "fmt " and "data" chunks of a WAVE file and cache the format.
+ *
+ * Scans the top level chunks once. Afterwards the riff_handle is at the start of the "data" chunk.
+ *
+ * @param rh The riff_handle to use, opened WAVE file.
+ * @param wav The riff_wav to fill.
+ *
+ * @return RIFF error code, ::RIFF_ERROR_ILLID if the file is no (little endian) WAVE file or a chunk is missing.
+ */
+int riff_wavOpen(riff_handle *rh, riff_wav *wav);
+/**
+ * @brief Read sample frames.
+ *
+ * Seeks in the "data" chunk directly, the riff_handle is moved back to it if needed.
+ *
+ * @param rh The riff_handle to use.
+ * @param wav The riff_wav filled by riff_wavOpen().
+ * @param start First frame to read.
+ * @param count Amount of frames to read.
+ * @param buf Destination, at least `count * block_align` bytes.
+ *
+ * @return Amount of frames read, less than count at the end of the data.
+ */
+size_t riff_wavReadFrames(riff_handle *rh, const riff_wav *wav, uint64_t start, size_t count, void *buf);
+/**
+ * @brief Read several regions of sample frames.
+ *
+ * The regions are read in file order, whatever order they are passed in.
+ *
+ * @param rh The riff_handle to use.
+ * @param wav The riff_wav filled by riff_wavOpen().
+ * @param regions The regions to read, riff_wavRegion::read is set for each.
+ * @param count Amount of regions.
+ *
+ * @return Total amount of frames read.
+ */
+size_t riff_wavReadRegions(riff_handle *rh, const riff_wav *wav, struct riff_wavRegion *regions, size_t count);
+/**
+ * @brief Read sample frames converted to float or int16 samples.
+ *
+ * Memory based handles are converted in place, others are read in blocks.
+ * Supported are ::RIFF_WAV_FORMAT_PCM with 8, 16, 24 or 32 bits and ::RIFF_WAV_FORMAT_FLOAT with 32 or 64 bits per sample,
+ *   also as extensible format.
+ *
+ * @param rh The riff_handle to use.
+ * @param wav The riff_wav filled by riff_wavOpen().
+ * @param start First frame to read.
+ * @param count Amount of frames to read.
+ * @param dst Destination, `count * channels` samples.
+ * @param sample Sample type, ::RIFF_WAV_SAMPLE_FLOAT or ::RIFF_WAV_SAMPLE_INT16.
+ * @param planar 0 for interleaved samples, else one plane of `count` samples per channel.
+ *
+ * @return Amount of frames read, 0 if the format is not supported.
+ */
+size_t riff_wavReadConverted(riff_handle *rh, const riff_wav *wav, uint64_t start, size_t count, void *dst, int sample, int planar);
+/**
+ * @brief Convert raw sample frames in memory to float or int16 samples.
+ *
+ * @param wav The riff_wav describing the format.
+ * @param src The raw frames.
+ * @param frames Amount of frames.
+ * @param dst Destination, `frames * channels` samples.
+ * @param sample Sample type, ::RIFF_WAV_SAMPLE_FLOAT or ::RIFF_WAV_SAMPLE_INT16.
+ * @param planar 0 for interleaved samples, else one plane of `frames` samples per channel.
+ *
+ * @return Amount of frames converted, 0 if the format is not supported.
+ */
+size_t riff_wavConvert(const riff_wav *wav, const void *src, size_t frames, void *dst, int sample, int planar);
+/**
+ * @brief Name of the conversion kernels chosen for this CPU.
+ *
+ * @return "avx2", "sse2", "neon" or "scalar".
+ */
+const char *riff_wavConvertImpl();
+
+///@}
+
+#endif // _RIFF_WAV_H_
@@ -0,0 +1,562 @@
+// take care: whenever we call rw->fp_write() or rw->fp_seek()
+//   we must adjust rw->buf_pos
+//   => the output stream is positioned at rw->buf_pos, buffered data follows
+//      (after back-patching it is not, rw->seek_pending is set then and the seek back is done before the next write)
+//   => rw->pos == rw->buf_pos + rw->buf_len
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#elif defined(__unix__)  ||  defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "riff_writer.h"
+#include "riff_internal.h"
+
+
+#define RIFF_WRITER_LEVEL_ALLOC 16  //number of stack elements allocated per step
+
+#define checkValidRiffWriter(rw) if (rw == NULL) return RIFF_ERROR_INVALID_HANDLE
+
+
+
+//*** default access FP setup ***
+
+
+//** FILE **
+
+
+/*****************************************************************************/
+size_t write_file(riff_writer *rw, const void *ptr, size_t size){
+	return fwrite(ptr, 1, size, (FILE*)(rw->fh));
+}
+
+/*****************************************************************************/
+size_t seek_file_writer(riff_writer *rw, size_t pos){
+	fseek((FILE*)(rw->fh), pos, SEEK_SET);
+	return pos;
+}
+
+/*****************************************************************************/
+//pass to OS, to stable storage if durable
+int sync_file(riff_writer *rw, int durable){
+	FILE *f = (FILE*)(rw->fh);
+	if(fflush(f) != 0)
+		return -1;
+	if(!durable)
+		return 0;
+#if defined(_WIN32)
+	return _commit(_fileno(f));
+#elif defined(__unix__)  ||  defined(__APPLE__)
+	return fsync(fileno(f));
+#else
+	return 0; //no portable way
+#endif
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writer_open_file(riff_writer *rw, FILE *f, const char *type){
+	checkValidRiffWriter(rw);
+	rw->fh = f;
+	rw->pos_start = ftell(f); //current file offset of stream considered as start of RIFF file
+
+	rw->fp_write = &write_file;
+	rw->fp_seek = &seek_file_writer;
+	rw->fp_sync = &sync_file;
+
+	return riff_writerBegin(rw, type);
+}
+
+
+
+// **** internal ****
+
+
+
+//ds64 chunk data layout, offsets relative to ds64 chunk data start
+#define DS64_RIFF_SIZE		0
+#define DS64_DATA_SIZE		8
+#define DS64_SAMPLE_COUNT	16
+#define DS64_TABLE_LENGTH	24
+#define DS64_TABLE			28
+#define DS64_TABLE_ENTRY	12	//ID + 64 bit size
+
+
+
+/*****************************************************************************/
+//seek back to the write position if back-patching moved away from it
+void writer_seekBack(riff_writer *rw){
+	if(rw->seek_pending){
+		rw->fp_seek(rw, rw->buf_pos);
+		rw->seek_pending = 0;
+	}
+}
+
+
+/*****************************************************************************/
+//write buffered data to output
+int writer_flush(riff_writer *rw){
+	if(rw->buf_len == 0)
+		return RIFF_ERROR_NONE;
+
+	writer_seekBack(rw);
+	size_t n = rw->fp_write(rw, rw->buf, rw->buf_len);
+	rw->buf_pos += n;
+	if(n != rw->buf_len){
+		if(rw->fp_printf)
+			rw->fp_printf("Write error, %zu of %zu bytes written!\n", n, rw->buf_len);
+		//drop the rest, positions stay consistent with the output
+		rw->buf_len = 0;
+		rw->pos = rw->buf_pos;
+		return RIFF_ERROR_ACCESS;
+	}
+	rw->buf_len = 0;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//overwrite already written bytes at absolute position "at"
+//in the buffer if possible, else seek there, seeking back is deferred until the next write
+int writer_patch(riff_writer *rw, size_t at, const void *ptr, size_t size){
+	if(at >= rw->buf_pos  &&  at + size <= rw->buf_pos + rw->buf_len){
+		memcpy(rw->buf + (at - rw->buf_pos), ptr, size);
+		return RIFF_ERROR_NONE;
+	}
+
+	int r = writer_flush(rw);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+
+	rw->fp_seek(rw, at);
+	rw->seek_pending = 1;
+	size_t n = rw->fp_write(rw, ptr, size);
+	if(n != size){
+		if(rw->fp_printf)
+			rw->fp_printf("Failed to write chunk size at pos %zu!\n", at);
+		return RIFF_ERROR_ACCESS;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//push to chunk stack and write chunk header with given or placeholder size
+//type is NULL for chunks without subchunks
+int writer_push(riff_writer *rw, const char *id, const char *type, size_t size){
+	if(!isValidID(id)  ||  (type != NULL  &&  !isValidID(type))){
+		if(rw->fp_printf)
+			rw->fp_printf("Invalid chunk ID (FOURCC) at file pos %zu\n", rw->pos);
+		return RIFF_ERROR_ILLID;
+	}
+
+	//need to enlarge stack?
+	if(rw->ls_size < (size_t)rw->ls_level + 1){
+		size_t ls_size_new = rw->ls_size * 2; //double size
+		if(ls_size_new == 0)
+			ls_size_new = RIFF_WRITER_LEVEL_ALLOC; //default stack allocation
+
+		struct riff_writerStackE *lsnew = mem_realloc(&rw->alloc, rw->ls, ls_size_new * sizeof(struct riff_writerStackE));
+		if(lsnew == NULL){
+			if(rw->fp_printf)
+				rw->fp_printf("Failed to allocate chunk stack\n");
+			return RIFF_ERROR_MEMORY;
+		}
+		rw->ls_size = ls_size_new;
+		rw->ls = lsnew;
+	}
+
+	struct riff_writerStackE *ls = rw->ls + rw->ls_level;
+	memset(ls, 0, sizeof(struct riff_writerStackE));
+	ls->c_pos_start = rw->pos;
+	memcpy(ls->c_id, id, 4);
+	if(type != NULL)
+		memcpy(ls->c_type, type, 4);
+	ls->c_size = (size <= 0xFFFFFFFF) ? size : RIFF_WRITER_SIZE_UNKNOWN;
+	rw->ls_level++;
+
+	uint8_t hdr[RIFF_HEADER_SIZE];
+	memcpy(hdr, id, 4);
+	//placeholder if not known, written by riff_writerEnd()
+	writeUInt32LE(hdr + 4, (ls->c_size != RIFF_WRITER_SIZE_UNKNOWN) ? (uint32_t)ls->c_size : 0);
+	if(type != NULL)
+		memcpy(hdr + 8, type, 4);
+	size_t hdrsize = (type != NULL) ? RIFF_HEADER_SIZE : RIFF_CHUNK_DATA_OFFSET;
+
+	if(riff_writerWrite(rw, hdr, hdrsize) != hdrsize)
+		return RIFF_ERROR_ACCESS;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//turn the RIFF file into a 64 bit one: header ID and reserved JUNK chunk -> ds64 chunk
+//in place, nothing is moved
+int writer_promote(riff_writer *rw){
+	if(rw->ds64_pos == 0){
+		if(rw->fp_printf)
+			rw->fp_printf("RIFF file or chunk exceeds 4 GB and no ds64 chunk was reserved!\n");
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	int r;
+	uint8_t buf[4];
+	if((r = writer_patch(rw, rw->pos_start, rw->ds64_id, 4)) != RIFF_ERROR_NONE)
+		return r;
+	if((r = writer_patch(rw, rw->ds64_pos, "ds64", 4)) != RIFF_ERROR_NONE)
+		return r;
+	writeUInt32LE(buf, 0); //empty table
+	if((r = writer_patch(rw, rw->ds64_pos + RIFF_CHUNK_DATA_OFFSET + DS64_TABLE_LENGTH, buf, 4)) != RIFF_ERROR_NONE)
+		return r;
+	rw->ds64_promoted = 1;
+	return RIFF_ERROR_NONE;
+}
+
+
+/*****************************************************************************/
+//write size field of open chunk ls[i]
+//sizes that don't fit into 32 bit go to the ds64 chunk, the file is promoted if needed
+int writer_size(riff_writer *rw, int i, uint64_t size){
+	struct riff_writerStackE *ls = rw->ls + i;
+	uint8_t buf[8];
+	int r;
+
+	if(size <= 0xFFFFFFFF  &&  !(i == 0  &&  rw->ds64_promoted)){
+		writeUInt32LE(buf, (uint32_t)size);
+		return writer_patch(rw, ls->c_pos_start + 4, buf, 4);
+	}
+
+	if(!rw->ds64_promoted  &&  (r = writer_promote(rw)) != RIFF_ERROR_NONE)
+		return r;
+
+	size_t ds64 = rw->ds64_pos + RIFF_CHUNK_DATA_OFFSET;
+	size_t at;
+	if(i == 0){
+		//RIFF size and sample count
+		at = ds64 + DS64_RIFF_SIZE;
+		writeUInt64LE(buf, rw->ds64_samples);
+		if((r = writer_patch(rw, ds64 + DS64_SAMPLE_COUNT, buf, 8)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	else if(memcmp(ls->c_id, "data", 4) == 0  &&  (rw->ds64_data == 0  ||  rw->ds64_data == ls->c_pos_start)){
+		at = ds64 + DS64_DATA_SIZE;
+		rw->ds64_data = ls->c_pos_start;
+	}
+	else {
+		//table entry of this chunk, new one if there is none yet
+		int e;
+		for(e = 0; e < rw->ds64_table_len; e++){
+			if(rw->ds64_table[e] == ls->c_pos_start)
+				break;
+		}
+		if(e == rw->ds64_table_len){
+			if(e >= rw->ds64_table_size){
+				if(rw->fp_printf)
+					rw->fp_printf("Chunk \"%s\" at pos %zu exceeds 4 GB and the ds64 table is full!\n", ls->c_id, ls->c_pos_start);
+				return RIFF_ERROR_ICSIZE;
+			}
+			rw->ds64_table[e] = ls->c_pos_start;
+			rw->ds64_table_len++;
+			if((r = writer_patch(rw, ds64 + DS64_TABLE + e * DS64_TABLE_ENTRY, ls->c_id, 4)) != RIFF_ERROR_NONE)
+				return r;
+			writeUInt32LE(buf, rw->ds64_table_len);
+			if((r = writer_patch(rw, ds64 + DS64_TABLE_LENGTH, buf, 4)) != RIFF_ERROR_NONE)
+				return r;
+		}
+		at = ds64 + DS64_TABLE + e * DS64_TABLE_ENTRY + 4;
+	}
+
+	writeUInt64LE(buf, size);
+	if((r = writer_patch(rw, at, buf, 8)) != RIFF_ERROR_NONE)
+		return r;
+	writeUInt32LE(buf, 0xFFFFFFFF); //real size is in ds64 chunk
+	return writer_patch(rw, ls->c_pos_start + 4, buf, 4);
+}
+
+
+/*****************************************************************************/
+//begin chunk or chunk list inside of the innermost open chunk list
+int writer_begin(riff_writer *rw, const char *id, const char *type, size_t size){
+	checkValidRiffWriter(rw);
+
+	//only chunk lists can contain subchunks
+	if(rw->ls_level <= 0  ||  rw->ls[rw->ls_level - 1].c_type[0] == '\0'){
+		if(rw->fp_printf)
+			rw->fp_printf("Can't begin chunk at pos %zu, only RIFF or LIST chunk can contain subchunks\n", rw->pos);
+		return RIFF_ERROR_ILLID;
+	}
+	return writer_push(rw, id, type, size);
+}
+
+
+
+//**** user access ****
+
+
+/*****************************************************************************/
+//description: see header file
+riff_writer *riff_writerAllocate(){
+	riff_writer *rw = mem_calloc(&alloc_global, 1, sizeof(riff_writer));
+	if(rw != NULL){
+		rw->buf_size = RIFF_WRITER_BUFFER_SIZE;
+		rw->fp_printf = riff_printf;
+		rw->alloc = alloc_global;
+	}
+	return rw;
+}
+
+/*****************************************************************************/
+//description: see header file
+//Deallocate riff_writer, buffer and stack, output is not closed
+void riff_writerFree(riff_writer *rw){
+	if(rw == NULL)
+		return;
+	riff_allocator alloc = rw->alloc;
+	mem_free(&alloc, rw->buf);
+	mem_free(&alloc, rw->ls);
+	mem_free(&alloc, rw);
+}
+
+/*****************************************************************************/
+//description: see header file
+//shall be called only once by the open-function
+int riff_writerBegin(riff_writer *rw, const char *type){
+	checkValidRiffWriter(rw);
+
+	if(rw->fp_write == NULL  ||  rw->fp_seek == NULL) {
+		if(rw->fp_printf)
+			rw->fp_printf("I/O function pointer not set\n"); //fatal user error
+		return RIFF_ERROR_INVALID_HANDLE;
+	}
+
+	rw->pos = rw->pos_start;
+	rw->buf_pos = rw->pos_start;
+	rw->buf_len = 0;
+	rw->ls_level = 0;
+	rw->commit_pos = rw->pos_start;
+	rw->commit_error = RIFF_ERROR_NONE;
+
+	return writer_push(rw, "RIFF", type, RIFF_WRITER_SIZE_UNKNOWN);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerReserveDs64(riff_writer *rw, const char *id, int table_entries){
+	checkValidRiffWriter(rw);
+
+	if(memcmp(id, "BW64", 4) != 0  &&  memcmp(id, "RF64", 4) != 0){
+		if(rw->fp_printf)
+			rw->fp_printf("Invalid 64 bit RIFF header ID, must be BW64 or RF64\n");
+		return RIFF_ERROR_ILLID;
+	}
+	//must be the first chunk of the file
+	if(rw->ls_level != 1  ||  rw->pos != rw->pos_start + RIFF_HEADER_SIZE){
+		if(rw->fp_printf)
+			rw->fp_printf("ds64 chunk must be reserved right after opening\n");
+		return RIFF_ERROR_ILLID;
+	}
+	if(table_entries < 0  ||  table_entries > RIFF_WRITER_DS64_TABLE_MAX){
+		if(rw->fp_printf)
+			rw->fp_printf("ds64 table can have at most %d entries\n", RIFF_WRITER_DS64_TABLE_MAX);
+		return RIFF_ERROR_ICSIZE;
+	}
+
+	size_t pos = rw->pos;
+	uint8_t zero[DS64_TABLE + RIFF_WRITER_DS64_TABLE_MAX * DS64_TABLE_ENTRY] = {0};
+	int r = riff_writerWriteChunk(rw, "JUNK", zero, DS64_TABLE + table_entries * DS64_TABLE_ENTRY);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+
+	memcpy(rw->ds64_id, id, 4);
+	rw->ds64_pos = pos;
+	rw->ds64_table_size = table_entries;
+	rw->ds64_table_len = 0;
+	rw->ds64_data = 0;
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerBeginChunk(riff_writer *rw, const char *id){
+	return writer_begin(rw, id, NULL, RIFF_WRITER_SIZE_UNKNOWN);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerBeginChunkSized(riff_writer *rw, const char *id, size_t size){
+	return writer_begin(rw, id, NULL, size);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerBeginList(riff_writer *rw, const char *type){
+	return writer_begin(rw, "LIST", type, RIFF_WRITER_SIZE_UNKNOWN);
+}
+
+/*****************************************************************************/
+//small writes are collected in the buffer, large ones are passed through
+size_t writer_write(riff_writer *rw, const void *ptr, size_t size){
+	//allocate buffer on first write, unbuffered if allocation fails
+	if(rw->buf == NULL  &&  rw->buf_size > 0){
+		rw->buf = mem_alloc(&rw->alloc, rw->buf_size);
+		if(rw->buf == NULL)
+			rw->buf_size = 0;
+	}
+
+	if(rw->buf_len + size <= rw->buf_size){
+		memcpy(rw->buf + rw->buf_len, ptr, size);
+		rw->buf_len += size;
+		rw->pos += size;
+		return size;
+	}
+
+	if(writer_flush(rw) != RIFF_ERROR_NONE)
+		return 0;
+
+	if(size < rw->buf_size){
+		memcpy(rw->buf, ptr, size);
+		rw->buf_len = size;
+		rw->pos += size;
+		return size;
+	}
+
+	writer_seekBack(rw);
+	size_t n = rw->fp_write(rw, ptr, size);
+	rw->buf_pos += n;
+	rw->pos += n;
+	return n;
+}
+
+/*****************************************************************************/
+//description: see header file
+size_t riff_writerWrite(riff_writer *rw, const void *ptr, size_t size){
+	if(rw == NULL)
+		return 0;
+
+	size_t n = writer_write(rw, ptr, size);
+
+	//batched commit of the sizes written so far, stops after the first failure
+	//the data is accepted either way, the error is reported by commit, end and close
+	if(rw->commit_interval > 0  &&  rw->commit_error == RIFF_ERROR_NONE  &&  rw->pos - rw->commit_pos >= rw->commit_interval)
+		rw->commit_error = riff_writerCommit(rw);
+	return n;
+}
+
+/*****************************************************************************/
+//end innermost chunk, without the sticky commit error
+int writer_end(riff_writer *rw){
+	if(rw->ls_level <= 0)
+		return -1;  //not critical error, same as riff_levelParent()
+
+	struct riff_writerStackE *ls = rw->ls + rw->ls_level - 1;
+	size_t size = rw->pos - ls->c_pos_start - RIFF_CHUNK_DATA_OFFSET;
+	//size written with the header is still valid if it matches and no commit overwrote it since
+	if(size != ls->c_size  ||  rw->commit_pos > ls->c_pos_start){
+		int r = writer_size(rw, rw->ls_level - 1, size);
+		if(r != RIFF_ERROR_NONE)
+			return r;
+	}
+	rw->ls_level--;
+
+	//pad byte if size is odd
+	if(size & 0x1){
+		uint8_t pad = 0;
+		if(riff_writerWrite(rw, &pad, 1) != 1)
+			return RIFF_ERROR_ACCESS;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerEnd(riff_writer *rw){
+	checkValidRiffWriter(rw);
+	int r = writer_end(rw);
+	return (r != RIFF_ERROR_NONE) ? r : rw->commit_error;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerWriteChunk(riff_writer *rw, const char *id, const void *ptr, size_t size){
+	int r;
+	if((r = riff_writerBeginChunkSized(rw, id, size)) != RIFF_ERROR_NONE)
+		return r;
+	if(riff_writerWrite(rw, ptr, size) != size)
+		return RIFF_ERROR_ACCESS;
+	return riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerFlush(riff_writer *rw){
+	checkValidRiffWriter(rw);
+	return writer_flush(rw);
+}
+
+/*****************************************************************************/
+//description: see header file
+//order: data -> (sync) -> sizes -> (sync), so committed sizes never cover unwritten data with RIFF_WRITER_SYNC_FULL
+int riff_writerCommit(riff_writer *rw){
+	checkValidRiffWriter(rw);
+
+	if(rw->ls_level <= 0)
+		return RIFF_ERROR_NONE;
+
+	//committed end, the innermost chunk is cut to an even size since its pad byte can't be written yet
+	struct riff_writerStackE *ls = rw->ls + rw->ls_level - 1;
+	size_t end = rw->pos - ((rw->pos - ls->c_pos_start - RIFF_CHUNK_DATA_OFFSET) & 0x1);
+
+	int r = writer_flush(rw);
+	if(r != RIFF_ERROR_NONE)
+		return r;
+	if(rw->fp_sync != NULL  &&  rw->fp_sync(rw, rw->commit_sync >= RIFF_WRITER_SYNC_FULL) != 0)
+		return RIFF_ERROR_ACCESS;
+
+	//size fields from outer to inner chunk, forward in the file, one seek back at the next write
+	int i;
+	for(i = 0; i < rw->ls_level; i++){
+		if((r = writer_size(rw, i, end - rw->ls[i].c_pos_start - RIFF_CHUNK_DATA_OFFSET)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	if(rw->fp_sync != NULL  &&  rw->fp_sync(rw, rw->commit_sync >= RIFF_WRITER_SYNC_HEADER) != 0)
+		return RIFF_ERROR_ACCESS;
+
+	rw->commit_pos = end;
+	rw->commit_count++;
+	rw->commit_bytes += (size_t)rw->ls_level * 4;
+	return rw->commit_error;
+}
+
+/*****************************************************************************/
+//description: see header file
+void riff_writerSetCommitPolicy(riff_writer *rw, size_t interval, int sync){
+	if(rw == NULL)
+		return;
+	rw->commit_interval = interval;
+	rw->commit_sync = sync;
+}
+
+/*****************************************************************************/
+//description: see header file
+int riff_writerClose(riff_writer *rw){
+	checkValidRiffWriter(rw);
+
+	int r;
+	while(rw->ls_level > 0){
+		if((r = writer_end(rw)) != RIFF_ERROR_NONE)
+			return r;
+	}
+	if((r = writer_flush(rw)) != RIFF_ERROR_NONE)
+		return r;
+	writer_seekBack(rw); //leave the output at the end of the RIFF file
+	rw->commit_pos = rw->pos;
+	if(rw->fp_sync != NULL  &&  rw->fp_sync(rw, rw->commit_sync >= RIFF_WRITER_SYNC_HEADER) != 0)
+		return RIFF_ERROR_ACCESS;
+	return rw->commit_error;
+}
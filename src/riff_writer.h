@@ -0,0 +1,527 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+To write any RIFF files.
+Counterpart of the reader in riff.h, output goes through user defined function pointers.
+
+
+Usage:
+Use a default open-function (file) or create your own
+  The required function pointers for writing and seeking are set here
+  The RIFF header is written by the open-function, chunk sizes are written once known
+Call riff_writerBeginChunk() / riff_writerBeginList() to start a chunk or a chunk list
+ Write data of unknown length with riff_writerWrite()
+ Call riff_writerEnd() to end the chunk, the size field is back-patched and the pad byte is written
+Call riff_writerClose() to end all open chunks and the RIFF file
+*/
+
+#ifndef _RIFF_WRITER_H_
+#define _RIFF_WRITER_H_
+
+#include "riff.h"
+
+/**
+ * @brief Default size of the write buffer in bytes.
+ *
+ * Writes smaller than this are collected and written in one go.
+ */
+#define RIFF_WRITER_BUFFER_SIZE	65536
+
+/**
+ * @brief Maximum amount of ds64 table entries, see riff_writerReserveDs64().
+ */
+#define RIFF_WRITER_DS64_TABLE_MAX	8
+
+/**
+ * @name Commit sync policies
+ *
+ * How riff_writerCommit() makes sure data reaches the storage, see riff_writerSetCommitPolicy().
+ * @{
+ */
+/**
+ * @brief Only hand data and sizes to the OS.
+ *
+ * The file survives a crash of the process, but not of the system.
+ */
+#define RIFF_WRITER_SYNC_NONE	0
+/**
+ * @brief Sync to stable storage after the sizes are written.
+ */
+#define RIFF_WRITER_SYNC_HEADER	1
+/**
+ * @brief Sync to stable storage before and after the sizes are written.
+ *
+ * Committed sizes never cover data that is not on stable storage yet.
+ */
+#define RIFF_WRITER_SYNC_FULL	2
+///@}
+
+/**
+ * @brief Chunk size not known when the chunk is begun, it is back-patched by riff_writerEnd().
+ */
+#define RIFF_WRITER_SIZE_UNKNOWN	((size_t)-1)
+
+/**
+ * @brief Writer stack entry struct.
+ *
+ * Contains header info of a chunk that was started but not ended yet.
+ */
+struct riff_writerStackE {
+	/**
+	 * @brief Absolute chunk position in file stream.
+	 */
+	size_t c_pos_start;
+	/**
+	 * @brief ID of chunk.
+	 */
+	char c_id[5];
+	/**
+	 * @brief Type ID of chunk list.
+	 *
+	 * Empty string if the chunk does not contain subchunks.
+	 */
+	char c_type[5];
+	/**
+	 * @brief Chunk data size written with the header.
+	 *
+	 * ::RIFF_WRITER_SIZE_UNKNOWN if a placeholder was written.
+	 */
+	size_t c_size;
+};
+
+/**
+ * @defgroup riff_writer The RIFF writer
+ * @{
+ */
+/**
+ * @brief The RIFF writer.
+ *
+ * Members are public and intended for read access.
+ *
+ * The writer keeps a stack of open chunks (the RIFF chunk at the bottom), their size fields are written when they are ended.
+ */
+typedef struct riff_writer {
+	/**
+	 * @brief Start position of RIFF file.
+	 */
+	size_t pos_start;
+	/**
+	 * @brief Current position in data stream.
+	 *
+	 * Includes data which is still buffered.
+	 */
+	size_t pos;
+
+	/**
+	 * @name Write buffer.
+	 */
+	///@{
+	/**
+	 * @brief Buffered data, written at riff_writer::buf_pos.
+	 */
+	uint8_t *buf;
+	/**
+	 * @brief Capacity of riff_writer::buf.
+	 *
+	 * Can be changed right after allocation, before any other `riff_writer...()` functions, defaults to ::RIFF_WRITER_BUFFER_SIZE.
+	 */
+	size_t buf_size;
+	/**
+	 * @brief Amount of buffered bytes.
+	 */
+	size_t buf_len;
+	/**
+	 * @brief Stream position of the first buffered byte.
+	 */
+	size_t buf_pos;
+	///@}
+
+	/**
+	 * @name Chunk stack data.
+	 */
+	///@{
+	/**
+	 * @brief Stack of open chunks.
+	 *
+	 * `ls[0]` is the RIFF chunk, `ls[ls_level-1]` is the innermost open chunk.
+	 */
+	struct riff_writerStackE *ls;
+	/**
+	 * @brief Size of stack in entries.
+	 */
+	size_t ls_size;
+	/**
+	 * @brief Amount of open chunks.
+	 *
+	 * 0 after riff_writerClose().
+	 */
+	int ls_level;
+	///@}
+
+	/**
+	 * @name Commit data.
+	 *
+	 * See riff_writerCommit().
+	 */
+	///@{
+	/**
+	 * @brief Commit automatically after this many bytes, 0 to disable.
+	 */
+	size_t commit_interval;
+	/**
+	 * @brief Sync policy of commits, one of the `RIFF_WRITER_SYNC_...` values.
+	 */
+	int commit_sync;
+	/**
+	 * @brief End of the committed data.
+	 *
+	 * The file is parseable up to this position.
+	 */
+	size_t commit_pos;
+	/**
+	 * @brief Amount of commits so far.
+	 */
+	size_t commit_count;
+	/**
+	 * @brief Extra bytes written by commits so far.
+	 *
+	 * Each commit writes 4 bytes per open chunk.
+	 */
+	size_t commit_bytes;
+	/**
+	 * @brief First error of an automatic commit, ::RIFF_ERROR_NONE if none failed.
+	 *
+	 * Sticky: no further automatic commits are made, riff_writerCommit(), riff_writerEnd() and riff_writerClose() return it from then on.
+	 */
+	int commit_error;
+	///@}
+
+	/**
+	 * @name 64 bit size data.
+	 *
+	 * See riff_writerReserveDs64().
+	 */
+	///@{
+	/**
+	 * @brief Position of the reserved JUNK / ds64 chunk, 0 if none was reserved.
+	 */
+	size_t ds64_pos;
+	/**
+	 * @brief Header ID used once the file exceeds 4 GB, `"BW64"` or `"RF64"`.
+	 */
+	char ds64_id[5];
+	/**
+	 * @brief 1 if the file has been turned into a 64 bit one.
+	 */
+	int ds64_promoted;
+	/**
+	 * @brief Sample count written to the ds64 chunk.
+	 *
+	 * Can be set by the user any time before riff_writerClose().
+	 */
+	uint64_t ds64_samples;
+	/**
+	 * @brief Position of the "data" chunk whose size is stored in the ds64 chunk, 0 if none.
+	 */
+	size_t ds64_data;
+	/**
+	 * @brief Positions of the chunks whose sizes are stored in the ds64 table.
+	 */
+	size_t ds64_table[RIFF_WRITER_DS64_TABLE_MAX];
+	/**
+	 * @brief Reserved ds64 table entries.
+	 */
+	int ds64_table_size;
+	/**
+	 * @brief Used ds64 table entries.
+	 */
+	int ds64_table_len;
+	///@}
+
+	/**
+	 * @brief 1 if the output is not positioned at riff_writer::buf_pos after back-patching.
+	 *
+	 * The position is restored before the next write.
+	 */
+	int seek_pending;
+
+	/**
+	 * @brief Data access handle.
+	 *
+	 * Only accessed by user FP functions.
+	 */
+	void *fh;
+
+	/**
+	 * @name Internal functions
+	 *
+	 * Function pointers for e.g. defining your own output methods
+	 */
+	///@{
+	/**
+	 * @brief Write bytes.
+	 *
+	 * @return Amount of successfully written bytes.
+	 *
+	 * @note Required for proper operation.
+	 */
+	size_t (*fp_write)(struct riff_writer *rw, const void *ptr, size_t size);
+	/**
+	 * @brief Seek to absolute position in the output.
+	 *
+	 * Positions include riff_writer::pos_start.
+	 * Required to back-patch size fields that are not buffered anymore.
+	 *
+	 * @note Required for proper operation.
+	 */
+	size_t (*fp_seek)(struct riff_writer *rw, size_t pos);
+	/**
+	 * @brief Pass written data to the OS, or to stable storage if durable is set.
+	 *
+	 * @return 0 on success.
+	 *
+	 * @note Optional, only used by commits and riff_writerClose().
+	 */
+	int (*fp_sync)(struct riff_writer *rw, int durable);
+	/**
+	 * @brief Print error.
+	 *
+	 * Same as riff_handle::fp_printf.
+	 */
+	int (*fp_printf)(const char * format, ... );
+	///@}
+
+	/**
+	 * @brief Allocator of the writer, its buffer and chunk stack, the global one when allocated.
+	 *
+	 * Must not be modified, the writer itself is freed with it.
+	 */
+	riff_allocator alloc;
+} riff_writer;
+
+///@}
+
+/**
+ * @defgroup RIFF_C_Writer C RIFF writer functions
+ * @{
+ */
+/**
+ * @name riff_writer allocation/deallocation functions
+ * @{
+ */
+/**
+ * @brief Allocate, initialize and return a riff_writer.
+ *
+ * @return Pointer to the intialized riff_writer.
+ */
+riff_writer *riff_writerAllocate();
+/**
+ * @brief Free the memory allocated to a riff_writer.
+ *
+ * @note Does not close the RIFF file, call riff_writerClose() first.
+ *
+ * @param rw The riff_writer to free.
+ */
+void riff_writerFree(riff_writer *rw);
+
+///@}
+
+/**
+ * @name Writing functions
+ * @{
+ */
+/**
+ * @brief Reserve space for 64 bit sizes.
+ *
+ * Writes a "JUNK" chunk large enough to hold a ds64 chunk. The file stays a plain RIFF file as long as it is smaller than 4 GB.
+ *
+ * Once the file or one of its chunks exceeds 4 GB, the header ID is changed to @p id and the JUNK chunk is turned into the ds64 chunk in place, the file is never copied:
+ * - The RIFF size goes to the ds64 chunk
+ * - The size of the "data" chunk goes to the ds64 chunk
+ * - Sizes of other chunks go to the ds64 table, which can hold @p table_entries chunks
+ *
+ * Their 32 bit size fields are set to `0xFFFFFFFF`.
+ *
+ * @note Must be called right after opening, before any chunk is written.
+ *
+ * @param rw The riff_writer to use.
+ * @param id The header ID of a 64 bit file, `"BW64"` or `"RF64"`.
+ * @param table_entries Amount of ds64 table entries to reserve, at most ::RIFF_WRITER_DS64_TABLE_MAX.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerReserveDs64(riff_writer *rw, const char *id, int table_entries);
+/**
+ * @brief Begin a chunk inside of the current chunk list.
+ *
+ * Writes the chunk header with a placeholder size.
+ *
+ * @param rw The riff_writer to use.
+ * @param id The chunk ID (4 bytes).
+ *
+ * @return RIFF error code.
+ */
+int riff_writerBeginChunk(riff_writer *rw, const char *id);
+/**
+ * @brief Begin a chunk of known size inside of the current chunk list.
+ *
+ * The size is written with the chunk header, riff_writerEnd() does not need to seek back if the written data matches it.
+ * It is corrected if it does not.
+ *
+ * @param rw The riff_writer to use.
+ * @param id The chunk ID (4 bytes).
+ * @param size The chunk data size, must fit into 32 bit.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerBeginChunkSized(riff_writer *rw, const char *id, size_t size);
+/**
+ * @brief Begin a "LIST" chunk inside of the current chunk list.
+ *
+ * Following chunks are written into the new list until it is ended.
+ *
+ * @param rw The riff_writer to use.
+ * @param type The list type ID (4 bytes).
+ *
+ * @return RIFF error code.
+ */
+int riff_writerBeginList(riff_writer *rw, const char *type);
+/**
+ * @brief Write data to the current chunk.
+ *
+ * Small writes are buffered, the data size does not need to be known in advance.
+ *
+ * @param rw The riff_writer to use.
+ * @param ptr The data to write.
+ * @param size The amount of data to write.
+ *
+ * @note A failed automatic commit does not change the returned count, the data was written; it is kept in riff_writer::commit_error.
+ *
+ * @return Amount of successfully written bytes.
+ */
+size_t riff_writerWrite(riff_writer *rw, const void *ptr, size_t size);
+/**
+ * @brief End the innermost open chunk or chunk list.
+ *
+ * Writes the size field of the chunk and the pad byte if the size is odd.
+ *
+ * @param rw The riff_writer to use.
+ *
+ * @return RIFF error code, riff_writer::commit_error if an automatic commit failed before.
+ */
+int riff_writerEnd(riff_writer *rw);
+/**
+ * @brief Write a complete chunk.
+ *
+ * @param rw The riff_writer to use.
+ * @param id The chunk ID (4 bytes).
+ * @param ptr The chunk data.
+ * @param size The chunk data size.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerWriteChunk(riff_writer *rw, const char *id, const void *ptr, size_t size);
+/**
+ * @brief Write all buffered data to the output.
+ *
+ * @param rw The riff_writer to use.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerFlush(riff_writer *rw);
+/**
+ * @brief Commit the sizes of all open chunks.
+ *
+ * Writes the size fields of all open chunks as if they were ended at the current position, so the file can be opened with riff_open_file() up to here even if the process dies afterwards.
+ *
+ * The innermost chunk is committed with an even size (the last byte is left out if needed), since its pad byte is not written yet.
+ *
+ * Costs one flush, 4 bytes per open chunk and the syncs required by riff_writer::commit_sync.
+ * Returns riff_writer::commit_error after a successful commit if an automatic commit failed before.
+ *
+ * @note A file opened after a crash may contain data behind the committed RIFF size, riff_open_file() reports ::RIFF_ERROR_EXDAT for it if the exact file size is passed.
+ *
+ * @param rw The riff_writer to use.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerCommit(riff_writer *rw);
+/**
+ * @brief Set up automatic commits for recording growing files.
+ *
+ * riff_writerWrite() commits whenever at least @p interval bytes were written since the last commit, so the overhead is bounded by 4 bytes per open chunk and @p interval bytes.
+ * The first failed commit is kept in riff_writer::commit_error, it stops automatic commits and is returned by riff_writerCommit(), riff_writerEnd() and riff_writerClose().
+ *
+ * @param rw The riff_writer to use.
+ * @param interval Commit after this many bytes, 0 to disable automatic commits.
+ * @param sync Sync policy, one of the `RIFF_WRITER_SYNC_...` values.
+ */
+void riff_writerSetCommitPolicy(riff_writer *rw, size_t interval, int sync);
+/**
+ * @brief End all open chunks and the RIFF file.
+ *
+ * Returns riff_writer::commit_error even if closing succeeds, since the file may not have been recoverable at all times.
+ *
+ * @note Does not close the output, since it was opened by the user.
+ *
+ * @param rw The riff_writer to use.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerClose(riff_writer *rw);
+
+///@}
+
+/**
+ * @name I/O Init functions
+ *
+ * To be used in your user-made open functions
+ *
+ * @{
+ */
+/**
+ * @brief Write RIFF file header.
+ *
+ * To be called from user I/O functions after the function pointers are set.
+ *
+ * @param rw The riff_writer to use.
+ * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+ *
+ * @return RIFF error code.
+ */
+int riff_writerBegin(riff_writer *rw, const char *type);
+
+///@}
+
+/**
+ * @name RIFF writer open functions
+ *
+ * Use the following built in open-functions or make your own.
+ *
+ * Only pass a fresh allocated writer.
+ *
+ * @{
+ */
+/**
+ * @brief Initialize RIFF writer, set up FPs for C FILE access and write the RIFF header.
+ *
+ * @note File position must be at the start of the RIFF data (it can be nested in another file), the file must be opened for writing in binary mode.
+ * @note Since the file was opened by the user, it must be closed by the user.
+ *
+ * @param rw The riff_writer to initialize.
+ * @param f The FILE pointer to write to.
+ * @param type The form type ID of the file (4 bytes), e.g. `"WAVE"`.
+ *
+ * @return RIFF error code.
+ */
+int riff_writer_open_file(riff_writer *rw, FILE *f, const char *type);
+
+///@}
+
+///@}
+
+#endif // _RIFF_WRITER_H_
@@ -0,0 +1,70 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Timing helpers shared by the benchmarks.
+A benchmark is a program that prints one line per measurement, see RIFF_BENCHMARKS in CMakeLists.txt and the "bench" target of the makefile.
+Results only mean something for optimized builds, e.g. CMAKE_BUILD_TYPE=Release.
+*/
+
+#ifndef _RIFF_BENCH_H_
+#define _RIFF_BENCH_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "riff_writer.h"
+
+#define BENCH_MB (1024.0 * 1024.0)
+
+//seconds from an arbitrary starting point, only differences are used
+static inline double bench_now(void){
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+//print amount per second of one measurement, e.g. MB or files
+static inline void bench_report(const char *name, double amount, const char *unit, double seconds){
+	if(seconds <= 0)
+		seconds = 1e-9;
+	printf("%-44s %12.1f %s/s  (%.3f s)\n", name, amount / seconds, unit, seconds);
+}
+
+//file of form type "type" written by fp_write, read back into memory, free with free()
+//fp_write gets the open writer and returns a RIFF error code
+//returns NULL on failure, the size via size
+static inline uint8_t *bench_makeFile(const char *type, int (*fp_write)(riff_writer *rw, void *user), void *user, size_t *size){
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	int r = (f != NULL  &&  rw != NULL) ? riff_writer_open_file(rw, f, type) : RIFF_ERROR_MEMORY;
+	if(r == RIFF_ERROR_NONE)
+		r = fp_write(rw, user);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerClose(rw);
+	riff_writerFree(rw);
+
+	uint8_t *mem = NULL;
+	long n = (f != NULL) ? ftell(f) : 0;
+	if(r == RIFF_ERROR_NONE  &&  n > 0  &&  (mem = (uint8_t *)malloc((size_t)n)) != NULL){
+		fseek(f, 0, SEEK_SET);
+		if(fread(mem, 1, (size_t)n, f) != (size_t)n){
+			free(mem);
+			mem = NULL;
+		}
+	}
+	if(f != NULL)
+		fclose(f);
+	*size = (mem != NULL) ? (size_t)n : 0;
+	return mem;
+}
+
+#endif // _RIFF_BENCH_H_
@@ -0,0 +1,75 @@
+// cost of crash-consistent recording, see riff_writerSetCommitPolicy() in riff_writer.c
+// a LIST with a growing "data" chunk is written in 4 KB slices to a temporary file:
+//   without commits, then with commits every interval and each RIFF_WRITER_SYNC_... policy
+// the byte overhead is printed as well, it is 4 bytes per open chunk per commit
+// usage: bench_commit [MB], default 64
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "bench.h"
+
+
+#define SLICE 4096
+
+
+
+/*****************************************************************************/
+static void run(const char *name, size_t size, size_t interval, int sync){
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	uint8_t *buf = malloc(SLICE);
+	int r = (f != NULL  &&  rw != NULL  &&  buf != NULL) ? RIFF_ERROR_NONE : RIFF_ERROR_MEMORY;
+	if(buf != NULL)
+		memset(buf, 0x55, SLICE);
+
+	double t = bench_now();
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writer_open_file(rw, f, "BNCH");
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginList(rw, "strm");
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginChunk(rw, "data");
+	if(r == RIFF_ERROR_NONE)
+		riff_writerSetCommitPolicy(rw, interval, sync);
+	size_t done = 0;
+	while(r == RIFF_ERROR_NONE  &&  done < size){
+		if(riff_writerWrite(rw, buf, SLICE) != SLICE)
+			r = RIFF_ERROR_ACCESS;
+		done += SLICE;
+	}
+	size_t commits = (rw != NULL) ? rw->commit_count : 0;
+	size_t bytes = (rw != NULL) ? rw->commit_bytes : 0;
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerClose(rw);
+	t = bench_now() - t;
+
+	if(r != RIFF_ERROR_NONE)
+		printf("%s: failed with %d\n", name, r);
+	else {
+		bench_report(name, size / BENCH_MB, "MB", t);
+		printf("%-44s %12zu commits, %zu extra bytes\n", "", commits, bytes);
+	}
+	riff_writerFree(rw);
+	free(buf);
+	if(f != NULL)
+		fclose(f);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t size = (size_t)((argc > 1) ? atoi(argv[1]) : 64) << 20;
+	printf("recording of a %zu MB chunk in %d byte slices\n", size >> 20, SLICE);
+
+	run("no commits", size, 0, RIFF_WRITER_SYNC_NONE);
+	run("every 64 KB, RIFF_WRITER_SYNC_NONE", size, 64 << 10, RIFF_WRITER_SYNC_NONE);
+	run("every 1 MB, RIFF_WRITER_SYNC_NONE", size, 1 << 20, RIFF_WRITER_SYNC_NONE);
+	run("every 1 MB, RIFF_WRITER_SYNC_HEADER", size, 1 << 20, RIFF_WRITER_SYNC_HEADER);
+	run("every 1 MB, RIFF_WRITER_SYNC_FULL", size, 1 << 20, RIFF_WRITER_SYNC_FULL);
+	return 0;
+}
@@ -0,0 +1,129 @@
+// chunk copy throughput, see riff_copy.c
+// the "data" chunk of a generated file is copied to a file descriptor:
+//   read + write through a user buffer (what a caller would do without riff_copy.h)
+//   riff_copyChunkTo() through its buffer (custom read function), from a FILE (kernel copy) and from memory
+// usage: bench_copy [MB], default 256
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "riff.h"
+#include "riff_copy.h"
+#include "riff_writer.h"
+#include "bench.h"
+
+
+#define RUNS 3
+#define USER_BUFFER (1 << 20)
+
+
+
+/*****************************************************************************/
+//not read_file(), so riff_copyChunkTo() can't use the kernel copy
+static size_t read_stdio(riff_handle *rh, void *ptr, size_t size){
+	return fread(ptr, 1, size, (FILE*)(rh->fh));
+}
+
+/*****************************************************************************/
+//file with one "data" chunk of size bytes
+static int writeFile(FILE *f, size_t size){
+	uint8_t *buf = calloc(1, USER_BUFFER);
+	riff_writer *rw = riff_writerAllocate();
+	int r = (buf != NULL  &&  rw != NULL) ? riff_writer_open_file(rw, f, "BNCH") : RIFF_ERROR_MEMORY;
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginChunkSized(rw, "data", size);
+	size_t done = 0;
+	while(r == RIFF_ERROR_NONE  &&  done < size){
+		size_t n = (size - done < USER_BUFFER) ? size - done : USER_BUFFER;
+		memset(buf, (int)(done >> 20), n);
+		if(riff_writerWrite(rw, buf, n) != n)
+			r = RIFF_ERROR_ACCESS;
+		done += n;
+	}
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerClose(rw);
+	riff_writerFree(rw);
+	free(buf);
+	return r;
+}
+
+/*****************************************************************************/
+//put handle on the "data" chunk, empty destination
+static int prepare(riff_handle *rh, int fd){
+	if(ftruncate(fd, 0) != 0  ||  lseek(fd, 0, SEEK_SET) != 0)
+		return 0;
+	return riff_seekLevelStart(rh) == RIFF_ERROR_NONE  &&  strcmp(rh->c_id, "data") == 0;
+}
+
+/*****************************************************************************/
+//best of RUNS, size is the expected amount
+static void run(const char *name, riff_handle *rh, int fd, size_t size, int user_buffer){
+	uint8_t *buf = user_buffer ? malloc(USER_BUFFER) : NULL;
+	double best = 0;
+	int i;
+	for(i = 0; i < RUNS; i++){
+		if(!prepare(rh, fd)  ||  (user_buffer  &&  buf == NULL)){
+			printf("%s: failed\n", name);
+			free(buf);
+			return;
+		}
+		double t = bench_now();
+		size_t done = 0, n;
+		if(user_buffer){
+			while((n = riff_readInChunk(rh, buf, USER_BUFFER)) > 0  &&  write(fd, buf, n) == (ssize_t)n)
+				done += n;
+		}
+		else
+			done = riff_copyChunkTo(rh, fd);
+		//include writeback of the page cache, the kernel copy may defer it otherwise
+		fsync(fd);
+		t = bench_now() - t;
+		if(done != size){
+			printf("%s: copied %zu of %zu bytes\n", name, done, size);
+			free(buf);
+			return;
+		}
+		if(i == 0  ||  t < best)
+			best = t;
+	}
+	bench_report(name, size / BENCH_MB, "MB", best);
+	free(buf);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t size = (size_t)((argc > 1) ? atoi(argv[1]) : 256) << 20;
+	FILE *src = tmpfile();
+	FILE *dst = tmpfile();
+	riff_handle *rh = riff_handleAllocate();
+	if(src == NULL  ||  dst == NULL  ||  rh == NULL  ||  writeFile(src, size) != RIFF_ERROR_NONE){
+		printf("can't create %zu MB source file\n", size >> 20);
+		return 1;
+	}
+	long file_size = ftell(src);
+	int fd = fileno(dst);
+	printf("copy of a %zu MB chunk, best of %d\n", size >> 20, RUNS);
+
+	fseek(src, 0, SEEK_SET);
+	if(riff_open_file(rh, src, (size_t)file_size) == RIFF_ERROR_NONE){
+		run("riff_readInChunk + write, 1 MB buffer", rh, fd, size, 1);
+		run("riff_copyChunkTo, FILE (kernel copy)", rh, fd, size, 0);
+		rh->fp_read = &read_stdio;
+		run("riff_copyChunkTo, custom read (buffer)", rh, fd, size, 0);
+	}
+
+	uint8_t *mem = malloc((size_t)file_size);
+	fseek(src, 0, SEEK_SET);
+	if(mem != NULL  &&  fread(mem, 1, (size_t)file_size, src) == (size_t)file_size  &&  riff_open_mem(rh, mem, (size_t)file_size) == RIFF_ERROR_NONE)
+		run("riff_copyChunkTo, memory", rh, fd, size, 0);
+	free(mem);
+
+	riff_handleFree(rh);
+	fclose(dst);
+	fclose(src);
+	return 0;
+}
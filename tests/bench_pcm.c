@@ -0,0 +1,102 @@
+// PCM conversion throughput per source format and output sample type, see riff_pcm.c
+// the scalar kernel of each format is timed against the one picked for this CPU, both from pcm_kernelOf()
+// usage: bench_pcm [samples per run], default 65536 (fits the L2 cache, so the kernels are compared, not the memory)
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_wav.h"
+#include "riff_internal.h"
+#include "bench.h"
+
+
+#define SECONDS 0.2     //minimum time per measurement
+
+struct pcmCase {
+	const char *name;
+	int type;           //PCM_...
+	int sample;         //RIFF_WAV_SAMPLE_...
+	size_t in_size;     //bytes per source sample
+};
+
+static const struct pcmCase cases[] = {
+	{ "u8  -> float", PCM_U8,  RIFF_WAV_SAMPLE_FLOAT, 1 },
+	{ "s16 -> float", PCM_S16, RIFF_WAV_SAMPLE_FLOAT, 2 },
+	{ "s24 -> float", PCM_S24, RIFF_WAV_SAMPLE_FLOAT, 3 },
+	{ "s32 -> float", PCM_S32, RIFF_WAV_SAMPLE_FLOAT, 4 },
+	{ "f32 -> float", PCM_F32, RIFF_WAV_SAMPLE_FLOAT, 4 },
+	{ "f64 -> float", PCM_F64, RIFF_WAV_SAMPLE_FLOAT, 8 },
+	{ "u8  -> int16", PCM_U8,  RIFF_WAV_SAMPLE_INT16, 1 },
+	{ "s16 -> int16", PCM_S16, RIFF_WAV_SAMPLE_INT16, 2 },
+	{ "s24 -> int16", PCM_S24, RIFF_WAV_SAMPLE_INT16, 3 },
+	{ "s32 -> int16", PCM_S32, RIFF_WAV_SAMPLE_INT16, 4 },
+	{ "f32 -> int16", PCM_F32, RIFF_WAV_SAMPLE_INT16, 4 },
+	{ "f64 -> int16", PCM_F64, RIFF_WAV_SAMPLE_INT16, 8 },
+};
+
+
+
+/*****************************************************************************/
+//n source samples of type, floats in [-1, 1), so no kernel hits NaN or denormal paths
+static void fill(uint8_t *src, int type, size_t in_size, size_t n){
+	size_t i;
+	uint32_t x = 1;
+	for(i = 0; i < n; i++){
+		x = x * 1664525u + 1013904223u;
+		float f = (float)(int32_t)x / 2147483648.0f;
+		double d = f;
+		if(type == PCM_F32)
+			memcpy(src + i * 4, &f, 4);
+		else if(type == PCM_F64)
+			memcpy(src + i * 8, &d, 8);
+		else
+			memcpy(src + i * in_size, &x, in_size);
+	}
+}
+
+/*****************************************************************************/
+//samples per second of kernel, repeated for at least SECONDS
+static double measure(pcm_kernel k, const uint8_t *src, void *dst, size_t n){
+	size_t runs = 0, per = 1;
+	double t = bench_now(), elapsed;
+	do{
+		size_t i;
+		for(i = 0; i < per; i++)
+			k(src, dst, n);
+		runs += per;
+		per *= 2;
+		elapsed = bench_now() - t;
+	}while(elapsed < SECONDS);
+	return (double)runs * n / elapsed;
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t n = (argc > 1) ? (size_t)atoi(argv[1]) : 65536;
+	uint8_t *src = malloc(n * 8);
+	float *dst = malloc(n * sizeof(float));
+	if(n == 0  ||  src == NULL  ||  dst == NULL){
+		printf("can't allocate %zu samples\n", n);
+		return 1;
+	}
+
+	printf("conversion of %zu samples, kernels: %s\n", n, riff_wavConvertImpl());
+	printf("%-14s %14s %14s %8s\n", "", "scalar Ms/s", "picked Ms/s", "speedup");
+	size_t i;
+	for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+		const struct pcmCase *c = cases + i;
+		pcm_kernel ref = pcm_kernelOf("scalar", c->type, c->sample);
+		pcm_kernel picked = pcm_kernelOf(NULL, c->type, c->sample);
+		fill(src, c->type, c->in_size, n);
+		double scalar = measure(ref, src, dst, n);
+		double fast = (picked == ref) ? scalar : measure(picked, src, dst, n);
+		printf("%-14s %14.1f %14.1f %7.2fx%s\n", c->name, scalar / 1e6, fast / 1e6, fast / scalar, (picked == ref) ? "  (scalar only)" : "");
+	}
+
+	free(dst);
+	free(src);
+	return 0;
+}
@@ -0,0 +1,105 @@
+// files per second with and without the handle pool, see riff_handlePoolGet() in riff.c
+// the same in-memory file is opened and validated again and again, so only the handle cost differs:
+//   riff_handleAllocate() and riff_handleFree() per file
+//   riff_handlePoolGet() and riff_handlePoolPut() per file
+// a flat WAVE file fits the inline level stack, the nested one spills it to the heap
+// usage: bench_pool [files], default 1000000
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "bench.h"
+
+
+#define RUNS 3
+#define NESTED_LEVELS (RIFF_LEVEL_INLINE + 4)
+
+
+
+/*****************************************************************************/
+//"fmt " and "data" chunks in *(int *)user nested lists
+static int writeFile(riff_writer *rw, void *user){
+	uint8_t fmt[16] = { 1,0, 1,0, 0x44,0xAC,0,0, 0x88,0x58,1,0, 2,0, 16,0 };
+	uint8_t data[64] = {0};
+	int levels = *(int *)user;
+	int r = RIFF_ERROR_NONE;
+	int i;
+	for(i = 0; r == RIFF_ERROR_NONE  &&  i < levels; i++)
+		r = riff_writerBeginList(rw, "nest");
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "fmt ", fmt, sizeof(fmt));
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "data", data, sizeof(data));
+	return r;
+}
+
+/*****************************************************************************/
+//open and validate the file count times, returns amount of failures
+static size_t run(const uint8_t *mem, size_t size, size_t count, riff_handlePool *pool){
+	size_t i, failed = 0;
+	for(i = 0; i < count; i++){
+		riff_handle *rh = (pool != NULL) ? riff_handlePoolGet(pool) : riff_handleAllocate();
+		if(rh == NULL){
+			failed++;
+			continue;
+		}
+		rh->fp_printf = NULL;
+		if(riff_open_mem(rh, mem, size) != RIFF_ERROR_NONE  ||  riff_fileValidate(rh) != RIFF_ERROR_NONE)
+			failed++;
+		if(pool != NULL)
+			riff_handlePoolPut(pool, rh);
+		else
+			riff_handleFree(rh);
+	}
+	return failed;
+}
+
+/*****************************************************************************/
+static void bench(const char *name, const uint8_t *mem, size_t size, size_t count){
+	riff_handlePool *pool = riff_handlePoolAllocate(4);
+	if(mem == NULL  ||  pool == NULL){
+		printf("%s: failed\n", name);
+		riff_handlePoolFree(pool);
+		return;
+	}
+	char line[128];
+	int m, i;
+	for(m = 0; m < 2; m++){
+		double best = 0;
+		size_t failed = 0;
+		for(i = 0; i < RUNS; i++){
+			double t = bench_now();
+			failed += run(mem, size, count, (m == 0) ? NULL : pool);
+			t = bench_now() - t;
+			if(i == 0  ||  t < best)
+				best = t;
+		}
+		snprintf(line, sizeof(line), "%s, %s", name, (m == 0) ? "allocate + free" : "pool");
+		bench_report(line, (double)count, "files", best);
+		if(failed > 0)
+			printf("  %zu failed\n", failed);
+	}
+	riff_handlePoolFree(pool);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t count = (argc > 1) ? (size_t)atoi(argv[1]) : 1000000;
+	size_t flat_size, nested_size;
+	int flat_levels = 0, nested_levels = NESTED_LEVELS;
+	uint8_t *flat = bench_makeFile("WAVE", &writeFile, &flat_levels, &flat_size);
+	uint8_t *nested = bench_makeFile("WAVE", &writeFile, &nested_levels, &nested_size);
+	printf("open + validate of one in-memory file %zu times, best of %d\n", count, RUNS);
+
+	bench("flat WAVE", flat, flat_size, count);
+	bench("nested lists", nested, nested_size, count);
+
+	free(nested);
+	free(flat);
+	return 0;
+}
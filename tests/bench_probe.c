@@ -0,0 +1,146 @@
+// files per second of the format probe, see riff_probe.c
+// many small files of different kinds are classified:
+//   riff_open_file() on a handle (what a caller would do without riff_probe.h)
+//   a RIFF_PROBE_SIZE read and riff_probe()
+//   riff_probeBatch() on prefixes already in memory, no I/O
+// usage: bench_probe [files], default 2000
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "riff.h"
+#include "riff_probe.h"
+#include "bench.h"
+
+
+#define RUNS 3
+#define FILE_SIZE 4096
+
+//first bytes of the generated kinds of files, the rest is zero
+static const uint8_t heads[][RIFF_PROBE_SIZE] = {
+	{ 'R','I','F','F', 0xF8,0x0F,0,0, 'W','A','V','E', 'f','m','t',' ', 16,0,0,0 },
+	{ 'R','I','F','F', 0xF8,0x0F,0,0, 'A','V','I',' ', 'L','I','S','T', 0xE8,0x0F,0,0 },
+	{ 'R','I','F','X', 0,0,0x0F,0xF8, 'W','A','V','E', 'f','m','t',' ', 0,0,0,16 },
+	{ 'B','W','6','4', 0xFF,0xFF,0xFF,0xFF, 'W','A','V','E', 'd','s','6','4', 28,0,0,0, 0xF8,0x0F,0,0,0,0,0,0 },
+	{ 0x89,'P','N','G', 0x0D,0x0A,0x1A,0x0A },
+};
+#define KINDS (sizeof(heads) / sizeof(heads[0]))
+
+
+
+/*****************************************************************************/
+static void fileName(char *name, size_t size, const char *dir, size_t i){
+	snprintf(name, size, "%s/%zu.bin", dir, i);
+}
+
+/*****************************************************************************/
+static int writeFiles(const char *dir, size_t count){
+	uint8_t buf[FILE_SIZE] = {0};
+	char name[256];
+	size_t i;
+	for(i = 0; i < count; i++){
+		memcpy(buf, heads[i % KINDS], RIFF_PROBE_SIZE);
+		fileName(name, sizeof(name), dir, i);
+		FILE *f = fopen(name, "wb");
+		if(f == NULL)
+			return 0;
+		size_t n = fwrite(buf, 1, sizeof(buf), f);
+		fclose(f);
+		if(n != sizeof(buf))
+			return 0;
+	}
+	return 1;
+}
+
+/*****************************************************************************/
+static void removeFiles(const char *dir, size_t count){
+	char name[256];
+	size_t i;
+	for(i = 0; i < count; i++){
+		fileName(name, sizeof(name), dir, i);
+		remove(name);
+	}
+	rmdir(dir);
+}
+
+/*****************************************************************************/
+//classify every file, returns amount of RIFF files, the probe uses riff_probe() instead of a handle
+static size_t classify(const char *dir, size_t count, riff_handle *rh){
+	char name[256];
+	uint8_t buf[RIFF_PROBE_SIZE];
+	struct riff_probeResult res;
+	size_t i, found = 0;
+	for(i = 0; i < count; i++){
+		fileName(name, sizeof(name), dir, i);
+		FILE *f = fopen(name, "rb");
+		if(f == NULL)
+			continue;
+		if(rh != NULL)
+			found += riff_open_file(rh, f, FILE_SIZE) == RIFF_ERROR_NONE;
+		else
+			found += riff_probe(buf, fread(buf, 1, sizeof(buf), f), FILE_SIZE, &res) > 0;
+		fclose(f);
+	}
+	return found;
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t count = (argc > 1) ? (size_t)atoi(argv[1]) : 2000;
+	char dir[] = "/tmp/riff_bench_XXXXXX";
+	if(count == 0  ||  mkdtemp(dir) == NULL  ||  !writeFiles(dir, count)){
+		printf("can't create %zu files\n", count);
+		return 1;
+	}
+	riff_handle *rh = riff_handleAllocate();
+	if(rh == NULL)
+		return 1;
+	rh->fp_printf = NULL;
+	printf("classification of %zu files (%zu kinds, %d bytes each, page cache warm), best of %d\n", count, KINDS, FILE_SIZE, RUNS);
+
+	const char *names[] = { "riff_open_file", "read prefix + riff_probe" };
+	int m, i;
+	for(m = 0; m < 2; m++){
+		double best = 0;
+		size_t found = 0;
+		for(i = 0; i < RUNS; i++){
+			double t = bench_now();
+			found = classify(dir, count, (m == 0) ? rh : NULL);
+			t = bench_now() - t;
+			if(i == 0  ||  t < best)
+				best = t;
+		}
+		bench_report(names[m], (double)count, "files", best);
+		printf("  %zu recognized\n", found);
+	}
+
+	//prefixes in memory, the probe alone
+	const void **bufs = malloc(count * sizeof(void *));
+	size_t *lens = malloc(count * sizeof(size_t));
+	struct riff_probeResult *res = malloc(count * sizeof(struct riff_probeResult));
+	if(bufs != NULL  &&  lens != NULL  &&  res != NULL){
+		size_t j, found = 0, rounds = 0;
+		for(j = 0; j < count; j++){
+			bufs[j] = heads[j % KINDS];
+			lens[j] = RIFF_PROBE_SIZE;
+		}
+		double t = bench_now();
+		do{
+			found = riff_probeBatch(bufs, lens, NULL, count, res);
+			rounds++;
+		}while(bench_now() - t < 0.2);
+		bench_report("riff_probeBatch, in memory", (double)count * rounds, "files", bench_now() - t);
+		printf("  %zu recognized\n", found);
+	}
+	free(res);
+	free(lens);
+	free(bufs);
+
+	riff_handleFree(rh);
+	removeFiles(dir, count);
+	return 0;
+}
@@ -0,0 +1,103 @@
+// readChunkData throughput of the C++ wrapper, see RIFFFile::readChunkData() in riff.hpp
+// one large chunk of an in-memory file is read again and again:
+//   as readChunkData() did before: a new zero-filled vector, each read requesting the whole chunk size
+//   readChunkData() returning a new vector, still zero-filled
+//   readChunkBuffer(), a new ChunkBuffer without zero-fill
+//   readChunkData() into a reused vector and into caller storage
+//   readChunkData() from a std::pmr::monotonic_buffer_resource (C++17)
+// usage: bench_read [MB], default 8
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+#if RIFF_CXX17_SUPPORT
+#include <memory_resource>
+#endif
+
+#include "riff.hpp"
+#include "riff_writer.h"
+
+extern "C" {
+#include "bench.h"
+}
+
+
+#define SECONDS 0.3     //minimum time per measurement
+
+
+
+/*****************************************************************************/
+//one "data" chunk of *(size_t *)user bytes
+static int writeFile(riff_writer *rw, void *user){
+	std::vector<uint8_t> data(*(size_t *)user, 0x5a);
+	return riff_writerWriteChunk(rw, "data", data.data(), data.size());
+}
+
+/*****************************************************************************/
+//the pre-overload readChunkData(): zero-filled vector, each readInChunk call asks for the full size
+static std::vector<uint8_t> readBaseline(RIFF::RIFFFile & file){
+	riff_handle *rh = const_cast<riff_handle *>(&file());
+	std::vector<uint8_t> out(rh->c_size);
+	riff_seekChunkStart(rh);
+	size_t total = 0, n;
+	do {
+		n = riff_readInChunk(rh, out.data() + total, rh->c_size);
+		total += n;
+	} while (n != 0  &&  total < rh->c_size);
+	return out;
+}
+
+/*****************************************************************************/
+//GB per second of read, which returns the amount of read bytes
+static void bench(const char *name, size_t size, const std::function<size_t()> & read){
+	size_t runs = 0;
+	double t = bench_now(), elapsed;
+	do {
+		if (read() != size) {
+			printf("%s: failed\n", name);
+			return;
+		}
+		runs++;
+		elapsed = bench_now() - t;
+	} while (elapsed < SECONDS);
+	bench_report(name, (double)size * runs / (BENCH_MB * 1024), "GB", elapsed);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	size_t size = (size_t)((argc > 1) ? atoi(argv[1]) : 8) << 20;
+	size_t mem_size = 0;
+	uint8_t *mem = (size > 0) ? bench_makeFile("BNCH", &writeFile, &size, &mem_size) : nullptr;
+	RIFF::RIFFFile file;
+	if (mem == nullptr  ||  file.openMemory(mem, mem_size) != RIFF_ERROR_NONE  ||  file().c_size != size) {
+		printf("can't create file with a %zu MB chunk\n", size >> 20);
+		return 1;
+	}
+	printf("read of a %zu MB chunk from memory\n", size >> 20);
+
+	bench("previous readChunkData()", size, [&]{ return readBaseline(file).size(); });
+	bench("readChunkData(), new vector", size, [&]{ return file.readChunkData().size(); });
+	bench("readChunkBuffer()", size, [&]{ return file.readChunkBuffer().size(); });
+
+	std::vector<uint8_t> reused;
+	bench("readChunkData(vector &), reused", size, [&]{ file.readChunkData(reused); return reused.size(); });
+
+	std::vector<uint8_t> storage(size);
+	bench("readChunkData(void *, size_t)", size, [&]{ return file.readChunkData(storage.data(), storage.size()); });
+
+#if RIFF_CXX17_SUPPORT
+	std::vector<uint8_t> arena(size + 4096);
+	bench("readChunkData(memory_resource *)", size, [&]{
+		std::pmr::monotonic_buffer_resource mr(arena.data(), arena.size(), std::pmr::null_memory_resource());
+		return file.readChunkData(&mr).size();
+	});
+#endif
+
+	file.close();
+	free(mem);
+	return 0;
+}
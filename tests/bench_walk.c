@@ -0,0 +1,95 @@
+// header walk throughput, see riff_walk() and the cursor fields at the start of riff_handle
+// a generated file of LISTS lists with CHUNKS chunks each is walked in memory:
+//   riff_fileValidate(), no callbacks
+//   riff_walk() counting one chunk ID by FOURCC value (riff_chunkIs()) and by string (strcmp() on c_id)
+// usage: bench_walk [lists], default 64
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "bench.h"
+
+
+#define CHUNKS 64
+#define SECONDS 0.3     //minimum time per measurement
+
+
+
+/*****************************************************************************/
+//*(int *)user lists of "list" type, each with CHUNKS small chunks, every 4th is "data"
+static int writeFile(riff_writer *rw, void *user){
+	uint8_t data[6] = {0};
+	int lists = *(int *)user;
+	int r = RIFF_ERROR_NONE;
+	int i, j;
+	for(i = 0; r == RIFF_ERROR_NONE  &&  i < lists; i++){
+		r = riff_writerBeginList(rw, "list");
+		for(j = 0; r == RIFF_ERROR_NONE  &&  j < CHUNKS; j++)
+			r = riff_writerWriteChunk(rw, (j % 4 == 0) ? "data" : "junk", data, sizeof(data) - (j & 1));
+		if(r == RIFF_ERROR_NONE)
+			r = riff_writerEnd(rw);
+	}
+	return r;
+}
+
+/*****************************************************************************/
+static int countFourcc(riff_handle *rh, void *user){
+	if(riff_chunkIs(rh, RIFF_FOURCC('d','a','t','a')))
+		(*(size_t *)user)++;
+	return RIFF_WALK_CONTINUE;
+}
+
+static int countString(riff_handle *rh, void *user){
+	if(strcmp(rh->c_id, "data") == 0)
+		(*(size_t *)user)++;
+	return RIFF_WALK_CONTINUE;
+}
+
+/*****************************************************************************/
+//headers per second, callback NULL for riff_fileValidate()
+static void bench(const char *name, riff_handle *rh, int (*fp_chunk)(riff_handle *, void *), size_t headers, size_t expected){
+	struct riff_walker w = {0};
+	size_t found = 0, runs = 0;
+	w.fp_chunk = fp_chunk;
+	w.user = &found;
+
+	double t = bench_now(), elapsed;
+	do{
+		found = 0;
+		int r = (fp_chunk == NULL) ? riff_fileValidate(rh) : riff_walk(rh, &w);
+		if(r != RIFF_ERROR_NONE  ||  (fp_chunk != NULL  &&  found != expected)){
+			printf("%s: failed\n", name);
+			return;
+		}
+		runs++;
+		elapsed = bench_now() - t;
+	}while(elapsed < SECONDS);
+	bench_report(name, (double)headers * runs / 1e6, "M headers", elapsed);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	int lists = (argc > 1) ? atoi(argv[1]) : 64;
+	size_t size;
+	uint8_t *mem = (lists > 0) ? bench_makeFile("BNCH", &writeFile, &lists, &size) : NULL;
+	riff_handle *rh = riff_handleAllocate();
+	if(lists <= 0  ||  mem == NULL  ||  rh == NULL  ||  riff_open_mem(rh, mem, size) != RIFF_ERROR_NONE){
+		printf("can't create file with %d lists\n", lists);
+		return 1;
+	}
+	size_t headers = (size_t)lists * (CHUNKS + 1);
+	printf("walk of %d lists with %d chunks each (%zu bytes) in memory\n", lists, CHUNKS, size);
+
+	bench("riff_fileValidate", rh, NULL, headers, 0);
+	bench("riff_walk, riff_chunkIs", rh, &countFourcc, headers, (size_t)lists * CHUNKS / 4);
+	bench("riff_walk, strcmp", rh, &countString, headers, (size_t)lists * CHUNKS / 4);
+
+	riff_handleFree(rh);
+	free(mem);
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+libriff
+
+Author/copyright: Markus Wolf, alexmush
+License: zlib (https://opensource.org/licenses/Zlib)
+
+
+Minimal check macros shared by the tests.
+A test is a program that returns 0 if all checks passed, see CMakeLists.txt and the "test" target of the makefile.
+*/
+
+#ifndef _RIFF_TEST_H_
+#define _RIFF_TEST_H_
+
+#include <stdio.h>
+
+static int test_failed = 0;
+
+//report failed condition and continue, so one run shows all failures
+#define CHECK(cond) do{ \
+	if(!(cond)){ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		test_failed++; \
+	} \
+}while(0)
+
+//report failed condition and leave the test
+#define REQUIRE(cond) do{ \
+	if(!(cond)){ \
+		fprintf(stderr, "%s:%d: requirement failed: %s\n", __FILE__, __LINE__, #cond); \
+		return 1; \
+	} \
+}while(0)
+
+//report failed condition and leave a function without return value
+#define REQUIRE_VOID(cond) do{ \
+	if(!(cond)){ \
+		fprintf(stderr, "%s:%d: requirement failed: %s\n", __FILE__, __LINE__, #cond); \
+		test_failed++; \
+		return; \
+	} \
+}while(0)
+
+#define TEST_RESULT() (test_failed == 0 ? 0 : 1)
+
+#endif // _RIFF_TEST_H_
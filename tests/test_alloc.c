@@ -0,0 +1,488 @@
+// every allocation of the library goes through the riff_allocator, see riff_setAllocator() and riff_handleAllocateWith()
+// malloc, calloc, realloc and free are wrapped by the linker (--wrap) and counted, the library runs on a bump arena
+// usage: test_alloc <AVI file>, e.g. sample/test.avi
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "riff_mpwriter.h"
+#include "riff_edit.h"
+#include "riff_wav.h"
+#include "riff_meta.h"
+#include "riff_avi.h"
+#include "riff_avidemux.h"
+#include "riff_bank.h"
+#include "riff_anim.h"
+#include "test.h"
+
+
+#define ARENA_SIZE (16 << 20)
+#define ARENA_ALIGN 16
+
+#define DEEP_LEVELS 40    //beyond RIFF_LEVEL_INLINE, the level stacks spill
+
+
+
+//*** global heap, wrapped ***
+
+static long heap_calls = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size){ heap_calls++; return __real_malloc(size); }
+void *__wrap_calloc(size_t n, size_t size){ heap_calls++; return __real_calloc(n, size); }
+void *__wrap_realloc(void *ptr, size_t size){ heap_calls++; return __real_realloc(ptr, size); }
+void __wrap_free(void *ptr){ if(ptr != NULL) heap_calls++; __real_free(ptr); }
+
+
+//*** bump arena, the block size is stored in front of each block ***
+
+static union { unsigned char b[ARENA_SIZE]; long double align; } arena;
+static size_t arena_used = 0;
+static long arena_calls = 0;
+
+/*****************************************************************************/
+static void *arenaMalloc(void *user, size_t size){
+	(void)user;
+	arena_calls++;
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if(arena_used + ARENA_ALIGN + size > ARENA_SIZE)
+		return NULL;
+	unsigned char *p = arena.b + arena_used;
+	memcpy(p, &size, sizeof(size));
+	arena_used += ARENA_ALIGN + size;
+	return p + ARENA_ALIGN;
+}
+
+/*****************************************************************************/
+static void *arenaRealloc(void *user, void *ptr, size_t size){
+	void *p = arenaMalloc(user, size);
+	if(p == NULL  ||  ptr == NULL)
+		return p;
+	size_t old;
+	memcpy(&old, (unsigned char *)ptr - ARENA_ALIGN, sizeof(old));
+	memcpy(p, ptr, (old < size) ? old : size);
+	return p;
+}
+
+/*****************************************************************************/
+static void arenaFree(void *user, void *ptr){
+	(void)user;
+	(void)ptr;
+	arena_calls++;
+}
+
+
+//*** generated input files ***
+
+//chunk data under construction
+struct rec {
+	uint8_t d[512];
+	size_t len;
+};
+
+/*****************************************************************************/
+static void put(struct rec *r, const void *p, size_t size){
+	memcpy(r->d + r->len, p, size);
+	r->len += size;
+}
+
+/*****************************************************************************/
+static void put16(struct rec *r, uint16_t v){
+	uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+	put(r, b, 2);
+}
+
+/*****************************************************************************/
+static void put32(struct rec *r, uint32_t v){
+	put16(r, (uint16_t)v);
+	put16(r, (uint16_t)(v >> 16));
+}
+
+/*****************************************************************************/
+static void putName(struct rec *r, const char *name){
+	uint8_t b[20] = {0};
+	memcpy(b, name, strlen(name));
+	put(r, b, 20);
+}
+
+/*****************************************************************************/
+static void writeRec(riff_writer *rw, const char *id, struct rec *r){
+	riff_writerWriteChunk(rw, id, r->d, r->len);
+	r->len = 0;
+}
+
+/*****************************************************************************/
+//WAVE, 16 bit PCM with INFO and "bext" metadata
+static void writeWav(riff_writer *rw){
+	struct rec r = { {0}, 0 };
+	put16(&r, RIFF_WAV_FORMAT_PCM);
+	put16(&r, 2);
+	put32(&r, 44100);
+	put32(&r, 44100 * 4);
+	put16(&r, 4);
+	put16(&r, 16);
+	writeRec(rw, "fmt ", &r);
+
+	riff_writerBeginList(rw, "INFO");
+	riff_writerWriteChunk(rw, "INAM", "Test\0", 5);
+	riff_writerWriteChunk(rw, "ICMT", "generated\0", 10);
+	riff_writerEnd(rw);
+
+	uint8_t bext[602] = {0};
+	memcpy(bext, "Description", 11);
+	riff_writerBeginChunk(rw, "bext");
+	riff_writerWrite(rw, bext, sizeof(bext));
+	riff_writerWrite(rw, "A=PCM\r\n", 7);
+	riff_writerEnd(rw);
+
+	riff_writerBeginChunk(rw, "data");
+	int16_t s;
+	for(s = -2000; s < 2000; s++)
+		riff_writerWrite(rw, &s, 2);
+	riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//SF2 with one preset, instrument and sample
+static void writeSf2(riff_writer *rw){
+	struct rec r = { {0}, 0 };
+	riff_writerBeginList(rw, "INFO");
+	put16(&r, 2);
+	put16(&r, 1);
+	writeRec(rw, "ifil", &r);
+	riff_writerWriteChunk(rw, "INAM", "Test\0", 6);
+	riff_writerEnd(rw);
+
+	riff_writerBeginList(rw, "sdta");
+	riff_writerBeginChunk(rw, "smpl");
+	int16_t s;
+	for(s = 0; s < 128; s++)
+		riff_writerWrite(rw, &s, 2);
+	riff_writerEnd(rw);
+	riff_writerEnd(rw);
+
+	riff_writerBeginList(rw, "pdta");
+	putName(&r, "Piano"); put16(&r, 0); put16(&r, 0); put16(&r, 0); put32(&r, 0); put32(&r, 0); put32(&r, 0);
+	putName(&r, "EOP");   put16(&r, 0); put16(&r, 0); put16(&r, 1); put32(&r, 0); put32(&r, 0); put32(&r, 0);
+	writeRec(rw, "phdr", &r);
+	put16(&r, 0); put16(&r, 0);
+	put16(&r, 1); put16(&r, 0);
+	writeRec(rw, "pbag", &r);
+	put(&r, "\0\0\0\0\0\0\0\0\0\0", 10);
+	writeRec(rw, "pmod", &r);
+	put16(&r, 41); put16(&r, 0);    //instrument 0
+	put16(&r, 0); put16(&r, 0);
+	writeRec(rw, "pgen", &r);
+	putName(&r, "PianoI"); put16(&r, 0);
+	putName(&r, "EOI");    put16(&r, 1);
+	writeRec(rw, "inst", &r);
+	put16(&r, 0); put16(&r, 0);
+	put16(&r, 1); put16(&r, 0);
+	writeRec(rw, "ibag", &r);
+	put(&r, "\0\0\0\0\0\0\0\0\0\0", 10);
+	writeRec(rw, "imod", &r);
+	put16(&r, 53); put16(&r, 0);    //sample 0
+	put16(&r, 0); put16(&r, 0);
+	writeRec(rw, "igen", &r);
+	putName(&r, "s0");  put32(&r, 0); put32(&r, 80); put32(&r, 10); put32(&r, 70); put32(&r, 44100); put(&r, "\x3c\0", 2); put16(&r, 0); put16(&r, 1);
+	putName(&r, "EOS"); put32(&r, 0); put32(&r, 0);  put32(&r, 0);  put32(&r, 0);  put32(&r, 0);     put(&r, "\0\0", 2);   put16(&r, 0); put16(&r, 0);
+	writeRec(rw, "shdr", &r);
+	riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//ANI with rate and sequence tables
+static void writeAni(riff_writer *rw){
+	struct rec r = { {0}, 0 };
+	uint32_t anih[9] = { 36, 3, 5, 32, 32, 0, 1, 6, 3 };
+	int i;
+	for(i = 0; i < 9; i++)
+		put32(&r, anih[i]);
+	writeRec(rw, "anih", &r);
+	for(i = 0; i < 5; i++)
+		put32(&r, 6 + i);
+	writeRec(rw, "rate", &r);
+	for(i = 0; i < 5; i++)
+		put32(&r, (uint32_t)(i % 3));
+	writeRec(rw, "seq ", &r);
+	const char icon[20] = "icon";
+	riff_writerBeginList(rw, "fram");
+	for(i = 0; i < 3; i++)
+		riff_writerWriteChunk(rw, "icon", icon, 16 + i);
+	riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//deeply nested lists and a "movi" list from the multi-producer writer
+static void writeDeep(riff_writer *rw){
+	int i;
+	for(i = 0; i < DEEP_LEVELS; i++)
+		riff_writerBeginList(rw, "deep");
+	riff_writerWriteChunk(rw, "data", "x", 1);
+	for(i = 0; i < DEEP_LEVELS; i++)
+		riff_writerEnd(rw);
+
+	riff_writerBeginList(rw, "movi");
+	riff_mpWriter *mw = riff_mpWriterAllocate();
+	CHECK(mw != NULL);
+	CHECK(riff_mpWriterBegin(mw, rw) == RIFF_ERROR_NONE);
+	for(i = 0; i < 3000; i++){
+		uint64_t seq;
+		if(riff_mpWriterReserve(mw, "00dc", 4, 0, &seq) != RIFF_ERROR_NONE)
+			break;
+		riff_mpWriterWrite(mw, seq, 0, "abcd", 4);
+		riff_mpWriterCommit(mw, seq);
+	}
+	CHECK(i == 3000);
+	CHECK(riff_mpWriterEnd(mw) == RIFF_ERROR_NONE);
+	riff_mpWriterFree(mw);
+	riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//lists nested RIFF_LEVEL_INLINE deep, with a chunk before each list
+static void writeInline(riff_writer *rw){
+	int i;
+	for(i = 0; i < RIFF_LEVEL_INLINE; i++){
+		riff_writerWriteChunk(rw, "data", "xy", 2);
+		riff_writerBeginList(rw, "nest");
+	}
+	riff_writerWriteChunk(rw, "data", "x", 1);
+	for(i = 0; i < RIFF_LEVEL_INLINE; i++)
+		riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//file with the form type written by fp_write, NULL on error
+static FILE *generate(const char *type, void (*fp_write)(riff_writer *rw)){
+	FILE *f = tmpfile();
+	if(f == NULL)
+		return NULL;
+	riff_writer *rw = riff_writerAllocate();
+	int r = RIFF_ERROR_MEMORY;
+	if(rw != NULL  &&  (r = riff_writer_open_file(rw, f, type)) == RIFF_ERROR_NONE){
+		fp_write(rw);
+		r = riff_writerClose(rw);
+	}
+	riff_writerFree(rw);
+	CHECK(r == RIFF_ERROR_NONE);
+	fseek(f, 0, SEEK_SET);
+	return f;
+}
+
+
+//*** library use ***
+
+/*****************************************************************************/
+static riff_handle *openFile(FILE *f){
+	riff_handle *rh = riff_handleAllocate();
+	if(rh == NULL)
+		return NULL;
+	rh->fp_printf = NULL;
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, 0) == RIFF_ERROR_NONE);
+	return rh;
+}
+
+/*****************************************************************************/
+static void useWav(FILE *f){
+	riff_handle *rh = openFile(f);
+	REQUIRE_VOID(rh != NULL);
+	riff_meta meta;
+	memset(&meta, 0, sizeof(meta));
+	CHECK(riff_metaOpen(rh, &meta) == RIFF_ERROR_NONE);
+	const char *v = riff_metaGet(rh, &meta, "INAM");
+	CHECK(v != NULL  &&  strcmp(v, "Test") == 0);
+	v = riff_metaGet(rh, &meta, "CodingHistory");
+	CHECK(v != NULL  &&  strcmp(v, "A=PCM\r\n") == 0);
+	riff_metaClose(&meta);
+
+	riff_wav wav;
+	float samples[2 * 64];
+	CHECK(riff_wavOpen(rh, &wav) == RIFF_ERROR_NONE);
+	CHECK(riff_wavReadConverted(rh, &wav, 0, 64, samples, RIFF_WAV_SAMPLE_FLOAT, 0) == 64);
+	CHECK(riff_wavReadConverted(rh, &wav, 0, 64, samples, RIFF_WAV_SAMPLE_FLOAT, 1) == 64);
+	riff_handleFree(rh);
+}
+
+/*****************************************************************************/
+static void useBank(FILE *f){
+	riff_handle *rh = openFile(f);
+	REQUIRE_VOID(rh != NULL);
+	riff_bank bank;
+	CHECK(riff_bankOpen(rh, &bank) == RIFF_ERROR_NONE);
+	CHECK(bank.presets_len == 2);
+	CHECK(bank.samples_len == 2);
+	riff_bankClose(&bank);
+	riff_handleFree(rh);
+}
+
+/*****************************************************************************/
+static void useAni(FILE *f){
+	riff_handle *rh = openFile(f);
+	REQUIRE_VOID(rh != NULL);
+	riff_anim anim;
+	CHECK(riff_animOpen(rh, &anim) == RIFF_ERROR_NONE);
+	CHECK(anim.frames_len == 5);
+	riff_animClose(&anim);
+	riff_handleFree(rh);
+}
+
+/*****************************************************************************/
+static void useDeep(FILE *f){
+	riff_handle *rh = openFile(f);
+	REQUIRE_VOID(rh != NULL);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->ls_size > DEEP_LEVELS);
+
+	riff_handle *dup = riff_handleDuplicate(rh);
+	CHECK(dup != NULL);
+	riff_handleFree(dup);
+
+	riff_editScript *es = riff_editScriptAllocate();
+	CHECK(es != NULL);
+	int i;
+	for(i = 0; i < 100; i++)
+		riff_editScriptDelete(es, 12);
+	riff_editScriptFree(es);
+	riff_handleFree(rh);
+}
+
+/*****************************************************************************/
+//chunks walked and deepest level
+struct walkCount {
+	int chunks;
+	int level;
+};
+
+static int countChunk(riff_handle *rh, void *user){
+	struct walkCount *c = (struct walkCount *)user;
+	c->chunks++;
+	if(rh->ls_level > c->level)
+		c->level = rh->ls_level;
+	return RIFF_WALK_CONTINUE;
+}
+
+/*****************************************************************************/
+//a handle in caller storage opens and traverses a file within its inline level stack without any heap call
+static void useInline(FILE *f){
+	static uint8_t data[512];
+	fseek(f, 0, SEEK_SET);
+	size_t size = fread(data, 1, sizeof(data), f);
+	REQUIRE_VOID(size > 0  &&  size < sizeof(data));
+
+	uint64_t storage[(sizeof(riff_handle) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+	struct walkCount c = {0, 0};
+	struct riff_walker w = {0};
+	w.fp_chunk = &countChunk;
+	w.user = &c;
+
+	heap_calls = 0;
+	riff_handle *rh = riff_handleInit(storage, sizeof(storage));
+	REQUIRE_VOID(rh != NULL);
+	rh->fp_printf = NULL;
+	CHECK(riff_open_mem(rh, data, size) == RIFF_ERROR_NONE);
+	CHECK(riff_walk(rh, &w) == RIFF_ERROR_NONE);
+	CHECK(c.chunks == 2 * RIFF_LEVEL_INLINE + 1);
+	CHECK(c.level == RIFF_LEVEL_INLINE);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->ls == rh->ls_inline  &&  !rh->ls_heap);
+	riff_handleFree(rh);
+	CHECK(heap_calls == 0);
+	printf("caller storage: %ld heap calls\n", heap_calls);
+}
+
+/*****************************************************************************/
+//the demuxer is not built from the handle, it uses the global allocator
+static void useAvi(riff_handle *rh, int demux){
+	riff_avi avi;
+	CHECK(riff_aviOpen(rh, &avi) == RIFF_ERROR_NONE);
+	CHECK(avi.streams_len > 0  &&  avi.streams[0].idx_len > 0);
+
+	riff_aviDemux *dm = demux ? riff_aviDemuxAllocate() : NULL;
+	CHECK(dm != NULL  ||  !demux);
+	if(dm != NULL){
+		CHECK(riff_aviDemuxBegin(dm, rh, &avi) == RIFF_ERROR_NONE);
+		CHECK(riff_aviDemuxRun(dm) == RIFF_ERROR_NONE);
+		size_t s, packets = 0;
+		struct riff_aviPacket *pkt;
+		for(s = 0; s < avi.streams_len; s++){
+			while(riff_aviDemuxPull(dm, s, &pkt) == RIFF_ERROR_NONE){
+				packets++;
+				riff_aviDemuxPacketFree(pkt);
+			}
+		}
+		CHECK(packets > 0);
+		riff_aviDemuxFree(dm);
+	}
+	riff_aviClose(&avi);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	REQUIRE(argc == 2);
+	FILE *avi = fopen(argv[1], "rb");
+	REQUIRE(avi != NULL);
+
+	riff_allocator a = { &arenaMalloc, &arenaRealloc, &arenaFree, NULL };
+
+	//global allocator, counted from before the first library call
+	heap_calls = 0;
+	riff_setAllocator(&a);
+	FILE *wav = generate("WAVE", &writeWav);
+	FILE *sf2 = generate("sfbk", &writeSf2);
+	FILE *ani = generate("ACON", &writeAni);
+	FILE *deep = generate("TEST", &writeDeep);
+	FILE *nest = generate("TEST", &writeInline);
+	REQUIRE(wav != NULL  &&  sf2 != NULL  &&  ani != NULL  &&  deep != NULL  &&  nest != NULL);
+	useWav(wav);
+	useBank(sf2);
+	useAni(ani);
+	useDeep(deep);
+	riff_handle *rh = openFile(avi);
+	REQUIRE(rh != NULL);
+	useAvi(rh, 1);
+	riff_handleFree(rh);
+	CHECK(heap_calls == 0);
+	CHECK(arena_calls > 0);
+	printf("global allocator: %ld heap calls, %ld arena calls, %zu arena bytes\n", heap_calls, arena_calls, arena_used);
+
+	//per handle allocator, everything built from the handle uses it
+	riff_setAllocator(NULL);
+	long arena_before = arena_calls;
+	heap_calls = 0;
+	rh = riff_handleAllocateWith(&a);
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+	fseek(avi, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, avi, 0) == RIFF_ERROR_NONE);
+	useAvi(rh, 0);
+	riff_handleFree(rh);
+	CHECK(heap_calls == 0);
+	CHECK(arena_calls > arena_before);
+	printf("handle allocator: %ld heap calls, %ld arena calls\n", heap_calls, arena_calls - arena_before);
+
+	//default allocator is the C heap
+	heap_calls = 0;
+	rh = riff_handleAllocate();
+	riff_handleFree(rh);
+	CHECK(heap_calls == 2);
+	useInline(nest);
+
+	fclose(wav);
+	fclose(sf2);
+	fclose(ani);
+	fclose(deep);
+	fclose(nest);
+	fclose(avi);
+	return TEST_RESULT();
+}
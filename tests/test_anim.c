@@ -0,0 +1,203 @@
+// WebP frame index on a generated animated file, see riff_anim.c
+// three "ANMF" frames: plain "VP8L", "ALPH" with an odd sized "VP8 " and an unknown chunk before the image
+// the frames have the blend and dispose flags in all combinations used by encoders
+// the file is read from memory and through a FILE
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_anim.h"
+#include "test.h"
+
+
+#define FRAMES 3
+
+//frame as written
+struct frameInfo {
+	uint32_t x, y, width, height;
+	uint32_t duration;
+	uint8_t flags;
+	const char *c_id;
+	size_t data_size;
+	size_t alpha_size;      //0 if none
+	int unknown;            //unknown chunk before the image
+};
+
+static const struct frameInfo info[FRAMES] = {
+	{0, 0, 16, 12, 100, 0, "VP8L", 8, 0, 0},
+	{2, 4, 6, 4, 50, RIFF_ANIM_DISPOSE, "VP8 ", 7, 5, 0},
+	{10, 0, 3, 3, 200, RIFF_ANIM_NO_BLEND | RIFF_ANIM_DISPOSE, "VP8L", 4, 0, 1},
+};
+
+static uint8_t file[1024];
+static size_t file_len;
+
+//positions as written
+static size_t anmf_pos[FRAMES], data_pos[FRAMES], alpha_pos[FRAMES];
+
+
+
+/*****************************************************************************/
+static void put16(size_t pos, uint16_t v){
+	file[pos] = (uint8_t)v;
+	file[pos + 1] = (uint8_t)(v >> 8);
+}
+
+static void put24(size_t pos, uint32_t v){
+	put16(pos, (uint16_t)v);
+	file[pos + 2] = (uint8_t)(v >> 16);
+}
+
+static void put32(size_t pos, uint32_t v){
+	put16(pos, (uint16_t)v);
+	put16(pos + 2, (uint16_t)(v >> 16));
+}
+
+/*****************************************************************************/
+//chunk with data bytes first, first + 1, ..., returns its position
+static size_t chunk(const char *id, size_t size, uint8_t first){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	put32(pos + 4, (uint32_t)size);
+	size_t i;
+	for(i = 0; i < size; i++)
+		file[pos + 8 + i] = (uint8_t)(first + i);
+	file[pos + 8 + size] = 0;
+	file_len += 8 + size + (size & 0x1);
+	return pos;
+}
+
+/*****************************************************************************/
+//chunk whose data is written by the caller, closed by end()
+static size_t begin(const char *id){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	file_len += 8;
+	return pos;
+}
+
+static void end(size_t pos){
+	put32(pos + 4, (uint32_t)(file_len - pos - 8));
+}
+
+/*****************************************************************************/
+static void makeFile(void){
+	file_len = 0;
+	size_t riff = begin("RIFF");
+	memcpy(file + file_len, "WEBP", 4);
+	file_len += 4;
+
+	//animation flag, canvas 20 x 16
+	size_t pos = chunk("VP8X", 10, 0) + 8;
+	memset(file + pos, 0, 10);
+	file[pos] = 0x02;
+	put24(pos + 4, 20 - 1);
+	put24(pos + 7, 16 - 1);
+	pos = chunk("ANIM", 6, 0) + 8;
+	put32(pos, 0xff102030);
+	put16(pos + 4, 3);
+
+	int k;
+	for(k = 0; k < FRAMES; k++){
+		const struct frameInfo *fi = info + k;
+		anmf_pos[k] = begin("ANMF");
+		pos = file_len;
+		put24(pos, fi->x / 2);
+		put24(pos + 3, fi->y / 2);
+		put24(pos + 6, fi->width - 1);
+		put24(pos + 9, fi->height - 1);
+		put24(pos + 12, fi->duration);
+		file[pos + 15] = fi->flags;
+		file_len += 16;
+		alpha_pos[k] = 0;
+		if(fi->alpha_size > 0)
+			alpha_pos[k] = chunk("ALPH", fi->alpha_size, 0x80) + 8;
+		if(fi->unknown)
+			chunk("XYZW", 3, 0);
+		data_pos[k] = chunk(fi->c_id, fi->data_size, (uint8_t)(k * 16)) + 8;
+		end(anmf_pos[k]);
+	}
+	end(riff);
+}
+
+
+/*****************************************************************************/
+//frame index against what was written
+static void checkAnim(riff_handle *rh){
+	riff_anim anim;
+	CHECK(riff_animOpen(rh, &anim) == RIFF_ERROR_NONE);
+	CHECK(anim.type == RIFF_ANIM_WEBP);
+	CHECK(anim.width == 20  &&  anim.height == 16);
+	CHECK(anim.flags == 0x02);
+	CHECK(anim.background == 0xff102030);
+	CHECK(anim.loops == 3);
+	CHECK(anim.duration == 100 + 50 + 200);
+	CHECK(anim.images == FRAMES);
+	REQUIRE_VOID(anim.frames_len == FRAMES);
+
+	int k;
+	uint64_t start = 0;
+	for(k = 0; k < FRAMES; k++){
+		const struct frameInfo *fi = info + k;
+		const struct riff_animFrame *f = anim.frames + k;
+		CHECK(f->pos == anmf_pos[k]);
+		CHECK(f->data_pos == data_pos[k]);
+		CHECK(f->data_size == fi->data_size);
+		CHECK(strcmp(f->c_id, fi->c_id) == 0);
+		CHECK(f->alpha_pos == alpha_pos[k]);
+		CHECK(f->alpha_size == fi->alpha_size);
+		CHECK(f->x == fi->x  &&  f->y == fi->y);
+		CHECK(f->width == fi->width  &&  f->height == fi->height);
+		CHECK(f->duration == fi->duration);
+		CHECK(f->start == start);
+		CHECK(f->flags == fi->flags);
+		CHECK(f->image == (uint32_t)k);
+		start += fi->duration;
+	}
+
+	//image and alpha data, in reverse order so every seek moves backwards
+	for(k = FRAMES - 1; k >= 0; k--){
+		uint8_t buf[16];
+		CHECK(riff_animSeekFrame(rh, &anim, k) == RIFF_ERROR_NONE);
+		CHECK(strcmp(rh->c_id, "ANMF") == 0);
+		CHECK(riff_readInChunk(rh, buf, info[k].data_size) == info[k].data_size);
+		CHECK(buf[0] == k * 16  &&  buf[info[k].data_size - 1] == k * 16 + info[k].data_size - 1);
+		if(info[k].alpha_size > 0){
+			CHECK(riff_animSeekAlpha(rh, &anim, k) == RIFF_ERROR_NONE);
+			CHECK(riff_readInChunk(rh, buf, 1) == 1  &&  buf[0] == 0x80);
+		}
+		else
+			CHECK(riff_animSeekAlpha(rh, &anim, k) == RIFF_ERROR_EOC);
+	}
+	CHECK(riff_animSeekFrame(rh, &anim, FRAMES) == RIFF_ERROR_EOC);
+
+	CHECK(riff_animFrameAt(&anim, 0) == 0);
+	CHECK(riff_animFrameAt(&anim, 99) == 0);
+	CHECK(riff_animFrameAt(&anim, 100) == 1);
+	CHECK(riff_animFrameAt(&anim, 150) == 2);
+	CHECK(riff_animFrameAt(&anim, 10000) == 2);
+	riff_animClose(&anim);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	makeFile();
+	riff_handle *rh = riff_handleAllocate();
+	FILE *f = tmpfile();
+	REQUIRE(rh != NULL  &&  f != NULL);
+	rh->fp_printf = NULL;
+	REQUIRE(fwrite(file, 1, file_len, f) == file_len);
+
+	CHECK(riff_open_mem(rh, file, file_len) == RIFF_ERROR_NONE);
+	checkAnim(rh);
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, file_len) == RIFF_ERROR_NONE);
+	checkAnim(rh);
+
+	riff_handleFree(rh);
+	fclose(f);
+	return TEST_RESULT();
+}
@@ -0,0 +1,267 @@
+// AVI index loading on a generated OpenDML file, see riff_avi.c
+// stream 0 has a super index "indx" with one standard index "ix00" per "movi" list, the second one in a "RIFF AVIX" chunk
+// stream 1 has no index, it is found by scanning the "movi" lists, also inside a "rec " list
+// the demultiplexer must deliver the same chunks
+// the file is read from memory, through a FILE with and without known size and cut off in the second standard index
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_avi.h"
+#include "riff_avidemux.h"
+#include "test.h"
+
+
+#define FRAMES 10           //of stream 0 per "movi" list
+#define AUDIO 3             //chunks of stream 1 in the first "movi" list, the last one in a "rec " list
+
+static uint8_t file[4096];
+static size_t file_len;
+
+//chunk positions and sizes as written
+static size_t video_pos[2 * FRAMES], audio_pos[AUDIO];
+static size_t ix_pos[2];
+
+
+
+/*****************************************************************************/
+static void put16(size_t pos, uint16_t v){
+	file[pos] = (uint8_t)v;
+	file[pos + 1] = (uint8_t)(v >> 8);
+}
+
+static void put32(size_t pos, uint32_t v){
+	put16(pos, (uint16_t)v);
+	put16(pos + 2, (uint16_t)(v >> 16));
+}
+
+static void put64(size_t pos, uint64_t v){
+	put32(pos, (uint32_t)v);
+	put32(pos + 4, (uint32_t)(v >> 32));
+}
+
+/*****************************************************************************/
+//chunk with zero filled data, returns its position
+static size_t chunk(const char *id, size_t size){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	put32(pos + 4, (uint32_t)size);
+	memset(file + pos + 8, 0, size + (size & 0x1));
+	file_len += 8 + size + (size & 0x1);
+	return pos;
+}
+
+/*****************************************************************************/
+//chunk list or "RIFF" chunk, closed by end()
+static size_t begin(const char *id, const char *type){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	memcpy(file + pos + 8, type, 4);
+	file_len += 12;
+	return pos;
+}
+
+static void end(size_t pos){
+	put32(pos + 4, (uint32_t)(file_len - pos - 8));
+}
+
+/*****************************************************************************/
+//frame data size, odd ones have a pad byte
+static size_t frameSize(size_t frame){
+	return 5 + frame % 4;
+}
+
+/*****************************************************************************/
+//"movi" list with frames of stream 0 starting at first, and its standard index
+static size_t writeMovi(size_t first, int audio, size_t *ix){
+	size_t movi = begin("LIST", "movi");
+	size_t i;
+	for(i = first; i < first + FRAMES; i++){
+		video_pos[i] = chunk("00dc", frameSize(i));
+		file[video_pos[i] + 8] = (uint8_t)i;
+		if(audio  &&  i < AUDIO - 1)
+			audio_pos[i] = chunk("01wb", 4);
+	}
+	if(audio){
+		size_t rec = begin("LIST", "rec ");
+		audio_pos[AUDIO - 1] = chunk("01wb", 4);
+		end(rec);
+	}
+
+	//offsets relative to the first frame, key frames have the top bit of the size clear
+	*ix = chunk("ix00", 24 + FRAMES * 8);
+	uint8_t *h = file + *ix + 8;
+	h[0] = 2;
+	h[3] = 0x01;    //AVI_INDEX_OF_CHUNKS
+	put32(*ix + 12, FRAMES);
+	memcpy(h + 8, "00dc", 4);
+	put64(*ix + 20, video_pos[first]);
+	for(i = 0; i < FRAMES; i++){
+		put32(*ix + 32 + i * 8, (uint32_t)(video_pos[first + i] - video_pos[first] + 8));
+		put32(*ix + 36 + i * 8, (uint32_t)frameSize(first + i) | ((first + i) % 3 ? 0x80000000 : 0));
+	}
+	end(movi);
+	return movi;
+}
+
+/*****************************************************************************/
+static void makeFile(void){
+	file_len = 0;
+	size_t riff = begin("RIFF", "AVI ");
+	size_t hdrl = begin("LIST", "hdrl");
+	chunk("avih", 56);
+
+	size_t strl = begin("LIST", "strl");
+	size_t strh = chunk("strh", 56);
+	memcpy(file + strh + 8, "vids", 4);
+	chunk("strf", 40);
+	size_t indx = chunk("indx", 24 + 2 * 16);
+	end(strl);
+
+	strl = begin("LIST", "strl");
+	strh = chunk("strh", 56);
+	memcpy(file + strh + 8, "auds", 4);
+	chunk("strf", 18);
+	end(strl);
+	end(hdrl);
+
+	writeMovi(0, 1, ix_pos);
+	end(riff);
+	riff = begin("RIFF", "AVIX");
+	writeMovi(FRAMES, 0, ix_pos + 1);
+	end(riff);
+
+	//super index, the entries point to the "ix00" chunks
+	file[indx + 8] = 4;
+	file[indx + 11] = 0x00;     //AVI_INDEX_OF_INDEXES
+	put32(indx + 12, 2);
+	memcpy(file + indx + 16, "00dc", 4);
+	int k;
+	for(k = 0; k < 2; k++){
+		put64(indx + 32 + k * 16, ix_pos[k]);
+		put32(indx + 40 + k * 16, 24 + FRAMES * 8);
+		put32(indx + 44 + k * 16, FRAMES);
+	}
+}
+
+
+/*****************************************************************************/
+//index of both streams against the positions as written
+static void checkIndex(riff_handle *rh){
+	riff_avi avi;
+	CHECK(riff_aviOpen(rh, &avi) == RIFF_ERROR_NONE);
+	REQUIRE_VOID(avi.streams_len == 2);
+	CHECK(avi.movi_len == 2);
+
+	const struct riff_aviStream *st = avi.streams;
+	CHECK(st->index == RIFF_AVI_INDEX_ODML);
+	CHECK(st->idx_len == 2 * FRAMES);
+	size_t i;
+	for(i = 0; i < st->idx_len  &&  i < 2 * FRAMES; i++){
+		CHECK(st->idx[i].pos == video_pos[i]);
+		CHECK(st->idx[i].size == frameSize(i));
+		CHECK(st->idx[i].flags == ((i % 3) ? 0 : RIFF_AVI_KEYFRAME));
+	}
+	CHECK(riff_aviKeyFrame(&avi, 0, FRAMES + 2) == FRAMES + 2);
+	CHECK(riff_aviKeyFrame(&avi, 0, FRAMES + 1) == FRAMES - 1);
+
+	//a frame of the "RIFF AVIX" chunk, then one of the first "movi" list again
+	uint8_t b;
+	CHECK(riff_aviSeekFrame(rh, &avi, 0, FRAMES + 4) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "00dc") == 0);
+	CHECK(rh->c_size == frameSize(FRAMES + 4));
+	CHECK(riff_readInChunk(rh, &b, 1) == 1  &&  b == FRAMES + 4);
+	CHECK(riff_aviSeekFrame(rh, &avi, 0, 1) == RIFF_ERROR_NONE);
+	CHECK(riff_readInChunk(rh, &b, 1) == 1  &&  b == 1);
+
+	st = avi.streams + 1;
+	CHECK(st->index == RIFF_AVI_INDEX_SCAN);
+	CHECK(st->idx_len == AUDIO);
+	for(i = 0; i < st->idx_len  &&  i < AUDIO; i++){
+		CHECK(st->idx[i].pos == audio_pos[i]);
+		CHECK(st->idx[i].size == 4);
+	}
+	riff_aviClose(&avi);
+}
+
+/*****************************************************************************/
+//the demultiplexer walks the same chunks as the scan, in one thread, the queues hold the whole file
+static void checkDemux(riff_handle *rh){
+	riff_avi avi;
+	riff_aviDemux *dm = riff_aviDemuxAllocate();
+	REQUIRE_VOID(dm != NULL);
+	CHECK(riff_aviOpenHeaders(rh, &avi) == RIFF_ERROR_NONE);
+	CHECK(riff_aviDemuxBegin(dm, rh, &avi) == RIFF_ERROR_NONE);
+	CHECK(riff_aviDemuxRun(dm) == RIFF_ERROR_NONE);
+	struct riff_aviPacket *pkt;
+	size_t i;
+	for(i = 0; riff_aviDemuxPull(dm, 0, &pkt) == RIFF_ERROR_NONE; i++){
+		CHECK(i < 2 * FRAMES  &&  pkt->pos == video_pos[i]  &&  pkt->size == frameSize(i)  &&  pkt->data[0] == i);
+		riff_aviDemuxPacketFree(pkt);
+	}
+	CHECK(i == 2 * FRAMES);
+	for(i = 0; riff_aviDemuxPull(dm, 1, &pkt) == RIFF_ERROR_NONE; i++){
+		CHECK(i < AUDIO  &&  pkt->pos == audio_pos[i]);
+		riff_aviDemuxPacketFree(pkt);
+	}
+	CHECK(i == AUDIO);
+	riff_aviDemuxFree(dm);
+	riff_aviClose(&avi);
+}
+
+/*****************************************************************************/
+//a standard index cut off by the end of the file keeps the entries that are there, with and without known file size
+static void checkCutOff(riff_handle *rh, size_t entries){
+	riff_avi avi;
+	CHECK(riff_aviOpen(rh, &avi) == RIFF_ERROR_NONE);
+	REQUIRE_VOID(avi.streams_len == 2);
+	const struct riff_aviStream *st = avi.streams;
+	CHECK(st->index == RIFF_AVI_INDEX_ODML);
+	CHECK(st->idx_len == FRAMES + entries);
+	size_t i;
+	for(i = 0; i < st->idx_len  &&  i < 2 * FRAMES; i++)
+		CHECK(st->idx[i].pos == video_pos[i]);
+	riff_aviClose(&avi);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	makeFile();
+	riff_handle *rh = riff_handleAllocate();
+	FILE *f = tmpfile();
+	REQUIRE(rh != NULL  &&  f != NULL);
+	rh->fp_printf = NULL;
+	REQUIRE(fwrite(file, 1, file_len, f) == file_len);
+
+	//the "RIFF AVIX" chunk is data behind the RIFF chunk for riff_open_...()
+	CHECK(riff_open_mem(rh, file, file_len) == RIFF_ERROR_EXDAT);
+	checkIndex(rh);
+	checkDemux(rh);
+
+	//file size given and unknown, the index chunks are read outside of the level structure
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, file_len) == RIFF_ERROR_EXDAT);
+	checkIndex(rh);
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, 0) == RIFF_ERROR_NONE);
+	checkIndex(rh);
+
+	//cut in the fourth entry of the second "ix00"
+	size_t cut = ix_pos[1] + 32 + 8 * 3 + 5;
+	CHECK(riff_open_mem(rh, file, cut) == RIFF_ERROR_EXDAT);
+	checkCutOff(rh, 3);
+	fclose(f);
+	f = tmpfile();
+	REQUIRE(f != NULL);
+	REQUIRE(fwrite(file, 1, cut, f) == cut);
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, 0) == RIFF_ERROR_NONE);
+	checkCutOff(rh, 3);
+
+	riff_handleFree(rh);
+	fclose(f);
+	return TEST_RESULT();
+}
@@ -0,0 +1,112 @@
+// AVI demultiplexer, see riff_avidemux.c
+// a stream nobody pulls is disabled while the reader is blocked on its full queue, the reader must continue
+// usage: test_avidemux <AVI file with two streams>, e.g. sample/test.avi
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "riff_avi.h"
+#include "riff_avidemux.h"
+#include "riff_internal.h"
+#include "test.h"
+
+
+#define QUEUE_BYTES 64    //one packet per queue, the reader blocks soon
+
+
+
+/*****************************************************************************/
+#if defined(_WIN32)
+static DWORD WINAPI runReader(LPVOID dm){
+	return (DWORD)riff_aviDemuxRun((riff_aviDemux *)dm);
+}
+#else
+static void *runReader(void *dm){
+	static int r;
+	r = riff_aviDemuxRun((riff_aviDemux *)dm);
+	return &r;
+}
+#endif
+
+/*****************************************************************************/
+//wait until the next packet of the stream doesn't fit into its queue, the reader blocks on it then
+//dm_push() wakes us after each packet, the queue is only read under the lock
+static void waitFull(riff_aviDemux *dm, const riff_avi *avi, size_t stream){
+	const struct riff_aviQueue *q = dm->queues + stream;
+	const struct riff_aviStream *st = avi->streams + stream;
+	sync_lock(dm->sync);
+	while(!dm->done  &&  !(q->len > 0  &&  q->frames < st->idx_len  &&  q->bytes + st->idx[q->frames].size > q->max_bytes))
+		sync_wait(dm->sync);
+	int full = !dm->done;
+	sync_unlock(dm->sync);
+	CHECK(full);
+}
+
+
+/*****************************************************************************/
+int main(int argc, char *argv[]){
+	REQUIRE(argc == 2);
+	FILE *f = fopen(argv[1], "rb");
+	REQUIRE(f != NULL);
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+	REQUIRE(riff_open_file(rh, f, 0) == RIFF_ERROR_NONE);
+	riff_avi avi;
+	REQUIRE(riff_aviOpen(rh, &avi) == RIFF_ERROR_NONE);
+	REQUIRE(avi.streams_len >= 2);
+
+	riff_aviDemux *dm = riff_aviDemuxAllocate();
+	REQUIRE(dm != NULL);
+	dm->queue_bytes = QUEUE_BYTES;
+	REQUIRE(riff_aviDemuxBegin(dm, rh, &avi) == RIFF_ERROR_NONE);
+
+	int r;
+#if defined(_WIN32)
+	HANDLE t = CreateThread(NULL, 0, &runReader, dm, 0, NULL);
+	REQUIRE(t != NULL);
+#else
+	pthread_t t;
+	REQUIRE(pthread_create(&t, NULL, &runReader, dm) == 0);
+#endif
+
+	//stream 1 (the frequent small packets) is never pulled
+	waitFull(dm, &avi, 1);
+	CHECK(riff_aviDemuxSelect(dm, 1, 0) == RIFF_ERROR_NONE);
+	size_t packets = 0;
+	struct riff_aviPacket *pkt;
+	while(riff_aviDemuxPull(dm, 0, &pkt) == RIFF_ERROR_NONE){
+		CHECK(pkt->stream == 0);
+		packets++;
+		riff_aviDemuxPacketFree(pkt);
+	}
+	CHECK(packets == avi.streams[0].idx_len);
+	CHECK(riff_aviDemuxPull(dm, 1, &pkt) == RIFF_ERROR_EOCL);
+
+#if defined(_WIN32)
+	DWORD code;
+	WaitForSingleObject(t, INFINITE);
+	GetExitCodeThread(t, &code);
+	CloseHandle(t);
+	r = (int)code;
+#else
+	void *ret;
+	pthread_join(t, &ret);
+	r = *(int *)ret;
+#endif
+	CHECK(r == RIFF_ERROR_NONE);
+
+	riff_aviDemuxFree(dm);
+	riff_aviClose(&avi);
+	riff_handleFree(rh);
+	fclose(f);
+	return TEST_RESULT();
+}
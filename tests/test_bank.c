@@ -0,0 +1,246 @@
+// DLS headers on a generated file, see riff_bank.c
+// one instrument with two regions in "lins", two waves in "wvpl" and a pool table listing them in reverse order
+// the first region has its own "wsmp" chunk, the second one takes that of its wave
+// the file is read from memory and through a FILE with and without known size
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_bank.h"
+#include "test.h"
+
+
+#define WAVE0 6             //data bytes of the waves, the second one with pad byte
+#define WAVE1 9
+
+static uint8_t file[1024];
+static size_t file_len;
+
+//positions as written
+static size_t wvpl_pos, wave_pos[2], data_pos[2];
+
+
+
+/*****************************************************************************/
+static void put16(size_t pos, uint16_t v){
+	file[pos] = (uint8_t)v;
+	file[pos + 1] = (uint8_t)(v >> 8);
+}
+
+static void put32(size_t pos, uint32_t v){
+	put16(pos, (uint16_t)v);
+	put16(pos + 2, (uint16_t)(v >> 16));
+}
+
+/*****************************************************************************/
+//chunk with zero filled data, returns its position
+static size_t chunk(const char *id, size_t size){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	put32(pos + 4, (uint32_t)size);
+	memset(file + pos + 8, 0, size + (size & 0x1));
+	file_len += 8 + size + (size & 0x1);
+	return pos;
+}
+
+/*****************************************************************************/
+//chunk list or "RIFF" chunk, closed by end()
+static size_t begin(const char *id, const char *type){
+	size_t pos = file_len;
+	memcpy(file + pos, id, 4);
+	memcpy(file + pos + 8, type, 4);
+	file_len += 12;
+	return pos;
+}
+
+static void end(size_t pos){
+	put32(pos + 4, (uint32_t)(file_len - pos - 8));
+}
+
+/*****************************************************************************/
+//"wsmp" chunk with one loop if loop_start is not 0
+static void wsmp(uint16_t unity_note, uint32_t loop_start){
+	size_t pos = chunk("wsmp", loop_start ? 20 + 16 : 20) + 8;
+	put32(pos, 20);
+	put16(pos + 4, unity_note);
+	put16(pos + 6, (uint16_t)-5);
+	put32(pos + 8, (uint32_t)-100);
+	put32(pos + 12, 0x2);
+	if(loop_start){
+		put32(pos + 16, 1);
+		put32(pos + 20, 16);
+		put32(pos + 24, 1);
+		put32(pos + 28, loop_start);
+		put32(pos + 32, 3);
+	}
+}
+
+/*****************************************************************************/
+static void region(uint16_t key_lo, uint16_t key_hi, uint32_t table_index, int own_wsmp){
+	size_t rgn = begin("LIST", "rgn ");
+	size_t pos = chunk("rgnh", 12) + 8;
+	put16(pos, key_lo);
+	put16(pos + 2, key_hi);
+	put16(pos + 6, 127);
+	put16(pos + 8, 1);
+	put16(pos + 10, 2);
+	if(own_wsmp)
+		wsmp(key_lo, 2);
+	pos = chunk("wlnk", 12) + 8;
+	put32(pos + 4, 1);
+	put32(pos + 8, table_index);
+	end(rgn);
+}
+
+/*****************************************************************************/
+static void wave(int k, size_t size){
+	wave_pos[k] = begin("LIST", "wave");
+	size_t pos = chunk("fmt ", 16) + 8;
+	put16(pos, 1);
+	put16(pos + 2, 1);
+	put32(pos + 4, 22050 * (k + 1));
+	put32(pos + 8, 2 * 22050 * (k + 1));
+	put16(pos + 12, 2);
+	put16(pos + 14, 16);
+	wsmp(60 + k, 0);
+	data_pos[k] = chunk("data", size);
+	size_t i;
+	for(i = 0; i < size; i++)
+		file[data_pos[k] + 8 + i] = (uint8_t)(k * 16 + i);
+	end(wave_pos[k]);
+}
+
+/*****************************************************************************/
+static void makeFile(void){
+	file_len = 0;
+	size_t riff = begin("RIFF", "DLS ");
+	put32(chunk("colh", 4) + 8, 1);
+
+	size_t lins = begin("LIST", "lins");
+	size_t ins = begin("LIST", "ins ");
+	size_t pos = chunk("insh", 12) + 8;
+	put32(pos, 2);
+	put32(pos + 4, 0x80000000);     //drum flag
+	put32(pos + 8, 5);
+	size_t lrgn = begin("LIST", "lrgn");
+	region(36, 47, 1, 1);
+	region(48, 59, 0, 0);
+	end(lrgn);
+	size_t info = begin("LIST", "INFO");
+	memcpy(file + chunk("INAM", 6) + 8, "Drums", 6);
+	end(info);
+	end(ins);
+	end(lins);
+
+	//pool offsets are filled in once the waves are written
+	size_t ptbl = chunk("ptbl", 8 + 2 * 4) + 8;
+	put32(ptbl, 8);
+	put32(ptbl + 4, 2);
+
+	wvpl_pos = begin("LIST", "wvpl");
+	wave(0, WAVE0);
+	wave(1, WAVE1);
+	end(wvpl_pos);
+	end(riff);
+
+	put32(ptbl + 8, (uint32_t)(wave_pos[1] - wvpl_pos - 12));
+	put32(ptbl + 12, (uint32_t)(wave_pos[0] - wvpl_pos - 12));
+}
+
+
+/*****************************************************************************/
+static void checkWsmp(const struct riff_dlsWsmp *w, uint16_t unity_note, uint32_t loop_start){
+	CHECK(w->present);
+	CHECK(w->unity_note == unity_note);
+	CHECK(w->fine_tune == -5);
+	CHECK(w->gain == -100);
+	CHECK(w->options == 0x2);
+	CHECK(w->loops == (loop_start ? 1 : 0));
+	CHECK(w->loop_start == loop_start);
+	CHECK(w->loop_length == (loop_start ? 3 : 0));
+}
+
+/*****************************************************************************/
+//headers against what was written, the samples point into the file if it is in memory
+static void checkBank(riff_handle *rh, int mem){
+	riff_bank bank;
+	CHECK(riff_bankOpen(rh, &bank) == RIFF_ERROR_NONE);
+	CHECK(bank.type == RIFF_BANK_DLS);
+	CHECK(rh->ls_level == 0  &&  rh->c_pos_start == 12);
+
+	REQUIRE_VOID(bank.instruments_len == 1);
+	const struct riff_dlsInstrument *ins = bank.instruments;
+	CHECK(strcmp(ins->name, "Drums") == 0);
+	CHECK(ins->bank == 0x80000000);
+	CHECK(ins->program == 5);
+	CHECK(ins->region == 0  &&  ins->regions_len == 2);
+
+	REQUIRE_VOID(bank.regions_len == 2);
+	const struct riff_dlsRegion *rg = bank.regions;
+	CHECK(rg->key_lo == 36  &&  rg->key_hi == 47);
+	CHECK(rg->vel_lo == 0  &&  rg->vel_hi == 127);
+	CHECK(rg->options == 1  &&  rg->key_group == 2);
+	CHECK(rg->channel == 1);
+	//pool table index 1 holds the offset of the first wave
+	CHECK(rg->table_index == 1  &&  rg->wave == 0);
+	checkWsmp(&rg->wsmp, 36, 2);
+	rg++;
+	CHECK(rg->key_lo == 48  &&  rg->key_hi == 59);
+	CHECK(rg->table_index == 0  &&  rg->wave == 1);
+	checkWsmp(&rg->wsmp, 61, 0);
+
+	CHECK(bank.cues_len == 2);
+	CHECK(bank.smpl.pos == wvpl_pos + 12);
+	REQUIRE_VOID(bank.waves_len == 2);
+	int k;
+	for(k = 0; k < 2; k++){
+		const struct riff_dlsWave *w = bank.waves + k;
+		CHECK(w->offset == wave_pos[k] - wvpl_pos - 12);
+		CHECK(w->format_tag == 1  &&  w->channels == 1);
+		CHECK(w->sample_rate == 22050u * (k + 1));
+		CHECK(w->block_align == 2  &&  w->bits_per_sample == 16);
+		checkWsmp(&w->wsmp, 60 + k, 0);
+
+		//sample data through the slice
+		struct riff_bankSlice s;
+		size_t size = k ? WAVE1 : WAVE0;
+		CHECK(riff_bankSample(&bank, k, &s) == RIFF_ERROR_NONE);
+		CHECK(s.pos == data_pos[k] + 8);
+		CHECK(s.size == size);
+		CHECK((s.data != NULL) == mem);
+		uint8_t buf[16];
+		CHECK(riff_bankRead(rh, &s, 0, buf, sizeof(buf)) == size);
+		size_t i;
+		for(i = 0; i < size; i++)
+			CHECK(buf[i] == k * 16 + i);
+	}
+	CHECK(rh->ls_level == 0  &&  rh->c_pos_start == 12);
+	riff_bankClose(&bank);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	makeFile();
+	riff_handle *rh = riff_handleAllocate();
+	FILE *f = tmpfile();
+	REQUIRE(rh != NULL  &&  f != NULL);
+	rh->fp_printf = NULL;
+	REQUIRE(fwrite(file, 1, file_len, f) == file_len);
+
+	CHECK(riff_open_mem(rh, file, file_len) == RIFF_ERROR_NONE);
+	checkBank(rh, 1);
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, file_len) == RIFF_ERROR_NONE);
+	checkBank(rh, 0);
+	//file size unknown
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, 0) == RIFF_ERROR_NONE);
+	checkBank(rh, 0);
+
+	riff_handleFree(rh);
+	fclose(f);
+	return TEST_RESULT();
+}
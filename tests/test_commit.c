@@ -0,0 +1,146 @@
+// crash-consistent recording, see riff_writerCommit() and riff_writerSetCommitPolicy() in riff_writer.c
+// after every write the file is taken as the OS has it, like after the process died without riff_writerClose()
+// every such snapshot and its truncations behind the last commit are reopened with riff_open_file()
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "test.h"
+
+
+#define INTERVAL 1000
+#define WRITES 200
+#define SLICE_MAX 500
+
+//RIFF "TEST": "fmt " (4), LIST "strm" { "data" (growing) }
+static const uint8_t fmt[4] = {1, 2, 3, 4};
+
+
+
+/*****************************************************************************/
+static uint8_t pattern(size_t i){
+	return (uint8_t)(i * 7 + 1);
+}
+
+/*****************************************************************************/
+//file content as the OS has it, the writer buffer and the FILE buffer are lost
+static uint8_t *snapshot(FILE *f, size_t *size){
+	struct stat st;
+	if(fstat(fileno(f), &st) != 0)
+		return NULL;
+	*size = (size_t)st.st_size;
+	uint8_t *buf = malloc(*size + 1);
+	if(buf != NULL  &&  pread(fileno(f), buf, *size, 0) != (ssize_t)*size){
+		free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+/*****************************************************************************/
+//reopen the first size bytes, "data" must hold exactly the committed bytes
+static void checkReopen(const uint8_t *buf, size_t size, size_t committed){
+	FILE *f = tmpfile();
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE_VOID(f != NULL  &&  rh != NULL);
+	rh->fp_printf = NULL;
+	CHECK(fwrite(buf, 1, size, f) == size);
+	fseek(f, 0, SEEK_SET);
+
+	//with the exact file size the uncommitted data behind the RIFF end is reported
+	int r = riff_open_file(rh, f, size);
+	CHECK(r == RIFF_ERROR_NONE  ||  r == RIFF_ERROR_EXDAT);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "fmt ") == 0);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekLevelSub(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(rh->c_size == committed);
+	if(rh->c_size != committed)
+		fprintf(stderr, "%zu bytes: data chunk %zu, committed %zu\n", size, (size_t)rh->c_size, committed);
+
+	uint8_t data[SLICE_MAX];
+	size_t i = 0, n, k;
+	while((n = riff_readInChunk(rh, data, sizeof(data))) > 0){
+		for(k = 0; k < n  &&  data[k] == pattern(i + k); k++);
+		CHECK(k == n);
+		i += n;
+	}
+	CHECK(i == committed);
+
+	riff_handleFree(rh);
+	fclose(f);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	REQUIRE(f != NULL  &&  rw != NULL);
+	rw->fp_printf = NULL;
+
+	REQUIRE(riff_writer_open_file(rw, f, "TEST") == RIFF_ERROR_NONE);
+	REQUIRE(riff_writerWriteChunk(rw, "fmt ", fmt, sizeof(fmt)) == RIFF_ERROR_NONE);
+	REQUIRE(riff_writerBeginList(rw, "strm") == RIFF_ERROR_NONE);
+	REQUIRE(riff_writerBeginChunk(rw, "data") == RIFF_ERROR_NONE);
+	size_t data_start = rw->pos;
+	riff_writerSetCommitPolicy(rw, INTERVAL, RIFF_WRITER_SYNC_NONE);
+
+	//odd slice sizes, so commits also cut the data chunk before its pad byte
+	uint8_t slice[SLICE_MAX];
+	size_t written = 0, snapshots = 0;
+	int w;
+	for(w = 0; w < WRITES; w++){
+		size_t n = 1 + (size_t)w * 37 % SLICE_MAX, k;
+		for(k = 0; k < n; k++)
+			slice[k] = pattern(written + k);
+		CHECK(riff_writerWrite(rw, slice, n) == n);
+		written += n;
+		if(rw->commit_count == 0)
+			continue;
+
+		//never more than one interval and one write behind
+		size_t committed = rw->commit_pos - data_start;
+		CHECK(committed <= written);
+		CHECK(written - committed <= INTERVAL + n);
+
+		size_t size;
+		uint8_t *buf = snapshot(f, &size);
+		REQUIRE(buf != NULL);
+		CHECK(size >= rw->commit_pos);
+		//abandoned as is, truncated right behind the commit and somewhere between
+		checkReopen(buf, size, committed);
+		checkReopen(buf, rw->commit_pos, committed);
+		checkReopen(buf, rw->commit_pos + (size - rw->commit_pos) / 2, committed);
+		free(buf);
+		snapshots++;
+	}
+	CHECK(snapshots > 0);
+	CHECK(rw->commit_error == RIFF_ERROR_NONE);
+
+	//cost: 4 bytes for each of RIFF, LIST and "data" per commit, about one commit per interval
+	printf("%zu bytes, %zu commits, %zu extra bytes (%.3f%%)\n", written, rw->commit_count, rw->commit_bytes, 100.0 * rw->commit_bytes / written);
+	CHECK(rw->commit_bytes == rw->commit_count * 3 * 4);
+	CHECK(rw->commit_count <= written / INTERVAL);
+
+	//after closing the file is complete
+	CHECK(riff_writerClose(rw) == RIFF_ERROR_NONE);
+	size_t size;
+	uint8_t *buf = snapshot(f, &size);
+	REQUIRE(buf != NULL);
+	checkReopen(buf, size, written);
+	free(buf);
+
+	riff_writerFree(rw);
+	fclose(f);
+	return TEST_RESULT();
+}
@@ -0,0 +1,173 @@
+// C++ wrapper ownership, see RIFFFile in riff.hpp
+// RIFFFile is move-only, duplicate() makes a second cursor that reads independently of the original
+// every source type is read interleaved through both cursors
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <utility>
+
+#include "riff.hpp"
+#include "test.h"
+
+
+#define FILE_NAME "test_cxx.riff"
+
+//RIFF "TEST": "aaaa" (4), "bbbb" (4), "cccc" (4)
+static const uint8_t file_abc[] = {
+	'R','I','F','F', 40,0,0,0, 'T','E','S','T',
+	'a','a','a','a', 4,0,0,0, 1,2,3,4,
+	'b','b','b','b', 4,0,0,0, 5,6,7,8,
+	'c','c','c','c', 4,0,0,0, 9,10,11,12,
+};
+
+static_assert(!std::is_copy_constructible<RIFF::RIFFFile>::value, "RIFFFile must not be copyable");
+static_assert(!std::is_copy_assignable<RIFF::RIFFFile>::value, "RIFFFile must not be copyable");
+static_assert(std::is_nothrow_move_constructible<RIFF::RIFFFile>::value, "RIFFFile must be movable");
+static_assert(std::is_nothrow_move_assignable<RIFF::RIFFFile>::value, "RIFFFile must be movable");
+
+
+
+/*****************************************************************************/
+//read n bytes of the current chunk, they must continue at value first
+static void checkRead(RIFF::RIFFFile &f, size_t n, uint8_t first){
+	uint8_t buf[4] = {0};
+	CHECK(n <= sizeof(buf));
+	CHECK(f.readInChunk(buf, n) == n);
+	size_t i;
+	for(i = 0; i < n; i++)
+		CHECK(buf[i] == first + i);
+}
+
+static void checkChunk(RIFF::RIFFFile &f, const char *id){
+	CHECK(f.seekNextChunk() == RIFF_ERROR_NONE);
+	CHECK(strcmp(f().c_id, id) == 0);
+}
+
+/*****************************************************************************/
+//f is open at "aaaa", the duplicate and f alternate, each at its own position
+static void checkDuplicate(const char *name, RIFF::RIFFFile &f){
+	REQUIRE_VOID(f.latestError() == RIFF_ERROR_NONE);
+	auto fp_read = f().fp_read;
+	auto fp_seek = f().fp_seek;
+	checkRead(f, 2, 1);
+
+	RIFF::RIFFFile d = f.duplicate();
+	if(d.latestError() != RIFF_ERROR_NONE)
+		fprintf(stderr, "%s: duplicate failed\n", name);
+	REQUIRE_VOID(d.latestError() == RIFF_ERROR_NONE);
+	//the original keeps its I/O functions, e.g. for the kernel copy of riff_copyChunkTo()
+	CHECK(f().fp_read == fp_read);
+	CHECK(f().fp_seek == fp_seek);
+
+	checkRead(d, 2, 3);
+	checkChunk(d, "bbbb");
+	checkRead(d, 4, 5);
+	checkRead(f, 2, 3);
+	checkChunk(f, "bbbb");
+	checkRead(f, 2, 5);
+	checkChunk(d, "cccc");
+	checkRead(f, 2, 7);
+	checkRead(d, 4, 9);
+	checkChunk(f, "cccc");
+	checkRead(f, 4, 9);
+	CHECK(d.seekNextChunk() == RIFF_ERROR_EOCL);
+
+	//a duplicate of the duplicate, the first one can go first
+	CHECK(d.rewind() == RIFF_ERROR_NONE);
+	RIFF::RIFFFile dd = d.duplicate();
+	d.close();
+	CHECK(dd.latestError() == RIFF_ERROR_NONE);
+	checkRead(dd, 4, 1);
+}
+
+/*****************************************************************************/
+//moves take the handle and the file, the source is left without handle
+static void checkMove(){
+	RIFF::RIFFFile a;
+	REQUIRE_VOID(a.openCFILE(FILE_NAME) == RIFF_ERROR_NONE);
+	checkRead(a, 2, 1);
+
+	RIFF::RIFFFile b(std::move(a));
+	checkRead(b, 2, 3);
+	checkChunk(b, "bbbb");
+
+	RIFF::RIFFFile c;
+	CHECK(c.openMemory(file_abc, sizeof(file_abc)) == RIFF_ERROR_NONE);
+	c = std::move(b);
+	checkRead(c, 4, 5);
+	checkChunk(c, "cccc");
+
+	//a moved-from object has no handle left
+	CHECK(a.openMemory(file_abc, sizeof(file_abc)) == RIFF_ERROR_INVALID_HANDLE);
+	CHECK(b.openMemory(file_abc, sizeof(file_abc)) == RIFF_ERROR_INVALID_HANDLE);
+}
+
+/*****************************************************************************/
+//the writer owns the stream of openFstream(), it is closed by close() or with a moved-to writer
+static void checkWriterFstream(){
+	const uint8_t data[4] = {1, 2, 3, 4};
+	RIFF::RIFFWriter w;
+	CHECK(w.openFstream(FILE_NAME, "TEST") == RIFF_ERROR_NONE);
+	CHECK(w.writeChunk("aaaa", data, sizeof(data)) == RIFF_ERROR_NONE);
+	RIFF::RIFFWriter m(std::move(w));
+	CHECK(m.writeChunk("bbbb", data, sizeof(data)) == RIFF_ERROR_NONE);
+	CHECK(m.close() == RIFF_ERROR_NONE);
+	CHECK(m.file == nullptr);
+
+	//a failed open leaves the writer closed
+	CHECK(m.openFstream("no_such_directory/" FILE_NAME, "TEST") == RIFF_ERROR_ACCESS);
+	CHECK(m.close() == RIFF_ERROR_NONE);
+
+	RIFF::RIFFFile f(FILE_NAME);
+	REQUIRE_VOID(f.latestError() == RIFF_ERROR_NONE);
+	CHECK(f().h_size == 4 + 2 * 12);
+	checkRead(f, 4, 1);
+	checkChunk(f, "bbbb");
+	checkRead(f, 4, 1);
+	CHECK(f.seekNextChunk() == RIFF_ERROR_EOCL);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	FILE *tmp = fopen(FILE_NAME, "wb");
+	REQUIRE(tmp != NULL);
+	REQUIRE(fwrite(file_abc, 1, sizeof(file_abc), tmp) == sizeof(file_abc));
+	fclose(tmp);
+
+	{
+		RIFF::RIFFFile f;
+		f.openCFILE(FILE_NAME);
+		checkDuplicate("C FILE by name", f);
+	}
+	{
+		FILE *cf = fopen(FILE_NAME, "rb");
+		REQUIRE(cf != NULL);
+		RIFF::RIFFFile f(*cf, sizeof(file_abc));
+		checkDuplicate("C FILE of the caller", f);
+		f.close();
+		fclose(cf);
+	}
+	{
+		RIFF::RIFFFile f(FILE_NAME);
+		checkDuplicate("std::fstream by name", f);
+	}
+	{
+		std::fstream fs(FILE_NAME, std::ios_base::in|std::ios_base::binary);
+		RIFF::RIFFFile f(fs, sizeof(file_abc));
+		checkDuplicate("std::fstream of the caller", f);
+	}
+	{
+		RIFF::RIFFFile f(file_abc, sizeof(file_abc));
+		checkDuplicate("memory", f);
+	}
+	checkMove();
+	checkWriterFstream();
+
+	remove(FILE_NAME);
+	return TEST_RESULT();
+}
@@ -0,0 +1,161 @@
+// 64 bit sizes of BW64 files, see riff_readHeader() and ds64Read() in riff.c
+// the file is sparse: only the headers are written, the 4 GB of "data" are a hole
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_edit.h"
+#include "test.h"
+
+
+#define TEST_SKIP 77    //ctest SKIP_RETURN_CODE
+
+#define DATA_SIZE 0x100000010ull    //"data" chunk beyond 4 GB, even
+
+
+
+/*****************************************************************************/
+static void putU32(uint8_t *p, uint32_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+/*****************************************************************************/
+static void putU64(uint8_t *p, uint64_t v){
+	putU32(p, (uint32_t)v);
+	putU32(p + 4, (uint32_t)(v >> 32));
+}
+
+/*****************************************************************************/
+static void putHeader(uint8_t *p, const char *id, uint32_t size){
+	memcpy(p, id, 4);
+	putU32(p + 4, size);
+}
+
+
+/*****************************************************************************/
+//BW64 WAVE: ds64 with one table entry, "fmt ", "data" (size from ds64), "xtra" (size from table), "tail"
+//returns total file size, 0 on error
+static uint64_t writeSparse(FILE *f){
+	uint8_t h[92];
+	const uint64_t data_end = sizeof(h) + DATA_SIZE;
+	const uint64_t total = data_end + 8 + 6 + 8 + 4;
+
+	putHeader(h, "BW64", 0xFFFFFFFF);
+	memcpy(h + 8, "WAVE", 4);
+	putHeader(h + 12, "ds64", 28 + 12);
+	putU64(h + 20, total - 8);              //RIFF size
+	putU64(h + 28, DATA_SIZE);              //data size
+	putU64(h + 36, DATA_SIZE / 2);          //sample count
+	putU32(h + 44, 1);                      //table length
+	memcpy(h + 48, "xtra", 4);
+	putU64(h + 52, 6);
+	putHeader(h + 60, "fmt ", 16);
+	putU32(h + 68, 0x00010001);             //PCM, mono
+	putU32(h + 72, 8000);
+	putU32(h + 76, 16000);
+	putU32(h + 80, 0x00100002);             //block align 2, 16 bit
+	putHeader(h + 84, "data", 0xFFFFFFFF);
+	if(fwrite(h, 1, sizeof(h), f) != sizeof(h))
+		return 0;
+
+	uint8_t t[26];
+	putHeader(t, "xtra", 0xFFFFFFFF);
+	memcpy(t + 8, "abcdef", 6);
+	putHeader(t + 14, "tail", 4);
+	memcpy(t + 22, "TAIL", 4);
+	if(fseek(f, (long)data_end, SEEK_SET) != 0  ||  fwrite(t, 1, sizeof(t), f) != sizeof(t))
+		return 0;
+	if(fflush(f) != 0  ||  fseek(f, 0, SEEK_SET) != 0)
+		return 0;
+	return total;
+}
+
+
+/*****************************************************************************/
+int main(void){
+	//FILE based handles seek with long
+	if(sizeof(long) < 8  ||  sizeof(size_t) < 8){
+		printf("skipped, no 64 bit file offsets\n");
+		return TEST_SKIP;
+	}
+
+	FILE *f = tmpfile();
+	REQUIRE(f != NULL);
+	uint64_t total = writeSparse(f);
+	if(total == 0){
+		fclose(f);
+		printf("skipped, can't create sparse file\n");
+		return TEST_SKIP;
+	}
+
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+
+	REQUIRE(riff_open_file(rh, f, (size_t)total) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "BW64") == 0);
+	CHECK(rh->h_size == total - 8);
+	CHECK(rh->ds64 == 1);
+	CHECK(rh->ds64_data == DATA_SIZE);
+	CHECK(rh->ds64_samples == DATA_SIZE / 2);
+	CHECK(rh->ds64_table_len == 1);
+
+	REQUIRE(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "fmt ") == 0);
+
+	//size field 0xFFFFFFFF, size from the ds64 data size
+	REQUIRE(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(rh->c_pos_start == 84);
+	CHECK(rh->c_size == DATA_SIZE);
+
+	//first chunk past 4 GB, size from the ds64 table
+	REQUIRE(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "xtra") == 0);
+	CHECK(rh->c_pos_start == 92 + DATA_SIZE);
+	CHECK(rh->c_size == 6);
+	char buf[8] = "";
+	CHECK(riff_readInChunk(rh, buf, sizeof(buf)) == 6);
+	CHECK(memcmp(buf, "abcdef", 6) == 0);
+
+	REQUIRE(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "tail") == 0);
+	CHECK(rh->c_size == 4);
+	CHECK(riff_readInChunk(rh, buf, 4) == 4);
+	CHECK(memcmp(buf, "TAIL", 4) == 0);
+
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_EOCL);
+
+	//seeking back over the 4 GB chunk
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "ds64") == 0);
+
+	//shrinking it in place, the freed 4 GB don't fit into one 32 bit JUNK size
+	int path = RIFF_EDIT_NONE;
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	REQUIRE(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(riff_editReplaceChunk(rh, "abcd", 4, NULL, &path) == RIFF_ERROR_NONE);
+	CHECK(path == RIFF_EDIT_JUNK);
+
+	const char *ids[] = { "ds64", "fmt ", "data", "JUNK", "JUNK", "xtra", "tail" };
+	const uint64_t sizes[] = { 40, 16, 4, 0xFFFFFFF6, 6, 6, 4 };
+	size_t i;
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	for(i = 0; i < sizeof(ids) / sizeof(ids[0]); i++){
+		CHECK(strcmp(rh->c_id, ids[i]) == 0);
+		CHECK(rh->c_size == sizes[i]);
+		CHECK(riff_seekNextChunk(rh) == ((i + 1 < sizeof(ids) / sizeof(ids[0])) ? RIFF_ERROR_NONE : RIFF_ERROR_EOCL));
+	}
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+
+	riff_handleFree(rh);
+	fclose(f);
+	return TEST_RESULT();
+}
@@ -0,0 +1,98 @@
+// in-place chunk replacement, see edit_inPlace() in riff_edit.c
+// every case edits a fresh temporary copy of the same small file
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_edit.h"
+#include "test.h"
+
+
+//RIFF "TEST": "JUNK" (16), "aaaa" (4), "bbbb" (2)
+static const uint8_t file_junk[] = {
+	'R','I','F','F', 50,0,0,0, 'T','E','S','T',
+	'J','U','N','K', 16,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	'a','a','a','a', 4,0,0,0, 1,2,3,4,
+	'b','b','b','b', 2,0,0,0, 5,6,
+};
+
+//expected chunk after the edit
+struct editCase {
+	const char *name;
+	size_t size;        //new size of "aaaa"
+	int path;           //RIFF_EDIT_...
+	size_t pos;         //new position of "aaaa"
+	const char *ids;    //chunk IDs of level 0, first char each
+};
+
+
+
+/*****************************************************************************/
+static void runCase(const struct editCase *c){
+	uint8_t data[64];
+	size_t i;
+	for(i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t)(0x40 + i);
+
+	FILE *f = tmpfile();
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE_VOID(f != NULL  &&  rh != NULL);
+	rh->fp_printf = NULL;
+	CHECK(fwrite(file_junk, 1, sizeof(file_junk), f) == sizeof(file_junk));
+	fseek(f, 0, SEEK_SET);
+
+	int path = RIFF_EDIT_NONE;
+	CHECK(riff_open_file(rh, f, sizeof(file_junk)) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "aaaa") == 0);
+	int r = riff_editReplaceChunk(rh, data, c->size, NULL, &path);
+	CHECK(r == ((c->path == RIFF_EDIT_NONE) ? RIFF_ERROR_ICSIZE : RIFF_ERROR_NONE));
+	CHECK(path == c->path);
+	if(path != c->path)
+		fprintf(stderr, "case \"%s\" took path %d\n", c->name, path);
+	if(r != RIFF_ERROR_NONE  ||  path != c->path)
+		goto end;
+
+	//handle is at the data start of the edited chunk
+	uint8_t buf[64];
+	CHECK(rh->c_pos_start == c->pos);
+	CHECK(riff_readInChunk(rh, buf, sizeof(buf)) == c->size);
+	CHECK(memcmp(buf, data, c->size) == 0);
+
+	//file is intact, the RIFF size is unchanged
+	char ids[8] = "";
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	for(i = 0; i + 1 < sizeof(ids); i++){
+		ids[i] = rh->c_id[0];
+		if(riff_seekNextChunk(rh) != RIFF_ERROR_NONE)
+			break;
+	}
+	CHECK(strcmp(ids, c->ids) == 0);
+	CHECK(rh->h_size == sizeof(file_junk) - 8);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+
+end:
+	riff_handleFree(rh);
+	fclose(f);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	const struct editCase cases[] = {
+		{ "same size", 3, RIFF_EDIT_INPLACE, 36, "Jab" },
+		{ "shrink leaves no room for JUNK", 2, RIFF_EDIT_NONE, 0, "" },
+		//the preceding JUNK chunk shrinks, "aaaa" moves to its start
+		{ "grow into preceding JUNK", 12, RIFF_EDIT_JUNK, 12, "aJb" },
+		{ "grow over all of preceding JUNK", 28, RIFF_EDIT_JUNK, 12, "ab" },
+		{ "grow into preceding JUNK, 1 to 7 bytes left", 22, RIFF_EDIT_NONE, 0, "" },
+		{ "grow beyond preceding JUNK", 30, RIFF_EDIT_NONE, 0, "" },
+	};
+	size_t i;
+	for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+		runCase(cases + i);
+	return TEST_RESULT();
+}
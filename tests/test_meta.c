@@ -0,0 +1,162 @@
+// metadata of many files at once, see riff_metaBatch() in riff_meta.c
+// four WAVE files through one riff_handle: INFO and "bext", INFO only behind another list, not a RIFF file, "bext" only
+// values of all files must stay valid until the end, missing tags and the broken file give NULL values
+// the same riff_meta is used again for a second batch, its memory is reused
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_meta.h"
+#include "riff_writer.h"
+#include "test.h"
+
+
+#define FILES 4
+#define KEYS 5
+
+static const char *keys[KEYS] = { "INAM", "IART", "Description", "TimeReference", "LoudnessValue" };
+
+//expected values per file, NULL if missing
+static const char *expect[FILES][KEYS] = {
+	{ "Song A", "Artist A", "Desc A", "48000", "-2300" },
+	{ "Song B", NULL, NULL, NULL, NULL },
+	{ NULL, NULL, NULL, NULL, NULL },
+	{ NULL, NULL, "Desc D", "4294967296", "0" },
+};
+
+static FILE *files[FILES];
+
+
+
+/*****************************************************************************/
+static void putLE(uint8_t *p, uint64_t v, int size){
+	int i;
+	for(i = 0; i < size; i++)
+		p[i] = (uint8_t)(v >> (i * 8));
+}
+
+/*****************************************************************************/
+static void writeBext(riff_writer *rw, const char *desc, uint64_t time_ref, int16_t loudness){
+	uint8_t bext[602] = {0};
+	memcpy(bext, desc, strlen(desc));
+	putLE(bext + 338, time_ref, 8);
+	putLE(bext + 346, 2, 2);
+	putLE(bext + 412, (uint16_t)loudness, 2);
+	riff_writerWriteChunk(rw, "bext", bext, sizeof(bext));
+}
+
+/*****************************************************************************/
+static void writeInfo(riff_writer *rw, const char *name, const char *artist){
+	riff_writerBeginList(rw, "INFO");
+	riff_writerWriteChunk(rw, "INAM", name, strlen(name) + 1);
+	if(artist != NULL)
+		riff_writerWriteChunk(rw, "IART", artist, strlen(artist) + 1);
+	riff_writerEnd(rw);
+}
+
+/*****************************************************************************/
+//file i as listed above, NULL on error
+static FILE *makeFile(int i){
+	FILE *f = tmpfile();
+	if(f == NULL)
+		return NULL;
+	if(i == 2){
+		fwrite("JUNK\4\0\0\0abcd", 1, 12, f);
+		return f;
+	}
+	riff_writer *rw = riff_writerAllocate();
+	if(rw == NULL  ||  riff_writer_open_file(rw, f, "WAVE") != RIFF_ERROR_NONE){
+		riff_writerFree(rw);
+		fclose(f);
+		return NULL;
+	}
+	rw->fp_printf = NULL;
+	const uint8_t fmt[16] = { 1,0, 1,0, 0x80,0xBB,0,0, 0x00,0x77,1,0, 2,0, 16,0 };
+	riff_writerWriteChunk(rw, "fmt ", fmt, sizeof(fmt));
+	if(i == 0){
+		writeInfo(rw, "Song A", "Artist A");
+		writeBext(rw, "Desc A", 48000, -2300);
+	}
+	else if(i == 1){
+		riff_writerBeginList(rw, "adtl");
+		riff_writerWriteChunk(rw, "labl", "\1\0\0\0x", 6);
+		riff_writerEnd(rw);
+		writeInfo(rw, "Song B", NULL);
+	}
+	else
+		writeBext(rw, "Desc D", 0x100000000ull, 0);
+	riff_writerWriteChunk(rw, "data", "\0\0\0\0", 4);
+	riff_writerClose(rw);
+	riff_writerFree(rw);
+	return f;
+}
+
+/*****************************************************************************/
+static int openFile(riff_handle *rh, size_t i, void *user){
+	FILE **f = (FILE **)user;
+	fseek(f[i], 0, SEEK_SET);
+	return riff_open_file(rh, f[i], 0);
+}
+
+
+/*****************************************************************************/
+//one batch, all values checked after the last file was read
+static void checkBatch(riff_handle *rh, riff_meta *meta, const char * const *k){
+	const char *values[FILES * KEYS];
+	size_t expect_found = 0;
+	int i, j;
+	for(i = 0; i < FILES; i++){
+		for(j = 0; j < KEYS; j++)
+			expect_found += (expect[i][j] != NULL);
+	}
+	memset(values, 0xff, sizeof(values));
+	CHECK(riff_metaBatch(rh, meta, FILES, &openFile, files, k, KEYS, values) == expect_found);
+	CHECK(meta->tags_len == 0);
+	for(i = 0; i < FILES; i++){
+		for(j = 0; j < KEYS; j++){
+			const char *v = values[i * KEYS + j];
+			if(expect[i][j] == NULL)
+				CHECK(v == NULL);
+			else
+				CHECK(v != NULL  &&  strcmp(v, expect[i][j]) == 0);
+		}
+	}
+}
+
+
+/*****************************************************************************/
+int main(void){
+	int i;
+	for(i = 0; i < FILES; i++){
+		files[i] = makeFile(i);
+		REQUIRE(files[i] != NULL);
+	}
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+
+	riff_meta meta;
+	memset(&meta, 0, sizeof(meta));
+	checkBatch(rh, &meta, keys);
+
+	//again with interned keys, compared by pointer
+	const char *interned[KEYS];
+	for(i = 0; i < KEYS; i++){
+		interned[i] = riff_metaKey(&meta, keys[i]);
+		REQUIRE(interned[i] != NULL);
+	}
+	checkBatch(rh, &meta, interned);
+
+	//no files, nothing is opened
+	const char *none[KEYS];
+	CHECK(riff_metaBatch(rh, &meta, 0, &openFile, files, keys, KEYS, none) == 0);
+	riff_metaClose(&meta);
+
+	riff_handleFree(rh);
+	for(i = 0; i < FILES; i++)
+		fclose(files[i]);
+	return TEST_RESULT();
+}
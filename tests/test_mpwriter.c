@@ -0,0 +1,212 @@
+// multi-producer writer, see riff_mpwriter.c
+// several threads reserve, write and commit chunks of a "movi" list at once:
+//   data is written back to front in two pieces, threads holding several slots commit the latest first
+// the file must have the chunks in reservation order, the list sizes of the last size update and a matching "idx1"
+// build with -fsanitize=thread to check the locking
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "riff.h"
+#include "riff_mpwriter.h"
+#include "test.h"
+
+
+#define THREADS 4
+#define CHUNKS 300          //per thread
+#define CHUNK_MAX 61
+#define INTERVAL 2000       //commit interval, list sizes are updated by the producers
+
+//chunk of a sequence number as the producer made it
+struct chunkInfo {
+	char id[5];
+	size_t size;
+	uint32_t flags;
+	uint8_t first;      //data byte i is first + i
+};
+
+struct producer {
+	riff_mpWriter *mw;
+	int thread;
+	int batch;          //slots held at once
+	struct chunkInfo *info;
+	int r;
+};
+
+
+
+/*****************************************************************************/
+static void makeChunk(struct chunkInfo *c, int thread, int k){
+	snprintf(c->id, sizeof(c->id), "%02ddc", thread);
+	c->size = 1 + (size_t)(thread * 31 + k * 7) % CHUNK_MAX;    //also odd, with pad byte
+	c->flags = (k % 3 == 0) ? 0x10 : 0;
+	c->first = (uint8_t)(thread * 50 + k);
+}
+
+/*****************************************************************************/
+static void *produce(void *arg){
+	struct producer *p = (struct producer *)arg;
+	uint8_t data[CHUNK_MAX];
+	int k, b;
+	for(k = 0; k < CHUNKS  &&  p->r == RIFF_ERROR_NONE; k += p->batch){
+		uint64_t seq[8];
+		int n = (CHUNKS - k < p->batch) ? CHUNKS - k : p->batch;
+		for(b = 0; b < n  &&  p->r == RIFF_ERROR_NONE; b++){
+			struct chunkInfo c;
+			makeChunk(&c, p->thread, k + b);
+			p->r = riff_mpWriterReserve(p->mw, c.id, c.size, c.flags, seq + b);
+			if(p->r == RIFF_ERROR_NONE)
+				p->info[seq[b]] = c;    //each sequence number is handed out once
+		}
+		//latest slot first, second half of the data first
+		for(b = n - 1; b >= 0  &&  p->r == RIFF_ERROR_NONE; b--){
+			const struct chunkInfo *c = p->info + seq[b];
+			size_t i, half = c->size / 2;
+			for(i = 0; i < c->size; i++)
+				data[i] = (uint8_t)(c->first + i);
+			p->r = riff_mpWriterWrite(p->mw, seq[b], half, data + half, c->size - half);
+			if(p->r == RIFF_ERROR_NONE  &&  (seq[b] + p->thread) % 4 == 0)
+				sched_yield();
+			if(p->r == RIFF_ERROR_NONE)
+				p->r = riff_mpWriterWrite(p->mw, seq[b], 0, data, half);
+			if(p->r == RIFF_ERROR_NONE)
+				p->r = riff_mpWriterCommit(p->mw, seq[b]);
+		}
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+static uint32_t sizeAt(FILE *f, size_t pos){
+	uint8_t b[4] = {0};
+	if(pread(fileno(f), b, 4, pos) != 4)
+		return 0;
+	return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+/*****************************************************************************/
+//chunks of the "movi" list and the "idx1" entries against what the producers made
+static void checkFile(FILE *f, const riff_mpWriter *mw, const struct chunkInfo *info, size_t total){
+	fseek(f, 0, SEEK_END);
+	size_t size = (size_t)ftell(f);
+	fseek(f, 0, SEEK_SET);
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE_VOID(rh != NULL);
+	rh->fp_printf = NULL;
+	CHECK(riff_open_file(rh, f, size) == RIFF_ERROR_NONE);
+	CHECK(rh->h_size == size - 8);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "head") == 0);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "LIST") == 0);
+	CHECK(riff_seekLevelSub(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->ls[rh->ls_level - 1].c_type, "movi") == 0);
+	size_t i = 0, k;
+	uint8_t data[CHUNK_MAX];
+	do{
+		const struct chunkInfo *c = info + i;
+		if(i >= total  ||  strcmp(rh->c_id, c->id) != 0  ||  rh->c_size != c->size){
+			fprintf(stderr, "chunk %zu: \"%s\" (%zu) instead of \"%s\" (%zu)\n", i, rh->c_id, (size_t)rh->c_size, c->id, c->size);
+			test_failed++;
+			break;
+		}
+		CHECK(riff_readInChunk(rh, data, c->size) == c->size);
+		for(k = 0; k < c->size  &&  data[k] == (uint8_t)(c->first + k); k++);
+		CHECK(k == c->size);
+		CHECK(mw->idx[i].c_pos_start == rh->c_pos_start);
+		i++;
+	}while(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(i == total);
+
+	//"idx1" behind the list, offsets relative to the list type
+	CHECK(riff_levelParent(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "idx1") == 0);
+	CHECK(rh->c_size == total * 16);
+	for(i = 0; i < total  &&  riff_readInChunk(rh, data, 16) == 16; i++){
+		const struct chunkInfo *c = info + i;
+		CHECK(memcmp(data, c->id, 4) == 0);
+		CHECK(data[4] == c->flags);
+		size_t offset = (size_t)data[8] | (size_t)data[9] << 8 | (size_t)data[10] << 16 | (size_t)data[11] << 24;
+		CHECK(offset == mw->idx[i].c_pos_start - mw->list_pos);
+		CHECK(data[12] == c->size  &&  data[13] == 0);
+	}
+	CHECK(i == total);
+	riff_handleFree(rh);
+}
+
+/*****************************************************************************/
+static void run(size_t slots, int batch){
+	size_t total = THREADS * CHUNKS;
+	struct chunkInfo *info = calloc(total, sizeof(struct chunkInfo));
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	riff_mpWriter *mw = riff_mpWriterAllocate();
+	REQUIRE_VOID(info != NULL  &&  f != NULL  &&  rw != NULL  &&  mw != NULL);
+	rw->fp_printf = NULL;
+
+	CHECK(riff_writer_open_file(rw, f, "TEST") == RIFF_ERROR_NONE);
+	CHECK(riff_writerWriteChunk(rw, "head", "abc", 3) == RIFF_ERROR_NONE);
+	CHECK(riff_writerBeginList(rw, "movi") == RIFF_ERROR_NONE);
+	size_t movi_pos = rw->ls[rw->ls_level - 1].c_pos_start;
+	riff_writerSetCommitPolicy(rw, INTERVAL, RIFF_WRITER_SYNC_NONE);
+	mw->slots_size = slots;
+	CHECK(riff_mpWriterBegin(mw, rw) == RIFF_ERROR_NONE);
+
+	pthread_t t[THREADS];
+	struct producer p[THREADS];
+	int i;
+	for(i = 0; i < THREADS; i++){
+		p[i].mw = mw;
+		p[i].thread = i;
+		p[i].batch = batch;
+		p[i].info = info;
+		p[i].r = RIFF_ERROR_NONE;
+		REQUIRE_VOID(pthread_create(t + i, NULL, &produce, p + i) == 0);
+	}
+	for(i = 0; i < THREADS; i++){
+		pthread_join(t[i], NULL);
+		CHECK(p[i].r == RIFF_ERROR_NONE);
+	}
+	CHECK(riff_mpWriterEnd(mw) == RIFF_ERROR_NONE);
+	CHECK(mw->idx_len == total);
+	for(i = 0; (size_t)i < mw->idx_len; i++){
+		CHECK(strcmp(mw->idx[i].c_id, info[i].id) == 0);
+		CHECK(mw->idx[i].c_size == info[i].size);
+		CHECK(mw->idx[i].flags == info[i].flags);
+	}
+
+	//the producers' last size update, before riff_writerEnd() writes the final ones
+	CHECK(mw->commit_pos >= movi_pos + INTERVAL);
+	CHECK(mw->pub_pos - mw->commit_pos < INTERVAL);
+	CHECK(sizeAt(f, 4) == mw->commit_pos - 8);
+	CHECK(sizeAt(f, movi_pos + 4) == mw->commit_pos - movi_pos - 8);
+
+	CHECK(riff_writerEnd(rw) == RIFF_ERROR_NONE);
+	CHECK(riff_mpWriterWriteIdx1(mw) == RIFF_ERROR_NONE);
+	CHECK(riff_writerClose(rw) == RIFF_ERROR_NONE);
+	checkFile(f, mw, info, total);
+
+	riff_mpWriterFree(mw);
+	riff_writerFree(rw);
+	fclose(f);
+	free(info);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	//few slots, producers wait for each other
+	run(THREADS, 1);
+	//several slots per producer, committed latest first
+	//a producer holding slots can only reserve more if all of them fit, else it could wait for itself
+	run(THREADS * CHUNKS, 5);
+	return TEST_RESULT();
+}
@@ -0,0 +1,196 @@
+// handle reuse, see riff_handleReset() and riff_handlePoolGet() in riff.c
+// a handle first reads a file deeper than RIFF_LEVEL_INLINE, so its level stack is on the heap, then an RF64 file with a ds64 table
+// after the reset it must read the next file like a new handle, keeping only the level stack
+// the global allocator counts the blocks, none may be left once the handles are freed
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "test.h"
+
+
+#define DEEP_LEVELS (RIFF_LEVEL_INLINE + 4)
+
+//blocks allocated and not freed
+static long live = 0;
+
+static uint8_t file_deep[512];
+static size_t file_deep_len;
+
+//RF64 "TEST": "ds64" with one table entry, "aaaa" (size 3 from the table), "bbbb" (2)
+static const uint8_t file_rf64[] = {
+	'R','F','6','4', 0xff,0xff,0xff,0xff, 'T','E','S','T',
+	'd','s','6','4', 40,0,0,0,
+		74,0,0,0,0,0,0,0,       //RIFF size
+		0,0,0,0,0,0,0,0,        //data size
+		0,0,0,0,0,0,0,0,        //sample count
+		1,0,0,0,                //table length
+		'a','a','a','a', 3,0,0,0,0,0,0,0,
+	'a','a','a','a', 0xff,0xff,0xff,0xff, 1,2,3,0,
+	'b','b','b','b', 2,0,0,0, 4,5,
+};
+
+//RIFF "TEST": "cccc" (4)
+static const uint8_t file_flat[] = {
+	'R','I','F','F', 16,0,0,0, 'T','E','S','T',
+	'c','c','c','c', 4,0,0,0, 6,7,8,9,
+};
+
+
+
+/*****************************************************************************/
+static void *countMalloc(void *user, size_t size){
+	(void)user;
+	void *p = malloc(size);
+	if(p != NULL)
+		live++;
+	return p;
+}
+
+static void *countRealloc(void *user, void *ptr, size_t size){
+	(void)user;
+	void *p = realloc(ptr, size);
+	if(p != NULL  &&  ptr == NULL)
+		live++;
+	return p;
+}
+
+static void countFree(void *user, void *ptr){
+	(void)user;
+	if(ptr != NULL)
+		live--;
+	free(ptr);
+}
+
+/*****************************************************************************/
+//DEEP_LEVELS nested lists around one "data" chunk
+static void makeDeep(void){
+	size_t inner = 8 + 2;
+	size_t i;
+	file_deep_len = 12 + DEEP_LEVELS * 12 + inner;
+	memcpy(file_deep, "RIFF", 4);
+	memcpy(file_deep + 8, "TEST", 4);
+	for(i = 0; i <= DEEP_LEVELS; i++){
+		uint8_t *p = file_deep + i * 12;
+		uint32_t size = (uint32_t)(file_deep_len - i * 12 - 8);
+		if(i > 0){
+			memcpy(p, "LIST", 4);
+			memcpy(p + 8, "deep", 4);
+		}
+		p[4] = (uint8_t)size;
+		p[5] = (uint8_t)(size >> 8);
+		p[6] = p[7] = 0;
+	}
+	uint8_t *p = file_deep + 12 + DEEP_LEVELS * 12;
+	memcpy(p, "data", 4);
+	p[4] = 2;
+	p[5] = p[6] = p[7] = 0;
+	p[8] = 'x';
+	p[9] = 'y';
+}
+
+/*****************************************************************************/
+//the handle is in the state after allocation, with a level stack on the heap
+static void checkReset(riff_handle *rh){
+	CHECK(rh->fh == NULL  &&  rh->fp_read == NULL);
+	CHECK(rh->ls_level == 0  &&  rh->c_size == 0  &&  rh->h_size == 0);
+	CHECK(rh->ds64 == 0  &&  rh->ds64_table == NULL  &&  rh->ds64_hash == NULL);
+	CHECK(rh->ls_heap  &&  rh->ls != rh->ls_inline  &&  rh->ls_size > DEEP_LEVELS);
+	CHECK(rh->fp_printf == NULL);
+}
+
+/*****************************************************************************/
+//read the three files one after the other, resetting by fp_reset
+static void readFiles(riff_handle *rh, void (*fp_reset)(riff_handle **rh, void *user), void *user){
+	uint8_t buf[4];
+	CHECK(riff_open_mem(rh, file_deep, file_deep_len) == RIFF_ERROR_NONE);
+	while(riff_seekLevelSub(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->ls_level == DEEP_LEVELS);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(riff_readInChunk(rh, buf, 2) == 2  &&  memcmp(buf, "xy", 2) == 0);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+
+	fp_reset(&rh, user);
+	REQUIRE_VOID(rh != NULL);
+	checkReset(rh);
+	CHECK(riff_open_mem(rh, file_rf64, sizeof(file_rf64)) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "RF64") == 0  &&  rh->h_size == sizeof(file_rf64) - 8);
+	CHECK(rh->ds64_table_len == 1);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "aaaa") == 0  &&  rh->c_size == 3);
+	CHECK(riff_readInChunk(rh, buf, 4) == 3  &&  buf[0] == 1  &&  buf[2] == 3);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "bbbb") == 0  &&  rh->c_size == 2);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_EOCL);
+
+	fp_reset(&rh, user);
+	REQUIRE_VOID(rh != NULL);
+	checkReset(rh);
+	CHECK(riff_open_mem(rh, file_flat, sizeof(file_flat)) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "RIFF") == 0  &&  rh->h_size == sizeof(file_flat) - 8);
+	CHECK(rh->ds64 == 0);
+	CHECK(strcmp(rh->c_id, "cccc") == 0  &&  rh->c_size == 4);
+	CHECK(riff_readInChunk(rh, buf, 4) == 4  &&  buf[0] == 6  &&  buf[3] == 9);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+}
+
+/*****************************************************************************/
+static void resetHandle(riff_handle **rh, void *user){
+	(void)user;
+	riff_handleReset(*rh);
+}
+
+//back to the pool and out again, the pool holds one handle
+static void resetPool(riff_handle **rh, void *user){
+	riff_handlePool *pool = (riff_handlePool *)user;
+	riff_handle *old = *rh;
+	riff_handlePoolPut(pool, *rh);
+	*rh = riff_handlePoolGet(pool);
+	CHECK(*rh == old);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	riff_allocator a = { &countMalloc, &countRealloc, &countFree, NULL };
+	riff_setAllocator(&a);
+	makeDeep();
+
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+	readFiles(rh, &resetHandle, NULL);
+	riff_handleFree(rh);
+	CHECK(live == 0);
+
+	//caller storage, the level stack still moves to the heap
+	uint64_t storage[(sizeof(riff_handle) + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+	rh = riff_handleInit(storage, sizeof(storage));
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+	readFiles(rh, &resetHandle, NULL);
+	CHECK(rh->storage);
+	riff_handleFree(rh);
+	CHECK(live == 0);
+
+	riff_handlePool *pool = riff_handlePoolAllocate(1);
+	REQUIRE(pool != NULL);
+	rh = riff_handlePoolGet(pool);
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+	readFiles(rh, &resetPool, pool);
+	//a handle beyond the maximum is freed right away
+	riff_handle *extra = riff_handlePoolGet(pool);
+	CHECK(extra != NULL  &&  extra != rh);
+	riff_handlePoolPut(pool, rh);
+	riff_handlePoolPut(pool, extra);
+	CHECK(pool->handles_len == 1);
+	riff_handlePoolFree(pool);
+	CHECK(live == 0);
+
+	riff_setAllocator(NULL);
+	return TEST_RESULT();
+}
@@ -0,0 +1,140 @@
+// classification of prefix buffers, see riff_probe() in riff_probe.c
+// every container type with the full score, then truncated prefixes, sizes not matching the file and other formats
+// a 64 bit form size at the maximum must not wrap around when compared to the file size
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_probe.h"
+#include "test.h"
+
+
+//RIFF "WAVE", form size 36, "fmt " (16)
+static const uint8_t pre_riff[RIFF_PROBE_SIZE] = {
+	'R','I','F','F', 36,0,0,0, 'W','A','V','E',
+	'f','m','t',' ', 16,0,0,0, 1,0,1,0, 0x40,0x1F,0,0, 0x80,0x3E,0,0,
+};
+
+//RIFX "AVI ", sizes big endian, form size 0x1000, "LIST" (0x200)
+static const uint8_t pre_rifx[RIFF_PROBE_SIZE] = {
+	'R','I','F','X', 0,0,0x10,0, 'A','V','I',' ',
+	'L','I','S','T', 0,0,0x02,0, 'h','d','r','l',
+};
+
+//RF64 "WAVE", form size 0x100000100 in "ds64"
+static const uint8_t pre_rf64[RIFF_PROBE_SIZE] = {
+	'R','F','6','4', 0xff,0xff,0xff,0xff, 'W','A','V','E',
+	'd','s','6','4', 28,0,0,0, 0x00,0x01,0,0,1,0,0,0, 0,0,0,0,
+};
+
+//BW64 "WAVE", form size 0xFFFFFFFFFFFFFFFF in "ds64"
+static const uint8_t pre_bw64[RIFF_PROBE_SIZE] = {
+	'B','W','6','4', 0xff,0xff,0xff,0xff, 'W','A','V','E',
+	'd','s','6','4', 28,0,0,0, 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff, 0,0,0,0,
+};
+
+
+
+/*****************************************************************************/
+static void checkContainers(void){
+	struct riff_probeResult res;
+	CHECK(riff_probe(pre_riff, sizeof(pre_riff), 44, &res) == 100);
+	CHECK(res.container == RIFF_PROBE_RIFF);
+	CHECK(strcmp(res.h_type, "WAVE") == 0  &&  res.h_size == 36);
+	CHECK(strcmp(res.c_id, "fmt ") == 0  &&  res.c_size == 16);
+	//pad byte after the form
+	CHECK(riff_probe(pre_riff, sizeof(pre_riff), 45, &res) == 100);
+
+	CHECK(riff_probe(pre_rifx, sizeof(pre_rifx), 0x1008, &res) == 100);
+	CHECK(res.container == RIFF_PROBE_RIFX);
+	CHECK(strcmp(res.h_type, "AVI ") == 0  &&  res.h_size == 0x1000);
+	CHECK(strcmp(res.c_id, "LIST") == 0  &&  res.c_size == 0x200);
+
+	CHECK(riff_probe(pre_rf64, sizeof(pre_rf64), 0x100000108ull, &res) == 100);
+	CHECK(res.container == RIFF_PROBE_RF64);
+	CHECK(res.h_size == 0x100000100ull);
+	CHECK(strcmp(res.c_id, "ds64") == 0  &&  res.c_size == 28);
+
+	//unknown file size is plausible
+	CHECK(riff_probe(pre_bw64, sizeof(pre_bw64), 0, &res) == 100);
+	CHECK(res.container == RIFF_PROBE_BW64);
+	CHECK(res.h_size == 0xFFFFFFFFFFFFFFFFull);
+}
+
+/*****************************************************************************/
+//form size against file size
+static void checkSizes(void){
+	struct riff_probeResult res;
+	//extra data after the form
+	CHECK(riff_probe(pre_riff, sizeof(pre_riff), 1000, &res) == 90);
+	//form larger than the file
+	CHECK(riff_probe(pre_riff, sizeof(pre_riff), 40, &res) == 80);
+	//first chunk larger than the form
+	uint8_t big[RIFF_PROBE_SIZE];
+	memcpy(big, pre_riff, sizeof(big));
+	big[16] = 100;
+	CHECK(riff_probe(big, sizeof(big), 44, &res) == 90);
+	//the maximum form size does not wrap around to a small total
+	CHECK(riff_probe(pre_bw64, sizeof(pre_bw64), 100, &res) == 80);
+}
+
+/*****************************************************************************/
+//prefixes cut off before each check
+static void checkTruncated(void){
+	struct riff_probeResult res;
+	CHECK(riff_probe(pre_riff, 0, 0, &res) == 0  &&  res.container == RIFF_PROBE_NONE);
+	CHECK(riff_probe(pre_riff, 3, 0, &res) == 0  &&  res.container == RIFF_PROBE_NONE);
+	CHECK(riff_probe(pre_riff, 4, 0, &res) == 30  &&  res.container == RIFF_PROBE_RIFF);
+	CHECK(riff_probe(pre_riff, 11, 0, &res) == 30  &&  res.h_type[0] == '\0');
+	//form type, no first chunk
+	CHECK(riff_probe(pre_riff, 12, 0, &res) == 70  &&  strcmp(res.h_type, "WAVE") == 0  &&  res.c_id[0] == '\0');
+	CHECK(riff_probe(pre_riff, 20, 0, &res) == 100);
+	//"ds64" without the form size, 64 bit size unknown
+	CHECK(riff_probe(pre_rf64, 27, 0, &res) == 70);
+	CHECK(res.container == RIFF_PROBE_RF64  &&  res.h_size == 0xFFFFFFFF);
+	CHECK(riff_probe(NULL, 32, 0, &res) == 0);
+}
+
+/*****************************************************************************/
+static void checkUnknown(void){
+	struct riff_probeResult res;
+	static const uint8_t ogg[RIFF_PROBE_SIZE] = { 'O','g','g','S', 0,2 };
+	static const uint8_t lower[RIFF_PROBE_SIZE] = { 'r','i','f','f', 36,0,0,0, 'W','A','V','E' };
+	CHECK(riff_probe(ogg, sizeof(ogg), 0, &res) == 0  &&  res.container == RIFF_PROBE_NONE);
+	CHECK(riff_probe(lower, sizeof(lower), 0, &res) == 0);
+
+	//invalid form type and first chunk ID
+	uint8_t bad[RIFF_PROBE_SIZE];
+	memcpy(bad, pre_riff, sizeof(bad));
+	bad[8] = 0x01;
+	bad[12] = 0x00;
+	CHECK(riff_probe(bad, sizeof(bad), 44, &res) == 50);
+	CHECK(res.container == RIFF_PROBE_RIFF);
+}
+
+/*****************************************************************************/
+static void checkBatch(void){
+	static const uint8_t ogg[4] = { 'O','g','g','S' };
+	const void *bufs[] = { pre_riff, ogg, pre_rifx, pre_rf64 };
+	const size_t lens[] = { sizeof(pre_riff), sizeof(ogg), sizeof(pre_rifx), 4 };
+	const uint64_t sizes[] = { 44, 4, 0x1008, 0 };
+	struct riff_probeResult res[4];
+	CHECK(riff_probeBatch(bufs, lens, sizes, 4, res) == 3);
+	CHECK(res[0].score == 100  &&  res[1].score == 0  &&  res[2].score == 100  &&  res[3].score == 30);
+	CHECK(res[3].container == RIFF_PROBE_RF64);
+	CHECK(riff_probeBatch(bufs, lens, NULL, 4, res) == 3);
+	CHECK(res[0].score == 100);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	checkContainers();
+	checkSizes();
+	checkTruncated();
+	checkUnknown();
+	checkBatch();
+	return TEST_RESULT();
+}
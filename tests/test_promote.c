@@ -0,0 +1,217 @@
+// promotion of a growing RIFF file to BW64, see writer_promote() and writer_size() in riff_writer.c
+// "data" and "xtra" get larger than 4 GB, their sizes must end up in the reserved ds64 chunk and its table
+// the output is virtual: only the bytes around the chunk headers are kept, the rest is dropped like a hole in a sparse file
+// the result is read back through the same windows with riff_readHeader()
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_writer.h"
+#include "test.h"
+
+
+#define TEST_SKIP 77    //ctest SKIP_RETURN_CODE
+
+#define DATA_SIZE 0x100000010ull    //"data" chunk beyond 4 GB, even
+#define XTRA_SIZE 0x100000002ull    //"xtra" chunk beyond 4 GB, sized by the ds64 table
+#define SLICE (1 << 20)             //larger than the writer buffer, passed through without copying
+
+//same layout as tests/test_ds64.c: "ds64" (JUNK until promoted) with one table entry, "fmt ", "data", "xtra", "tail"
+#define DATA_POS 84
+#define XTRA_POS (DATA_POS + 8 + DATA_SIZE)
+#define TAIL_POS (XTRA_POS + 8 + XTRA_SIZE)
+#define TOTAL (TAIL_POS + 8 + 4)
+
+//kept bytes of the output, everything else reads as 0
+struct window {
+	uint64_t start;
+	uint8_t buf[128];
+};
+
+static struct window win[3];
+static uint64_t out_pos;
+static uint64_t out_end;
+
+static uint8_t slice[SLICE];
+
+
+
+/*****************************************************************************/
+static uint32_t getU32(const uint8_t *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t getU64(const uint8_t *p){
+	return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32);
+}
+
+/*****************************************************************************/
+//copy between the output at pos and ptr, only the parts within the windows
+static void windowCopy(uint64_t pos, uint8_t *ptr, const uint8_t *src, size_t size){
+	size_t w;
+	for(w = 0; w < sizeof(win) / sizeof(win[0]); w++){
+		uint64_t start = (pos > win[w].start) ? pos : win[w].start;
+		uint64_t end = pos + size;
+		if(end > win[w].start + sizeof(win[w].buf))
+			end = win[w].start + sizeof(win[w].buf);
+		if(start >= end)
+			continue;
+		if(src != NULL)
+			memcpy(win[w].buf + (start - win[w].start), src + (start - pos), (size_t)(end - start));
+		else
+			memcpy(ptr + (start - pos), win[w].buf + (start - win[w].start), (size_t)(end - start));
+	}
+}
+
+/*****************************************************************************/
+static size_t writeWin(riff_writer *rw, const void *ptr, size_t size){
+	(void)rw;
+	windowCopy(out_pos, NULL, (const uint8_t *)ptr, size);
+	out_pos += size;
+	if(out_pos > out_end)
+		out_end = out_pos;
+	return size;
+}
+
+static size_t seekWin(riff_writer *rw, size_t pos){
+	(void)rw;
+	out_pos = pos;
+	return pos;
+}
+
+static size_t readWin(riff_handle *rh, void *ptr, size_t size){
+	memset(ptr, 0, size);
+	windowCopy(rh->pos, (uint8_t *)ptr, NULL, size);
+	return size;
+}
+
+static size_t seekWinRead(riff_handle *rh, size_t pos){
+	(void)rh;
+	return pos;
+}
+
+/*****************************************************************************/
+//size bytes of chunk data, in slices the writer passes through
+static int writeLarge(riff_writer *rw, uint64_t size){
+	while(size > 0){
+		size_t n = (size > SLICE) ? SLICE : (size_t)size;
+		if(riff_writerWrite(rw, slice, n) != n)
+			return RIFF_ERROR_ACCESS;
+		size -= n;
+	}
+	return RIFF_ERROR_NONE;
+}
+
+/*****************************************************************************/
+//the file as described above, returns the result of riff_writerClose()
+static int writeFile(int reserve){
+	const uint8_t fmt[16] = { 1,0, 1,0, 0x40,0x1F,0,0, 0x80,0x3E,0,0, 2,0, 16,0 };
+	memset(win, 0, sizeof(win));
+	win[1].start = XTRA_POS - 8;
+	win[2].start = TAIL_POS - 8;
+	out_pos = out_end = 0;
+
+	riff_writer *rw = riff_writerAllocate();
+	if(rw == NULL)
+		return RIFF_ERROR_MEMORY;
+	rw->fp_printf = NULL;
+	rw->fp_write = &writeWin;
+	rw->fp_seek = &seekWin;
+	rw->pos_start = 0;
+	int r = riff_writerBegin(rw, "WAVE");
+	if(r == RIFF_ERROR_NONE  &&  reserve)
+		r = riff_writerReserveDs64(rw, "BW64", 1);
+	else if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "JUNK", slice, 28 + 12); //same layout, but no ds64
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "fmt ", fmt, sizeof(fmt));
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginChunk(rw, "data");
+	if(r == RIFF_ERROR_NONE)
+		r = writeLarge(rw, DATA_SIZE);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerEnd(rw);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginChunk(rw, "xtra");
+	if(r == RIFF_ERROR_NONE)
+		r = writeLarge(rw, XTRA_SIZE);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerEnd(rw);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "tail", "TAIL", 4);
+	rw->ds64_samples = DATA_SIZE / 2;
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerClose(rw);
+	riff_writerFree(rw);
+	return r;
+}
+
+
+/*****************************************************************************/
+//header ID and ds64 chunk as patched by the promotion
+static void checkHeaders(void){
+	const uint8_t *h = win[0].buf;
+	CHECK(out_end == TOTAL);
+	CHECK(memcmp(h, "BW64", 4) == 0  &&  getU32(h + 4) == 0xFFFFFFFF);
+	CHECK(memcmp(h + 8, "WAVE", 4) == 0);
+	CHECK(memcmp(h + 12, "ds64", 4) == 0  &&  getU32(h + 16) == 28 + 12);
+	CHECK(getU64(h + 20) == TOTAL - 8);         //RIFF size
+	CHECK(getU64(h + 28) == DATA_SIZE);         //data size
+	CHECK(getU64(h + 36) == DATA_SIZE / 2);     //sample count
+	CHECK(getU32(h + 44) == 1);                 //table length
+	CHECK(memcmp(h + 48, "xtra", 4) == 0  &&  getU64(h + 52) == XTRA_SIZE);
+	CHECK(memcmp(h + 60, "fmt ", 4) == 0  &&  getU32(h + 64) == 16);
+	CHECK(memcmp(h + DATA_POS, "data", 4) == 0  &&  getU32(h + DATA_POS + 4) == 0xFFFFFFFF);
+
+	const uint8_t *x = win[1].buf + 8;
+	CHECK(memcmp(x, "xtra", 4) == 0  &&  getU32(x + 4) == 0xFFFFFFFF);
+	const uint8_t *t = win[2].buf + 8;
+	CHECK(memcmp(t, "tail", 4) == 0  &&  getU32(t + 4) == 4  &&  memcmp(t + 8, "TAIL", 4) == 0);
+}
+
+/*****************************************************************************/
+//read back: the reader takes all 64 bit sizes from the ds64 chunk
+static void checkRead(void){
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE_VOID(rh != NULL);
+	rh->fp_printf = NULL;
+	rh->fp_read = &readWin;
+	rh->fp_seek = &seekWinRead;
+	rh->pos_start = 0;
+	rh->size = (size_t)TOTAL;
+	REQUIRE_VOID(riff_readHeader(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "BW64") == 0  &&  rh->h_size == TOTAL - 8);
+	CHECK(rh->ds64_data == DATA_SIZE  &&  rh->ds64_samples == DATA_SIZE / 2);
+
+	const char *ids[] = { "ds64", "fmt ", "data", "xtra", "tail" };
+	const uint64_t sizes[] = { 28 + 12, 16, DATA_SIZE, XTRA_SIZE, 4 };
+	size_t i;
+	for(i = 0; i < sizeof(ids) / sizeof(ids[0]); i++){
+		CHECK(strcmp(rh->c_id, ids[i]) == 0);
+		CHECK(rh->c_size == sizes[i]);
+		CHECK(riff_seekNextChunk(rh) == ((i + 1 < sizeof(ids) / sizeof(ids[0])) ? RIFF_ERROR_NONE : RIFF_ERROR_EOCL));
+	}
+	riff_handleFree(rh);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	if(sizeof(size_t) < 8){
+		printf("skipped, no 64 bit sizes\n");
+		return TEST_SKIP;
+	}
+
+	CHECK(writeFile(1) == RIFF_ERROR_NONE);
+	checkHeaders();
+	checkRead();
+
+	//without a reserved ds64 chunk the 4 GB "data" can't be ended
+	CHECK(writeFile(0) == RIFF_ERROR_ICSIZE);
+	CHECK(memcmp(win[0].buf, "RIFF", 4) == 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,283 @@
+// file variants with other size fields, see riff_readHeader() in riff.c
+// "RIFX": big endian sizes, walked, edited in place (the sizes stay big endian) and rewritten (riff_writer output is little endian)
+// "RF64": 64 bit sizes in the "ds64" chunk, the "data" chunk has size field 0xFFFFFFFF
+// both files are read from memory, edits go to a temporary copy
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff.h"
+#include "riff_edit.h"
+#include "riff_writer.h"
+#include "test.h"
+
+
+//RIFX "TEST": "aaaa" (4), "JUNK" (16), LIST "list" { "bbbb" (3, padded), "cccc" (2) }
+static const uint8_t file_rifx[] = {
+	'R','I','F','X', 0,0,0,74, 'T','E','S','T',
+	'a','a','a','a', 0,0,0,4, 1,2,3,4,
+	'J','U','N','K', 0,0,0,16, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+	'L','I','S','T', 0,0,0,26, 'l','i','s','t',
+		'b','b','b','b', 0,0,0,3, 5,6,7,0,
+		'c','c','c','c', 0,0,0,2, 8,9,
+};
+
+//RF64 "WAVE": "ds64" (28), "fmt " (16), "data" (size 6 from "ds64"), "tail" (2)
+static const uint8_t file_rf64[] = {
+	'R','F','6','4', 0xff,0xff,0xff,0xff, 'W','A','V','E',
+	'd','s','6','4', 28,0,0,0,
+		88,0,0,0,0,0,0,0,       //RIFF size
+		6,0,0,0,0,0,0,0,        //data size
+		3,0,0,0,0,0,0,0,        //sample count
+		0,0,0,0,                //table length
+	'f','m','t',' ', 16,0,0,0, 1,0,1,0, 0x40,0x1f,0,0, 0x80,0x3e,0,0, 2,0,16,0,
+	'd','a','t','a', 0xff,0xff,0xff,0xff, 1,2,3,4,5,6,
+	't','a','i','l', 2,0,0,0, 7,8,
+};
+
+//chunk of the walk
+struct chunkInfo {
+	const char *id;
+	size_t pos;
+	size_t size;
+	int level;
+};
+
+
+
+/*****************************************************************************/
+static uint32_t getU32LE(const uint8_t *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t getU32BE(const uint8_t *p){
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/*****************************************************************************/
+//compare walked chunk with the next expected one
+struct walkState {
+	const struct chunkInfo *chunks;
+	size_t len;
+	size_t i;
+};
+
+static int walkChunk(riff_handle *rh, void *user){
+	struct walkState *s = (struct walkState *)user;
+	if(s->i >= s->len){
+		fprintf(stderr, "chunk \"%s\" beyond the expected ones\n", rh->c_id);
+		test_failed++;
+		return RIFF_WALK_STOP;
+	}
+	const struct chunkInfo *c = s->chunks + s->i++;
+	if(strcmp(rh->c_id, c->id) != 0  ||  rh->c_pos_start != c->pos  ||  rh->c_size != c->size  ||  rh->ls_level != c->level){
+		fprintf(stderr, "chunk %zu: \"%s\" at %zu (%zu), level %d instead of \"%s\" at %zu (%zu), level %d\n", s->i - 1,
+			rh->c_id, (size_t)rh->c_pos_start, (size_t)rh->c_size, rh->ls_level, c->id, c->pos, c->size, c->level);
+		test_failed++;
+	}
+	return RIFF_WALK_CONTINUE;
+}
+
+static void checkWalk(riff_handle *rh, const struct chunkInfo *chunks, size_t len){
+	struct walkState s = {chunks, len, 0};
+	struct riff_walker w = {0};
+	w.fp_chunk = &walkChunk;
+	w.user = &s;
+	CHECK(riff_walk(rh, &w) == RIFF_ERROR_NONE);
+	CHECK(s.i == len);
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+}
+
+/*****************************************************************************/
+//whole file into buf, returns its size
+static size_t readAll(FILE *f, uint8_t *buf, size_t size){
+	fflush(f);
+	fseek(f, 0, SEEK_END);
+	long n = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if(n <= 0  ||  (size_t)n > size)
+		return 0;
+	return fread(buf, 1, (size_t)n, f);
+}
+
+/*****************************************************************************/
+static FILE *copyToFile(const uint8_t *data, size_t size){
+	FILE *f = tmpfile();
+	if(f != NULL  &&  (fwrite(data, 1, size, f) != size  ||  fseek(f, 0, SEEK_SET) != 0)){
+		fclose(f);
+		return NULL;
+	}
+	return f;
+}
+
+
+/*****************************************************************************/
+static void checkRifx(riff_handle *rh){
+	const struct chunkInfo chunks[] = {
+		{"aaaa", 12, 4, 0}, {"JUNK", 24, 16, 0}, {"LIST", 48, 26, 0}, {"bbbb", 60, 3, 1}, {"cccc", 72, 2, 1},
+	};
+	CHECK(riff_open_mem(rh, file_rifx, sizeof(file_rifx)) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "RIFX") == 0  &&  rh->h_fourcc == RIFF_FOURCC_RIFX);
+	CHECK(strcmp(rh->h_type, "TEST") == 0);
+	CHECK(rh->h_size == sizeof(file_rifx) - 8);
+	CHECK(rh->ds64 == 0);
+	CHECK(strcmp(rh->c_id, "aaaa") == 0  &&  rh->c_size == 4);
+	checkWalk(rh, chunks, sizeof(chunks) / sizeof(chunks[0]));
+
+	//reading the header again gives the same
+	CHECK(riff_readHeader(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->h_size == sizeof(file_rifx) - 8);
+	CHECK(strcmp(rh->c_id, "aaaa") == 0  &&  rh->c_size == 4);
+}
+
+/*****************************************************************************/
+//"aaaa" grows into the "JUNK" chunk, the last chunk "cccc" grows with its parents
+static void checkRifxEdit(riff_handle *rh){
+	const uint8_t data[8] = {11, 12, 13, 14, 15, 16, 17, 18};
+	uint8_t buf[128];
+	FILE *f = copyToFile(file_rifx, sizeof(file_rifx));
+	REQUIRE_VOID(f != NULL);
+	int path = RIFF_EDIT_NONE;
+	CHECK(riff_open_file(rh, f, sizeof(file_rifx)) == RIFF_ERROR_NONE);
+	CHECK(riff_editReplaceChunk(rh, data, 8, NULL, &path) == RIFF_ERROR_NONE);
+	CHECK(path == RIFF_EDIT_JUNK);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekLevelSub(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "cccc") == 0);
+	CHECK(riff_editReplaceChunk(rh, data, 6, NULL, &path) == RIFF_ERROR_NONE);
+	CHECK(path == RIFF_EDIT_RESIZE);
+
+	size_t size = readAll(f, buf, sizeof(buf));
+	REQUIRE_VOID(size == sizeof(file_rifx) + 4);
+	CHECK(memcmp(buf, "RIFX", 4) == 0  &&  getU32BE(buf + 4) == size - 8);
+	CHECK(memcmp(buf + 12, "aaaa", 4) == 0  &&  getU32BE(buf + 16) == 8);
+	CHECK(memcmp(buf + 28, "JUNK", 4) == 0  &&  getU32BE(buf + 32) == 12);
+	CHECK(memcmp(buf + 48, "LIST", 4) == 0  &&  getU32BE(buf + 52) == 30);
+	CHECK(memcmp(buf + 72, "cccc", 4) == 0  &&  getU32BE(buf + 76) == 6);
+	CHECK(memcmp(buf + 80, data, 6) == 0);
+
+	const struct chunkInfo chunks[] = {
+		{"aaaa", 12, 8, 0}, {"JUNK", 28, 12, 0}, {"LIST", 48, 30, 0}, {"bbbb", 60, 3, 1}, {"cccc", 72, 6, 1},
+	};
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, size) == RIFF_ERROR_NONE);
+	CHECK(rh->h_size == size - 8);
+	checkWalk(rh, chunks, sizeof(chunks) / sizeof(chunks[0]));
+	fclose(f);
+}
+
+/*****************************************************************************/
+//the rewrite engine copies the chunks to a little endian "RIFF" file
+static void checkRifxRewrite(riff_handle *rh){
+	uint8_t buf[128];
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	riff_editScript *es = riff_editScriptAllocate();
+	REQUIRE_VOID(f != NULL  &&  rw != NULL  &&  es != NULL);
+	rw->fp_printf = NULL;
+
+	CHECK(riff_open_mem(rh, file_rifx, sizeof(file_rifx)) == RIFF_ERROR_NONE);
+	CHECK(riff_writer_open_file(rw, f, "TEST") == RIFF_ERROR_NONE);
+	CHECK(riff_editScriptDelete(es, 24) == RIFF_ERROR_NONE);
+	CHECK(riff_editApply(rh, es, rw) == RIFF_ERROR_NONE);
+	CHECK(riff_writerClose(rw) == RIFF_ERROR_NONE);
+
+	size_t size = readAll(f, buf, sizeof(buf));
+	REQUIRE_VOID(size == sizeof(file_rifx) - 24);
+	CHECK(memcmp(buf, "RIFF", 4) == 0  &&  getU32LE(buf + 4) == size - 8);
+	CHECK(memcmp(buf + 12, "aaaa", 4) == 0  &&  getU32LE(buf + 16) == 4);
+	CHECK(memcmp(buf + 24, "LIST", 4) == 0  &&  getU32LE(buf + 28) == 26);
+	CHECK(memcmp(buf + 36, "bbbb", 4) == 0  &&  getU32LE(buf + 40) == 3);
+	CHECK(memcmp(buf + 48, "cccc", 4) == 0  &&  getU32LE(buf + 52) == 2);
+	CHECK(memcmp(buf + 56, file_rifx + 80, 2) == 0);
+
+	riff_editScriptFree(es);
+	riff_writerFree(rw);
+	fclose(f);
+}
+
+/*****************************************************************************/
+static void checkRf64(riff_handle *rh){
+	const struct chunkInfo chunks[] = {
+		{"ds64", 12, 28, 0}, {"fmt ", 48, 16, 0}, {"data", 72, 6, 0}, {"tail", 86, 2, 0},
+	};
+	CHECK(riff_open_mem(rh, file_rf64, sizeof(file_rf64)) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->h_id, "RF64") == 0  &&  rh->h_fourcc == RIFF_FOURCC_RF64);
+	CHECK(strcmp(rh->h_type, "WAVE") == 0);
+	CHECK(rh->h_size == sizeof(file_rf64) - 8);
+	CHECK(rh->ds64 == 1);
+	CHECK(rh->ds64_data == 6);
+	CHECK(rh->ds64_samples == 3);
+	CHECK(rh->ds64_table_len == 0);
+	CHECK(strcmp(rh->c_id, "ds64") == 0  &&  rh->c_pos == 0);
+	checkWalk(rh, chunks, sizeof(chunks) / sizeof(chunks[0]));
+
+	CHECK(riff_readHeader(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->h_size == sizeof(file_rf64) - 8);
+	CHECK(rh->ds64_data == 6);
+
+	//data of the chunk with its size from "ds64"
+	uint8_t buf[8];
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(riff_readInChunk(rh, buf, sizeof(buf)) == 6);
+	CHECK(memcmp(buf, file_rf64 + 80, 6) == 0);
+}
+
+/*****************************************************************************/
+//in-place edits of a 64 bit file write little endian 32 bit sizes, the RIFF size stays in "ds64"
+static void checkRf64Edit(riff_handle *rh){
+	const uint8_t data[6] = {11, 12, 13, 14, 15, 16};
+	uint8_t buf[128];
+	FILE *f = copyToFile(file_rf64, sizeof(file_rf64));
+	REQUIRE_VOID(f != NULL);
+	int path = RIFF_EDIT_NONE;
+	CHECK(riff_open_file(rh, f, sizeof(file_rf64)) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	CHECK(riff_editReplaceChunk(rh, data, 6, NULL, &path) == RIFF_ERROR_NONE);
+	CHECK(path == RIFF_EDIT_INPLACE);
+	//the last chunk does not grow, the size of a 64 bit file is not patched
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_editReplaceChunk(rh, data, 4, NULL, &path) == RIFF_ERROR_ICSIZE);
+	CHECK(path == RIFF_EDIT_NONE);
+
+	size_t size = readAll(f, buf, sizeof(buf));
+	REQUIRE_VOID(size == sizeof(file_rf64));
+	CHECK(memcmp(buf, file_rf64, 72) == 0);
+	CHECK(memcmp(buf + 72, "data", 4) == 0  &&  getU32LE(buf + 76) == 6);
+	CHECK(memcmp(buf + 80, data, 6) == 0);
+	CHECK(memcmp(buf + 86, file_rf64 + 86, 10) == 0);
+
+	const struct chunkInfo chunks[] = {
+		{"ds64", 12, 28, 0}, {"fmt ", 48, 16, 0}, {"data", 72, 6, 0}, {"tail", 86, 2, 0},
+	};
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, size) == RIFF_ERROR_NONE);
+	CHECK(rh->h_size == size - 8);
+	checkWalk(rh, chunks, sizeof(chunks) / sizeof(chunks[0]));
+	fclose(f);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+
+	checkRifx(rh);
+	checkRifxEdit(rh);
+	checkRifxRewrite(rh);
+	checkRf64(rh);
+	checkRf64Edit(rh);
+
+	riff_handleFree(rh);
+	return TEST_RESULT();
+}
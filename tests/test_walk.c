@@ -0,0 +1,235 @@
+// tree walk over an empty chunk list, see walkFrom() and riff_seekLevelSub() in riff.c
+// the rewrite engine walks the same way, so an edited copy must keep the empty list
+// the resumable validator runs on the same file, also restored into a fresh handle and with a time budget
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "riff.h"
+#include "riff_edit.h"
+#include "riff_writer.h"
+#include "test.h"
+
+
+//RIFF "TEST": "aaaa" (2), LIST "empt" (type only), LIST "full" { "bbbb" (1, padded) }, "cccc" (4)
+static const uint8_t file_empty[] = {
+	'R','I','F','F', 60,0,0,0, 'T','E','S','T',
+	'a','a','a','a', 2,0,0,0, 1,2,
+	'L','I','S','T', 4,0,0,0, 'e','m','p','t',
+	'L','I','S','T', 14,0,0,0, 'f','u','l','l',
+		'b','b','b','b', 1,0,0,0, 3,0,
+	'c','c','c','c', 4,0,0,0, 4,5,6,7,
+};
+
+//walked chunk IDs and levels, one char per callback
+struct walkLog {
+	char s[64];
+	size_t len;
+};
+
+//read function of the opened file, wrapped by slowRead()
+static size_t (*fp_readOrig)(riff_handle *rh, void *ptr, size_t size);
+
+
+
+/*****************************************************************************/
+static uint32_t getU32(const uint8_t *p){
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*****************************************************************************/
+static void logAdd(struct walkLog *l, char c){
+	if(l->len + 1 < sizeof(l->s))
+		l->s[l->len++] = c;
+}
+
+static int logChunk(riff_handle *rh, void *user){
+	logAdd((struct walkLog *)user, riff_chunkIsList(rh) ? 'L' : rh->c_id[0]);
+	return RIFF_WALK_CONTINUE;
+}
+
+static int logEnter(riff_handle *rh, void *user){
+	logAdd((struct walkLog *)user, '(');
+	logAdd((struct walkLog *)user, rh->ls[rh->ls_level - 1].c_type[0]);
+	return RIFF_WALK_CONTINUE;
+}
+
+static int logLeave(riff_handle *rh, void *user){
+	(void)rh;
+	logAdd((struct walkLog *)user, ')');
+	return RIFF_WALK_CONTINUE;
+}
+
+
+/*****************************************************************************/
+static void checkWalk(riff_handle *rh){
+	struct walkLog l = {{0}, 0};
+	struct riff_walker w = {0};
+	w.fp_chunk = &logChunk;
+	w.fp_enter = &logEnter;
+	w.fp_leave = &logLeave;
+	w.user = &l;
+
+	CHECK(riff_walk(rh, &w) == RIFF_ERROR_NONE);
+	CHECK(strcmp(l.s, "aL(e)L(fb)c") == 0);
+	CHECK(rh->ls_level == 0);
+
+	CHECK(riff_fileValidate(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->ls_level == 0);
+
+	//in small slices, so a step also ends right at the empty list
+	struct riff_validator v;
+	int steps = 0;
+	CHECK(riff_validatorInit(rh, &v) == RIFF_ERROR_NONE);
+	while(!v.done  &&  steps++ < 100)
+		riff_validatorStep(rh, &v, 1, 0);
+	CHECK(v.done);
+	CHECK(v.result == RIFF_ERROR_NONE);
+}
+
+/*****************************************************************************/
+//the empty list is entered without a current chunk and left again
+static void checkLevelSub(riff_handle *rh){
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_NONE);
+	size_t list_pos = rh->c_pos_start;
+	CHECK(riff_seekLevelSub(rh) == RIFF_ERROR_EOCL);
+	CHECK(rh->ls_level == 1);
+	CHECK(memcmp(rh->ls[0].c_type, "empt", 4) == 0);
+	CHECK(rh->c_pos_start == list_pos);
+	CHECK(riff_seekNextChunk(rh) == RIFF_ERROR_EOCL);
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_EOCL);
+	CHECK(riff_seekLevelParentNext(rh) == RIFF_ERROR_NONE);
+	CHECK(rh->ls_level == 0);
+	CHECK(rh->c_pos_start == list_pos + 12);
+}
+
+/*****************************************************************************/
+//every read takes a few milliseconds, so a time budget runs out within the file
+static size_t slowRead(riff_handle *rh, void *ptr, size_t size){
+	clock_t end = clock() + CLOCKS_PER_SEC / 200;
+	while(clock() < end);
+	return fp_readOrig(rh, ptr, size);
+}
+
+/*****************************************************************************/
+//validation stopped inside the list "full", serialized and continued in a fresh handle
+static void checkRestore(riff_handle *rh){
+	struct riff_validator v, v2;
+	int steps = 0;
+	CHECK(riff_validatorInit(rh, &v) == RIFF_ERROR_NONE);
+	while(!v.done  &&  rh->ls_level == 0  &&  steps++ < 100)
+		riff_validatorStep(rh, &v, 1, 0);
+	REQUIRE_VOID(!v.done  &&  rh->ls_level == 1);
+
+	uint8_t buf[256];
+	size_t size = riff_validatorSerialize(rh, &v, NULL, 0);
+	REQUIRE_VOID(size <= sizeof(buf));
+	CHECK(riff_validatorSerialize(rh, &v, buf, sizeof(buf)) == size);
+
+	riff_handle *rh2 = riff_handleAllocate();
+	REQUIRE_VOID(rh2 != NULL);
+	rh2->fp_printf = NULL;
+	CHECK(riff_open_mem(rh2, file_empty, sizeof(file_empty)) == RIFF_ERROR_NONE);
+	CHECK(riff_validatorRestore(rh2, &v2, buf, size) == RIFF_ERROR_NONE);
+	CHECK(rh2->ls_level == 1  &&  memcmp(rh2->ls[0].c_type, "full", 4) == 0);
+	CHECK(rh2->c_pos_start == rh->c_pos_start  &&  strcmp(rh2->c_id, rh->c_id) == 0);
+	CHECK(v2.io_bytes == v.io_bytes  &&  v2.covered == v.covered  &&  !v2.done);
+
+	//both finish the same way
+	while(!v.done  &&  steps++ < 100)
+		riff_validatorStep(rh, &v, 1, 0);
+	while(!v2.done  &&  steps++ < 200)
+		riff_validatorStep(rh2, &v2, 1, 0);
+	CHECK(v.done  &&  v2.done);
+	CHECK(v.result == RIFF_ERROR_NONE  &&  v2.result == RIFF_ERROR_NONE);
+	CHECK(v2.covered == v.covered  &&  v2.covered == v2.total);
+	CHECK(v2.io_bytes == v.io_bytes);
+
+	//level entry and next chunk must stay within their parent
+	uint8_t bad[256];
+	memcpy(bad, buf, size);
+	bad[60 + 8 + 6] = 0x01; //list size beyond the RIFF chunk
+	CHECK(riff_validatorRestore(rh2, &v2, bad, size) == RIFF_ERROR_ICSIZE);
+	memcpy(bad, buf, size);
+	memset(bad + 60, 0, 8); //list in front of the first chunk
+	CHECK(riff_validatorRestore(rh2, &v2, bad, size) == RIFF_ERROR_ICSIZE);
+	memcpy(bad, buf, size);
+	memset(bad + 56, 0, 8); //next chunk outside the list
+	CHECK(riff_validatorRestore(rh2, &v2, bad, size) == RIFF_ERROR_ICSIZE);
+	memcpy(bad, buf, size);
+	bad[4] = 'X'; //other file
+	CHECK(riff_validatorRestore(rh2, &v2, bad, size) == RIFF_ERROR_ILLID);
+	CHECK(riff_validatorRestore(rh2, &v2, buf, size - 1) == RIFF_ERROR_EOF);
+
+	riff_handleFree(rh2);
+}
+
+/*****************************************************************************/
+//a time budget stops the validation after about max_ms, the steps still cover the whole file
+static void checkTimeBudget(riff_handle *rh){
+	struct riff_validator v;
+	int steps = 0;
+	CHECK(riff_validatorInit(rh, &v) == RIFF_ERROR_NONE);
+	fp_readOrig = rh->fp_read;
+	rh->fp_read = &slowRead;
+	while(!v.done  &&  steps++ < 100)
+		riff_validatorStep(rh, &v, 0, 1);
+	rh->fp_read = fp_readOrig;
+	CHECK(v.done  &&  v.result == RIFF_ERROR_NONE);
+	CHECK(steps > 1);
+	CHECK(v.covered == v.total);
+
+	//without any budget a single step does it all
+	CHECK(riff_validatorInit(rh, &v) == RIFF_ERROR_NONE);
+	CHECK(riff_validatorStep(rh, &v, 0, 0) == RIFF_ERROR_NONE);
+	CHECK(v.done  &&  v.result == RIFF_ERROR_NONE);
+}
+
+/*****************************************************************************/
+//rewrite with a script deleting "cccc", the result keeps both lists
+static void checkEdit(riff_handle *rh){
+	FILE *f = tmpfile();
+	riff_writer *rw = riff_writerAllocate();
+	riff_editScript *es = riff_editScriptAllocate();
+	REQUIRE_VOID(f != NULL  &&  rw != NULL  &&  es != NULL);
+	rw->fp_printf = NULL;
+
+	CHECK(riff_writer_open_file(rw, f, "TEST") == RIFF_ERROR_NONE);
+	CHECK(riff_editScriptDelete(es, 12 + 10 + 12 + 22) == RIFF_ERROR_NONE);
+	CHECK(riff_editApply(rh, es, rw) == RIFF_ERROR_NONE);
+
+	long size = ftell(f);
+	uint8_t buf[sizeof(file_empty)];
+	CHECK(size == (long)sizeof(file_empty) - 12);
+	fseek(f, 0, SEEK_SET);
+	if(size > 0  &&  size <= (long)sizeof(buf)  &&  fread(buf, 1, (size_t)size, f) == (size_t)size){
+		CHECK(memcmp(buf + 8, file_empty + 8, (size_t)size - 8) == 0);
+		CHECK(getU32(buf + 4) == (uint32_t)size - 8);
+	}
+
+	riff_editScriptFree(es);
+	riff_writerFree(rw);
+	fclose(f);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	riff_handle *rh = riff_handleAllocate();
+	REQUIRE(rh != NULL);
+	rh->fp_printf = NULL;
+
+	REQUIRE(riff_open_mem(rh, file_empty, sizeof(file_empty)) == RIFF_ERROR_NONE);
+	checkWalk(rh);
+	checkLevelSub(rh);
+	checkRestore(rh);
+	checkTimeBudget(rh);
+	checkEdit(rh);
+
+	riff_handleFree(rh);
+	return TEST_RESULT();
+}
@@ -0,0 +1,427 @@
+// WAVE layer on generated files, see riff_wav.c
+// every file is read through a FILE based and a memory based handle
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "riff_wav.h"
+#include "riff_writer.h"
+#include "riff_internal.h"
+#include "test.h"
+
+
+#define WAV_EXT_PCM_GUID "\x01\x00\x00\x00\x00\x00\x10\x00\x80\x00\x00\xaa\x00\x38\x9b\x71"
+
+#define KERNEL_MAX 80       //samples, covers the tail of every vector width
+#define GUARD 16            //output samples behind the end that must stay untouched
+
+//bits per sample of the PCM_... source types
+static const uint16_t pcm_bits[PCM_TYPES] = { 8, 16, 24, 32, 32, 64 };
+
+//generated file and its expected format
+struct wavCase {
+	const char *name;
+	uint8_t fmt[40];
+	size_t fmt_size;
+	int data_first;     //"data" chunk before "fmt "
+	size_t data_size;   //can have a cut off frame at the end
+	//expected
+	uint16_t format_tag;
+	uint16_t format;
+	uint16_t channels;
+	uint16_t block_align;
+	uint16_t bits_per_sample;
+	uint16_t valid_bits;
+	uint32_t channel_mask;
+};
+
+
+
+/*****************************************************************************/
+static void putU16(uint8_t *p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+/*****************************************************************************/
+static void putU32(uint8_t *p, uint32_t v){
+	putU16(p, (uint16_t)v);
+	putU16(p + 2, (uint16_t)(v >> 16));
+}
+
+/*****************************************************************************/
+//"fmt " chunk data, WAVE_FORMAT_EXTENSIBLE if sub_format is given
+static size_t makeFmt(uint8_t *p, uint16_t tag, uint16_t channels, uint16_t bits, uint16_t valid_bits, uint32_t mask, const char *sub_format){
+	uint16_t align = channels * (bits / 8);
+	putU16(p, tag);
+	putU16(p + 2, channels);
+	putU32(p + 4, 48000);
+	putU32(p + 8, 48000 * align);
+	putU16(p + 12, align);
+	putU16(p + 14, bits);
+	if(sub_format == NULL){
+		putU16(p + 16, 0);
+		return 18;
+	}
+	putU16(p + 16, 22);
+	putU16(p + 18, valid_bits);
+	putU32(p + 20, mask);
+	memcpy(p + 24, sub_format, 16);
+	return 40;
+}
+
+/*****************************************************************************/
+//sample data byte at position, no pattern repeats within a frame
+static uint8_t dataByte(size_t i){
+	return (uint8_t)(i * 7 + (i >> 8) + 1);
+}
+
+/*****************************************************************************/
+//write the case with riff_writer, odd sized "JUNK" chunk in front to have a pad byte
+static int writeCase(FILE *f, const struct wavCase *c){
+	riff_writer *rw = riff_writerAllocate();
+	if(rw == NULL)
+		return RIFF_ERROR_MEMORY;
+	rw->fp_printf = NULL;
+	int r = riff_writer_open_file(rw, f, "WAVE");
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerWriteChunk(rw, "JUNK", "abc", 3);
+	if(r == RIFF_ERROR_NONE  &&  !c->data_first)
+		r = riff_writerWriteChunk(rw, "fmt ", c->fmt, c->fmt_size);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerBeginChunk(rw, "data");
+	size_t i;
+	for(i = 0; r == RIFF_ERROR_NONE  &&  i < c->data_size; i++){
+		uint8_t b = dataByte(i);
+		if(riff_writerWrite(rw, &b, 1) != 1)
+			r = RIFF_ERROR_ACCESS;
+	}
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerEnd(rw);
+	if(r == RIFF_ERROR_NONE  &&  c->data_first)
+		r = riff_writerWriteChunk(rw, "fmt ", c->fmt, c->fmt_size);
+	if(r == RIFF_ERROR_NONE)
+		r = riff_writerClose(rw);
+	riff_writerFree(rw);
+	return r;
+}
+
+/*****************************************************************************/
+//frames as they were written
+static int framesMatch(const struct wavCase *c, uint64_t start, size_t count, const uint8_t *buf){
+	size_t i;
+	for(i = 0; i < count * c->block_align; i++){
+		if(buf[i] != dataByte((size_t)start * c->block_align + i))
+			return 0;
+	}
+	return 1;
+}
+
+
+/*****************************************************************************/
+static void checkFormat(const struct wavCase *c, const riff_wav *wav){
+	CHECK(wav->format_tag == c->format_tag);
+	CHECK(wav->format == c->format);
+	CHECK(wav->channels == c->channels);
+	CHECK(wav->sample_rate == 48000);
+	CHECK(wav->block_align == c->block_align);
+	CHECK(wav->bits_per_sample == c->bits_per_sample);
+	CHECK(wav->valid_bits == c->valid_bits);
+	CHECK(wav->channel_mask == c->channel_mask);
+	CHECK(wav->data_size == c->data_size);
+	CHECK(wav->frames == c->data_size / c->block_align);
+}
+
+/*****************************************************************************/
+static void checkFrames(riff_handle *rh, const struct wavCase *c, const riff_wav *wav){
+	size_t frames = (size_t)wav->frames;
+	uint8_t *buf = malloc(frames * c->block_align);
+	CHECK(buf != NULL);
+	if(buf == NULL)
+		return;
+
+	//whole data, then from the middle, then across the end
+	CHECK(riff_wavReadFrames(rh, wav, 0, frames, buf) == frames);
+	CHECK(framesMatch(c, 0, frames, buf));
+	CHECK(riff_wavReadFrames(rh, wav, 37, 20, buf) == 20);
+	CHECK(framesMatch(c, 37, 20, buf));
+	CHECK(riff_wavReadFrames(rh, wav, frames - 3, 10, buf) == 3);
+	CHECK(framesMatch(c, frames - 3, 3, buf));
+	CHECK(riff_wavReadFrames(rh, wav, frames, 1, buf) == 0);
+
+	//works after the handle was moved elsewhere
+	CHECK(riff_seekLevelStart(rh) == RIFF_ERROR_NONE);
+	CHECK(riff_wavReadFrames(rh, wav, 1, 2, buf) == 2);
+	CHECK(framesMatch(c, 1, 2, buf));
+
+	//out of order, overlapping and cut off regions
+	uint8_t *b[4];
+	size_t i;
+	for(i = 0; i < 4; i++)
+		b[i] = buf + i * 32 * c->block_align;
+	struct riff_wavRegion regions[4] = {
+		{ frames - 5, 32, b[0], 0 },
+		{ 100, 16, b[1], 0 },
+		{ 2, 8, b[2], 0 },
+		{ 104, 4, b[3], 0 },
+	};
+	CHECK(riff_wavReadRegions(rh, wav, regions, 4) == 5 + 16 + 8 + 4);
+	CHECK(regions[0].read == 5);
+	CHECK(regions[1].read == 16);
+	CHECK(regions[2].read == 8);
+	CHECK(regions[3].read == 4);
+	for(i = 0; i < 4; i++)
+		CHECK(framesMatch(c, regions[i].start, regions[i].read, regions[i].buf));
+
+	free(buf);
+}
+
+
+/*****************************************************************************/
+//PCM_... source type of format
+static int pcmType(const riff_wav *wav){
+	int t;
+	for(t = (wav->format == RIFF_WAV_FORMAT_FLOAT) ? PCM_F32 : PCM_U8; t < PCM_TYPES; t++){
+		if(pcm_bits[t] == wav->bits_per_sample)
+			return t;
+	}
+	return -1;
+}
+
+/*****************************************************************************/
+//interleaved frames converted by the scalar kernel, as planes if planar
+static void convertScalar(const riff_wav *wav, const uint8_t *src, size_t frames, void *dst, int sample, int planar){
+	size_t ch = wav->channels, osize = (sample == RIFF_WAV_SAMPLE_FLOAT) ? 4 : 2;
+	size_t f, c;
+	pcm_kernel k = pcm_kernelOf("scalar", pcmType(wav), sample);
+	if(!planar){
+		k(src, dst, frames * ch);
+		return;
+	}
+	for(f = 0; f < frames; f++){
+		for(c = 0; c < ch; c++)
+			k(src + f * wav->block_align + c * (wav->bits_per_sample / 8), (uint8_t *)dst + (c * frames + f) * osize, 1);
+	}
+}
+
+/*****************************************************************************/
+//riff_wavReadConverted() gives what the scalar kernel makes of the raw frames
+static void checkConverted(riff_handle *rh, const riff_wav *wav){
+	size_t frames = (size_t)wav->frames;
+	size_t size = frames * wav->channels * sizeof(float);
+	uint8_t *raw = malloc(frames * wav->block_align);
+	uint8_t *ref = malloc(size), *out = malloc(size);
+	CHECK(raw != NULL  &&  ref != NULL  &&  out != NULL);
+	if(raw != NULL  &&  ref != NULL  &&  out != NULL){
+		CHECK(riff_wavReadFrames(rh, wav, 0, frames, raw) == frames);
+		int sample, planar;
+		for(sample = RIFF_WAV_SAMPLE_FLOAT; sample <= RIFF_WAV_SAMPLE_INT16; sample++){
+			size_t osize = (sample == RIFF_WAV_SAMPLE_FLOAT) ? 4 : 2;
+			for(planar = 0; planar < 2; planar++){
+				convertScalar(wav, raw, frames, ref, sample, planar);
+				CHECK(riff_wavReadConverted(rh, wav, 0, frames, out, sample, planar) == frames);
+				CHECK(memcmp(ref, out, frames * wav->channels * osize) == 0);
+				//from the middle, with a count that is no multiple of a vector
+				convertScalar(wav, raw + 37 * wav->block_align, 19, ref, sample, planar);
+				CHECK(riff_wavReadConverted(rh, wav, 37, 19, out, sample, planar) == 19);
+				CHECK(memcmp(ref, out, 19 * wav->channels * osize) == 0);
+			}
+		}
+	}
+	free(out);
+	free(ref);
+	free(raw);
+}
+
+/*****************************************************************************/
+static void runCase(struct wavCase *c){
+	FILE *f = tmpfile();
+	CHECK(f != NULL);
+	if(f == NULL)
+		return;
+	int r = writeCase(f, c);
+	CHECK(r == RIFF_ERROR_NONE);
+	long size = ftell(f);
+	riff_handle *rh = riff_handleAllocate();
+	CHECK(rh != NULL);
+	if(r != RIFF_ERROR_NONE  ||  size <= 0  ||  rh == NULL){
+		fprintf(stderr, "case \"%s\" not written\n", c->name);
+		riff_handleFree(rh);
+		fclose(f);
+		return;
+	}
+	rh->fp_printf = NULL;
+
+	riff_wav wav;
+	fseek(f, 0, SEEK_SET);
+	CHECK(riff_open_file(rh, f, (size_t)size) == RIFF_ERROR_NONE);
+	CHECK(riff_wavOpen(rh, &wav) == RIFF_ERROR_NONE);
+	CHECK(strcmp(rh->c_id, "data") == 0);
+	checkFormat(c, &wav);
+	checkFrames(rh, c, &wav);
+	checkConverted(rh, &wav);
+
+	uint8_t *mem = malloc((size_t)size);
+	CHECK(mem != NULL);
+	fseek(f, 0, SEEK_SET);
+	if(mem != NULL  &&  fread(mem, 1, (size_t)size, f) == (size_t)size){
+		CHECK(riff_open_mem(rh, mem, (size_t)size) == RIFF_ERROR_NONE);
+		CHECK(riff_wavOpen(rh, &wav) == RIFF_ERROR_NONE);
+		checkFormat(c, &wav);
+		checkFrames(rh, c, &wav);
+		checkConverted(rh, &wav);
+	}
+	free(mem);
+
+	riff_handleFree(rh);
+	fclose(f);
+}
+
+
+/*****************************************************************************/
+//n source samples of type, floats also out of range, on rounding ties and not finite
+static void fillSamples(uint8_t *src, int type, size_t n){
+	static const float special[] = { 1.0f, -1.0f, 1.5f, -1.5f, 0.5f / 32768, 1.5f / 32768, -2.5f / 32768, 1e30f, 0.0f / 0.0f };
+	size_t i, size = pcm_bits[type] / 8;
+	uint32_t x = 12345;
+	for(i = 0; i < n; i++){
+		x = x * 1664525u + 1013904223u;
+		float f = (float)(int32_t)x / 1.5e9f;
+		if(x % 5 == 0)
+			f = special[(x >> 8) % (sizeof(special) / sizeof(special[0]))];
+		double d = f;
+		if(type == PCM_F32)
+			memcpy(src + i * 4, &f, 4);
+		else if(type == PCM_F64)
+			memcpy(src + i * 8, &d, 8);
+		else
+			memcpy(src + i * size, &x, size);
+	}
+}
+
+/*****************************************************************************/
+//each SIMD kernel built in and supported by the CPU against the scalar one
+//every length up to KERNEL_MAX, from an unaligned source, nothing written behind the end
+static void checkKernels(void){
+	static const char *const impls[] = { "sse2", "avx2", "neon" };
+	uint8_t src[KERNEL_MAX * 8 + 1];
+	float ref[KERNEL_MAX + GUARD], out[KERNEL_MAX + GUARD];
+	size_t i, n, tested = 0;
+	int t, sample;
+	for(i = 0; i < sizeof(impls) / sizeof(impls[0]); i++){
+		for(t = 0; t < PCM_TYPES; t++){
+			fillSamples(src + 1, t, KERNEL_MAX);
+			for(sample = RIFF_WAV_SAMPLE_FLOAT; sample <= RIFF_WAV_SAMPLE_INT16; sample++){
+				pcm_kernel k = pcm_kernelOf(impls[i], t, sample);
+				if(k == NULL)
+					continue;
+				size_t osize = (sample == RIFF_WAV_SAMPLE_FLOAT) ? 4 : 2;
+				for(n = 0; n <= KERNEL_MAX; n++){
+					memset(ref, 0xA5, sizeof(ref));
+					memset(out, 0xA5, sizeof(out));
+					pcm_kernelOf("scalar", t, sample)(src + 1, ref, n);
+					k(src + 1, out, n);
+					if(memcmp(ref, out, sizeof(out)) != 0){
+						fprintf(stderr, "%s kernel of type %d to sample %d differs at %zu samples\n", impls[i], t, sample, n);
+						CHECK(memcmp(ref, out, n * osize) == 0);
+						CHECK(memcmp(ref, out, sizeof(out)) == 0);
+						break;
+					}
+				}
+				tested++;
+			}
+		}
+	}
+	printf("PCM kernels: %s, %zu SIMD kernels checked\n", riff_wavConvertImpl(), tested);
+}
+
+/*****************************************************************************/
+//riff_wavConvert() with the picked kernels against the scalar ones
+//every source format, interleaved and planar, frame counts around the vector widths and beyond the planar scratch buffer
+static void checkConvert(void){
+	static const size_t counts[] = { 0, 1, 3, 7, 8, 9, 15, 16, 17, 33, 700 };
+	static const uint16_t channels[] = { 1, 2, 6 };
+	size_t max = 700 * 6;
+	uint8_t *src = malloc(max * 8);
+	float *ref = malloc(max * sizeof(float)), *out = malloc(max * sizeof(float));
+	REQUIRE_VOID(src != NULL  &&  ref != NULL  &&  out != NULL);
+
+	size_t i, c;
+	int t, sample, planar;
+	for(t = 0; t < PCM_TYPES; t++){
+		fillSamples(src, t, max);
+		for(c = 0; c < sizeof(channels) / sizeof(channels[0]); c++){
+			riff_wav wav;
+			memset(&wav, 0, sizeof(wav));
+			wav.format = (t >= PCM_F32) ? RIFF_WAV_FORMAT_FLOAT : RIFF_WAV_FORMAT_PCM;
+			wav.channels = channels[c];
+			wav.bits_per_sample = pcm_bits[t];
+			wav.block_align = wav.channels * (wav.bits_per_sample / 8);
+			for(sample = RIFF_WAV_SAMPLE_FLOAT; sample <= RIFF_WAV_SAMPLE_INT16; sample++){
+				size_t osize = (sample == RIFF_WAV_SAMPLE_FLOAT) ? 4 : 2;
+				for(planar = 0; planar < 2; planar++){
+					for(i = 0; i < sizeof(counts) / sizeof(counts[0]); i++){
+						size_t frames = counts[i];
+						convertScalar(&wav, src, frames, ref, sample, planar);
+						CHECK(riff_wavConvert(&wav, src, frames, out, sample, planar) == frames);
+						if(memcmp(ref, out, frames * wav.channels * osize) != 0){
+							fprintf(stderr, "type %d, %u channels, sample %d, planar %d: %zu frames differ\n", t, wav.channels, sample, planar, frames);
+							test_failed++;
+						}
+					}
+				}
+			}
+		}
+	}
+	free(out);
+	free(ref);
+	free(src);
+}
+
+
+/*****************************************************************************/
+int main(void){
+	struct wavCase pcm;
+	memset(&pcm, 0, sizeof(pcm));
+	pcm.name = "PCM 16 bit stereo";
+	pcm.fmt_size = makeFmt(pcm.fmt, RIFF_WAV_FORMAT_PCM, 2, 16, 16, 0, NULL);
+	pcm.data_size = 1000 * 4;
+	pcm.format_tag = pcm.format = RIFF_WAV_FORMAT_PCM;
+	pcm.channels = 2;
+	pcm.block_align = 4;
+	pcm.bits_per_sample = pcm.valid_bits = 16;
+	runCase(&pcm);
+
+	struct wavCase flt;
+	memset(&flt, 0, sizeof(flt));
+	flt.name = "float 32 bit mono, data before fmt";
+	flt.fmt_size = makeFmt(flt.fmt, RIFF_WAV_FORMAT_FLOAT, 1, 32, 32, 0, NULL);
+	flt.data_first = 1;
+	flt.data_size = 257 * 4;
+	flt.format_tag = flt.format = RIFF_WAV_FORMAT_FLOAT;
+	flt.channels = 1;
+	flt.block_align = 4;
+	flt.bits_per_sample = flt.valid_bits = 32;
+	runCase(&flt);
+
+	//odd data size, the last frame is cut off
+	struct wavCase ext;
+	memset(&ext, 0, sizeof(ext));
+	ext.name = "extensible PCM 24 bit container, 20 valid bits";
+	ext.fmt_size = makeFmt(ext.fmt, RIFF_WAV_FORMAT_EXTENSIBLE, 2, 24, 20, 0x3, WAV_EXT_PCM_GUID);
+	ext.data_size = 300 * 6 + 3;
+	ext.format_tag = RIFF_WAV_FORMAT_EXTENSIBLE;
+	ext.format = RIFF_WAV_FORMAT_PCM;
+	ext.channels = 2;
+	ext.block_align = 6;
+	ext.bits_per_sample = 24;
+	ext.valid_bits = 20;
+	ext.channel_mask = 0x3;
+	runCase(&ext);
+
+	checkKernels();
+	checkConvert();
+	return TEST_RESULT();
+}